@@ -8,3 +8,9 @@
 
 #define IDM_MAIN 102
 #define IDM_EXIT 103
+#define IDM_BENCHMARK 104
+#define IDM_PROFILE 105
+#define IDM_TRACE 106
+#define IDM_FIND 107
+
+#define IDC_FIND 201
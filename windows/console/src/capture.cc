@@ -0,0 +1,231 @@
+#include "capture.h"
+#include "pipe.h"
+#include <fcntl.h>
+#include <io.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CAPTURE_PIPE_SIZE   (1 << 20)  // pipe buffer that absorbs bursts from writing threads
+#define CAPTURE_BUFFER_SIZE (1 << 16)  // read buffer size
+#define CAPTURE_PENDING     (1 << 24)  // maximum number of bytes waiting for the console
+
+#define BENCHMARK_MARKER "capture benchmark "
+
+namespace {
+
+long long ticks()
+{
+  LARGE_INTEGER counter = {};
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart;
+}
+
+double frequency()
+{
+  LARGE_INTEGER frequency = {};
+  QueryPerformanceFrequency(&frequency);
+  return static_cast<double>(frequency.QuadPart);
+}
+
+void redirect(FILE* stream, DWORD id, HANDLE pipe, HANDLE& handle, int& fd)
+{
+  // Give the stream a descriptor in applications without a console.
+  if (_fileno(stream) < 0) {
+    freopen("NUL", "w", stream);
+  }
+  fflush(stream);
+  handle = GetStdHandle(id);
+  fd = _dup(_fileno(stream));
+
+  // Replace the descriptor and the standard handle with the pipe.
+  auto pipe_fd = _open_osfhandle(reinterpret_cast<intptr_t>(pipe), _O_WRONLY | _O_BINARY);
+  if (pipe_fd < 0) {
+    CloseHandle(pipe);
+    return;
+  }
+  _dup2(pipe_fd, _fileno(stream));
+  _close(pipe_fd);
+  SetStdHandle(id, reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(stream))));
+}
+
+void restore(FILE* stream, DWORD id, HANDLE& handle, int& fd)
+{
+  fflush(stream);
+  if (fd >= 0) {
+    _dup2(fd, _fileno(stream));
+    _close(fd);
+    fd = -1;
+  }
+  SetStdHandle(id, handle);
+  handle = nullptr;
+}
+
+}  // namespace
+
+capture::capture(pipe_reader::data_handler data) :
+  data_(std::move(data)),
+  reader_([this](int stream, const char* chunk, std::size_t size) {
+    // Measure the latency once the console took the chunk, because a rejected chunk is delivered again.
+    if (!data_(stream, chunk, size)) {
+      return false;
+    }
+    measure(chunk, size);
+    return true;
+  }, nullptr, CAPTURE_BUFFER_SIZE, CAPTURE_PENDING)
+{}
+
+capture::~capture()
+{
+  stop();
+}
+
+void capture::start()
+{
+  if (active_) {
+    return;
+  }
+
+  // Create the pipes before touching any stream.
+  scoped_handle out_read;
+  scoped_handle out_write;
+  create_pipe(out_read, out_write, CAPTURE_PIPE_SIZE, false);
+
+  scoped_handle err_read;
+  scoped_handle err_write;
+  create_pipe(err_read, err_write, CAPTURE_PIPE_SIZE, false);
+
+  // Reserve descriptor 0 for stdin so that stdout and stderr get their usual descriptors.
+  if (_fileno(stdin) < 0) {
+    freopen("NUL", "r", stdin);
+  }
+
+  // Remember the buffering that the CRT chose for stdout. Character devices are written unbuffered,
+  // files and pipes are fully buffered. Standard error is always unbuffered.
+  stdout_buffered_ = _fileno(stdout) >= 0 && !_isatty(_fileno(stdout));
+  redirect(stdout, STD_OUTPUT_HANDLE, out_write.release(), stdout_handle_, stdout_fd_);
+  redirect(stderr, STD_ERROR_HANDLE, err_write.release(), stderr_handle_, stderr_fd_);
+
+  // Buffer stdout to keep printf cheap for the writing threads. The console flushes it periodically.
+  setvbuf(stdout, nullptr, _IOFBF, CAPTURE_BUFFER_SIZE);
+  setvbuf(stderr, nullptr, _IONBF, 0);
+
+  reader_.start(out_read.release(), err_read.release());
+  active_ = true;
+}
+
+void capture::stop()
+{
+  if (!active_) {
+    return;
+  }
+
+  // Stop the reader first so that writers blocked on a full pipe fail instead of waiting for the console.
+  // Restoring the descriptors closes the write ends of the pipes.
+  active_ = false;
+  reader_.stop();
+  restore(stdout, STD_OUTPUT_HANDLE, stdout_handle_, stdout_fd_);
+  restore(stderr, STD_ERROR_HANDLE, stderr_handle_, stderr_fd_);
+
+  // Restore the original buffering, which also releases the capture buffer.
+  setvbuf(stdout, nullptr, stdout_buffered_ ? _IOFBF : _IONBF, BUFSIZ);
+  setvbuf(stderr, nullptr, _IONBF, 0);
+}
+
+bool capture::active() const
+{
+  return active_;
+}
+
+void capture::flush()
+{
+  if (active_) {
+    fflush(stdout);
+  }
+}
+
+void capture::consume(std::size_t size)
+{
+  reader_.consume(size);
+}
+
+pipe_reader::statistics capture::stats() const
+{
+  return reader_.stats();
+}
+
+capture::benchmark_result capture::benchmark(std::size_t lines)
+{
+  benchmark_result result;
+  if (!active_) {
+    return result;
+  }
+
+  latency_sum_ = 0;
+  latency_max_ = 0;
+  latency_count_ = 0;
+  received_ = 0;
+  measuring_ = true;
+
+  // Write numbered lines that carry their timestamp. Every line is flushed, so that the latency covers the
+  // pipe and the reader thread instead of the time the line waits in the stdout buffer.
+  auto start = ticks();
+  for (std::size_t i = 1; i <= lines; i++) {
+    auto size = std::printf(BENCHMARK_MARKER "%zu %lld\n", i, ticks());
+    if (size > 0) {
+      result.bytes += static_cast<std::size_t>(size);
+    }
+    std::fflush(stdout);
+  }
+  auto end = ticks();
+
+  // Wait for the reader thread to receive the last line.
+  auto deadline = GetTickCount() + 5000;
+  while (active_ && received_ < lines && static_cast<LONG>(deadline - GetTickCount()) > 0) {
+    Sleep(1);
+  }
+  measuring_ = false;
+
+  auto f = frequency();
+  result.lines = lines;
+  result.seconds = (end - start) / f;
+  if (auto count = latency_count_.load()) {
+    result.latency_avg = latency_sum_.load() / static_cast<double>(count) * 1e6 / f;
+    result.latency_max = latency_max_.load() * 1e6 / f;
+  }
+  return result;
+}
+
+void capture::measure(const char* data, std::size_t size)
+{
+  if (!measuring_) {
+    return;
+  }
+
+  // Measure every complete benchmark line in the chunk.
+  static const char marker[] = BENCHMARK_MARKER;
+  static const std::size_t marker_size = sizeof(marker) - 1;
+  auto now = ticks();
+  auto end = data + size;
+  for (auto pos = std::search(data, end, marker, marker + marker_size); pos != end;
+       pos = std::search(pos, end, marker, marker + marker_size)) {
+    auto eol = std::find(pos, end, '\n');
+    if (eol == end) {
+      break;
+    }
+    // The line break ends the numbers.
+    char* next = nullptr;
+    auto index = std::strtoull(pos + marker_size, &next, 10);
+    auto stamp = std::strtoll(next, nullptr, 10);
+    auto latency = static_cast<std::uint64_t>(now > stamp ? now - stamp : 0);
+
+    latency_sum_ += latency;
+    latency_count_++;
+    auto max = latency_max_.load();
+    while (latency > max && !latency_max_.compare_exchange_weak(max, latency)) {
+    }
+    received_ = index;
+    pos = eol;
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "pipe_reader.h"
+#include <windows.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Redirects the standard handles and the CRT streams of this process into a pipe reader.
+class capture {
+public:
+  struct benchmark_result {
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+    double seconds = 0.0;
+    double latency_avg = 0.0;  // microseconds
+    double latency_max = 0.0;  // microseconds
+  };
+
+  capture(pipe_reader::data_handler data);
+  ~capture();
+
+  // Redirects stdout and stderr. Throws on failure.
+  void start();
+
+  // Restores the original handles and streams.
+  void stop();
+
+  bool active() const;
+
+  // Flushes the buffered CRT output.
+  void flush();
+
+  // Acknowledges output that was written to the console.
+  void consume(std::size_t size);
+
+  pipe_reader::statistics stats() const;
+
+  // Writes and flushes the given number of lines with printf and measures the writer throughput
+  // and the latency of every line until the reader thread receives it.
+  benchmark_result benchmark(std::size_t lines);
+
+private:
+  void measure(const char* data, std::size_t size);
+
+  pipe_reader::data_handler data_;
+  pipe_reader reader_;
+  std::atomic<bool> active_ = { false };
+
+  HANDLE stdout_handle_ = nullptr;
+  HANDLE stderr_handle_ = nullptr;
+  int stdout_fd_ = -1;
+  int stderr_fd_ = -1;
+  bool stdout_buffered_ = false;
+
+  std::atomic<bool> measuring_ = { false };
+  std::atomic<std::uint64_t> latency_sum_ = { 0 };
+  std::atomic<std::uint64_t> latency_max_ = { 0 };
+  std::atomic<std::uint64_t> latency_count_ = { 0 };
+  std::atomic<std::uint64_t> received_ = { 0 };
+};
@@ -0,0 +1,498 @@
+#include "console_view.h"
+#include "text_search.h"
+#include <resource.h>
+#include <windowsx.h>
+#include <algorithm>
+#include <string>
+#include <climits>
+
+#define PADDING   3L  // text padding
+
+#define MATCH_COLOR RGB(255, 230, 110)  // background of search matches
+
+#define VIEW_CLASS L"ConsoleView"
+
+console_view::console_view(HINSTANCE instance) : instance_(instance)
+{
+  // Register the console view window class.
+  WNDCLASSEX wc = {};
+  wc.cbSize = sizeof(wc);
+  wc.style = CS_DBLCLKS;
+  wc.lpfnWndProc = window_proc;
+  wc.hInstance = instance;
+  wc.hCursor = LoadCursor(nullptr, IDC_IBEAM);
+  wc.lpszClassName = VIEW_CLASS;
+  RegisterClassEx(&wc);
+}
+
+HWND console_view::create(HWND parent)
+{
+  // Create the console view control.
+  auto ws = WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL;
+  return CreateWindowEx(0, VIEW_CLASS, nullptr, ws, 0, 0, 100, 100, parent, nullptr, instance_, this);
+}
+
+void console_view::set_font(HFONT font)
+{
+  // Measure the fixed-pitch font.
+  font_ = font;
+  if (auto hdc = GetDC(hwnd_)) {
+    auto old = SelectObject(hdc, font_ ? font_ : GetStockObject(SYSTEM_FIXED_FONT));
+    TEXTMETRIC tm = {};
+    GetTextMetrics(hdc, &tm);
+    SelectObject(hdc, old);
+    ReleaseDC(hwnd_, hdc);
+    line_height_ = std::max(1, static_cast<int>(tm.tmHeight));
+    char_width_ = std::max(1, static_cast<int>(tm.tmAveCharWidth));
+  }
+  advance_.assign(advance_.size(), char_width_);
+  update_scrollbars();
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void console_view::set_limits(std::size_t lines, std::size_t bytes)
+{
+  store_.set_limits(lines, bytes);
+}
+
+void console_view::append(const wchar_t* text, std::size_t size)
+{
+  // Follow the output if the last line is visible.
+  auto follow = top_ + rows() >= store_.size();
+
+  // Move the viewport and the selection with trimmed lines.
+  auto trimmed = store_.append(text, size);
+  if (!hwnd_) {
+    return;
+  }
+  if (trimmed) {
+    auto adjust = [trimmed](position& pos) {
+      if (pos.line < trimmed) {
+        pos = {};
+      } else {
+        pos.line -= trimmed;
+      }
+    };
+    top_ -= std::min(top_, trimmed);
+    adjust(anchor_);
+    adjust(caret_);
+  }
+
+  if (follow) {
+    auto size = store_.size();
+    top_ = size > rows() ? size - rows() : 0;
+  }
+  update_scrollbars();
+  if (follow || trimmed) {
+    InvalidateRect(hwnd_, nullptr, FALSE);
+  }
+}
+
+void console_view::copy()
+{
+  // Collect the selected text.
+  position begin = {};
+  position end = {};
+  if (!selection(begin, end)) {
+    return;
+  }
+  std::wstring text;
+  for (auto i = begin.line; i <= end.line && i < store_.size(); i++) {
+    auto line = store_.get(i);
+    auto from = i == begin.line ? std::min(begin.column, line.size) : 0;
+    auto to = i == end.line ? std::min(end.column, line.size) : line.size;
+    text.append(line.data + from, to - from);
+    if (i != end.line) {
+      text.append(L"\r\n");
+    }
+  }
+
+  // Copy the text to the clipboard.
+  if (!OpenClipboard(hwnd_)) {
+    return;
+  }
+  EmptyClipboard();
+  if (auto memory = GlobalAlloc(GMEM_MOVEABLE, (text.size() + 1) * sizeof(wchar_t))) {
+    if (auto data = GlobalLock(memory)) {
+      std::copy(text.c_str(), text.c_str() + text.size() + 1, static_cast<wchar_t*>(data));
+      GlobalUnlock(memory);
+      if (!SetClipboardData(CF_UNICODETEXT, memory)) {
+        GlobalFree(memory);
+      }
+    } else {
+      GlobalFree(memory);
+    }
+  }
+  CloseClipboard();
+}
+
+void console_view::set_pattern(const std::wstring& pattern)
+{
+  // Repaint the visible lines with the new highlights.
+  if (pattern == pattern_) {
+    return;
+  }
+  pattern_ = pattern;
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+std::vector<line_store::text> console_view::snapshot() const
+{
+  return store_.snapshot();
+}
+
+std::size_t console_view::memory() const
+{
+  return store_.memory();
+}
+
+void console_view::on_create()
+{
+  // Measure the default font.
+  set_font(nullptr);
+}
+
+void console_view::on_paint()
+{
+  PAINTSTRUCT ps = {};
+  auto hdc = BeginPaint(hwnd_, &ps);
+  auto old = SelectObject(hdc, font_ ? font_ : GetStockObject(SYSTEM_FIXED_FONT));
+
+  auto fg = GetSysColor(COLOR_WINDOWTEXT);
+  auto bg = GetSysColor(COLOR_WINDOW);
+  auto sfg = GetSysColor(COLOR_HIGHLIGHTTEXT);
+  auto sbg = GetSysColor(COLOR_HIGHLIGHT);
+
+  position begin = {};
+  position end = {};
+  auto selected = selection(begin, end);
+  auto columns = cols();
+  if (advance_.size() < columns) {
+    advance_.resize(columns, char_width_);
+  }
+
+  // Paint only the rows that intersect the update region.
+  auto first = std::max(0L, ps.rcPaint.top) / line_height_;
+  auto last = (ps.rcPaint.bottom + line_height_ - 1) / line_height_;
+  for (auto row = first; row < last; row++) {
+    auto y = static_cast<int>(row * line_height_);
+    auto fill = [&](int x0, int x1, COLORREF color) {
+      if (x1 > x0) {
+        RECT rc = { x0, y, x1, y + line_height_ };
+        SetBkColor(hdc, color);
+        ExtTextOut(hdc, 0, 0, ETO_OPAQUE, &rc, nullptr, 0, nullptr);
+      }
+    };
+
+    auto index = top_ + row;
+    if (index >= store_.size()) {
+      fill(ps.rcPaint.left, ps.rcPaint.right, bg);
+      continue;
+    }
+
+    // Split the line into the parts before, inside and after the selection.
+    auto line = store_.get(index);
+    auto s0 = line.size;
+    auto s1 = line.size;
+    if (selected && index >= begin.line && index <= end.line) {
+      s0 = index == begin.line ? std::min(begin.column, line.size) : 0;
+      s1 = index == end.line ? std::min(end.column, line.size) : line.size;
+    }
+
+    auto text = [&](std::size_t from, std::size_t to, COLORREF color, COLORREF background) {
+      from = std::max(from, left_);
+      to = std::min(to, left_ + columns);
+      if (from < to) {
+        RECT rc = { PADDING + static_cast<int>(from - left_) * char_width_, y, 0, y + line_height_ };
+        rc.right = rc.left + static_cast<int>(to - from) * char_width_;
+        SetTextColor(hdc, color);
+        SetBkColor(hdc, background);
+        ExtTextOutW(hdc, rc.left, y, ETO_OPAQUE | ETO_CLIPPED, &rc, line.data + from, static_cast<UINT>(to - from), advance_.data());
+      }
+    };
+
+    // Find the search matches in the visible part of the line.
+    matches_.clear();
+    if (!pattern_.empty()) {
+      auto end = line.data + std::min(line.size, left_ + columns + pattern_.size());
+      for (auto p = line.data; (p = text_find(p, end, pattern_.data(), pattern_.size())) != end; p += pattern_.size()) {
+        matches_.push_back(static_cast<std::size_t>(p - line.data));
+      }
+    }
+
+    // Paint the unselected parts with the matches highlighted.
+    auto plain = [&](std::size_t from, std::size_t to) {
+      for (auto match : matches_) {
+        auto m0 = std::max(from, match);
+        auto m1 = std::min(to, match + pattern_.size());
+        if (m0 < m1) {
+          text(from, m0, fg, bg);
+          text(m0, m1, fg, MATCH_COLOR);
+          from = m1;
+        }
+      }
+      text(from, to, fg, bg);
+    };
+
+    fill(0, PADDING, bg);
+    plain(0, s0);
+    text(s0, s1, sfg, sbg);
+    plain(s1, line.size);
+    auto visible = line.size > left_ ? std::min(line.size - left_, columns) : 0;
+    fill(PADDING + static_cast<int>(visible) * char_width_, cx_, bg);
+  }
+
+  SelectObject(hdc, old);
+  EndPaint(hwnd_, &ps);
+}
+
+void console_view::on_size(int cx, int cy)
+{
+  // Keep the bottom line in place when the view was following the output.
+  auto follow = top_ + rows() >= store_.size();
+  cx_ = cx;
+  cy_ = cy;
+  if (follow) {
+    auto size = store_.size();
+    top_ = size > rows() ? size - rows() : 0;
+  }
+  update_scrollbars();
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void console_view::on_vscroll(int code)
+{
+  auto top = static_cast<std::ptrdiff_t>(top_);
+  auto page = static_cast<std::ptrdiff_t>(rows());
+  switch (code) {
+  case SB_LINEUP:   scroll_to(top - 1, left_); break;
+  case SB_LINEDOWN: scroll_to(top + 1, left_); break;
+  case SB_PAGEUP:   scroll_to(top - page, left_); break;
+  case SB_PAGEDOWN: scroll_to(top + page, left_); break;
+  case SB_TOP:      scroll_to(0, left_); break;
+  case SB_BOTTOM:   scroll_to(store_.size(), left_); break;
+  case SB_THUMBTRACK:
+  case SB_THUMBPOSITION: {
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_TRACKPOS;
+    GetScrollInfo(hwnd_, SB_VERT, &si);
+    scroll_to(si.nTrackPos, left_);
+  } break;
+  }
+}
+
+void console_view::on_hscroll(int code)
+{
+  auto left = static_cast<std::ptrdiff_t>(left_);
+  auto page = static_cast<std::ptrdiff_t>(cols());
+  switch (code) {
+  case SB_LINELEFT:  scroll_to(top_, left - 1); break;
+  case SB_LINERIGHT: scroll_to(top_, left + 1); break;
+  case SB_PAGELEFT:  scroll_to(top_, left - page); break;
+  case SB_PAGERIGHT: scroll_to(top_, left + page); break;
+  case SB_LEFT:      scroll_to(top_, 0); break;
+  case SB_RIGHT:     scroll_to(top_, store_.columns()); break;
+  case SB_THUMBTRACK:
+  case SB_THUMBPOSITION: {
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_TRACKPOS;
+    GetScrollInfo(hwnd_, SB_HORZ, &si);
+    scroll_to(top_, si.nTrackPos);
+  } break;
+  }
+}
+
+void console_view::on_mousewheel(int delta)
+{
+  // Scroll by the system wheel setting and keep partial notches.
+  UINT lines = 3;
+  SystemParametersInfo(SPI_GETWHEELSCROLLLINES, 0, &lines, 0);
+  wheel_ += delta;
+  auto notches = wheel_ / WHEEL_DELTA;
+  wheel_ %= WHEEL_DELTA;
+  if (notches) {
+    auto step = lines == WHEEL_PAGESCROLL ? static_cast<std::ptrdiff_t>(rows()) : static_cast<std::ptrdiff_t>(lines);
+    scroll_to(static_cast<std::ptrdiff_t>(top_) - notches * step, left_);
+  }
+}
+
+void console_view::on_lbuttondown(int x, int y, bool extend)
+{
+  // Start a new selection or extend the current one.
+  SetFocus(hwnd_);
+  SetCapture(hwnd_);
+  caret_ = hit(x, y);
+  if (!extend) {
+    anchor_ = caret_;
+  }
+  selecting_ = true;
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void console_view::on_mousemove(int x, int y)
+{
+  if (!selecting_) {
+    return;
+  }
+
+  // Scroll while the mouse is dragged outside of the view.
+  if (y < 0) {
+    scroll_to(static_cast<std::ptrdiff_t>(top_) - 1, left_);
+  } else if (y >= cy_) {
+    scroll_to(static_cast<std::ptrdiff_t>(top_) + 1, left_);
+  }
+  caret_ = hit(x, y);
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void console_view::on_lbuttonup()
+{
+  selecting_ = false;
+  ReleaseCapture();
+}
+
+bool console_view::on_keydown(UINT key)
+{
+  auto control = GetKeyState(VK_CONTROL) < 0;
+  auto top = static_cast<std::ptrdiff_t>(top_);
+  auto page = static_cast<std::ptrdiff_t>(rows());
+  switch (key) {
+  case 'A':
+    if (!control || !store_.size()) {
+      return false;
+    }
+    anchor_ = {};
+    caret_ = { store_.size() - 1, store_.get(store_.size() - 1).size };
+    InvalidateRect(hwnd_, nullptr, FALSE);
+    return true;
+  case 'F':
+    if (!control) {
+      return false;
+    }
+    SendMessage(GetParent(hwnd_), WM_COMMAND, IDM_FIND, 0);
+    return true;
+  case 'C':
+  case VK_INSERT:
+    if (!control) {
+      return false;
+    }
+    copy();
+    return true;
+  case VK_UP:    scroll_to(top - 1, left_); return true;
+  case VK_DOWN:  scroll_to(top + 1, left_); return true;
+  case VK_PRIOR: scroll_to(top - page, left_); return true;
+  case VK_NEXT:  scroll_to(top + page, left_); return true;
+  case VK_HOME:  scroll_to(control ? 0 : top, 0); return true;
+  case VK_END:   scroll_to(control ? store_.size() : top_, control ? 0 : store_.columns()); return true;
+  }
+  return false;
+}
+
+std::size_t console_view::rows() const
+{
+  return static_cast<std::size_t>(std::max(1, cy_ / line_height_));
+}
+
+std::size_t console_view::cols() const
+{
+  return static_cast<std::size_t>(std::max(1, static_cast<int>(cx_ - PADDING) / char_width_ + 1));
+}
+
+void console_view::scroll_to(std::ptrdiff_t line, std::ptrdiff_t column)
+{
+  // Clamp the position to the content.
+  auto size = static_cast<std::ptrdiff_t>(store_.size());
+  auto page = static_cast<std::ptrdiff_t>(rows());
+  auto width = static_cast<std::ptrdiff_t>(store_.columns());
+  auto cols = static_cast<std::ptrdiff_t>(this->cols());
+  line = std::max<std::ptrdiff_t>(0, std::min(line, size - page));
+  column = std::max<std::ptrdiff_t>(0, std::min(column, width - cols + 1));
+
+  auto dy = line - static_cast<std::ptrdiff_t>(top_);
+  auto dx = column - static_cast<std::ptrdiff_t>(left_);
+  if (!dx && !dy) {
+    return;
+  }
+  top_ = static_cast<std::size_t>(line);
+  left_ = static_cast<std::size_t>(column);
+
+  // Move the pixels that stay visible and only repaint the exposed rows.
+  if (!dx && dy > -page && dy < page) {
+    ScrollWindowEx(hwnd_, 0, static_cast<int>(-dy * line_height_), nullptr, nullptr, nullptr, nullptr, SW_INVALIDATE);
+  } else {
+    InvalidateRect(hwnd_, nullptr, FALSE);
+  }
+  update_scrollbars();
+}
+
+void console_view::update_scrollbars()
+{
+  auto limit = static_cast<std::size_t>(INT_MAX);
+
+  SCROLLINFO si = {};
+  si.cbSize = sizeof(si);
+  si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+  si.nMax = static_cast<int>(std::min(store_.size() ? store_.size() - 1 : 0, limit));
+  si.nPage = static_cast<UINT>(rows());
+  si.nPos = static_cast<int>(std::min(top_, limit));
+  SetScrollInfo(hwnd_, SB_VERT, &si, TRUE);
+
+  si.nMax = static_cast<int>(std::min(store_.columns(), limit));
+  si.nPage = static_cast<UINT>(cols());
+  si.nPos = static_cast<int>(std::min(left_, limit));
+  SetScrollInfo(hwnd_, SB_HORZ, &si, TRUE);
+}
+
+console_view::position console_view::hit(int x, int y) const
+{
+  // Convert client coordinates to a line and column in the store.
+  if (!store_.size()) {
+    return {};
+  }
+  auto row = y < 0 ? -1 : y / line_height_;
+  auto line = static_cast<std::ptrdiff_t>(top_) + row;
+  line = std::max<std::ptrdiff_t>(0, std::min<std::ptrdiff_t>(line, store_.size() - 1));
+  auto column = static_cast<std::size_t>(std::max(0L, (x - PADDING + char_width_ / 2) / char_width_)) + left_;
+  return { static_cast<std::size_t>(line), std::min(column, store_.get(static_cast<std::size_t>(line)).size) };
+}
+
+bool console_view::selection(position& begin, position& end) const
+{
+  // Order the anchor and the caret.
+  if (anchor_.line == caret_.line && anchor_.column == caret_.column) {
+    return false;
+  }
+  auto forward = anchor_.line < caret_.line || (anchor_.line == caret_.line && anchor_.column < caret_.column);
+  begin = forward ? anchor_ : caret_;
+  end = forward ? caret_ : anchor_;
+  return true;
+}
+
+bool console_view::on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
+{
+  // Handle the messages that are not part of the message map.
+  switch (msg) {
+  case WM_SETFONT:
+    set_font(reinterpret_cast<HFONT>(wparam));
+    return true;
+  case WM_GETFONT:
+    result = reinterpret_cast<LRESULT>(font_);
+    return true;
+  case WM_ERASEBKGND:
+    result = 1;
+    return true;
+  case WM_LBUTTONDOWN:
+  case WM_LBUTTONDBLCLK:
+    on_lbuttondown(GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam), (wparam & MK_SHIFT) != 0);
+    return true;
+  case WM_CAPTURECHANGED:
+    selecting_ = false;
+    return true;
+  case WM_COPY:
+    copy();
+    return true;
+  }
+  return false;
+}
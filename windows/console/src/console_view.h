@@ -0,0 +1,86 @@
+#pragma once
+#include "line_store.h"
+#include "window_base.h"
+#include <windows.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Owner-drawn console control that only paints the lines in the viewport.
+class console_view : public window_base<console_view> {
+public:
+  console_view(HINSTANCE instance);
+
+  // Creates the control as a child of the given window.
+  HWND create(HWND parent);
+
+  void set_font(HFONT font);
+  void set_limits(std::size_t lines, std::size_t bytes);
+
+  // Appends text and scrolls to the bottom if the last line was visible.
+  void append(const wchar_t* text, std::size_t size);
+
+  // Copies the selected text to the clipboard.
+  void copy();
+
+  // Highlights the occurrences of the pattern in the painted lines. An empty pattern removes the highlights.
+  void set_pattern(const std::wstring& pattern);
+
+  // Returns the text of all lines for a search on another thread.
+  std::vector<line_store::text> snapshot() const;
+
+  // Returns the number of bytes held by the line store.
+  std::size_t memory() const;
+
+private:
+  friend struct window_messages;
+
+  struct position {
+    std::size_t line;
+    std::size_t column;
+  };
+
+  void on_create();
+  void on_paint();
+  void on_size(int cx, int cy);
+  void on_vscroll(int code);
+  void on_hscroll(int code);
+  void on_mousewheel(int delta);
+  void on_lbuttondown(int x, int y, bool extend);
+  void on_mousemove(int x, int y);
+  void on_lbuttonup();
+  bool on_keydown(UINT key);
+  using messages = message_list<WM_SETFONT, WM_GETFONT, WM_ERASEBKGND, WM_LBUTTONDOWN, WM_LBUTTONDBLCLK,
+    WM_CAPTURECHANGED, WM_COPY>;
+  bool on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result);
+
+  std::size_t rows() const;
+  std::size_t cols() const;
+
+  void scroll_to(std::ptrdiff_t line, std::ptrdiff_t column);
+  void update_scrollbars();
+  position hit(int x, int y) const;
+  bool selection(position& begin, position& end) const;
+
+  HINSTANCE instance_;
+  HFONT font_ = nullptr;
+
+  line_store store_;
+
+  int cx_ = 0;
+  int cy_ = 0;
+  int line_height_ = 1;
+  int char_width_ = 1;
+  int wheel_ = 0;
+  std::vector<INT> advance_;
+
+  std::size_t top_ = 0;
+  std::size_t left_ = 0;
+
+  position anchor_ = {};
+  position caret_ = {};
+  bool selecting_ = false;
+
+  std::wstring pattern_;
+  std::vector<std::size_t> matches_;
+};
@@ -0,0 +1,199 @@
+#include "instance_channel.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <sddl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+namespace {
+
+// Security attributes whose DACL only grants the current user access, so that other users of
+// the session can neither write into the ring nor signal the event of the primary instance.
+class user_security {
+public:
+  user_security()
+  {
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+      return;
+    }
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    std::vector<char> user(size);
+    LPWSTR sid = nullptr;
+    if (size && GetTokenInformation(token, TokenUser, user.data(), size, &size) &&
+        ConvertSidToStringSid(reinterpret_cast<TOKEN_USER*>(user.data())->User.Sid, &sid)) {
+      auto sddl = std::wstring(L"D:P(A;;GA;;;") + sid + L")";
+      LocalFree(sid);
+      ConvertStringSecurityDescriptorToSecurityDescriptor(sddl.c_str(), SDDL_REVISION_1, &descriptor_, nullptr);
+    }
+    CloseHandle(token);
+    attributes_.nLength = sizeof(attributes_);
+    attributes_.lpSecurityDescriptor = descriptor_;
+    attributes_.bInheritHandle = FALSE;
+  }
+
+  ~user_security()
+  {
+    LocalFree(descriptor_);
+  }
+
+  user_security(const user_security& other) = delete;
+  user_security& operator=(const user_security& other) = delete;
+
+  // Returns null if the descriptor could not be created.
+  SECURITY_ATTRIBUTES* get()
+  {
+    return descriptor_ ? &attributes_ : nullptr;
+  }
+
+private:
+  PSECURITY_DESCRIPTOR descriptor_ = nullptr;
+  SECURITY_ATTRIBUTES attributes_ = {};
+};
+
+}  // namespace
+#endif
+
+instance_channel::~instance_channel()
+{
+  close();
+}
+
+bool instance_channel::open(const std::wstring& name, std::size_t capacity)
+{
+  close();
+  size_ = ipc_ring::size(capacity);
+
+#ifdef _WIN32
+  // Do not fall back to the default DACL, which may grant access to other users.
+  user_security security;
+  if (!security.get()) {
+    return false;
+  }
+
+  // The event decides which process is the primary instance, because it is created first.
+  event_ = CreateEvent(security.get(), FALSE, FALSE, name.c_str());
+  if (!event_) {
+    return false;
+  }
+  primary_ = GetLastError() != ERROR_ALREADY_EXISTS;
+
+  // New file mappings are zero-filled, which is an empty ring.
+  auto high = static_cast<DWORD>(static_cast<std::uint64_t>(size_) >> 32);
+  auto low = static_cast<DWORD>(size_);
+  mapping_ = CreateFileMapping(INVALID_HANDLE_VALUE, security.get(), PAGE_READWRITE, high, low, (name + L" Ring").c_str());
+  if (!mapping_) {
+    close();
+    return false;
+  }
+  memory_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+  if (!memory_) {
+    close();
+    return false;
+  }
+#else
+  // Shared memory names are a single path component.
+  name_ = "/";
+  for (auto c : name) {
+    name_ += (c == L'/' || c == L' ' || c > 0x7F) ? '_' : static_cast<char>(c);
+  }
+  auto fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  primary_ = fd >= 0;
+  if (!primary_) {
+    fd = shm_open(name_.c_str(), O_RDWR, 0600);
+  }
+  if (fd < 0) {
+    return false;
+  }
+
+  // Growing a shared memory object zero-fills it. Both sides set the size so that the order does not matter.
+  if (ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+    ::close(fd);
+    close();
+    return false;
+  }
+  memory_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory_ == MAP_FAILED) {
+    memory_ = nullptr;
+    close();
+    return false;
+  }
+#endif
+
+  ring_.reset(new ipc_ring(memory_, size_));
+  return true;
+}
+
+bool instance_channel::send(const std::wstring& message, unsigned timeout)
+{
+  if (!ring_) {
+    return false;
+  }
+
+  // Wait for the primary instance to drain a full ring.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  while (!ring_->write(message.data(), message.size() * sizeof(wchar_t))) {
+    if (message.size() * sizeof(wchar_t) + 8 > ring_->capacity() || std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+#ifdef _WIN32
+    SetEvent(event_);
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+#ifdef _WIN32
+  SetEvent(event_);
+#endif
+  return true;
+}
+
+std::size_t instance_channel::receive(std::vector<std::wstring>& messages)
+{
+  std::size_t count = 0;
+  while (ring_ && ring_->read(buffer_)) {
+    std::wstring message(buffer_.size() / sizeof(wchar_t), L'\0');
+    if (!message.empty()) {
+      std::memcpy(&message[0], buffer_.data(), message.size() * sizeof(wchar_t));
+    }
+    messages.push_back(std::move(message));
+    count++;
+  }
+  return count;
+}
+
+void instance_channel::close()
+{
+  ring_.reset();
+#ifdef _WIN32
+  if (memory_) {
+    UnmapViewOfFile(memory_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+  }
+  if (event_) {
+    CloseHandle(event_);
+  }
+  mapping_ = nullptr;
+  event_ = nullptr;
+#else
+  if (memory_) {
+    munmap(memory_, size_);
+  }
+  if (primary_) {
+    shm_unlink(name_.c_str());
+  }
+#endif
+  memory_ = nullptr;
+  primary_ = false;
+}
@@ -0,0 +1,182 @@
+#include "line_store.h"
+#include <algorithm>
+#include <cstring>
+
+#define TAB_SIZE 8  // tab stop width in columns
+
+line_store::line_store(std::size_t chunk_size) : chunk_size_(std::max<std::size_t>(chunk_size, 256))
+{}
+
+void line_store::set_limits(std::size_t max_lines, std::size_t max_bytes)
+{
+  max_lines_ = std::max<std::size_t>(max_lines, 1);
+  max_chars_ = std::max<std::size_t>(max_bytes / sizeof(wchar_t), 1);
+}
+
+std::size_t line_store::append(const wchar_t* text, std::size_t size)
+{
+  static const wchar_t spaces[TAB_SIZE + 1] = L"        ";
+
+  std::size_t i = 0;
+  while (i < size) {
+    // Copy runs of regular characters at once.
+    auto j = i;
+    while (j < size && text[j] != L'\r' && text[j] != L'\n' && text[j] != L'\t') {
+      j++;
+    }
+    if (j > i) {
+      write(text + i, j - i);
+    }
+    if (j == size) {
+      break;
+    }
+
+    // Expand tabs and terminate lines.
+    if (text[j] == L'\t') {
+      auto column = open_ ? lines_.back().size : 0;
+      write(spaces, TAB_SIZE - column % TAB_SIZE);
+    } else {
+      if (text[j] == L'\r' && j + 1 < size && text[j + 1] == L'\n') {
+        j++;
+      }
+      close();
+    }
+    i = j + 1;
+  }
+  return trim();
+}
+
+void line_store::clear()
+{
+  chunks_.clear();
+  chunk_base_ = 0;
+  lines_.clear();
+  open_ = false;
+  chars_ = 0;
+  columns_ = 0;
+}
+
+line_store::line line_store::get(std::size_t index) const
+{
+  const auto& r = lines_[index];
+  return { chunks_[static_cast<std::size_t>(r.chunk - chunk_base_)].data.get() + r.offset, r.size };
+}
+
+std::vector<line_store::text> line_store::snapshot() const
+{
+  // Start at the first line in the chunk that owns it, which may follow trimmed lines.
+  std::vector<text> texts;
+  if (lines_.empty()) {
+    return texts;
+  }
+  const auto& first = lines_.front();
+  std::size_t offset = first.offset;
+  for (auto i = static_cast<std::size_t>(first.chunk - chunk_base_); i < chunks_.size(); i++) {
+    const auto& c = chunks_[i];
+    texts.push_back({ c.data, c.data.get() + offset, c.size - offset });
+    offset = 0;
+  }
+  return texts;
+}
+
+std::size_t line_store::size() const
+{
+  return lines_.size();
+}
+
+std::size_t line_store::columns() const
+{
+  return columns_;
+}
+
+std::size_t line_store::memory() const
+{
+  std::size_t size = lines_.size() * sizeof(record);
+  for (const auto& c : chunks_) {
+    size += c.capacity * sizeof(wchar_t);
+  }
+  return size;
+}
+
+void line_store::write(const wchar_t* text, std::size_t size)
+{
+  // Make sure that the open line and the text fit into the last chunk.
+  reserve(size);
+  auto& c = chunks_.back();
+  if (!open_) {
+    lines_.push_back({ chunk_base_ + chunks_.size() - 1, static_cast<std::uint32_t>(c.size), 0 });
+    open_ = true;
+  }
+  auto& r = lines_.back();
+  if (size) {
+    std::memcpy(c.data.get() + c.size, text, size * sizeof(wchar_t));
+  }
+  c.size += size;
+  r.size += static_cast<std::uint32_t>(size);
+  chars_ += size;
+  columns_ = std::max<std::size_t>(columns_, r.size);
+}
+
+void line_store::reserve(std::size_t size)
+{
+  if (!chunks_.empty() && chunks_.back().capacity - chunks_.back().size >= size) {
+    return;
+  }
+
+  // Allocate a new chunk and move the open line into it.
+  std::size_t line_size = open_ ? lines_.back().size : 0;
+  chunk c;
+  c.capacity = std::max(chunk_size_, (line_size + size) * 2);
+  c.data.reset(new wchar_t[c.capacity], std::default_delete<wchar_t[]>());
+  if (open_) {
+    auto& r = lines_.back();
+    auto& old = chunks_[static_cast<std::size_t>(r.chunk - chunk_base_)];
+    std::memcpy(c.data.get(), old.data.get() + r.offset, line_size * sizeof(wchar_t));
+    old.size = r.offset;
+    c.size = line_size;
+    r.chunk = chunk_base_ + chunks_.size();
+    r.offset = 0;
+  }
+  chunks_.push_back(std::move(c));
+}
+
+void line_store::close()
+{
+  // Terminate the open line or add an empty one.
+  if (!open_) {
+    write(nullptr, 0);
+  }
+
+  // Store the line break so that searches over a chunk never match across lines.
+  reserve(1);
+  auto& c = chunks_.back();
+  c.data.get()[c.size++] = L'\n';
+  open_ = false;
+  chars_++;
+}
+
+std::size_t line_store::trim()
+{
+  // Wait until a whole chunk of an eighth of the limits is exceeded.
+  auto lines = lines_.size();
+  auto over_lines = lines > max_lines_ && lines - max_lines_ > max_lines_ / 8;
+  auto over_chars = chars_ > max_chars_ && chars_ - max_chars_ > max_chars_ / 8;
+
+  // Remove terminated lines until both limits are met.
+  std::size_t count = 0;
+  if (over_lines || over_chars) {
+    while (lines_.size() > (open_ ? 1 : 0) && (lines_.size() > max_lines_ || chars_ > max_chars_)) {
+      chars_ -= lines_.front().size + 1;
+      lines_.pop_front();
+      count++;
+    }
+  }
+
+  // Release the chunks that are no longer referenced. This is also needed below the limits, because the
+  // first line moves into a new chunk when it outgrows its chunk while it is open.
+  while (chunks_.size() > 1 && (lines_.empty() || chunk_base_ < lines_.front().chunk)) {
+    chunks_.pop_front();
+    chunk_base_++;
+  }
+  return count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Chunked text storage with a line index for the owner-drawn console view.
+// Lines never span chunks and tabs are expanded. Terminated lines are followed by a line break in their chunk,
+// which is not part of the line.
+class line_store {
+public:
+  struct line {
+    const wchar_t* data;
+    std::size_t size;
+  };
+
+  // Text of consecutive lines separated by line breaks. The owner keeps the chunk alive.
+  struct text {
+    std::shared_ptr<const wchar_t> owner;
+    const wchar_t* data;
+    std::size_t size;
+  };
+
+  explicit line_store(std::size_t chunk_size = 1 << 16);
+
+  // Sets the scrollback limits. Old lines are trimmed once a limit is exceeded by a whole chunk.
+  void set_limits(std::size_t max_lines, std::size_t max_bytes);
+
+  // Appends text and returns the number of lines that were trimmed from the head.
+  std::size_t append(const wchar_t* text, std::size_t size);
+
+  // Removes all lines.
+  void clear();
+
+  // Returns the line at the given index.
+  line get(std::size_t index) const;
+
+  // Returns the text of all lines per chunk. Appended text is written behind the returned ranges and trimmed
+  // chunks are kept by the owners, so the snapshot can be read by other threads while the store changes.
+  std::vector<text> snapshot() const;
+
+  // Returns the number of lines including the unterminated last line.
+  std::size_t size() const;
+
+  // Returns the length of the longest line that was ever appended.
+  std::size_t columns() const;
+
+  // Returns the number of bytes held by the chunks and the line index.
+  std::size_t memory() const;
+
+private:
+  struct chunk {
+    std::shared_ptr<wchar_t> data;
+    std::size_t capacity = 0;
+    std::size_t size = 0;
+  };
+
+  struct record {
+    std::uint64_t chunk;
+    std::uint32_t offset;
+    std::uint32_t size;
+  };
+
+  void write(const wchar_t* text, std::size_t size);
+  void reserve(std::size_t size);
+  void close();
+  std::size_t trim();
+
+  std::size_t chunk_size_ = 0;
+  std::deque<chunk> chunks_;
+  std::uint64_t chunk_base_ = 0;
+  std::deque<record> lines_;
+  bool open_ = false;
+
+  std::size_t max_lines_ = static_cast<std::size_t>(-1);
+  std::size_t max_chars_ = static_cast<std::size_t>(-1);
+  std::size_t chars_ = 0;
+  std::size_t columns_ = 0;
+};
@@ -0,0 +1,387 @@
+#include "log_mirror.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const std::size_t record_header = 16;
+
+std::size_t record_size(std::size_t size)
+{
+  return record_header + ((size + 7) & ~std::size_t(7));
+}
+
+// Computes the CRC-32 (IEEE 802.3) of the data eight bytes at a time with tables that are built on first use.
+// Pass the CRC of the preceding data to continue it.
+std::uint32_t crc32(const char* data, std::size_t size, std::uint32_t crc = 0)
+{
+  static const auto table = []() {
+    std::vector<std::uint32_t> table(8 * 256);
+    for (std::uint32_t i = 0; i < 256; i++) {
+      auto c = i;
+      for (auto k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+    for (std::size_t i = 256; i < table.size(); i++) {
+      table[i] = (table[i - 256] >> 8) ^ table[table[i - 256] & 0xFF];
+    }
+    return table;
+  }();
+  auto t = table.data();
+  auto p = reinterpret_cast<const unsigned char*>(data);
+  crc ^= 0xFFFFFFFF;
+  for (; size >= 8; size -= 8, p += 8) {
+    auto lo = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | static_cast<std::uint32_t>(p[3]) << 24);
+    auto hi = p[4] | p[5] << 8 | p[6] << 16 | static_cast<std::uint32_t>(p[7]) << 24;
+    crc = t[7 * 256 + (lo & 0xFF)] ^ t[6 * 256 + ((lo >> 8) & 0xFF)] ^ t[5 * 256 + ((lo >> 16) & 0xFF)] ^ t[4 * 256 + (lo >> 24)] ^
+      t[3 * 256 + (hi & 0xFF)] ^ t[2 * 256 + ((hi >> 8) & 0xFF)] ^ t[256 + ((hi >> 16) & 0xFF)] ^ t[hi >> 24];
+  }
+  for (; size; size--, p++) {
+    crc = t[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+// Scans the records of a segment. Returns the end of the last complete record and sets the sequence
+// number of the last record, which stays zero if the segment has no complete records.
+std::size_t scan(const char* data, std::size_t size, std::uint64_t& last, const log_mirror::record_handler* handler)
+{
+  std::size_t pos = 0;
+  last = 0;
+  while (pos + record_header <= size) {
+    std::uint32_t length = 0;
+    std::uint32_t crc = 0;
+    std::uint64_t sequence = 0;
+    std::memcpy(&length, data + pos, 4);
+    std::memcpy(&crc, data + pos + 4, 4);
+    std::memcpy(&sequence, data + pos + 8, 8);
+    if (!length || record_size(length) > size - pos || !sequence || (last && sequence != last + 1)) {
+      break;
+    }
+    if (crc32(data + pos + record_header, length) != crc) {
+      break;
+    }
+    if (handler) {
+      (*handler)(sequence, data + pos + record_header, length);
+    }
+    last = sequence;
+    pos += record_size(length);
+  }
+  return pos;
+}
+
+}  // namespace
+
+log_mirror::~log_mirror()
+{
+  close();
+}
+
+void log_mirror::open(const std::string& base, std::size_t segment_size, std::size_t segments, unsigned flush_interval)
+{
+  close();
+  if (segment_size < 4096 || segments < 2) {
+    throw std::runtime_error("Invalid log mirror segment configuration.");
+  }
+  base_ = base;
+  segment_size_ = segment_size & ~std::size_t(7);
+  segments_ = segments;
+  flush_interval_ = flush_interval;
+
+  // Continue after the newest complete record. Segments are created and preallocated on first use.
+  std::size_t newest = 0;
+  std::size_t end = 0;
+  sequence_ = 0;
+  tail_.clear();
+  for (std::size_t i = 0; i < segments_; i++) {
+    segment s;
+    map(path(base_, i), segment_size_, s);
+    std::uint64_t last = 0;
+    auto pos = scan(s.data, s.size, last, nullptr);
+    if (last > sequence_) {
+      sequence_ = last;
+      newest = i;
+      end = pos;
+    }
+    unmap(s);
+  }
+  prepare(current_, newest);
+  current_.written = end;
+  current_.flushed = end;
+
+  stop_ = false;
+  next_ready_ = false;
+  previous_pending_ = false;
+  error_.clear();
+  thread_ = std::thread([this]() {
+    run();
+  });
+}
+
+void log_mirror::close()
+{
+  // Write the unterminated last line. Errors were reported by append already.
+  if (current_.data && !tail_.empty()) {
+    try {
+      write(tail_.data(), tail_.size(), "", 0);
+    }
+    catch (const std::exception&) {
+    }
+    tail_.clear();
+  }
+
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+  }
+
+  // Flush the written records before the segments are released.
+  if (previous_pending_) {
+    retire(previous_);
+    previous_pending_ = false;
+  }
+  if (current_.data) {
+    retire(current_);
+  }
+  if (next_ready_) {
+    unmap(next_);
+    next_ready_ = false;
+  }
+}
+
+void log_mirror::append(const char* data, std::size_t size)
+{
+  if (!current_.data) {
+    return;
+  }
+
+  // Keep the unterminated last line for the next append.
+  auto end = size;
+  while (end && data[end - 1] != '\n') {
+    end--;
+  }
+  if (!end) {
+    if (tail_.size() + size <= segment_size_ - record_header) {
+      tail_.append(data, size);
+      return;
+    }
+    end = size;
+  }
+  write(tail_.data(), tail_.size(), data, end);
+  tail_.assign(data + end, size - end);
+}
+
+void log_mirror::write(const char* head, std::size_t head_size, const char* data, std::size_t size)
+{
+  // Split data that does not fit into one segment.
+  auto written = current_.written.load(std::memory_order_relaxed);
+  while (head_size + size) {
+    auto chunk = std::min(head_size + size, segment_size_ - record_header);
+    auto first = std::min(chunk, head_size);
+    auto need = record_size(chunk);
+    if (written + need > current_.size) {
+      if (rotate()) {
+        written = 0;
+        continue;
+      }
+
+      // Drop the rest rather than leave a gap inside of it.
+      auto max = segment_size_ - record_header;
+      drops_.fetch_add((head_size + size + max - 1) / max, std::memory_order_relaxed);
+      return;
+    }
+
+    // Write the header after the payload. Torn records are detected by the checksum.
+    auto record = current_.data + written;
+    auto crc = crc32(data, chunk - first, first ? crc32(head, first) : 0);
+    auto length = static_cast<std::uint32_t>(chunk);
+    auto sequence = ++sequence_;
+    std::memcpy(record + record_header, head, first);
+    std::memcpy(record + record_header + first, data, chunk - first);
+    std::memset(record + record_header + chunk, 0, need - record_header - chunk);
+    std::memcpy(record + 4, &crc, 4);
+    std::memcpy(record + 8, &sequence, 8);
+    std::memcpy(record, &length, 4);
+
+    written += need;
+    current_.written.store(written, std::memory_order_release);
+    records_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(chunk, std::memory_order_relaxed);
+    head += first;
+    head_size -= first;
+    data += chunk - first;
+    size -= chunk - first;
+  }
+}
+
+log_mirror::statistics log_mirror::stats() const
+{
+  statistics stats;
+  stats.records = records_.load(std::memory_order_relaxed);
+  stats.bytes = bytes_.load(std::memory_order_relaxed);
+  stats.rotations = rotations_.load(std::memory_order_relaxed);
+  stats.drops = drops_.load(std::memory_order_relaxed);
+  stats.flushes = flushes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::size_t log_mirror::read(const std::string& path, const record_handler& handler)
+{
+  std::vector<char> data;
+  if (!load(path, data)) {
+    return 0;
+  }
+  std::size_t count = 0;
+  record_handler counter = [&](std::uint64_t sequence, const char* record, std::size_t size) {
+    handler(sequence, record, size);
+    count++;
+  };
+  std::uint64_t last = 0;
+  scan(data.data(), data.size(), last, &counter);
+  return count;
+}
+
+bool log_mirror::recover(const std::string& base, std::size_t segments, std::uint64_t& sequence, std::string& data)
+{
+  // The newest segment holds the record with the highest sequence number.
+  sequence = 0;
+  std::vector<char> file;
+  for (std::size_t i = 0; i < segments; i++) {
+    if (!load(path(base, i), file)) {
+      continue;
+    }
+    std::uint64_t last = 0;
+    record_handler keep = [&](std::uint64_t number, const char* record, std::size_t size) {
+      if (number > sequence) {
+        sequence = number;
+        data.assign(record, size);
+      }
+    };
+    scan(file.data(), file.size(), last, &keep);
+  }
+  return sequence != 0;
+}
+
+std::string log_mirror::path(const std::string& base, std::size_t index)
+{
+  return base + "." + std::to_string(index) + ".log";
+}
+
+void log_mirror::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    try {
+      // Release the full segment first so that the writer can rotate again.
+      if (previous_pending_) {
+        lock.unlock();
+        retire(previous_);
+        lock.lock();
+        previous_pending_ = false;
+        continue;
+      }
+
+      // Map the next segment ahead of time.
+      if (!next_ready_) {
+        auto index = (current_.index + 1) % segments_;
+        lock.unlock();
+        prepare(next_, index);
+        lock.lock();
+        next_ready_ = true;
+        continue;
+      }
+
+      // Start writing back the new records of the current segment.
+      // The writer may rotate meanwhile, but only this thread releases the segment.
+      auto written = current_.written.load(std::memory_order_acquire);
+      if (written > current_.flushed) {
+        segment view;
+        view.file = current_.file;
+        view.mapping = current_.mapping;
+        view.data = current_.data;
+        view.size = current_.size;
+        auto flushed = current_.flushed;
+        lock.unlock();
+        flush(view, flushed, written - flushed, false);
+        lock.lock();
+        if (current_.data == view.data) {
+          current_.flushed = written;
+        }
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    catch (const std::exception& e) {
+      // Let the writer report the error when it needs the next segment.
+      if (!lock.owns_lock()) {
+        lock.lock();
+      }
+      error_ = e.what();
+      return;
+    }
+    wake_.wait_for(lock, std::chrono::milliseconds(flush_interval_), [this]() {
+      return stop_ || previous_pending_;
+    });
+  }
+}
+
+bool log_mirror::rotate()
+{
+  // Hand the full segment to the flush thread and continue in the prepared one. Waiting for the flush
+  // thread could block the writer for as long as a segment takes to reach the disk.
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!error_.empty()) {
+    throw std::runtime_error(error_);
+  }
+  if (!next_ready_ || previous_pending_) {
+    return false;
+  }
+  move(current_, previous_);
+  move(next_, current_);
+  previous_pending_ = true;
+  next_ready_ = false;
+  rotations_.fetch_add(1, std::memory_order_relaxed);
+  lock.unlock();
+  wake_.notify_all();
+  return true;
+}
+
+void log_mirror::prepare(segment& s, std::size_t index)
+{
+  map(path(base_, index), segment_size_, s);
+  s.index = index;
+  s.written = 0;
+  s.flushed = 0;
+}
+
+void log_mirror::retire(segment& s)
+{
+  auto written = s.written.load(std::memory_order_acquire);
+  if (written > s.flushed) {
+    flush(s, s.flushed, written - s.flushed, true);
+  }
+  unmap(s);
+}
+
+void log_mirror::move(segment& from, segment& to)
+{
+  to.file = from.file;
+  to.mapping = from.mapping;
+  to.data = from.data;
+  to.size = from.size;
+  to.index = from.index;
+  to.written.store(from.written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  to.flushed = from.flushed;
+  from.file = {};
+  from.mapping = {};
+  from.data = nullptr;
+  from.size = 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Mirrors console output into a fixed set of preallocated, memory-mapped segment files that are reused in turn.
+// Appending copies a checksummed record into the mapped segment. A background thread flushes the written
+// ranges asynchronously, prepares the next segment ahead of time and releases full segments. The writer
+// never waits for it: records that need a segment before the thread has one ready are dropped and counted.
+//
+// Records end on line boundaries. The unterminated last line of an append is kept until a later append or
+// close() completes it, unless it grows beyond a segment.
+//
+// Record layout: 32 bit payload size, 32 bit CRC-32 of the payload, 64 bit sequence number, payload padded
+// to 8 bytes. Sequence numbers increase by one across segments, so a reader stops at the first record that
+// is zero, torn or left over from an older use of the segment.
+class log_mirror {
+public:
+#ifdef _WIN32
+  using native_handle = void*;
+#else
+  using native_handle = int;
+#endif
+
+  // Called by read() with the sequence number and the payload of each complete record.
+  using record_handler = std::function<void(std::uint64_t sequence, const char* data, std::size_t size)>;
+
+  struct statistics {
+    std::uint64_t records = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t rotations = 0;
+    std::uint64_t drops = 0;     // records dropped because the flush thread had no segment ready
+    std::uint64_t flushes = 0;
+  };
+
+  log_mirror() = default;
+  ~log_mirror();
+
+  log_mirror(const log_mirror& other) = delete;
+  log_mirror& operator=(const log_mirror& other) = delete;
+
+  // Opens the segments <base>.0.log to <base>.<count - 1>.log of the given size and continues after the
+  // newest record found in them. Starts the flush thread. Throws on errors.
+  void open(const std::string& base, std::size_t segment_size = 64 << 20, std::size_t segments = 4, unsigned flush_interval = 100);
+
+  // Stops the flush thread, flushes all written records and unmaps the segments.
+  void close();
+
+  bool is_open() const
+  {
+    return current_.data != nullptr;
+  }
+
+  // Appends the complete lines of the data as one or more records. Must only be called from one thread at a time.
+  void append(const char* data, std::size_t size);
+
+  statistics stats() const;
+
+  // Calls the handler for every complete record of a segment file in order and returns the number of records.
+  static std::size_t read(const std::string& path, const record_handler& handler);
+
+  // Finds the last complete record in the segments of a mirror after a crash. Returns false if there is none.
+  static bool recover(const std::string& base, std::size_t segments, std::uint64_t& sequence, std::string& data);
+
+  // Returns the path of a segment file.
+  static std::string path(const std::string& base, std::size_t index);
+
+private:
+  struct segment {
+    native_handle file = {};
+    native_handle mapping = {};
+    char* data = nullptr;
+    std::size_t size = 0;
+    std::size_t index = 0;
+    std::atomic<std::size_t> written = { 0 };
+    std::size_t flushed = 0;
+  };
+
+  void run();
+  void write(const char* head, std::size_t head_size, const char* data, std::size_t size);
+  bool rotate();
+  void prepare(segment& s, std::size_t index);
+  void retire(segment& s);
+  static void move(segment& from, segment& to);
+
+  // Implemented by the platform backend.
+  static void map(const std::string& path, std::size_t size, segment& s);
+  static void flush(segment& s, std::size_t offset, std::size_t size, bool wait);
+  static void unmap(segment& s);
+  static bool load(const std::string& path, std::vector<char>& data);
+
+  std::string base_;
+  std::size_t segment_size_ = 0;
+  std::size_t segments_ = 0;
+  unsigned flush_interval_ = 0;
+  std::uint64_t sequence_ = 0;
+  std::string tail_;
+
+  // The current segment is written by the writer. The next segment is prepared and the previous one
+  // is flushed and released by the flush thread.
+  segment current_;
+  segment next_;
+  segment previous_;
+  bool next_ready_ = false;
+  bool previous_pending_ = false;
+
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::string error_;
+
+  std::atomic<std::uint64_t> records_ = { 0 };
+  std::atomic<std::uint64_t> bytes_ = { 0 };
+  std::atomic<std::uint64_t> rotations_ = { 0 };
+  std::atomic<std::uint64_t> drops_ = { 0 };
+  std::atomic<std::uint64_t> flushes_ = { 0 };
+};
@@ -0,0 +1,86 @@
+#ifndef _WIN32
+#include "log_mirror.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdexcept>
+
+void log_mirror::map(const std::string& path, std::size_t size, segment& s)
+{
+  auto file = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (file < 0) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+
+  // Reserve the blocks of new segments so that page faults never extend the file.
+  struct stat st = {};
+  if (fstat(file, &st) || static_cast<std::size_t>(st.st_size) < size) {
+#ifdef __linux__
+    auto error = posix_fallocate(file, 0, static_cast<off_t>(size));
+#else
+    auto error = ftruncate(file, static_cast<off_t>(size));
+#endif
+    if (error) {
+      ::close(file);
+      throw std::runtime_error("Could not allocate " + path + ".");
+    }
+  }
+
+  auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if (data == MAP_FAILED) {
+    ::close(file);
+    throw std::runtime_error("Could not map " + path + ".");
+  }
+  s.file = file;
+  s.mapping = file;
+  s.data = static_cast<char*>(data);
+  s.size = size;
+}
+
+void log_mirror::flush(segment& s, std::size_t offset, std::size_t size, bool wait)
+{
+  // The range must start at a page boundary.
+  static const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  auto begin = offset & ~(page - 1);
+  msync(s.data + begin, offset + size - begin, wait ? MS_SYNC : MS_ASYNC);
+}
+
+void log_mirror::unmap(segment& s)
+{
+  if (s.data) {
+    munmap(s.data, s.size);
+    ::close(s.file);
+  }
+  s.file = {};
+  s.mapping = {};
+  s.data = nullptr;
+  s.size = 0;
+}
+
+bool log_mirror::load(const std::string& path, std::vector<char>& data)
+{
+  auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    return false;
+  }
+  struct stat st = {};
+  if (fstat(file, &st)) {
+    ::close(file);
+    return false;
+  }
+  data.resize(static_cast<std::size_t>(st.st_size));
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    auto size = ::read(file, data.data() + pos, data.size() - pos);
+    if (size <= 0) {
+      break;
+    }
+    pos += static_cast<std::size_t>(size);
+  }
+  data.resize(pos);
+  ::close(file);
+  return true;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifdef _WIN32
+#include "log_mirror.h"
+#include "utf.h"
+#include <windows.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+HANDLE open_file(const std::string& path, DWORD access, DWORD disposition)
+{
+  std::wstring name;
+  utf8_to_utf16(path.c_str(), name);
+  return CreateFile(name.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+}
+
+}  // namespace
+
+void log_mirror::map(const std::string& path, std::size_t size, segment& s)
+{
+  auto file = open_file(path, GENERIC_READ | GENERIC_WRITE, OPEN_ALWAYS);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+
+  // Extend new segments to their full size so that page faults never extend the file.
+  LARGE_INTEGER current = {};
+  LARGE_INTEGER length = {};
+  length.QuadPart = static_cast<LONGLONG>(size);
+  if (!GetFileSizeEx(file, &current) || current.QuadPart < length.QuadPart) {
+    if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+      CloseHandle(file);
+      throw std::runtime_error("Could not allocate " + path + ".");
+    }
+  }
+
+  auto mapping = CreateFileMapping(file, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    throw std::runtime_error("Could not map " + path + ".");
+  }
+  auto data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (!data) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    throw std::runtime_error("Could not map " + path + ".");
+  }
+  s.file = file;
+  s.mapping = mapping;
+  s.data = static_cast<char*>(data);
+  s.size = size;
+}
+
+void log_mirror::flush(segment& s, std::size_t offset, std::size_t size, bool wait)
+{
+  // FlushViewOfFile starts writing the dirty pages and FlushFileBuffers waits for them.
+  FlushViewOfFile(s.data + offset, size);
+  if (wait) {
+    FlushFileBuffers(s.file);
+  }
+}
+
+void log_mirror::unmap(segment& s)
+{
+  if (s.data) {
+    UnmapViewOfFile(s.data);
+    CloseHandle(s.mapping);
+    CloseHandle(s.file);
+  }
+  s.file = {};
+  s.mapping = {};
+  s.data = nullptr;
+  s.size = 0;
+}
+
+bool log_mirror::load(const std::string& path, std::vector<char>& data)
+{
+  auto file = open_file(path, GENERIC_READ, OPEN_EXISTING);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size = {};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  data.resize(static_cast<std::size_t>(size.QuadPart));
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    DWORD chunk = 0;
+    auto request = static_cast<DWORD>(std::min<std::size_t>(data.size() - pos, 1 << 30));
+    if (!ReadFile(file, data.data() + pos, request, &chunk, nullptr) || !chunk) {
+      break;
+    }
+    pos += chunk;
+  }
+  data.resize(pos);
+  CloseHandle(file);
+  return true;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "log_queue.h"
+#include <cstdint>
+
+log_queue::log_queue(std::size_t capacity)
+{
+  // Round the capacity up to a power of two.
+  std::size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  cells_.reset(new cell[size]);
+  mask_ = size - 1;
+  for (std::size_t i = 0; i < size; i++) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool log_queue::push(std::string str)
+{
+  auto wake = false;
+  if (!try_push(str, wake)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return wake;
+}
+
+bool log_queue::try_push(std::string& str, bool& wake)
+{
+  // Reserve a cell.
+  auto pos = head_.load(std::memory_order_relaxed);
+  cell* c = nullptr;
+  for (;;) {
+    c = &cells_[pos & mask_];
+    auto seq = c->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      wake = false;
+      return false;
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Publish the string.
+  c->data = std::move(str);
+  c->sequence.store(pos + 1, std::memory_order_release);
+
+  // Only the first producer after a drain signals the consumer.
+  wake = !signaled_.exchange(true, std::memory_order_acq_rel);
+  return true;
+}
+
+std::size_t log_queue::drain(std::string& out, std::size_t limit)
+{
+  // Clear the signal before reading so that new strings trigger another wakeup.
+  signaled_.exchange(false, std::memory_order_acq_rel);
+
+  std::size_t count = 0;
+  auto pos = tail_.load(std::memory_order_relaxed);
+  while (out.size() < limit) {
+    auto& c = cells_[pos & mask_];
+    if (c.sequence.load(std::memory_order_acquire) != pos + 1) {
+      break;
+    }
+
+    // Split a string that does not fit at a UTF-8 character boundary and leave the rest queued.
+    auto room = limit - out.size();
+    if (c.data.size() > room) {
+      auto size = room;
+      while (size > 0 && (static_cast<unsigned char>(c.data[size]) & 0xC0) == 0x80) {
+        size--;
+      }
+      if (!size && out.empty()) {
+        size = room;
+      }
+      out.append(c.data, 0, size);
+      c.data.erase(0, size);
+      break;
+    }
+    out.append(c.data);
+    c.data.clear();
+    c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    pos++;
+    count++;
+  }
+  tail_.store(pos, std::memory_order_relaxed);
+  return count;
+}
+
+std::size_t log_queue::depth() const
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  auto tail = tail_.load(std::memory_order_relaxed);
+  return head > tail ? head - tail : 0;
+}
+
+std::size_t log_queue::dropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+std::size_t log_queue::reset_dropped()
+{
+  return dropped_.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+
+// Bounded lock-free multi-producer single-consumer queue of log strings.
+class log_queue {
+public:
+  explicit log_queue(std::size_t capacity = 65536);
+
+  // Queues a string from any thread.
+  // Returns true if the caller is responsible for waking up the consumer.
+  bool push(std::string str);
+
+  // Queues a string from any thread unless the queue is full. A rejected string is left untouched and is not
+  // counted as dropped, so the producer can retry it after the consumer drained the queue.
+  // Returns false if the queue is full. Sets wake if the caller is responsible for waking up the consumer.
+  bool try_push(std::string& str, bool& wake);
+
+  // Appends queued strings to the output buffer without exceeding the size limit. A string that does not fit
+  // is split at a UTF-8 character boundary and its rest stays queued.
+  // Must only be called from the consumer thread. Returns the number of complete strings.
+  std::size_t drain(std::string& out, std::size_t limit = std::numeric_limits<std::size_t>::max());
+
+  // Returns the number of queued strings.
+  std::size_t depth() const;
+
+  // Returns the number of strings that were dropped because the queue was full.
+  std::size_t dropped() const;
+
+  // Returns the number of dropped strings and resets the counter.
+  std::size_t reset_dropped();
+
+private:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    std::string data;
+  };
+
+  std::unique_ptr<cell[]> cells_;
+  std::size_t mask_ = 0;
+
+  alignas(64) std::atomic<std::size_t> head_ = { 0 };
+  alignas(64) std::atomic<std::size_t> tail_ = { 0 };
+  alignas(64) std::atomic<std::size_t> dropped_ = { 0 };
+  std::atomic<bool> signaled_ = { false };
+};
@@ -1,22 +1,45 @@
+#include "clock.h"
+#include "coroutine.h"
+#include "event_loop.h"
+#include "instance_channel.h"
+#include "thread_pool.h"
+#include "tracer.h"
 #include "window.h"
 #include <windows.h>
 #include <commctrl.h>
 #include <resource.h>
 #include <clocale>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define CHANNEL_POLL_INTERVAL 100  // milliseconds between reads while a message is not written yet
 
 int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, LPWSTR cmd, int show)
 {
+  // Start the startup benchmark and the startup trace.
+  auto start = clock_ticks();
+  trace_begin();
+
   // Initialize the locale.
   std::setlocale(LC_ALL, "");
+  trace_phase("setlocale");
 
-  // Check if another instance of this application is already running.
-  auto event = CreateEvent(NULL, TRUE, FALSE, PRODUCT);
-  if (event && GetLastError() == ERROR_ALREADY_EXISTS) {
-    MessageBox(nullptr, L"This application is already running.", PROJECT, MB_OK | MB_ICONASTERISK | MB_SETFOREGROUND);
-    return 0;
+  // Forward the command line to the instance that is already running and exit without creating a window.
+  instance_channel channel;
+  if (!channel.open(PRODUCT)) {
+    MessageBox(nullptr, L"Could not create the single instance channel.", PROJECT, MB_OK | MB_ICONERROR | MB_SETFOREGROUND);
+    return 1;
+  }
+  if (!channel.primary()) {
+    AllowSetForegroundWindow(ASFW_ANY);
+    return channel.send(cmd) ? 0 : 1;
   }
+  trace_phase("instance_channel");
 
-  // Initialize common controls.
+#ifndef CONSOLE_FAST_START
+  // Initialize common controls. The fast start mode does this after the window was shown.
   INITCOMMONCONTROLSEX icc = {
     sizeof(INITCOMMONCONTROLSEX),
     ICC_STANDARD_CLASSES
@@ -25,21 +48,81 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, LPWSTR cmd, int show)
     MessageBox(nullptr, L"Could not initialize common controls.", PROJECT, MB_OK | MB_ICONERROR | MB_SETFOREGROUND);
     return 1;
   }
+  trace_phase("InitCommonControlsEx");
 
   // Load the richedit library.
   if (!LoadLibrary(L"RICHED20.DLL")) {
     MessageBox(nullptr, L"Could not load the richedit library.", PROJECT, MB_OK | MB_ICONERROR | MB_SETFOREGROUND);
     return 1;
   }
+  trace_phase("LoadLibrary");
+#endif
 
-  // Create the main application window.
-  window window(instance);
+  // Create the event loop, the background thread pool and the main application window.
+  // Continuations of background work are posted to the event loop.
+  event_loop loop;
+  thread_pool pool(0, [&loop](thread_pool::task t) {
+    loop.post(std::move(t));
+  });
+  trace_phase("thread_pool");
+
+#ifdef COROUTINES
+  // Report exceptions that escape coroutines like other event loop errors.
+  async::set_error_handler([](std::exception_ptr e, void* context) {
+    static_cast<event_loop*>(context)->post([e]() {
+      std::rethrow_exception(e);
+    });
+  }, &loop);
+#endif
+
+  window window(instance, loop, pool);
+  window.measure_startup(start);
+
+  // Pass the command lines of later instances to the window in batches. While a later instance
+  // has reserved a message but not written it yet, poll until it arrives or the channel skips it.
+  timer_wheel::timer channel_timer;
+  std::function<void()> receive = [&channel, &window, &loop, &channel_timer]() {
+    std::vector<std::wstring> commands;
+    if (channel.receive(commands)) {
+      window.open(commands);
+    }
+    if (channel.stalled()) {
+      loop.timers().schedule(channel_timer, CHANNEL_POLL_INTERVAL);
+    }
+  };
+  channel_timer.bind([](void* context) {
+    (*static_cast<std::function<void()>*>(context))();
+  }, &receive);
+  loop.add(channel.event(), receive);
 
-  // Run the main message loop.
-  MSG msg = {};
-  while (GetMessage(&msg, nullptr, 0, 0)) {
-    TranslateMessage(&msg);
-    DispatchMessage(&msg);
+#ifdef CONSOLE_CAPTURE
+  // Capture the output of this process.
+  window.capture_output();
+#endif
+
+#ifdef CONSOLE_MIRROR
+  // Mirror the console output to log segments.
+  window.mirror_output();
+#endif
+
+#ifdef CONSOLE_RUN
+  // Run the command line as a child process and stream its output into the console.
+  if (cmd && *cmd) {
+    window.run(cmd);
   }
-  return static_cast<int>(msg.wParam);
+#endif
+
+  // Run the main loop.
+  auto result = loop.run();
+
+#ifdef TRACER
+  // Save the trace next to the executable. The trace is optional and errors are ignored at exit.
+  try {
+    tracer::instance().save();
+  }
+  catch (const std::exception&) {
+  }
+#endif
+
+  return result;
 }
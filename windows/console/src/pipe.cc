@@ -0,0 +1,55 @@
+#include "pipe.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+scoped_handle::scoped_handle(HANDLE value) : value_(value == INVALID_HANDLE_VALUE ? nullptr : value)
+{}
+
+scoped_handle::~scoped_handle()
+{
+  reset();
+}
+
+HANDLE scoped_handle::get() const
+{
+  return value_;
+}
+
+void scoped_handle::reset(HANDLE value)
+{
+  if (value_) {
+    CloseHandle(value_);
+  }
+  value_ = value == INVALID_HANDLE_VALUE ? nullptr : value;
+}
+
+HANDLE scoped_handle::release()
+{
+  auto value = value_;
+  value_ = nullptr;
+  return value;
+}
+
+void create_pipe(scoped_handle& read, scoped_handle& write, DWORD size, bool inherit)
+{
+  // Anonymous pipes do not support overlapped I/O, so create a uniquely named pipe instead.
+  static std::atomic<unsigned> counter = { 0 };
+  auto name = L"\\\\.\\pipe\\console." + std::to_wstring(GetCurrentProcessId()) + L"." + std::to_wstring(counter++);
+
+  auto mode = PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS;
+  auto access = PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE;
+  scoped_handle server(CreateNamedPipe(name.c_str(), access, mode, 1, 0, size, 0, nullptr));
+  if (!server.get()) {
+    throw std::runtime_error("Could not create the pipe.");
+  }
+
+  SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, inherit ? TRUE : FALSE };
+  scoped_handle client(CreateFile(name.c_str(), GENERIC_WRITE, 0, &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+  if (!client.get()) {
+    throw std::runtime_error("Could not open the pipe.");
+  }
+
+  read.reset(server.release());
+  write.reset(client.release());
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <windows.h>
+
+// Closes the owned kernel handle on destruction.
+class scoped_handle {
+public:
+  scoped_handle(HANDLE value = nullptr);
+  ~scoped_handle();
+
+  scoped_handle(const scoped_handle& other) = delete;
+  scoped_handle& operator=(const scoped_handle& other) = delete;
+
+  HANDLE get() const;
+  void reset(HANDLE value = nullptr);
+  HANDLE release();
+
+private:
+  HANDLE value_;
+};
+
+// Creates a pipe whose read end supports overlapped I/O. Throws on failure.
+void create_pipe(scoped_handle& read, scoped_handle& write, DWORD size, bool inherit);
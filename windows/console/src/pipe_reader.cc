@@ -0,0 +1,102 @@
+#include "pipe_reader.h"
+#include <algorithm>
+
+pipe_reader::pipe_reader(data_handler data, close_handler close, std::size_t buffer_size, std::size_t max_pending) :
+  data_(std::move(data)), close_(std::move(close)), buffer_size_(buffer_size), max_pending_(max_pending)
+{}
+
+pipe_reader::~pipe_reader()
+{
+  stop();
+}
+
+void pipe_reader::start(native_handle out, native_handle err)
+{
+  // Restart the reader thread with a fresh backpressure state.
+  stop();
+  stop_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = 0;
+  }
+  setup();
+  thread_ = std::thread([this, out, err]() {
+    run(out, err);
+  });
+}
+
+void pipe_reader::stop()
+{
+  if (!thread_.joinable()) {
+    return;
+  }
+
+  // Wake up the reader thread if it waits for data or for credit.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  credit_.notify_all();
+  wake();
+  thread_.join();
+  teardown();
+}
+
+void pipe_reader::consume(std::size_t size)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ -= std::min(pending_, size);
+    acknowledged_++;
+  }
+  credit_.notify_all();
+}
+
+pipe_reader::statistics pipe_reader::stats() const
+{
+  statistics stats;
+  stats.bytes = bytes_.load(std::memory_order_relaxed);
+  stats.reads = reads_.load(std::memory_order_relaxed);
+  stats.stalls = stalls_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.pending = pending_;
+  return stats;
+}
+
+bool pipe_reader::deliver(int stream, const char* data, std::size_t size)
+{
+  bytes_.fetch_add(size, std::memory_order_relaxed);
+  reads_.fetch_add(1, std::memory_order_relaxed);
+  for (;;) {
+    // Account for the data before the consumer can acknowledge it. The acknowledgements are counted before the
+    // handler runs, so one that arrives after a rejection is not missed.
+    std::uint64_t acknowledged = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ += size;
+      acknowledged = acknowledged_;
+    }
+    if (data_(stream, data, size)) {
+      break;
+    }
+
+    // Give the credit back and wait until the consumer made room for the rejected data.
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_ -= std::min(pending_, size);
+    if (!stop_) {
+      stalls_.fetch_add(1, std::memory_order_relaxed);
+      credit_.wait(lock, [this, acknowledged]() { return acknowledged_ != acknowledged || stop_; });
+    }
+    if (stop_) {
+      return false;
+    }
+  }
+
+  // Stop reading until the consumer catches up.
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pending_ >= max_pending_ && !stop_) {
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    credit_.wait(lock, [this]() { return pending_ < max_pending_ || stop_; });
+  }
+  return !stop_;
+}
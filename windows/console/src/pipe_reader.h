@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Reads pipes on a background thread into reusable buffers and applies backpressure.
+// Reading pauses while the consumer has not acknowledged more than max_pending bytes, and while the consumer
+// rejects data because its queue is full.
+class pipe_reader {
+public:
+#ifdef _WIN32
+  using native_handle = void*;
+#else
+  using native_handle = int;
+#endif
+
+  // Called on the reader thread with the stream index and the data that was read.
+  // Returns false if the consumer can not take the data yet, in which case it is delivered again after the next
+  // call to consume().
+  using data_handler = std::function<bool(int stream, const char* data, std::size_t size)>;
+
+  // Called on the reader thread once all pipes were closed.
+  using close_handler = std::function<void()>;
+
+  struct statistics {
+    std::uint64_t bytes = 0;
+    std::uint64_t reads = 0;
+    std::uint64_t stalls = 0;
+    std::size_t pending = 0;
+  };
+
+  pipe_reader(data_handler data, close_handler close, std::size_t buffer_size = 1 << 16, std::size_t max_pending = 1 << 22);
+  ~pipe_reader();
+
+  pipe_reader(const pipe_reader& other) = delete;
+  pipe_reader& operator=(const pipe_reader& other) = delete;
+
+  // Takes ownership of the pipe read ends and starts the reader thread.
+  // On Windows the pipes must be opened for overlapped I/O.
+  void start(native_handle out, native_handle err);
+
+  // Stops the reader thread and closes the pipes.
+  void stop();
+
+  // Acknowledges that the consumer applied the given number of delivered bytes.
+  void consume(std::size_t size);
+
+  statistics stats() const;
+
+private:
+  // Implemented by the platform backend.
+  void setup();
+  void run(native_handle out, native_handle err);
+  void wake();
+  void teardown();
+
+  // Delivers data to the handler and blocks while the consumer rejects it or is too far behind.
+  // Returns false if the reader was stopped.
+  bool deliver(int stream, const char* data, std::size_t size);
+
+  data_handler data_;
+  close_handler close_;
+  std::size_t buffer_size_;
+  std::size_t max_pending_;
+
+  std::thread thread_;
+  std::atomic<bool> stop_ = { false };
+  native_handle wake_[2] = {};
+
+  mutable std::mutex mutex_;
+  std::condition_variable credit_;
+  std::size_t pending_ = 0;
+  std::uint64_t acknowledged_ = 0;
+
+  std::atomic<std::uint64_t> bytes_ = { 0 };
+  std::atomic<std::uint64_t> reads_ = { 0 };
+  std::atomic<std::uint64_t> stalls_ = { 0 };
+};
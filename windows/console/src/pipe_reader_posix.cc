@@ -0,0 +1,88 @@
+#ifndef _WIN32
+#include "pipe_reader.h"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+
+void pipe_reader::setup()
+{
+  // Create the self-pipe that interrupts poll when the reader is stopped.
+  int fds[2] = {};
+  if (pipe(fds)) {
+    throw std::runtime_error("Could not create the wake pipe.");
+  }
+  wake_[0] = fds[0];
+  wake_[1] = fds[1];
+}
+
+void pipe_reader::run(native_handle out, native_handle err)
+{
+  std::unique_ptr<char[]> buffer(new char[buffer_size_]);
+  int fds[2] = { out, err };
+  auto open = (out >= 0 ? 1 : 0) + (err >= 0 ? 1 : 0);
+
+  // Read whichever pipe is ready into the shared buffer.
+  while (open > 0 && !stop_) {
+    pollfd entries[3] = {};
+    int streams[3] = { -1, -1, -1 };
+    nfds_t count = 0;
+    entries[count++] = { wake_[0], POLLIN, 0 };
+    for (auto i = 0; i < 2; i++) {
+      if (fds[i] >= 0) {
+        streams[count] = i;
+        entries[count++] = { fds[i], POLLIN, 0 };
+      }
+    }
+    if (poll(entries, count, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    for (nfds_t n = 1; n < count && !stop_; n++) {
+      if (!entries[n].revents) {
+        continue;
+      }
+      auto i = streams[n];
+      auto size = read(fds[i], buffer.get(), buffer_size_);
+      if (size > 0) {
+        deliver(i, buffer.get(), static_cast<std::size_t>(size));
+      } else if (size == 0 || (errno != EINTR && errno != EAGAIN)) {
+        // The write end was closed.
+        ::close(fds[i]);
+        fds[i] = -1;
+        open--;
+      }
+    }
+  }
+
+  for (auto fd : fds) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  if (!open && !stop_ && close_) {
+    close_();
+  }
+}
+
+void pipe_reader::wake()
+{
+  char c = 0;
+  while (write(wake_[1], &c, 1) < 0 && errno == EINTR) {
+  }
+}
+
+void pipe_reader::teardown()
+{
+  ::close(wake_[0]);
+  ::close(wake_[1]);
+  wake_[0] = -1;
+  wake_[1] = -1;
+}
+
+#endif
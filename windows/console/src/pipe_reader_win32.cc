@@ -0,0 +1,119 @@
+#ifdef _WIN32
+#include "pipe_reader.h"
+#include <windows.h>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+struct operation {
+  OVERLAPPED overlapped = {};
+  HANDLE pipe = nullptr;
+  std::unique_ptr<char[]> buffer;
+  bool pending = false;
+};
+
+}  // namespace
+
+void pipe_reader::setup()
+{
+  // Create the completion port that receives the read completions and the stop signal.
+  wake_[0] = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+  if (!wake_[0]) {
+    throw std::runtime_error("Could not create the I/O completion port.");
+  }
+}
+
+void pipe_reader::run(native_handle out, native_handle err)
+{
+  auto port = static_cast<HANDLE>(wake_[0]);
+  auto size = static_cast<DWORD>(buffer_size_);
+
+  operation ops[2];
+  HANDLE pipes[2] = { out, err };
+
+  auto read = [&](int i) {
+    auto& op = ops[i];
+    op.overlapped = {};
+    if (!ReadFile(op.pipe, op.buffer.get(), size, nullptr, &op.overlapped) && GetLastError() != ERROR_IO_PENDING) {
+      return false;
+    }
+    op.pending = true;
+    return true;
+  };
+
+  // Associate the pipes with the completion port and issue the first reads.
+  auto open = 0;
+  for (auto i = 0; i < 2; i++) {
+    if (!pipes[i] || pipes[i] == INVALID_HANDLE_VALUE) {
+      continue;
+    }
+    ops[i].pipe = pipes[i];
+    ops[i].buffer.reset(new char[buffer_size_]);
+    if (CreateIoCompletionPort(pipes[i], port, static_cast<ULONG_PTR>(i + 1), 0) && read(i)) {
+      open++;
+    } else {
+      CloseHandle(ops[i].pipe);
+      ops[i].pipe = nullptr;
+    }
+  }
+
+  // Deliver completed reads and reuse the buffers for the next read.
+  while (open > 0 && !stop_) {
+    DWORD bytes = 0;
+    ULONG_PTR key = 0;
+    LPOVERLAPPED overlapped = nullptr;
+    auto ok = GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, INFINITE);
+    if (!overlapped) {
+      if (!ok) {
+        break;
+      }
+      continue;
+    }
+
+    auto i = static_cast<int>(key - 1);
+    ops[i].pending = false;
+    if (ok) {
+      if (bytes && !deliver(i, ops[i].buffer.get(), bytes)) {
+        break;
+      }
+      if (read(i)) {
+        continue;
+      }
+    }
+
+    // The write end was closed.
+    CloseHandle(ops[i].pipe);
+    ops[i].pipe = nullptr;
+    open--;
+  }
+
+  // Cancel outstanding reads and wait for them before the buffers are released.
+  for (auto& op : ops) {
+    if (op.pipe) {
+      if (op.pending) {
+        DWORD bytes = 0;
+        CancelIoEx(op.pipe, &op.overlapped);
+        GetOverlappedResult(op.pipe, &op.overlapped, &bytes, TRUE);
+      }
+      CloseHandle(op.pipe);
+    }
+  }
+
+  if (!open && !stop_ && close_) {
+    close_();
+  }
+}
+
+void pipe_reader::wake()
+{
+  PostQueuedCompletionStatus(static_cast<HANDLE>(wake_[0]), 0, 0, nullptr);
+}
+
+void pipe_reader::teardown()
+{
+  CloseHandle(static_cast<HANDLE>(wake_[0]));
+  wake_[0] = nullptr;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "process.h"
+#include "pipe.h"
+#include <stdexcept>
+#include <vector>
+
+#define PIPE_BUFFER_SIZE (1 << 16)  // size of the pipe and read buffers
+
+process::process(pipe_reader::data_handler data, pipe_reader::close_handler close) :
+  reader_(std::move(data), std::move(close), PIPE_BUFFER_SIZE)
+{}
+
+process::~process()
+{
+  stop();
+}
+
+void process::start(const std::wstring& command)
+{
+  stop();
+
+  // Create the output pipes and an input handle that is always at the end of file.
+  scoped_handle out_read;
+  scoped_handle out_write;
+  create_pipe(out_read, out_write, PIPE_BUFFER_SIZE, true);
+
+  scoped_handle err_read;
+  scoped_handle err_write;
+  create_pipe(err_read, err_write, PIPE_BUFFER_SIZE, true);
+
+  SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, TRUE };
+  scoped_handle input(CreateFile(L"NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, nullptr));
+  if (!input.get()) {
+    throw std::runtime_error("Could not open the input device.");
+  }
+
+  // Only let the child process inherit the redirected handles.
+  HANDLE inherit[] = { input.get(), out_write.get(), err_write.get() };
+  SIZE_T size = 0;
+  InitializeProcThreadAttributeList(nullptr, 1, 0, &size);
+  std::vector<char> attributes(size);
+  auto list = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributes.data());
+  if (!InitializeProcThreadAttributeList(list, 1, 0, &size)) {
+    throw std::runtime_error("Could not initialize the process attributes.");
+  }
+  UpdateProcThreadAttribute(list, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inherit, sizeof(inherit), nullptr, nullptr);
+
+  STARTUPINFOEX si = {};
+  si.StartupInfo.cb = sizeof(si);
+  si.StartupInfo.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+  si.StartupInfo.wShowWindow = SW_HIDE;
+  si.StartupInfo.hStdInput = input.get();
+  si.StartupInfo.hStdOutput = out_write.get();
+  si.StartupInfo.hStdError = err_write.get();
+  si.lpAttributeList = list;
+
+  // Start the process.
+  std::wstring cmd = command;
+  PROCESS_INFORMATION pi = {};
+  auto flags = CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT;
+  auto ok = CreateProcess(nullptr, &cmd[0], nullptr, nullptr, TRUE, flags, nullptr, nullptr, &si.StartupInfo, &pi);
+  DeleteProcThreadAttributeList(list);
+  if (!ok) {
+    throw std::runtime_error("Could not start the process.");
+  }
+  CloseHandle(pi.hThread);
+  process_ = pi.hProcess;
+
+  // Close the write ends so that the reader sees the end of the output when the process exits.
+  out_write.reset();
+  err_write.reset();
+
+  reader_.start(out_read.release(), err_read.release());
+}
+
+void process::stop()
+{
+  reader_.stop();
+  if (process_) {
+    CloseHandle(process_);
+    process_ = nullptr;
+  }
+}
+
+bool process::exited(DWORD& code) const
+{
+  return process_ && GetExitCodeProcess(process_, &code) && code != STILL_ACTIVE;
+}
+
+bool process::running() const
+{
+  return process_ != nullptr;
+}
+
+void process::consume(std::size_t size)
+{
+  reader_.consume(size);
+}
+
+pipe_reader::statistics process::stats() const
+{
+  return reader_.stats();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "pipe_reader.h"
+#include <windows.h>
+#include <string>
+
+// Child process with its standard output and error streamed through a pipe reader.
+class process {
+public:
+  process(pipe_reader::data_handler data, pipe_reader::close_handler close);
+  ~process();
+
+  // Starts the command line with redirected output. Throws on failure.
+  void start(const std::wstring& command);
+
+  // Stops reading the output and releases the process handle without terminating the process.
+  void stop();
+
+  // Returns true and sets the exit code if the process has exited.
+  bool exited(DWORD& code) const;
+
+  // Returns true if a process was started and not stopped.
+  bool running() const;
+
+  // Acknowledges output that was written to the console.
+  void consume(std::size_t size);
+
+  pipe_reader::statistics stats() const;
+
+private:
+  pipe_reader reader_;
+  HANDLE process_ = nullptr;
+};
@@ -0,0 +1,198 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <stdexcept>
+#endif
+
+namespace {
+
+struct message_name {
+  unsigned msg;
+  const char* name;
+};
+
+// Names of the messages that usually show up in a profile.
+const message_name names[] = {
+  { 0x0001, "WM_CREATE" },
+  { 0x0002, "WM_DESTROY" },
+  { 0x0003, "WM_MOVE" },
+  { 0x0005, "WM_SIZE" },
+  { 0x0006, "WM_ACTIVATE" },
+  { 0x0007, "WM_SETFOCUS" },
+  { 0x0008, "WM_KILLFOCUS" },
+  { 0x000F, "WM_PAINT" },
+  { 0x0010, "WM_CLOSE" },
+  { 0x0014, "WM_ERASEBKGND" },
+  { 0x0018, "WM_SHOWWINDOW" },
+  { 0x001C, "WM_ACTIVATEAPP" },
+  { 0x0020, "WM_SETCURSOR" },
+  { 0x0024, "WM_GETMINMAXINFO" },
+  { 0x0030, "WM_SETFONT" },
+  { 0x0046, "WM_WINDOWPOSCHANGING" },
+  { 0x0047, "WM_WINDOWPOSCHANGED" },
+  { 0x0081, "WM_NCCREATE" },
+  { 0x0082, "WM_NCDESTROY" },
+  { 0x0083, "WM_NCCALCSIZE" },
+  { 0x0084, "WM_NCHITTEST" },
+  { 0x0085, "WM_NCPAINT" },
+  { 0x0086, "WM_NCACTIVATE" },
+  { 0x00A0, "WM_NCMOUSEMOVE" },
+  { 0x0100, "WM_KEYDOWN" },
+  { 0x0101, "WM_KEYUP" },
+  { 0x0102, "WM_CHAR" },
+  { 0x0110, "WM_INITDIALOG" },
+  { 0x0111, "WM_COMMAND" },
+  { 0x0112, "WM_SYSCOMMAND" },
+  { 0x0113, "WM_TIMER" },
+  { 0x0114, "WM_HSCROLL" },
+  { 0x0115, "WM_VSCROLL" },
+  { 0x0116, "WM_INITMENU" },
+  { 0x011F, "WM_MENUSELECT" },
+  { 0x0200, "WM_MOUSEMOVE" },
+  { 0x0201, "WM_LBUTTONDOWN" },
+  { 0x0202, "WM_LBUTTONUP" },
+  { 0x020A, "WM_MOUSEWHEEL" },
+  { 0x0215, "WM_CAPTURECHANGED" },
+  { 0x0231, "WM_ENTERSIZEMOVE" },
+  { 0x0232, "WM_EXITSIZEMOVE" },
+  { 0x02A3, "WM_MOUSELEAVE" },
+  { 0x0301, "WM_COPY" },
+};
+
+std::string name(unsigned msg)
+{
+  char buffer[32] = {};
+  for (const auto& n : names) {
+    if (n.msg == msg) {
+      std::snprintf(buffer, sizeof(buffer), "%s", n.name);
+      return buffer;
+    }
+  }
+  if (msg >= 0x8000 && msg < 0xC000) {
+    std::snprintf(buffer, sizeof(buffer), "WM_APP + %u", msg - 0x8000);
+  } else if (msg >= 0x0400 && msg < 0x8000) {
+    std::snprintf(buffer, sizeof(buffer), "WM_USER + %u", msg - 0x0400);
+  } else {
+    std::snprintf(buffer, sizeof(buffer), "0x%04X", msg);
+  }
+  return buffer;
+}
+
+}  // namespace
+
+profiler::profiler(double budget_ms) :
+  budget_(static_cast<std::uint64_t>(budget_ms * 1e6)), scale_(1e9 / clock_frequency())
+{}
+
+profiler& profiler::instance()
+{
+  static profiler instance;
+  return instance;
+}
+
+std::string profiler::report() const
+{
+  struct row {
+    unsigned msg;
+    const entry* e;
+  };
+
+  // Sort the messages by the total time spent in their handlers.
+  std::vector<row> rows;
+  for (unsigned hi = 0; hi < 256; hi++) {
+    if (!pages_[hi]) {
+      continue;
+    }
+    for (unsigned lo = 0; lo < 256; lo++) {
+      if (auto& e = pages_[hi]->entries[lo]) {
+        rows.push_back({ (hi << 8) | lo, e.get() });
+      }
+    }
+  }
+  std::sort(rows.begin(), rows.end(), [](const row& a, const row& b) {
+    return a.e->latency.sum() > b.e->latency.sum();
+  });
+
+  std::string out;
+  char line[160] = {};
+  auto format = [&](const std::string& label, const histogram& h, std::uint64_t over) {
+    std::snprintf(line, sizeof(line), "%-24s %10llu %10.1f %8.1f %8.1f %8.1f %9.1f %6llu\n",
+      label.c_str(), static_cast<unsigned long long>(h.count()), h.sum() / 1e6,
+      h.percentile(50) / 1e3, h.percentile(90) / 1e3, h.percentile(99) / 1e3, h.max() / 1e3,
+      static_cast<unsigned long long>(over));
+    out += line;
+  };
+
+  std::snprintf(line, sizeof(line), "%-24s %10s %10s %8s %8s %8s %9s %6s\n",
+    "message", "count", "total ms", "p50 us", "p90 us", "p99 us", "max us", "slow");
+  out += line;
+  for (const auto& r : rows) {
+    format(name(r.msg), r.e->latency, r.e->over_budget);
+  }
+  format("(outside handlers)", outside_, 0);
+  return out;
+}
+
+void profiler::reset()
+{
+  for (auto& p : pages_) {
+    p.reset();
+  }
+  outside_.reset();
+  last_ = 0;
+}
+
+#ifdef _WIN32
+std::wstring profiler::save() const
+{
+  // Use the executable name with a profile extension.
+  std::wstring path(MAX_PATH, L'\0');
+  auto size = GetModuleFileName(nullptr, &path[0], static_cast<DWORD>(path.size()));
+  if (!size || size >= path.size()) {
+    throw std::runtime_error("Could not determine the profile file name.");
+  }
+  path.resize(size);
+  path += L".profile.txt";
+
+  auto text = report();
+  auto file = _wfopen(path.c_str(), L"wb");
+  if (!file) {
+    throw std::runtime_error("Could not create the profile file.");
+  }
+  auto written = std::fwrite(text.data(), 1, text.size(), file);
+  std::fclose(file);
+  if (written != text.size()) {
+    throw std::runtime_error("Could not write the profile file.");
+  }
+  return path;
+}
+#endif
+
+profiler::entry& profiler::create(unsigned msg)
+{
+  auto& p = pages_[(msg >> 8) & 0xFF];
+  if (!p) {
+    p.reset(new page);
+  }
+  auto& e = p->entries[msg & 0xFF];
+  e.reset(new entry);
+  return *e;
+}
+
+void profiler::over_budget(unsigned msg, entry& e, std::uint64_t ns)
+{
+  // Flag the slow handler in the debugger output.
+  e.over_budget++;
+#ifdef _WIN32
+  char text[96] = {};
+  std::snprintf(text, sizeof(text), "slow message handler: %s took %.1f ms\n", name(msg).c_str(), ns / 1e6);
+  OutputDebugStringA(text);
+#else
+  static_cast<void>(msg);
+  static_cast<void>(ns);
+#endif
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "clock.h"
+#include "histogram.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Records the latency of message handlers per message ID and the time spent between handlers.
+// Must only be used from the UI thread. Nested messages are included in the time of the outer message.
+class profiler {
+public:
+  explicit profiler(double budget_ms = 16.0);
+
+  // Returns the profiler of the UI thread.
+  static profiler& instance();
+
+  // Starts timing a message and returns the start timestamp.
+  std::uint64_t enter()
+  {
+    auto now = clock_ticks();
+    if (!depth_++ && last_) {
+      outside_.record(to_ns(now - last_));
+    }
+    return now;
+  }
+
+  // Stops timing a message.
+  void leave(unsigned msg, std::uint64_t start)
+  {
+    auto now = clock_ticks();
+    auto ns = to_ns(now - start);
+    auto& entry = lookup(msg);
+    entry.latency.record(ns);
+    if (ns > budget_) {
+      over_budget(msg, entry, ns);
+    }
+    if (!--depth_) {
+      last_ = now;
+    }
+  }
+
+  // Returns a table with the call count, latency percentiles and budget overruns of every message.
+  std::string report() const;
+
+  // Clears all histograms.
+  void reset();
+
+#ifdef _WIN32
+  // Writes the report next to the executable and returns the file name. Throws on failure.
+  std::wstring save() const;
+#endif
+
+private:
+  struct entry {
+    histogram latency;
+    std::uint64_t over_budget = 0;
+  };
+
+  // Two-level table indexed by the high and the low byte of the 16-bit message ID.
+  struct page {
+    std::unique_ptr<entry> entries[256];
+  };
+
+  entry& lookup(unsigned msg)
+  {
+    auto& p = pages_[(msg >> 8) & 0xFF];
+    if (p) {
+      if (auto& e = p->entries[msg & 0xFF]) {
+        return *e;
+      }
+    }
+    return create(msg);
+  }
+
+  entry& create(unsigned msg);
+  void over_budget(unsigned msg, entry& e, std::uint64_t ns);
+
+  std::uint64_t to_ns(std::uint64_t ticks) const
+  {
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) * scale_);
+  }
+
+  std::uint64_t budget_;
+  double scale_;
+  unsigned depth_ = 0;
+  std::uint64_t last_ = 0;
+  histogram outside_;
+  std::unique_ptr<page> pages_[256];
+};
+
+// Times the enclosing scope as a handler of the given message.
+class profile_scope {
+public:
+  explicit profile_scope(unsigned msg) : msg_(msg), start_(profiler::instance().enter())
+  {}
+
+  ~profile_scope()
+  {
+    profiler::instance().leave(msg_, start_);
+  }
+
+  profile_scope(const profile_scope& other) = delete;
+  profile_scope& operator=(const profile_scope& other) = delete;
+
+private:
+  unsigned msg_;
+  std::uint64_t start_;
+};
@@ -0,0 +1,99 @@
+#include "scrollback.h"
+#include <algorithm>
+
+scrollback::scrollback(std::size_t max_lines, std::size_t max_bytes)
+{
+  set_limits(max_lines, max_bytes);
+}
+
+void scrollback::set_limits(std::size_t max_lines, std::size_t max_bytes)
+{
+  // Trim in chunks of an eighth of the limit to keep the cost per append constant.
+  max_lines_ = std::max<std::size_t>(max_lines, 1);
+  max_chars_ = std::max<std::size_t>(max_bytes / sizeof(wchar_t), 1);
+  chunk_lines_ = std::max<std::size_t>(max_lines_ / 8, 1);
+  chunk_chars_ = std::max<std::size_t>(max_chars_ / 8, 1);
+}
+
+std::size_t scrollback::append(const wchar_t* text, std::size_t size)
+{
+  // Split the text into lines.
+  for (std::size_t i = 0; i < size; i++) {
+    auto c = text[i];
+    if (c == L'\r' || c == L'\n') {
+      if (c == L'\r' && i + 1 < size && text[i + 1] == L'\n') {
+        i++;
+      }
+      push(static_cast<std::uint32_t>(open_ + 1));
+      open_ = 0;
+    } else {
+      open_++;
+    }
+    chars_++;
+  }
+
+  // Wait until a whole chunk exceeds the limits.
+  if (count_ <= max_lines_ + chunk_lines_ && chars_ <= max_chars_ + chunk_chars_) {
+    return 0;
+  }
+
+  // Remove lines until both limits are met.
+  std::size_t trim = 0;
+  while (count_ > 0 && (count_ > max_lines_ || chars_ > max_chars_)) {
+    auto line = pop();
+    chars_ -= line;
+    trim += line;
+  }
+  return trim;
+}
+
+void scrollback::clear()
+{
+  head_ = 0;
+  count_ = 0;
+  open_ = 0;
+  chars_ = 0;
+}
+
+std::size_t scrollback::lines() const
+{
+  return count_ + (open_ ? 1 : 0);
+}
+
+std::size_t scrollback::chars() const
+{
+  return chars_;
+}
+
+std::size_t scrollback::memory() const
+{
+  return chars_ * sizeof(wchar_t) + ring_.capacity() * sizeof(std::uint32_t);
+}
+
+std::size_t scrollback::capacity() const
+{
+  return max_chars_ + chunk_chars_;
+}
+
+void scrollback::push(std::uint32_t size)
+{
+  // Grow the ring by doubling and unwrap the existing records.
+  if (count_ == ring_.size()) {
+    std::vector<std::uint32_t> ring(std::max<std::size_t>(ring_.size() * 2, 1024));
+    for (std::size_t i = 0; i < count_; i++) {
+      ring[i] = ring_[(head_ + i) % ring_.size()];
+    }
+    ring_.swap(ring);
+    head_ = 0;
+  }
+  ring_[(head_ + count_) % ring_.size()] = size;
+  count_++;
+}
+
+std::uint32_t scrollback::pop()
+{
+  auto size = ring_[head_];
+  head_ = (head_ + 1) % ring_.size();
+  count_--;
+  return size;
+}
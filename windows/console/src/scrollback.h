@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tracks the lines held by the console control and decides when to trim them.
+// Lengths are counted in control characters, where each line break counts as one.
+class scrollback {
+public:
+  scrollback(std::size_t max_lines, std::size_t max_bytes);
+
+  // Changes the limits. The next append trims the control if necessary.
+  void set_limits(std::size_t max_lines, std::size_t max_bytes);
+
+  // Records appended text and returns the number of characters to remove from the head.
+  // Trimming only happens once the limits are exceeded by a whole chunk.
+  std::size_t append(const wchar_t* text, std::size_t size);
+
+  // Forgets all lines.
+  void clear();
+
+  std::size_t lines() const;
+  std::size_t chars() const;
+
+  // Returns the number of bytes held by the control text and the line records.
+  std::size_t memory() const;
+
+  // Returns the maximum number of characters the control must be able to hold.
+  std::size_t capacity() const;
+
+private:
+  void push(std::uint32_t size);
+  std::uint32_t pop();
+
+  std::size_t max_lines_ = 0;
+  std::size_t max_chars_ = 0;
+  std::size_t chunk_lines_ = 0;
+  std::size_t chunk_chars_ = 0;
+
+  // Ring of completed line lengths.
+  std::vector<std::uint32_t> ring_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+
+  // Length of the unterminated last line.
+  std::size_t open_ = 0;
+  std::size_t chars_ = 0;
+};
@@ -0,0 +1,57 @@
+#include "task_queue.h"
+#include <memory>
+#include <utility>
+
+task_queue::~task_queue()
+{
+  // Discard the tasks that were never executed.
+  for (auto n : { batch_, head_.exchange(nullptr, std::memory_order_acquire) }) {
+    while (n) {
+      auto next = n->next;
+      delete n;
+      n = next;
+    }
+  }
+}
+
+bool task_queue::post(task t)
+{
+  // The node belongs to the consumer once it is published, so only the local copy of the old head is read afterwards.
+  auto n = new node{ std::move(t), nullptr };
+  auto head = head_.load(std::memory_order_relaxed);
+  do {
+    n->next = head;
+  } while (!head_.compare_exchange_weak(head, n, std::memory_order_release, std::memory_order_relaxed));
+
+  // Only the producer that finds the queue empty signals the consumer.
+  return head == nullptr;
+}
+
+std::size_t task_queue::run()
+{
+  // Take the whole batch and restore the posting order.
+  if (!batch_) {
+    auto n = head_.exchange(nullptr, std::memory_order_acquire);
+    while (n) {
+      auto next = n->next;
+      n->next = batch_;
+      batch_ = n;
+      n = next;
+    }
+  }
+
+  // Execute the batch. If a task throws, the rest of the batch runs on the next call.
+  std::size_t count = 0;
+  while (batch_) {
+    std::unique_ptr<node> n(batch_);
+    batch_ = n->next;
+    n->t();
+    count++;
+  }
+  return count;
+}
+
+bool task_queue::empty() const
+{
+  return !batch_ && !head_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+// Unbounded lock-free multi-producer single-consumer queue of tasks.
+// Producers push onto a shared stack and the consumer takes the whole stack at once,
+// so tasks are executed in batches and in the order in which they were posted.
+class task_queue {
+public:
+  using task = std::function<void()>;
+
+  task_queue() = default;
+  ~task_queue();
+
+  task_queue(const task_queue& other) = delete;
+  task_queue& operator=(const task_queue& other) = delete;
+
+  // Queues a task from any thread.
+  // Returns true if the queue was empty and the caller is responsible for waking up the consumer.
+  bool post(task t);
+
+  // Runs all tasks that were queued before the call. Tasks posted while the batch runs are
+  // left for the next call. Must only be called from the consumer thread.
+  // Returns the number of tasks that were executed.
+  std::size_t run();
+
+  // Returns true if no tasks are queued. Must only be called from the consumer thread.
+  bool empty() const;
+
+private:
+  struct node {
+    task t;
+    node* next;
+  };
+
+  alignas(64) std::atomic<node*> head_ = { nullptr };
+  node* batch_ = nullptr;
+};
@@ -0,0 +1,129 @@
+#include "text_search.h"
+#include <cwchar>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TEXT_SEARCH_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TEXT_SEARCH_TARGET_SSE2
+#else
+#include <cpuid.h>
+#define TEXT_SEARCH_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+#ifdef TEXT_SEARCH_X86
+namespace {
+
+// Characters per vector and mask bits per character.
+const std::size_t lanes = 16 / sizeof(wchar_t);
+const unsigned lane_mask = (1u << sizeof(wchar_t)) - 1;
+
+TEXT_SEARCH_TARGET_SSE2 inline __m128i splat(wchar_t c)
+{
+  return sizeof(wchar_t) == 2 ? _mm_set1_epi16(static_cast<short>(c)) : _mm_set1_epi32(static_cast<int>(c));
+}
+
+TEXT_SEARCH_TARGET_SSE2 inline __m128i equal(__m128i a, __m128i b)
+{
+  return sizeof(wchar_t) == 2 ? _mm_cmpeq_epi16(a, b) : _mm_cmpeq_epi32(a, b);
+}
+
+inline unsigned lowest_bit(unsigned mask)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Compares the first and the last pattern character at every position of a vector at once.
+// Returns the first match or null and leaves p at the first candidate that was not checked.
+// The second load ends at most at the last character, because p + lanes <= end.
+TEXT_SEARCH_TARGET_SSE2 const wchar_t* find_sse2(const wchar_t*& p, const wchar_t* end, const wchar_t* pattern, std::size_t size)
+{
+  auto head = splat(pattern[0]);
+  auto tail = splat(pattern[size - 1]);
+  for (; static_cast<std::size_t>(end - p) >= lanes; p += lanes) {
+    auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + size - 1));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(equal(a, head), equal(b, tail))));
+    while (mask) {
+      auto bit = lowest_bit(mask);
+      auto candidate = p + bit / sizeof(wchar_t);
+      if (size <= 2 || !std::wmemcmp(candidate + 1, pattern + 1, size - 2)) {
+        return candidate;
+      }
+      mask &= ~(lane_mask << bit);
+    }
+  }
+  return nullptr;
+}
+
+// The console template targets IA32, so SSE2 can not be assumed at compile time.
+bool has_sse2()
+{
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 1);
+  return (static_cast<unsigned>(info[3]) & (1u << 26)) != 0;
+#else
+  unsigned regs[4] = {};
+  return __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]) && (regs[3] & (1u << 26)) != 0;
+#endif
+}
+
+}  // namespace
+#endif
+
+const wchar_t* text_find(const wchar_t* first, const wchar_t* last, const wchar_t* pattern, std::size_t size)
+{
+  if (!size) {
+    return first;
+  }
+  if (static_cast<std::size_t>(last - first) < size) {
+    return last;
+  }
+
+  // Candidates start in [first, end).
+  auto end = last - size + 1;
+  auto p = first;
+
+#ifdef TEXT_SEARCH_X86
+  static const auto sse2 = has_sse2();
+  if (sse2) {
+    if (auto match = find_sse2(p, end, pattern, size)) {
+      return match;
+    }
+  }
+#endif
+
+  // Skip to the next occurrence of the first character.
+  while (p < end) {
+    p = std::wmemchr(p, pattern[0], static_cast<std::size_t>(end - p));
+    if (!p) {
+      return last;
+    }
+    if (p[size - 1] == pattern[size - 1] && !std::wmemcmp(p, pattern, size)) {
+      return p;
+    }
+    p++;
+  }
+  return last;
+}
+
+std::size_t text_count(const wchar_t* first, const wchar_t* last, const wchar_t* pattern, std::size_t size)
+{
+  if (!size) {
+    return 0;
+  }
+  std::size_t count = 0;
+  for (auto p = first; (p = text_find(p, last, pattern, size)) != last; p += size) {
+    count++;
+  }
+  return count;
+}
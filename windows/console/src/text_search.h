@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// Substring search over wide character text.
+// Candidates are filtered by comparing the first and the last pattern character with 16 byte SSE2 vectors
+// where available and with wmemchr otherwise. Only the candidates are compared in full.
+
+// Returns the first occurrence of the pattern in [first, last) or last if there is none.
+const wchar_t* text_find(const wchar_t* first, const wchar_t* last, const wchar_t* pattern, std::size_t size);
+
+// Returns the number of non-overlapping occurrences of the pattern in [first, last).
+std::size_t text_count(const wchar_t* first, const wchar_t* last, const wchar_t* pattern, std::size_t size);
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hierarchical timing wheel with four levels of 256 slots at millisecond resolution.
+// Timers are intrusive list nodes owned by the caller, so scheduling and cancelling are O(1)
+// and neither allocates. Timers on the upper levels are moved down when the lower level wraps.
+// Delays are clamped to 2^32 - 1 milliseconds. Not thread-safe.
+class timer_wheel {
+public:
+  using callback = void (*)(void* context);
+
+  class timer {
+  public:
+    timer() = default;
+    timer(callback function, void* context) : callback_(function), context_(context)
+    {}
+
+    // Cancels the timer if it is still scheduled.
+    ~timer();
+
+    timer(const timer& other) = delete;
+    timer& operator=(const timer& other) = delete;
+
+    // Calls the member function of the object when the timer expires.
+    template <typename T, void (T::*Method)()>
+    void bind(T* object)
+    {
+      callback_ = [](void* context) {
+        (static_cast<T*>(context)->*Method)();
+      };
+      context_ = object;
+    }
+
+    void bind(callback function, void* context)
+    {
+      callback_ = function;
+      context_ = context;
+    }
+
+    // Returns true if the timer is scheduled.
+    bool active() const
+    {
+      return wheel_ != nullptr;
+    }
+
+  private:
+    friend class timer_wheel;
+
+    timer* next_ = nullptr;
+    timer* prev_ = nullptr;
+    timer** list_ = nullptr;
+    timer_wheel* wheel_ = nullptr;
+    std::uint64_t expiry_ = 0;
+    callback callback_ = nullptr;
+    void* context_ = nullptr;
+  };
+
+  // Starts the wheel at the given time in milliseconds.
+  explicit timer_wheel(std::uint64_t now = 0);
+  ~timer_wheel();
+
+  timer_wheel(const timer_wheel& other) = delete;
+  timer_wheel& operator=(const timer_wheel& other) = delete;
+
+  // Schedules the timer to expire the given number of milliseconds after now().
+  // Reschedules the timer if it is already active.
+  void schedule(timer& t, std::uint64_t delay);
+
+  // Cancels the timer if it is active.
+  void cancel(timer& t);
+
+  // Advances the wheel to the given time and calls the callbacks of all expired timers in one batch.
+  // Callbacks may schedule and cancel timers. If a callback throws, the remaining callbacks of the
+  // batch are called by the next advance. Returns the number of expired timers.
+  std::size_t advance(std::uint64_t now);
+
+  // Returns the number of milliseconds after now() when advance() must be called next,
+  // or UINT64_MAX if no timer is active. May be earlier than the next expiry when the
+  // next timer is on an upper level.
+  std::uint64_t timeout() const;
+
+  // Returns the time of the last advance.
+  std::uint64_t now() const
+  {
+    return current_ - 1;
+  }
+
+  // Returns the number of active timers.
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  static constexpr int levels = 4;
+  static constexpr int bits = 8;
+  static constexpr int slots = 1 << bits;
+
+  void insert(timer& t);
+  void unlink(timer& t);
+  void cascade(int level, int index);
+  std::size_t expire();
+  std::uint64_t next_tick() const;
+
+  // Next tick to process.
+  std::uint64_t current_;
+  std::size_t size_ = 0;
+
+  // Expired timers whose callbacks were not called yet.
+  timer* expired_ = nullptr;
+
+  timer* slots_[levels][slots] = {};
+  std::uint64_t occupied_[levels][slots / 64] = {};
+};
@@ -0,0 +1,260 @@
+#include "vt_parser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+std::uint32_t palette(std::uint32_t index)
+{
+  // Use the xterm colors for the 16 basic colors, the 6x6x6 cube and the gray ramp.
+  static const std::uint32_t basic[16] = {
+    0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+    0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF,
+  };
+  if (index < 16) {
+    return basic[index];
+  }
+  if (index < 232) {
+    static const std::uint32_t levels[6] = { 0, 95, 135, 175, 215, 255 };
+    index -= 16;
+    return (levels[index / 36] << 16) | (levels[index / 6 % 6] << 8) | levels[index % 6];
+  }
+  if (index < 256) {
+    auto level = 8 + (index - 232) * 10;
+    return (level << 16) | (level << 8) | level;
+  }
+  return VT_DEFAULT_COLOR;
+}
+
+// Returns the length of the UTF-8 sequence that starts with the lead byte, or 0 for other bytes.
+std::size_t sequence_size(unsigned char c)
+{
+  if (c >= 0xC0 && c < 0xE0) {
+    return 2;
+  }
+  if (c >= 0xE0 && c < 0xF0) {
+    return 3;
+  }
+  if (c >= 0xF0 && c < 0xF8) {
+    return 4;
+  }
+  return 0;
+}
+
+bool is_continuation(unsigned char c)
+{
+  return (c & 0xC0) == 0x80;
+}
+
+// Returns the number of bytes at the end of the text that start a UTF-8 sequence without completing it.
+std::size_t incomplete_tail(const char* data, std::size_t size)
+{
+  for (std::size_t n = 1; n <= std::min<std::size_t>(size, 3); n++) {
+    auto c = static_cast<unsigned char>(data[size - n]);
+    if (!is_continuation(c)) {
+      return sequence_size(c) > n ? n : 0;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+void vt_parser::parse(const char* data, std::size_t size, std::vector<vt_span>& spans)
+{
+  std::size_t start = 0;
+  auto emit = [&](std::size_t end) {
+    if (end <= start) {
+      return;
+    }
+    if (!spans.empty()) {
+      auto& last = spans.back();
+      if (last.data + last.size == data + start && last.style == style_) {
+        last.size += end - start;
+        return;
+      }
+    }
+    spans.push_back({ data + start, end - start, style_ });
+  };
+
+  // Complete a character that was split at the end of the previous input.
+  if (carry_size_) {
+    start = resume(data, size, spans);
+    if (carry_size_) {
+      return;
+    }
+  }
+
+  for (std::size_t i = start; i < size; i++) {
+    auto c = static_cast<unsigned char>(data[i]);
+    switch (state_) {
+    case state::ground:
+      // Skip to the next escape character.
+      if (auto next = static_cast<const char*>(std::memchr(data + i, 0x1B, size - i))) {
+        i = static_cast<std::size_t>(next - data);
+        emit(i);
+        state_ = state::escape;
+      } else {
+        i = size;
+      }
+      break;
+    case state::escape:
+      if (c == '[') {
+        state_ = state::csi;
+        params_[0] = 0;
+        param_count_ = 1;
+        private_ = false;
+        intermediate_ = false;
+      } else if (c == ']') {
+        state_ = state::osc;
+      } else if ((c >= 0x20 && c <= 0x2F) || c == 0x1B) {
+        // Wait for the final character.
+      } else {
+        state_ = state::ground;
+        start = i + 1;
+      }
+      break;
+    case state::csi:
+      if (c >= '0' && c <= '9') {
+        auto& param = params_[param_count_ - 1];
+        param = std::min<std::uint32_t>(param * 10 + (c - '0'), 0xFFFF);
+      } else if (c == ';' || c == ':') {
+        if (param_count_ < max_params) {
+          params_[param_count_++] = 0;
+        }
+      } else if (c >= 0x3C && c <= 0x3F) {
+        private_ = true;
+      } else if (c >= 0x20 && c <= 0x2F) {
+        intermediate_ = true;
+      } else if (c >= 0x40 && c <= 0x7E) {
+        csi_dispatch(static_cast<char>(c));
+        state_ = state::ground;
+        start = i + 1;
+      } else if (c == 0x1B) {
+        state_ = state::escape;
+      }
+      break;
+    case state::osc:
+      if (c == 0x07) {
+        state_ = state::ground;
+        start = i + 1;
+      } else if (c == 0x1B) {
+        state_ = state::osc_escape;
+      }
+      break;
+    case state::osc_escape:
+      if (c == '\\') {
+        state_ = state::ground;
+        start = i + 1;
+      } else {
+        // Abort the string and handle the character as part of a new escape sequence.
+        state_ = state::escape;
+        i--;
+      }
+      break;
+    }
+  }
+
+  if (state_ == state::ground) {
+    auto tail = incomplete_tail(data + start, size - start);
+    std::memcpy(carry_, data + size - tail, tail);
+    carry_size_ = tail;
+    emit(size - tail);
+  }
+}
+
+const vt_style& vt_parser::style() const
+{
+  return style_;
+}
+
+void vt_parser::reset()
+{
+  state_ = state::ground;
+  style_ = {};
+  param_count_ = 0;
+  carry_size_ = 0;
+}
+
+std::size_t vt_parser::resume(const char* data, std::size_t size, std::vector<vt_span>& spans)
+{
+  // Take the continuation bytes that the input starts with.
+  auto expected = sequence_size(static_cast<unsigned char>(carry_[0]));
+  std::size_t i = 0;
+  for (; i < size && carry_size_ < expected; i++) {
+    if (!is_continuation(static_cast<unsigned char>(data[i]))) {
+      break;
+    }
+    carry_[carry_size_++] = data[i];
+  }
+  if (carry_size_ < expected && i == size) {
+    return size;
+  }
+
+  // Emit the complete character, or the interrupted sequence as it is.
+  std::memcpy(char_, carry_, carry_size_);
+  spans.push_back({ char_, carry_size_, style_ });
+  carry_size_ = 0;
+  return i;
+}
+
+void vt_parser::csi_dispatch(char final)
+{
+  // Only plain SGR sequences affect the output.
+  if (final == 'm' && !private_ && !intermediate_) {
+    sgr();
+  }
+}
+
+void vt_parser::sgr()
+{
+  for (std::size_t i = 0; i < param_count_; i++) {
+    auto p = params_[i];
+    switch (p) {
+    case 0:  style_ = {}; break;
+    case 1:  style_.attributes |= VT_BOLD; break;
+    case 3:  style_.attributes |= VT_ITALIC; break;
+    case 4:  style_.attributes |= VT_UNDERLINE; break;
+    case 7:  style_.attributes |= VT_INVERSE; break;
+    case 9:  style_.attributes |= VT_STRIKEOUT; break;
+    case 22: style_.attributes &= ~VT_BOLD; break;
+    case 23: style_.attributes &= ~VT_ITALIC; break;
+    case 24: style_.attributes &= ~VT_UNDERLINE; break;
+    case 27: style_.attributes &= ~VT_INVERSE; break;
+    case 29: style_.attributes &= ~VT_STRIKEOUT; break;
+    case 38: style_.foreground = extended_color(i); break;
+    case 39: style_.foreground = VT_DEFAULT_COLOR; break;
+    case 48: style_.background = extended_color(i); break;
+    case 49: style_.background = VT_DEFAULT_COLOR; break;
+    default:
+      if (p >= 30 && p <= 37) {
+        style_.foreground = palette(p - 30);
+      } else if (p >= 40 && p <= 47) {
+        style_.background = palette(p - 40);
+      } else if (p >= 90 && p <= 97) {
+        style_.foreground = palette(p - 90 + 8);
+      } else if (p >= 100 && p <= 107) {
+        style_.background = palette(p - 100 + 8);
+      }
+      break;
+    }
+  }
+}
+
+std::uint32_t vt_parser::extended_color(std::size_t& i) const
+{
+  // Parse "5;index" and "2;r;g;b" color parameters.
+  if (i + 2 < param_count_ && params_[i + 1] == 5) {
+    i += 2;
+    return palette(params_[i]);
+  }
+  if (i + 4 < param_count_ && params_[i + 1] == 2) {
+    auto r = std::min<std::uint32_t>(params_[i + 2], 255);
+    auto g = std::min<std::uint32_t>(params_[i + 3], 255);
+    auto b = std::min<std::uint32_t>(params_[i + 4], 255);
+    i += 4;
+    return (r << 16) | (g << 8) | b;
+  }
+  i = param_count_;
+  return VT_DEFAULT_COLOR;
+}
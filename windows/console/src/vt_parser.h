@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define VT_DEFAULT_COLOR 0xFFFFFFFFu  // terminal default color
+
+#define VT_BOLD       0x01
+#define VT_ITALIC     0x02
+#define VT_UNDERLINE  0x04
+#define VT_STRIKEOUT  0x08
+#define VT_INVERSE    0x10
+
+// Character attributes selected by SGR sequences. Colors are stored as 0x00RRGGBB.
+struct vt_style {
+  std::uint32_t foreground = VT_DEFAULT_COLOR;
+  std::uint32_t background = VT_DEFAULT_COLOR;
+  std::uint32_t attributes = 0;
+
+  bool operator==(const vt_style& other) const
+  {
+    return foreground == other.foreground && background == other.background && attributes == other.attributes;
+  }
+
+  bool operator!=(const vt_style& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+// Text that points into the parsed input, or into the parser for a UTF-8 character that was split across
+// calls. The spans stay valid until the next call.
+struct vt_span {
+  const char* data;
+  std::size_t size;
+  vt_style style;
+};
+
+// Incremental VT escape sequence parser that keeps its state between calls.
+// SGR sequences change the style of the following text, all other sequences are removed.
+// An incomplete UTF-8 sequence at the end of the input is held back until the next call completes it,
+// so that every span can be transcoded on its own.
+class vt_parser {
+public:
+  // Appends the text spans of the input to the output vector.
+  void parse(const char* data, std::size_t size, std::vector<vt_span>& spans);
+
+  // Returns the current style.
+  const vt_style& style() const;
+
+  // Resets the parser state and the style.
+  void reset();
+
+private:
+  enum class state {
+    ground,
+    escape,
+    csi,
+    osc,
+    osc_escape,
+  };
+
+  void csi_dispatch(char final);
+  void sgr();
+  std::uint32_t extended_color(std::size_t& i) const;
+  std::size_t resume(const char* data, std::size_t size, std::vector<vt_span>& spans);
+
+  state state_ = state::ground;
+  vt_style style_;
+
+  static const std::size_t max_params = 16;
+  std::uint32_t params_[max_params] = {};
+  std::size_t param_count_ = 0;
+  bool private_ = false;
+  bool intermediate_ = false;
+
+  // The start of a UTF-8 sequence that was split across calls and the completed sequence.
+  char carry_[4] = {};
+  std::size_t carry_size_ = 0;
+  char char_[4] = {};
+};
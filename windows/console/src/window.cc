@@ -1,16 +1,140 @@
 #include "window.h"
+#include "clock.h"
+#include "text_search.h"
+#include "utf.h"
 #include <resource.h>
 #include <commctrl.h>
 #include <richedit.h>
 #include <algorithm>
+#include <exception>
 #include <stdexcept>
 #include <string>
+#include <cstdio>
+#include <cwchar>
 
 #define MARGIN    5L  // border margin
 #define PADDING   3L  // text padding
 
-window::window(HINSTANCE instance) : instance_(instance)
+#define STATS_INTERVAL 1000            // milliseconds between process statistics updates
+#define CAPTURE_FLUSH_INTERVAL 100     // milliseconds between flushes of the captured stdout buffer
+#define CAPTURE_BENCHMARK_LINES 100000  // number of lines written by the capture benchmark
+
+#define MIRROR_SEGMENT_SIZE (64 << 20)  // size of a log mirror segment in bytes
+#define MIRROR_SEGMENTS 4               // number of log mirror segments that are reused in turn
+#define MIRROR_FLUSH_INTERVAL 100       // milliseconds between asynchronous flushes of the log mirror
+
+#define WRITE_BATCH_LIMIT (1 << 20)  // maximum number of bytes applied per wakeup
+
+#define SCROLLBACK_LINES 100000     // default scrollback limit in lines
+#define SCROLLBACK_BYTES (32 << 20) // default scrollback limit in bytes
+
+#define FIND_HEIGHT 22L              // height of the find bar
+#define FIND_STATUS_WIDTH 160L       // width of the match count next to the find box
+#define FIND_TASK_CHARS (1 << 20)    // scrollback characters counted per pool task
+
+static void append_utf16(std::wstring& dst, const char* src, std::size_t size)
+{
+  // Convert the text into the unused capacity of the buffer.
+  auto offset = dst.size();
+  dst.resize(offset + size);
+  if (size) {
+    dst.resize(offset + utf8_to_utf16(src, size, reinterpret_cast<char16_t*>(&dst[offset])));
+  }
+}
+
+#ifndef CONSOLE_VIEW
+static CHARFORMAT2 make_format(const vt_style& style)
+{
+  auto color = [](std::uint32_t c) {
+    return RGB((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF);
+  };
+
+  CHARFORMAT2 cf = {};
+  cf.cbSize = sizeof(cf);
+  cf.dwMask = CFM_COLOR | CFM_BACKCOLOR | CFM_BOLD | CFM_ITALIC | CFM_UNDERLINE | CFM_STRIKEOUT;
+
+  // Swap the colors and resolve the default colors for inverse text.
+  if (style.attributes & VT_INVERSE) {
+    auto fg = style.foreground == VT_DEFAULT_COLOR ? GetSysColor(COLOR_WINDOWTEXT) : color(style.foreground);
+    auto bg = style.background == VT_DEFAULT_COLOR ? GetSysColor(COLOR_WINDOW) : color(style.background);
+    cf.crTextColor = bg;
+    cf.crBackColor = fg;
+  } else {
+    if (style.foreground == VT_DEFAULT_COLOR) {
+      cf.dwEffects |= CFE_AUTOCOLOR;
+    } else {
+      cf.crTextColor = color(style.foreground);
+    }
+    if (style.background == VT_DEFAULT_COLOR) {
+      cf.dwEffects |= CFE_AUTOBACKCOLOR;
+    } else {
+      cf.crBackColor = color(style.background);
+    }
+  }
+
+  if (style.attributes & VT_BOLD) {
+    cf.dwEffects |= CFE_BOLD;
+  }
+  if (style.attributes & VT_ITALIC) {
+    cf.dwEffects |= CFE_ITALIC;
+  }
+  if (style.attributes & VT_UNDERLINE) {
+    cf.dwEffects |= CFE_UNDERLINE;
+  }
+  if (style.attributes & VT_STRIKEOUT) {
+    cf.dwEffects |= CFE_STRIKEOUT;
+  }
+  return cf;
+}
+#endif
+
+static HFONT create_font()
 {
+  // Create a 10 point font for the screen resolution.
+  auto hdc = GetDC(nullptr);
+  auto size = -MulDiv(10, GetDeviceCaps(hdc, LOGPIXELSY), 72);
+  ReleaseDC(nullptr, hdc);
+  return CreateFontW(size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, ANSI_CHARSET, OUT_DEFAULT_PRECIS,
+    CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_MODERN, L"Lucida Console");
+}
+
+static std::string format_benchmark(const capture::benchmark_result& result)
+{
+  char report[256] = {};
+  std::snprintf(report, sizeof(report),
+    "[capture benchmark: %zu lines, %.1f MiB/s, %.0f lines/s, latency avg %.0f us, max %.0f us]\n",
+    result.lines, result.bytes / result.seconds / (1024.0 * 1024.0), result.lines / result.seconds,
+    result.latency_avg, result.latency_max);
+  return report;
+}
+
+window::window(HINSTANCE instance, event_loop& loop, thread_pool& pool) :
+  instance_(instance), loop_(loop), pool_(pool), output_(1024), captured_(1024), scrollback_(SCROLLBACK_LINES, SCROLLBACK_BYTES),
+#ifdef CONSOLE_VIEW
+  view_(instance),
+#endif
+  process_([this](int, const char* data, std::size_t size) {
+    return push_output(output_, data, size);
+  }, [this]() {
+    loop_.post([this]() {
+      if (hwnd_) {
+        on_process();
+      }
+    });
+  }),
+  capture_([this](int, const char* data, std::size_t size) {
+    return push_output(captured_, data, size);
+  })
+{
+#ifdef CONSOLE_VIEW
+  // Apply the default scrollback limits to the console view.
+  view_.set_limits(SCROLLBACK_LINES, SCROLLBACK_BYTES);
+#endif
+
+  // Update the title bar and flush the captured output from the timers of the event loop.
+  stats_timer_.bind<window, &window::on_stats>(this);
+  flush_timer_.bind<window, &window::on_flush>(this);
+
   // Load the window icon.
   auto icon = LoadIcon(instance, MAKEINTRESOURCE(IDI_MAIN));
 
@@ -18,26 +142,7 @@ window::window(HINSTANCE instance) : instance_(instance)
   WNDCLASSEX wc = {};
   wc.cbSize = sizeof(wc);
   wc.style = CS_HREDRAW | CS_VREDRAW;
-  wc.lpfnWndProc = [](HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) -> LRESULT {
-#ifdef _WIN64
-    auto self = reinterpret_cast<window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-    if (msg == WM_CREATE) {
-      self = reinterpret_cast<window*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
-    } else if (msg == WM_DESTROY) {
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
-    }
-#else
-    auto self = reinterpret_cast<window*>(GetWindowLong(hwnd, GWL_USERDATA));
-    if (msg == WM_CREATE) {
-      self = reinterpret_cast<window*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
-      SetWindowLong(hwnd, GWL_USERDATA, reinterpret_cast<LONG>(self));
-    } else if (msg == WM_DESTROY) {
-      SetWindowLong(hwnd, GWL_USERDATA, 0);
-    }
-#endif
-    return self ? self->handle(hwnd, msg, wparam, lparam) : DefWindowProc(hwnd, msg, wparam, lparam);
-  };
+  wc.lpfnWndProc = window_proc;
   wc.hInstance = instance;
   wc.hIcon = icon;
   wc.hIconSm = icon;
@@ -51,6 +156,7 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("RegisterClassEx");
 
   // Create the main application window.
   auto es = 0x0L;
@@ -63,24 +169,189 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("CreateWindowEx");
+}
+
+void window::write(std::string str)
+{
+  // Queue the string and wake up the UI thread once per batch.
+  if (queue_.push(std::move(str))) {
+    wake();
+  }
+}
+
+void window::wake()
+{
+  // Producer threads only read the handle that the UI thread publishes in on_create and clears in on_destroy.
+  if (auto hwnd = wakeup_.load(std::memory_order_acquire)) {
+    PostMessage(hwnd, WM_APP_WRITE, 0, 0);
+  }
+}
+
+bool window::push_output(log_queue& queue, const char* data, std::size_t size)
+{
+  // Reject the chunk while the queue is full. The pipe reader delivers it again once on_write drained the queue
+  // and acknowledged the output, so a burst blocks the writer instead of losing output or leaking credit.
+  std::string str(data, size);
+  auto signal = false;
+  if (!queue.try_push(str, signal)) {
+    return false;
+  }
+  if (signal) {
+    wake();
+  }
+  return true;
 }
 
-void window::write(const std::string& str)
+void window::set_scrollback(std::size_t lines, std::size_t bytes)
 {
-  // Write the string to the console control.
+  // Update the limits and let the control hold the untrimmed chunk and one batch.
+#ifdef CONSOLE_VIEW
+  view_.set_limits(lines, bytes);
+#else
+  scrollback_.set_limits(lines, bytes);
   if (console_) {
-    std::wstring msg;
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), nullptr, 0) + 1);
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), &msg[0], static_cast<int>(msg.size())));
-    CHARRANGE cr = { -1, -1 };
-    SendMessage(console_, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&cr));
-    SendMessage(console_, EM_REPLACESEL, 0, reinterpret_cast<LPARAM>(msg.data()));
-    SendMessage(console_, WM_VSCROLL, SB_BOTTOM, 0);
+    SendMessage(console_, EM_EXLIMITTEXT, 0, static_cast<LPARAM>(scrollback_.capacity() + WRITE_BATCH_LIMIT));
   }
+#endif
+}
+
+std::size_t window::memory() const
+{
+#ifdef CONSOLE_VIEW
+  return view_.memory();
+#else
+  return scrollback_.memory();
+#endif
+}
+
+void window::run(const std::wstring& command)
+{
+  // Start the process and report its throughput in the title bar.
+  try {
+    process_.start(command);
+    stats_bytes_ = 0;
+    stats_time_ = GetTickCount();
+    loop_.timers().schedule(stats_timer_, STATS_INTERVAL);
+  }
+  catch (const std::exception& e) {
+    write(std::string("[") + e.what() + "]\n");
+  }
+}
+
+void window::open(const std::vector<std::wstring>& commands)
+{
+  // Show the window of the running instance.
+  if (!hwnd_) {
+    return;
+  }
+  if (IsIconic(hwnd_)) {
+    ShowWindow(hwnd_, SW_RESTORE);
+  }
+  SetForegroundWindow(hwnd_);
+
+  // Any process of the session can write to the channel, so the command lines are only shown.
+  // Control characters are replaced so that they can not inject escape sequences.
+  for (const auto& command : commands) {
+    if (command.empty()) {
+      continue;
+    }
+    std::wstring line(command);
+    for (auto& c : line) {
+      if (c < 0x20 || (c >= 0x7F && c <= 0x9F)) {
+        c = L'?';
+      }
+    }
+    auto size = static_cast<int>(line.size());
+    std::string str(line.size() * 3, '\0');
+    str.resize(WideCharToMultiByte(CP_UTF8, 0, line.data(), size, &str[0], static_cast<int>(str.size()), nullptr, nullptr));
+    write("[forwarded: " + str + "]\n");
+  }
+}
+
+void window::capture_output()
+{
+  // Redirect the output and flush the buffered stdout periodically.
+  try {
+    capture_.start();
+    loop_.timers().schedule(flush_timer_, CAPTURE_FLUSH_INTERVAL);
+  }
+  catch (const std::exception& e) {
+    write(std::string("[") + e.what() + "]\n");
+  }
+}
+
+void window::mirror_output()
+{
+  // Use the executable name as the base name of the segments.
+  try {
+    std::wstring path(MAX_PATH, L'\0');
+    auto size = GetModuleFileName(nullptr, &path[0], static_cast<DWORD>(path.size()));
+    if (!size || size >= path.size()) {
+      throw std::runtime_error("Could not determine the log mirror file name.");
+    }
+    std::string base(size * 3, '\0');
+    base.resize(WideCharToMultiByte(CP_UTF8, 0, path.data(), size, &base[0], static_cast<int>(base.size()), nullptr, nullptr));
+    mirror_.open(base + ".console", MIRROR_SEGMENT_SIZE, MIRROR_SEGMENTS, MIRROR_FLUSH_INTERVAL);
+  }
+  catch (const std::exception& e) {
+    write(std::string("[") + e.what() + "]\n");
+  }
+}
+
+#ifdef COROUTINES
+async window::benchmark()
+{
+  if (!capture_.active()) {
+    write("[output capture is not enabled]\n");
+    co_return;
+  }
+  if (benchmarking_) {
+    co_return;
+  }
+  benchmarking_ = true;
+
+  // Write the benchmark output on the pool and report the result on the UI thread.
+  co_await resume_background(pool_);
+  auto result = capture_.benchmark(CAPTURE_BENCHMARK_LINES);
+  co_await resume_on_ui(loop_);
+  write(format_benchmark(result));
+  benchmarking_ = false;
+}
+#else
+void window::benchmark()
+{
+  if (!capture_.active()) {
+    write("[output capture is not enabled]\n");
+    return;
+  }
+  if (benchmarking_) {
+    return;
+  }
+  benchmarking_ = true;
+
+  // Write the benchmark output on the pool and report the result on the UI thread.
+  pool_.submit([this]() {
+    return capture_.benchmark(CAPTURE_BENCHMARK_LINES);
+  }, [this](const capture::benchmark_result& result) {
+    write(format_benchmark(result));
+    benchmarking_ = false;
+  });
+}
+#endif
+
+void window::measure_startup(std::uint64_t start)
+{
+  start_ = start;
+  report_startup();
 }
 
 void window::on_create()
 {
+  // Publish the window handle for wakeups and collect the strings that were queued before.
+  wakeup_.store(hwnd_, std::memory_order_release);
+  PostMessage(hwnd_, WM_APP_WRITE, 0, 0);
+
   // Center the window.
   if (auto monitor = MonitorFromWindow(hwnd_, MONITOR_DEFAULTTONEAREST)) {
     MONITORINFO mi = {};
@@ -94,6 +365,66 @@ void window::on_create()
     }
   }
 
+#ifdef CONSOLE_FAST_START
+  // Load the richedit library and the font in the background and show a placeholder until they are ready.
+  // Strings written in the meantime stay queued. Errors are reported on the UI thread and close the window
+  // instead of leaving the placeholder.
+  struct resources {
+    HFONT font = nullptr;
+    std::exception_ptr error;
+  };
+  pool_.submit([]() {
+    resources r;
+    try {
+#ifndef CONSOLE_VIEW
+      if (!LoadLibrary(L"RICHED20.DLL")) {
+        throw std::runtime_error("Could not load the richedit library.");
+      }
+#endif
+      r.font = create_font();
+    }
+    catch (...) {
+      r.error = std::current_exception();
+    }
+    return r;
+  }, [this](const resources& r) {
+    if (!hwnd_) {
+      DeleteObject(r.font);
+      return;
+    }
+    guarded([this, &r]() {
+      if (r.error) {
+        std::rethrow_exception(r.error);
+      }
+      INITCOMMONCONTROLSEX icc = {
+        sizeof(INITCOMMONCONTROLSEX),
+        ICC_STANDARD_CLASSES
+      };
+      if (!InitCommonControlsEx(&icc)) {
+        DeleteObject(r.font);
+        throw std::runtime_error("Could not initialize common controls.");
+      }
+      create_controls(r.font);
+      InvalidateRect(hwnd_, nullptr, TRUE);
+      on_write();
+    });
+  });
+#else
+  create_controls(create_font());
+#endif
+
+  // Show the window.
+  ShowWindow(hwnd_, SW_SHOW);
+
+  // Test the console.
+  write("Hello World!");
+}
+
+void window::create_controls(HFONT font)
+{
+  // Take ownership of the font.
+  font_ = font;
+
   // Create the controls.
   auto ws = WS_CHILD | WS_VISIBLE;
 
@@ -102,51 +433,409 @@ void window::on_create()
     throw std::runtime_error("Could not create the border control.");
   }
 
+#ifdef CONSOLE_VIEW
+  console_ = view_.create(hwnd_);
+  if (!console_) {
+    throw std::runtime_error("Could not create the console view control.");
+  }
+
+  RECT rc = {};
+#else
   console_ = CreateWindow(L"RichEdit20W", nullptr, ws | WS_VSCROLL | ES_MULTILINE | ES_READONLY, 0, 0, 100, 100, hwnd_, nullptr, instance_, nullptr);
   if (!console_) {
     throw std::runtime_error("Could not create the richedit control.");
   }
 
+  SendMessage(console_, EM_EXLIMITTEXT, 0, static_cast<LPARAM>(scrollback_.capacity() + WRITE_BATCH_LIMIT));
+  SendMessage(console_, EM_SETUNDOLIMIT, 0, 0);
+
   RECT rc = { PADDING, PADDING, 100 - PADDING * 2, 100 - PADDING * 2 };
   SendMessage(console_, EM_SETRECT, 1, reinterpret_cast<LPARAM>(&rc));
+#endif
 
-  auto hdc = GetDC(console_);
-  auto size = -MulDiv(10, GetDeviceCaps(hdc, LOGPIXELSY), 72);
-  ReleaseDC(console_, hdc);
-  auto font = CreateFontW(size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, ANSI_CHARSET, OUT_DEFAULT_PRECIS,
-    CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_MODERN, L"Lucida Console");
+  SendMessage(console_, WM_SETFONT, reinterpret_cast<WPARAM>(font_), 0);
 
-  SendMessage(console_, WM_SETFONT, reinterpret_cast<WPARAM>(font), 0);
+  // Place the console inside the border.
+  layout_node root;
+  root.padding = { MARGIN, MARGIN, MARGIN, MARGIN };
+#ifdef CONSOLE_VIEW
+  root.direction = layout_direction::column;
+#endif
+  layout_ = layout(root);
+
+  auto output = layout::root;
+#ifdef CONSOLE_VIEW
+  // Stack the console above the find bar.
+  layout_node group;
+  group.grow = 1;
+  output = layout_.add(layout::root, group);
+#endif
+
+  layout_node border;
+  border.handle = border_;
+  layout_.add(output, border);
+
+  layout_node console;
+  console.margin = { 1, 1, 1, 1 };
+  console.handle = console_;
+  layout_.add(output, console);
+
+#ifdef CONSOLE_VIEW
+  // Create the find bar, which has no height until it is shown.
+  find_ = CreateWindowEx(WS_EX_CLIENTEDGE, WC_EDIT, nullptr, WS_CHILD | ES_AUTOHSCROLL, 0, 0, 100, 100, hwnd_,
+    reinterpret_cast<HMENU>(IDC_FIND), instance_, nullptr);
+  find_status_ = CreateWindow(WC_STATIC, nullptr, WS_CHILD | SS_CENTERIMAGE | SS_RIGHT, 0, 0, 100, 100, hwnd_, nullptr, instance_, nullptr);
+  if (!find_ || !find_status_) {
+    throw std::runtime_error("Could not create the find controls.");
+  }
+  SendMessage(find_, WM_SETFONT, reinterpret_cast<WPARAM>(font_), 0);
+  SendMessage(find_status_, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT)), 0);
+  SetWindowSubclass(find_, find_proc, 0, reinterpret_cast<DWORD_PTR>(this));
+
+  layout_node bar;
+  bar.direction = layout_direction::row;
+  find_bar_ = layout_.add(layout::root, bar);
+
+  layout_node edit;
+  edit.grow = 1;
+  edit.handle = find_;
+  layout_.add(find_bar_, edit);
+
+  layout_node status;
+  status.width = FIND_STATUS_WIDTH;
+  status.handle = find_status_;
+  layout_.add(find_bar_, status);
+#endif
 
   // Resize the controls.
   GetClientRect(hwnd_, &rc);
   on_size(rc.right - rc.left, rc.bottom - rc.top);
 
-  // Show the window.
-  ShowWindow(hwnd_, SW_SHOW);
+  ready_ = clock_ticks();
+  report_startup();
+}
 
-  // Test the console.
-  write("Hello World!");
+void window::report_startup()
+{
+  // Report the startup times once the window was painted and the controls were created.
+  if (!start_ || !painted_ || !ready_ || reported_) {
+    return;
+  }
+  reported_ = true;
+
+  auto scale = 1e3 / clock_frequency();
+  char report[128] = {};
+  std::snprintf(report, sizeof(report), "\n[startup benchmark: first paint after %.1f ms, ready after %.1f ms]\n",
+    (painted_ - start_) * scale, (ready_ - start_) * scale);
+  write(report);
 }
 
 void window::on_destroy()
 {
+  wakeup_.store(nullptr, std::memory_order_release);
+
+  // Stop reading the process output.
+  loop_.timers().cancel(stats_timer_);
+  process_.stop();
+
+  // Restore the standard output first so that a running benchmark can not block on the pipe.
+  loop_.timers().cancel(flush_timer_);
+  capture_.stop();
+#ifdef CONSOLE_VIEW
+  if (search_) {
+    search_->store(true);
+  }
+#endif
+  pool_.wait();
+
+  // Flush the mirrored output.
+  mirror_.close();
+
   // Destroy the controls.
+#ifdef CONSOLE_VIEW
+  DestroyWindow(find_);
+  find_ = nullptr;
+  DestroyWindow(find_status_);
+  find_status_ = nullptr;
+#endif
   DestroyWindow(console_);
   console_ = nullptr;
+  scrollback_.clear();
 
   DestroyWindow(border_);
   border_ = nullptr;
 
+  if (font_) {
+    DeleteObject(font_);
+    font_ = nullptr;
+  }
+
   // Stop the main message loop.
   PostQuitMessage(0);
 }
 
 void window::on_size(int cx, int cy)
 {
-  // Resize the controls.
-  MoveWindow(border_, MARGIN, MARGIN, cx - MARGIN * 2, cy - MARGIN * 2, TRUE);
-  MoveWindow(console_, MARGIN + 1, MARGIN + 1, cx - MARGIN * 2 - 2, cy - MARGIN * 2 - 2, TRUE);
+  // Resize the controls at once and let the end of a live resize redraw them.
+  layout_.solve(cx, cy);
+  layout_.apply(!sizing_);
+}
+
+void window::on_entersizemove()
+{
+  sizing_ = true;
+}
+
+void window::on_exitsizemove()
+{
+  // Redraw the controls that were moved without redrawing.
+  sizing_ = false;
+  RedrawWindow(hwnd_, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN);
+}
+
+void window::on_paint()
+{
+  // Draw a placeholder until the controls were created.
+  PAINTSTRUCT ps = {};
+  auto hdc = BeginPaint(hwnd_, &ps);
+  if (!console_) {
+    RECT rc = {};
+    GetClientRect(hwnd_, &rc);
+    auto font = SelectObject(hdc, GetStockObject(DEFAULT_GUI_FONT));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, GetSysColor(COLOR_GRAYTEXT));
+    DrawText(hdc, L"Loading...", -1, &rc, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    SelectObject(hdc, font);
+  }
+  EndPaint(hwnd_, &ps);
+
+  if (!painted_) {
+    painted_ = clock_ticks();
+    report_startup();
+  }
+}
+
+void window::on_write()
+{
+  // Keep the strings queued until the controls were created.
+  if (!console_) {
+    return;
+  }
+
+  // Report dropped strings first so that the batch stays within the limit of the control.
+  batch_.clear();
+  if (auto dropped = queue_.reset_dropped()) {
+    batch_.append("\n[" + std::to_string(dropped) + " messages dropped]\n");
+  }
+
+  // Collect the queued strings.
+  queue_.drain(batch_, WRITE_BATCH_LIMIT);
+
+  // Let the process reader continue once its output was collected.
+  auto size = batch_.size();
+  output_.drain(batch_, WRITE_BATCH_LIMIT);
+  process_.consume(batch_.size() - size);
+
+  size = batch_.size();
+  captured_.drain(batch_, WRITE_BATCH_LIMIT);
+  capture_.consume(batch_.size() - size);
+
+  // Let the next wakeup handle the remaining strings.
+  if (queue_.depth() || output_.depth() || captured_.depth()) {
+    PostMessage(hwnd_, WM_APP_WRITE, 0, 0);
+  }
+
+  // Split the batch into styled spans.
+  if (batch_.empty()) {
+    return;
+  }
+
+  // Mirror the complete lines of the batch before it is split.
+  if (mirror_.is_open()) {
+    try {
+      mirror_.append(batch_.data(), batch_.size());
+    }
+    catch (const std::exception& e) {
+      mirror_.close();
+      batch_.append(std::string("\n[") + e.what() + "]\n");
+    }
+  }
+  spans_.clear();
+  parser_.parse(batch_.data(), batch_.size(), spans_);
+
+#ifdef CONSOLE_VIEW
+  // Write the text without styles to the console view.
+  text_.clear();
+  for (const auto& span : spans_) {
+    append_utf16(text_, span.data, span.size);
+  }
+  view_.append(text_.data(), text_.size());
+#else
+  CHARRANGE cr = { -1, -1 };
+  SendMessage(console_, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&cr));
+
+  // Insert consecutive spans with the same style at once.
+  std::size_t trim = 0;
+  for (std::size_t i = 0; i < spans_.size();) {
+    auto style = spans_[i].style;
+    text_.clear();
+    for (; i < spans_.size() && spans_[i].style == style; i++) {
+      append_utf16(text_, spans_[i].data, spans_[i].size);
+    }
+    if (style != style_) {
+      auto cf = make_format(style);
+      SendMessage(console_, EM_SETCHARFORMAT, SCF_SELECTION, reinterpret_cast<LPARAM>(&cf));
+      style_ = style;
+    }
+    SendMessage(console_, EM_REPLACESEL, 0, reinterpret_cast<LPARAM>(text_.c_str()));
+    trim += scrollback_.append(text_.data(), text_.size());
+  }
+
+  // Trim old lines in a single chunk.
+  if (trim) {
+    cr = { 0, static_cast<LONG>(trim) };
+    SendMessage(console_, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&cr));
+    SendMessage(console_, EM_REPLACESEL, 0, reinterpret_cast<LPARAM>(L""));
+  }
+  SendMessage(console_, WM_VSCROLL, SB_BOTTOM, 0);
+#endif
+}
+
+#ifdef CONSOLE_VIEW
+void window::find(const std::wstring& pattern)
+{
+  // Highlight the visible matches at once and stop counting the previous pattern.
+  pattern_ = pattern;
+  view_.set_pattern(pattern);
+  if (search_) {
+    search_->store(true);
+  }
+  search_ = std::make_shared<std::atomic<bool>>(false);
+  search_matches_ = 0;
+  search_pending_ = 0;
+
+  // Count the matches in tasks of about FIND_TASK_CHARS characters and add up the counts as they arrive.
+  auto texts = pattern.empty() ? std::vector<line_store::text>() : view_.snapshot();
+  auto shared = std::make_shared<const std::wstring>(pattern);
+  for (std::size_t begin = 0, end = 0; begin < texts.size(); begin = end) {
+    std::size_t chars = 0;
+    while (end < texts.size() && chars < FIND_TASK_CHARS) {
+      chars += texts[end++].size;
+    }
+    auto task = std::make_shared<std::vector<line_store::text>>(texts.begin() + begin, texts.begin() + end);
+    auto cancelled = search_;
+    search_pending_++;
+    pool_.submit([task, shared, cancelled]() {
+      std::size_t count = 0;
+      for (const auto& text : *task) {
+        if (cancelled->load(std::memory_order_relaxed)) {
+          break;
+        }
+        count += text_count(text.data, text.data + text.size, shared->data(), shared->size());
+      }
+      return count;
+    }, [this, cancelled](std::size_t count) {
+      if (!cancelled->load(std::memory_order_relaxed)) {
+        search_matches_ += count;
+        search_pending_--;
+        update_find();
+      }
+    });
+  }
+  update_find();
+}
+
+void window::show_find(bool show)
+{
+  // Give the find bar its height and search for the text that is left in the find box.
+  auto& bar = layout_[find_bar_];
+  bar.height = show ? FIND_HEIGHT : 0;
+  bar.margin.top = show ? MARGIN : 0;
+  ShowWindow(find_, show ? SW_SHOW : SW_HIDE);
+  ShowWindow(find_status_, show ? SW_SHOW : SW_HIDE);
+  RECT rc = {};
+  GetClientRect(hwnd_, &rc);
+  on_size(rc.right - rc.left, rc.bottom - rc.top);
+  if (show) {
+    SetFocus(find_);
+    SendMessage(find_, EM_SETSEL, 0, -1);
+    on_command(IDC_FIND);
+  } else {
+    SetFocus(console_);
+    find(L"");
+  }
+}
+
+void window::update_find()
+{
+  // Show the count so far while tasks are pending.
+  wchar_t status[64] = {};
+  if (!pattern_.empty()) {
+    std::swprintf(status, 64, search_pending_ ? L"%zu matches..." : L"%zu matches", search_matches_);
+  }
+  SetWindowText(find_status_, status);
+}
+
+LRESULT CALLBACK window::find_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam, UINT_PTR id, DWORD_PTR data)
+{
+  // Close the find bar with escape and keep the edit control from beeping on escape and enter.
+  auto self = reinterpret_cast<window*>(data);
+  switch (msg) {
+  case WM_KEYDOWN:
+    if (wparam == VK_ESCAPE) {
+      self->show_find(false);
+      return 0;
+    }
+    break;
+  case WM_CHAR:
+    if (wparam == VK_ESCAPE || wparam == VK_RETURN) {
+      return 0;
+    }
+    break;
+  case WM_NCDESTROY:
+    RemoveWindowSubclass(hwnd, find_proc, id);
+    break;
+  }
+  return DefSubclassProc(hwnd, msg, wparam, lparam);
+}
+#endif
+
+void window::on_process()
+{
+  // Write the remaining output and report how the process ended.
+  on_write();
+  DWORD code = 0;
+  if (process_.exited(code)) {
+    write("\n[process exited with code " + std::to_string(code) + "]\n");
+  } else {
+    write("\n[process closed its output]\n");
+  }
+  process_.stop();
+  loop_.timers().cancel(stats_timer_);
+  SetWindowText(hwnd_, PROJECT);
+}
+
+void window::on_flush()
+{
+  capture_.flush();
+  loop_.timers().schedule(flush_timer_, CAPTURE_FLUSH_INTERVAL);
+}
+
+void window::on_stats()
+{
+  // Show the throughput and the backpressure state in the title bar.
+  auto stats = process_.stats();
+  auto now = GetTickCount();
+  auto seconds = std::max(1UL, now - stats_time_) / 1000.0;
+  auto rate = (stats.bytes - stats_bytes_) / seconds / (1024.0 * 1024.0);
+  stats_bytes_ = stats.bytes;
+  stats_time_ = now;
+
+  wchar_t title[128] = {};
+  std::swprintf(title, 128, L"%ls - %.2f MiB/s, %llu stalls, %zu KiB pending", PROJECT, rate,
+    static_cast<unsigned long long>(stats.stalls), stats.pending / 1024);
+  SetWindowText(hwnd_, title);
+  loop_.timers().schedule(stats_timer_, STATS_INTERVAL);
 }
 
 void window::on_command(UINT id)
@@ -156,36 +845,43 @@ void window::on_command(UINT id)
   case IDM_EXIT:
     PostMessage(hwnd_, WM_CLOSE, 0, 0);
     break;
+#ifdef PROFILER
+  case IDM_PROFILE:
+    write(profiler::instance().report());
+    break;
+#endif
+#ifdef TRACER
+  case IDM_TRACE:
+    MessageBox(hwnd_, (L"The trace was saved to " + tracer::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
+  case IDM_BENCHMARK:
+    benchmark();
+    break;
+#ifdef CONSOLE_VIEW
+  case IDM_FIND:
+    if (find_) {
+      show_find(true);
+    }
+    break;
+  case IDC_FIND: {
+    // Edit notifications are not distinguished, so search whenever the text differs from the pattern.
+    std::wstring pattern(static_cast<std::size_t>(GetWindowTextLength(find_)) + 1, L'\0');
+    pattern.resize(static_cast<std::size_t>(GetWindowText(find_, &pattern[0], static_cast<int>(pattern.size()))));
+    if (IsWindowVisible(find_) && pattern != pattern_) {
+      find(pattern);
+    }
+  } break;
+#endif
   }
 }
 
-LRESULT window::handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+bool window::on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
 {
-  // Handle windows messages.
-  try {
-    switch (msg) {
-    case WM_CREATE:
-      hwnd_ = hwnd;
-      on_create();
-      return 0;
-    case WM_DESTROY:
-      on_destroy();
-      hwnd_ = nullptr;
-      return 0;
-    case WM_SIZE:
-      on_size(LOWORD(lparam), HIWORD(lparam));
-      return 0;
-    case WM_COMMAND:
-      on_command(LOWORD(wparam));
-      return 0;
-    }
-  }
-  catch (const std::exception& e) {
-    std::wstring msg;
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0) + 1);
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &msg[0], static_cast<int>(msg.size())));
-    MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
-    DestroyWindow(hwnd);
+  // Handle application messages.
+  if (msg == WM_APP_WRITE) {
+    on_write();
+    return true;
   }
-  return DefWindowProc(hwnd, msg, wparam, lparam);
+  return false;
 }
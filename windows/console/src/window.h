@@ -1,23 +1,144 @@
 #pragma once
+#include "capture.h"
+#include "console_view.h"
+#include "coroutine.h"
+#include "event_loop.h"
+#include "layout.h"
+#include "log_mirror.h"
+#include "log_queue.h"
+#include "process.h"
+#include "scrollback.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
+#include "vt_parser.h"
+#include "window_base.h"
 #include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
-class window {
+#define WM_APP_WRITE (WM_APP + 1)
+
+class window : public window_base<window> {
 public:
-  window(HINSTANCE instance);
+  window(HINSTANCE instance, event_loop& loop, thread_pool& pool);
+
+  // Queues a string for the console control. Can be called from any thread.
+  void write(std::string str);
+
+  // Limits the console control to the given number of lines and bytes.
+  void set_scrollback(std::size_t lines, std::size_t bytes);
+
+  // Returns the number of bytes held by the console control.
+  std::size_t memory() const;
+
+  // Starts a child process and streams its output into the console control.
+  void run(const std::wstring& command);
+
+  // Activates the window and writes the non-empty command lines that other instances forwarded to the console.
+  void open(const std::vector<std::wstring>& commands);
+
+  // Redirects stdout, stderr and the CRT streams of this process into the console control.
+  void capture_output();
+
+  // Appends everything written to the console to the log segments <executable>.console.<n>.log.
+  void mirror_output();
+
+#ifdef CONSOLE_VIEW
+  // Highlights the pattern in the console view and counts its occurrences in the scrollback on the pool.
+  // Every call cancels the count of the previous pattern.
+  void find(const std::wstring& pattern);
+#endif
+
+  // Reports the time from the given clock_ticks() timestamp to the first paint and to the creation of the controls.
+  void measure_startup(std::uint64_t start);
 
-  void write(const std::string& str);
+  // Runs the capture benchmark in the background and writes the result to the console.
+#ifdef COROUTINES
+  async benchmark();
+#else
+  void benchmark();
+#endif
 
   void on_create();
   void on_destroy();
+  void on_paint();
   void on_size(int cx, int cy);
+  void on_entersizemove();
+  void on_exitsizemove();
   void on_command(UINT id);
+  void on_write();
+  void on_process();
+  void on_stats();
+  void on_flush();
+
+  using messages = message_list<WM_APP_WRITE>;
+  bool on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result);
 
 private:
-  LRESULT handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+  // Creates the border and console controls and takes ownership of the font.
+  void create_controls(HFONT font);
+  void report_startup();
+
+  // Posts a write wakeup from any thread.
+  void wake();
+
+  // Queues a chunk of pipe output from a reader thread. Returns false if the queue is full.
+  bool push_output(log_queue& queue, const char* data, std::size_t size);
+
+#ifdef CONSOLE_VIEW
+  // Shows or hides the find bar below the console.
+  void show_find(bool show);
+  void update_find();
+  static LRESULT CALLBACK find_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam, UINT_PTR id, DWORD_PTR data);
+#endif
 
   HINSTANCE instance_;
-  HWND hwnd_ = nullptr;
+  event_loop& loop_;
+  thread_pool& pool_;
   HWND border_ = nullptr;
   HWND console_ = nullptr;
+  HFONT font_ = nullptr;
+  layout layout_;
+  bool sizing_ = false;
+
+  std::atomic<HWND> wakeup_ = { nullptr };
+  log_queue queue_;
+  log_queue output_;
+  log_queue captured_;
+  scrollback scrollback_;
+#ifdef CONSOLE_VIEW
+  console_view view_;
+  HWND find_ = nullptr;
+  HWND find_status_ = nullptr;
+  layout::node_id find_bar_ = 0;
+  std::wstring pattern_;
+  std::shared_ptr<std::atomic<bool>> search_;
+  std::size_t search_matches_ = 0;
+  std::size_t search_pending_ = 0;
+#endif
+  std::string batch_;
+  std::wstring text_;
+
+  vt_parser parser_;
+  std::vector<vt_span> spans_;
+  vt_style style_;
+
+  process process_;
+  std::uint64_t stats_bytes_ = 0;
+  DWORD stats_time_ = 0;
+  timer_wheel::timer stats_timer_;
+
+  capture capture_;
+  timer_wheel::timer flush_timer_;
+  bool benchmarking_ = false;
+
+  log_mirror mirror_;
+
+  std::uint64_t start_ = 0;
+  std::uint64_t painted_ = 0;
+  std::uint64_t ready_ = 0;
+  bool reported_ = false;
 };
@@ -0,0 +1,61 @@
+#include "coroutine.h"
+#include "task_queue.h"
+#include "benchmark.h"
+
+#define RESUME_COUNT  2000000   // suspensions per run
+#define FRAME_COUNT   2000000   // coroutine frames per run
+
+namespace {
+
+task_queue ui;
+
+async resume_loop(long count, long& resumed)
+{
+  for (long i = 0; i < count; i++) {
+    co_await resume_on([](thread_pool::task t) {
+      ui.post(std::move(t));
+    });
+    resumed++;
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  // Suspend and resume through a task queue, like resume_on_ui through the event loop.
+  long resumed = 0;
+  auto start = clock_ticks();
+  resume_loop(RESUME_COUNT, resumed);
+  while (resumed < RESUME_COUNT) {
+    ui.run();
+  }
+  auto end = clock_ticks();
+  report("coroutine suspend and resume", elapsed_ns(start, end) / RESUME_COUNT, "ns");
+
+  // Create and destroy a coroutine that completes at once, which allocates and releases a pooled frame.
+  start = clock_ticks();
+  for (long i = 0; i < FRAME_COUNT; i++) {
+    long unused = 0;
+    resume_loop(0, unused);
+  }
+  end = clock_ticks();
+  report("coroutine frame create and destroy", elapsed_ns(start, end) / FRAME_COUNT, "ns");
+
+  // Allocation of a frame with the pool and with the global allocator.
+  start = clock_ticks();
+  for (long i = 0; i < FRAME_COUNT; i++) {
+    coroutine_frames::deallocate(coroutine_frames::allocate(200), 200);
+  }
+  end = clock_ticks();
+  report("coroutine_frames allocate and release", elapsed_ns(start, end) / FRAME_COUNT, "ns");
+  start = clock_ticks();
+  for (long i = 0; i < FRAME_COUNT; i++) {
+    auto frame = ::operator new(200);
+    // Keep the allocation from being elided.
+    static_cast<volatile char*>(frame)[0] = 0;
+    ::operator delete(frame);
+  }
+  end = clock_ticks();
+  report("operator new and delete", elapsed_ns(start, end) / FRAME_COUNT, "ns");
+}
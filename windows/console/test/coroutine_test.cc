@@ -0,0 +1,97 @@
+#include "coroutine.h"
+#include "task_queue.h"
+#include "check.h"
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+task_queue ui;
+std::thread::id ui_thread;
+
+auto resume_on_queue()
+{
+  return resume_on([](thread_pool::task t) {
+    ui.post(std::move(t));
+  });
+}
+
+async hop(thread_pool& pool, int& done)
+{
+  CHECK(std::this_thread::get_id() == ui_thread);
+  co_await resume_background(pool);
+  CHECK(std::this_thread::get_id() != ui_thread);
+  co_await resume_on_queue();
+  CHECK(std::this_thread::get_id() == ui_thread);
+  done++;
+}
+
+async fail(thread_pool& pool)
+{
+  co_await resume_background(pool);
+  throw std::runtime_error("coroutine");
+}
+
+void test_resume()
+{
+  // Coroutines hop to the pool and back, and escaping exceptions reach the error handler.
+  ui_thread = std::this_thread::get_id();
+  async::set_error_handler([](std::exception_ptr e, void*) {
+    ui.post([e]() {
+      std::rethrow_exception(e);
+    });
+  }, nullptr);
+
+  thread_pool pool(2);
+  auto done = 0;
+  auto errors = 0;
+  for (int i = 0; i < 100; i++) {
+    hop(pool, done);
+  }
+  fail(pool);
+  while (done < 100 || !errors) {
+    try {
+      ui.run();
+    }
+    catch (const std::runtime_error&) {
+      errors++;
+    }
+    std::this_thread::yield();
+  }
+  pool.wait();
+  CHECK(errors == 1);
+}
+
+void test_frames()
+{
+  // Released frames of a size class are reused and large frames bypass the pool.
+  auto a = coroutine_frames::allocate(100);
+  coroutine_frames::deallocate(a, 100);
+  auto b = coroutine_frames::allocate(128);
+  CHECK(a == b);
+  coroutine_frames::deallocate(b, 128);
+
+  std::set<void*> frames;
+  for (int i = 0; i < 1000; i++) {
+    CHECK(frames.insert(coroutine_frames::allocate(64)).second);
+  }
+  for (auto frame : frames) {
+    coroutine_frames::deallocate(frame, 64);
+  }
+  auto large = coroutine_frames::allocate(1 << 16);
+  coroutine_frames::deallocate(large, 1 << 16);
+
+  // Frames released on another thread return through the shared pool.
+  std::thread([]() {
+    coroutine_frames::deallocate(coroutine_frames::allocate(200), 200);
+  }).join();
+}
+
+}  // namespace
+
+int main()
+{
+  test_resume();
+  test_frames();
+}
@@ -0,0 +1,35 @@
+#include "histogram.h"
+#include "benchmark.h"
+#include <random>
+#include <vector>
+
+#define VALUE_COUNT   4096        // distinct values, as latencies in nanoseconds
+#define RECORD_COUNT  100000000   // values per run
+#define QUERY_COUNT   100000      // percentile queries per run
+
+int main()
+{
+  std::mt19937_64 random(1);
+  std::lognormal_distribution<double> latency(10.0, 2.0);
+  std::vector<std::uint64_t> values(VALUE_COUNT);
+  for (auto& value : values) {
+    value = static_cast<std::uint64_t>(latency(random));
+  }
+
+  histogram h;
+  auto start = clock_ticks();
+  for (int i = 0; i < RECORD_COUNT; i++) {
+    h.record(values[i & (VALUE_COUNT - 1)]);
+  }
+  auto end = clock_ticks();
+  report("histogram record", elapsed_ns(start, end) / RECORD_COUNT, "ns");
+
+  std::uint64_t sum = 0;
+  start = clock_ticks();
+  for (int i = 0; i < QUERY_COUNT; i++) {
+    sum += h.percentile(99);
+  }
+  end = clock_ticks();
+  report("histogram p99 query", elapsed_ns(start, end) / QUERY_COUNT, "ns");
+  report("histogram p99", static_cast<double>(sum / QUERY_COUNT) / 1e3, "us");
+}
@@ -0,0 +1,113 @@
+#include "histogram.h"
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+void test_buckets()
+{
+  // Small values are exact.
+  for (std::uint64_t value = 0; value < 16; value++) {
+    CHECK(histogram::bucket(value) == value);
+    CHECK(histogram::upper_bound(histogram::bucket(value)) == value);
+  }
+
+  // Every bucket starts right after the previous one and is at most 1/16 of its values wide.
+  std::uint64_t lower = 0;
+  for (std::size_t i = 0; i < histogram::buckets - 1; i++) {
+    auto upper = histogram::upper_bound(i);
+    CHECK(upper >= lower);
+    CHECK(histogram::bucket(lower) == i);
+    CHECK(histogram::bucket(upper) == i);
+    CHECK(upper - lower <= lower / 16);
+    lower = upper + 1;
+  }
+  CHECK(histogram::bucket(lower) == histogram::buckets - 1);
+  CHECK(histogram::bucket(UINT64_MAX) == histogram::buckets - 1);
+}
+
+void test_statistics()
+{
+  histogram h;
+  CHECK(h.count() == 0);
+  CHECK(h.mean() == 0.0);
+  CHECK(h.percentile(50) == 0);
+
+  for (std::uint64_t value = 1; value <= 10; value++) {
+    h.record(value);
+  }
+  CHECK(h.count() == 10);
+  CHECK(h.sum() == 55);
+  CHECK(h.max() == 10);
+  CHECK(h.mean() == 5.5);
+  CHECK(h.percentile(0) == 1);
+  CHECK(h.percentile(50) == 5);
+  CHECK(h.percentile(90) == 9);
+  CHECK(h.percentile(100) == 10);
+
+  // The percentile is limited by the maximum even if the bucket is wider.
+  h.record(1000001);
+  CHECK(h.percentile(100) == 1000001);
+
+  h.reset();
+  CHECK(h.count() == 0);
+  CHECK(h.sum() == 0);
+  CHECK(h.max() == 0);
+  CHECK(h.percentile(99) == 0);
+}
+
+// Compares the percentiles with exact ranks of random latencies.
+void test_percentiles()
+{
+  std::mt19937_64 random(1);
+  std::lognormal_distribution<double> latency(10.0, 2.0);
+  for (int round = 0; round < 20; round++) {
+    histogram h;
+    std::vector<std::uint64_t> values(1 + random() % 10000);
+    for (auto& value : values) {
+      value = static_cast<std::uint64_t>(latency(random));
+      h.record(value);
+    }
+    std::sort(values.begin(), values.end());
+    for (double p : { 0.0, 1.0, 50.0, 90.0, 99.0, 99.9, 100.0 }) {
+      auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * values.size()));
+      auto exact = values[std::max<std::size_t>(rank, 1) - 1];
+      auto estimate = h.percentile(p);
+      CHECK(estimate >= exact);
+      CHECK(estimate - exact <= exact / 16);
+    }
+  }
+}
+
+void test_merge()
+{
+  histogram a;
+  histogram b;
+  histogram all;
+  std::mt19937_64 random(2);
+  for (int i = 0; i < 1000; i++) {
+    auto value = random() % 100000;
+    (i % 3 ? a : b).record(value);
+    all.record(value);
+  }
+  a.merge(b);
+  CHECK(a.count() == all.count());
+  CHECK(a.sum() == all.sum());
+  CHECK(a.max() == all.max());
+  for (double p = 0.0; p <= 100.0; p += 0.5) {
+    CHECK(a.percentile(p) == all.percentile(p));
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_buckets();
+  test_statistics();
+  test_percentiles();
+  test_merge();
+}
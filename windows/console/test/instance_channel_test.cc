@@ -0,0 +1,105 @@
+#include "instance_channel.h"
+#include "check.h"
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Returns a channel name that does not collide with parallel test runs.
+std::wstring channel_name(const wchar_t* name)
+{
+  return name + std::to_wstring(getpid());
+}
+
+void test_instances()
+{
+  auto name = channel_name(L"instance channel test ");
+  instance_channel primary;
+  CHECK(primary.open(name, 4096));
+  CHECK(primary.primary());
+
+  // Arbitrary text survives the round trip.
+  std::vector<std::wstring> messages;
+  {
+    instance_channel secondary;
+    CHECK(secondary.open(name, 4096));
+    CHECK(!secondary.primary());
+    CHECK(secondary.send(L"C:\\Users\\file.txt"));
+    CHECK(secondary.send(L""));
+    CHECK(secondary.send(L"\u00E9\u20AC \U0001F600"));
+  }
+  CHECK(primary.receive(messages) == 3);
+  CHECK(messages[0] == L"C:\\Users\\file.txt");
+  CHECK(messages[1].empty());
+  CHECK(messages[2] == L"\u00E9\u20AC \U0001F600");
+
+  // A full ring makes the sender give up after the timeout.
+  instance_channel secondary;
+  CHECK(secondary.open(name, 4096));
+  std::wstring large(200, L'x');
+  std::size_t sent = 0;
+  while (secondary.send(large, 10)) {
+    sent++;
+  }
+  messages.clear();
+  CHECK(primary.receive(messages) == sent);
+  CHECK(secondary.send(large, 10));
+}
+
+void test_processes()
+{
+  // Forked writers send concurrently. Every message arrives once, intact and in writer order.
+  auto name = channel_name(L"instance channel processes ");
+  instance_channel primary;
+  CHECK(primary.open(name, 4096));
+  CHECK(primary.primary());
+  const int writers = 16;
+  const int count = 2000;
+  for (int w = 0; w < writers; w++) {
+    if (fork() == 0) {
+      instance_channel channel;
+      if (!channel.open(name, 4096) || channel.primary()) {
+        _exit(2);
+      }
+      for (int i = 0; i < count; i++) {
+        if (!channel.send(std::to_wstring(w) + L" " + std::to_wstring(i) + L" " + std::wstring(i % 50, L'x'), 5000)) {
+          _exit(3);
+        }
+      }
+      _exit(0);
+    }
+  }
+
+  std::set<std::wstring> seen;
+  std::vector<int> next(writers, 0);
+  std::vector<std::wstring> messages;
+  while (seen.size() < static_cast<std::size_t>(writers * count)) {
+    messages.clear();
+    primary.receive(messages);
+    for (const auto& m : messages) {
+      CHECK(seen.insert(m).second);
+      auto w = std::stoi(m);
+      auto i = std::stoi(m.substr(m.find(L' ') + 1));
+      CHECK(w >= 0 && w < writers);
+      CHECK(i == next[w]);
+      CHECK(m.size() == m.rfind(L' ') + 1 + static_cast<std::size_t>(i % 50));
+      next[w]++;
+    }
+  }
+  for (int w = 0; w < writers; w++) {
+    int status = 0;
+    CHECK(wait(&status) > 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_instances();
+  test_processes();
+}
@@ -0,0 +1,65 @@
+#include "ipc_ring.h"
+#include "instance_channel.h"
+#include "benchmark.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#define MESSAGE_COUNT 10000000    // ring messages per run
+#define MESSAGE_SIZE  64          // bytes per ring message
+#define OPEN_COUNT    1000        // secondary instances per run
+
+int main()
+{
+  // Write and read in turns on one thread.
+  std::vector<char> memory(ipc_ring::size(65536), 0);
+  ipc_ring ring(memory.data(), memory.size());
+  std::string data(MESSAGE_SIZE, 'x');
+  std::vector<char> message;
+  auto start = clock_ticks();
+  for (int i = 0; i < MESSAGE_COUNT; i++) {
+    ring.write(data.data(), data.size());
+    ring.read(message);
+  }
+  auto end = clock_ticks();
+  report("ipc_ring write and read", elapsed_ns(start, end) / MESSAGE_COUNT, "ns");
+
+  // A producer thread and the consumer.
+  start = clock_ticks();
+  std::thread producer([&ring, &data]() {
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+      while (!ring.write(data.data(), data.size())) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (int i = 0; i < MESSAGE_COUNT;) {
+    if (ring.read(message)) {
+      i++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  end = clock_ticks();
+  report("ipc_ring with producer thread", elapsed_ns(start, end) / MESSAGE_COUNT, "ns");
+
+  // A secondary instance opens the channel, forwards a file name and closes it, as on a second launch.
+  auto name = L"instance channel benchmark " + std::to_wstring(getpid());
+  instance_channel primary;
+  if (!primary.open(name, 65536)) {
+    return 1;
+  }
+  std::vector<std::wstring> messages;
+  start = clock_ticks();
+  for (int i = 0; i < OPEN_COUNT; i++) {
+    instance_channel secondary;
+    secondary.open(name, 65536);
+    secondary.send(L"C:\\Users\\Public\\Documents\\file.txt");
+    primary.receive(messages);
+  }
+  end = clock_ticks();
+  report("secondary open, send and close", elapsed_ns(start, end) / OPEN_COUNT / 1e3, "us");
+  report("messages received", static_cast<double>(messages.size()), "messages");
+}
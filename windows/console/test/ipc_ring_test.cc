@@ -0,0 +1,270 @@
+#include "ipc_ring.h"
+#include "check.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+void test_empty()
+{
+  // Zero-filled memory is an empty ring.
+  std::vector<char> memory(ipc_ring::size(256), 0);
+  ipc_ring ring(memory.data(), memory.size());
+  CHECK(ring.capacity() == 256);
+  std::vector<char> message;
+  CHECK(!ring.read(message));
+
+  // Messages that can never fit are rejected.
+  std::string large(300, 'x');
+  CHECK(!ring.write(large.data(), large.size()));
+  CHECK(ring.write("", 0));
+  CHECK(ring.read(message));
+  CHECK(message.empty());
+}
+
+void test_full()
+{
+  std::vector<char> memory(ipc_ring::size(256), 0);
+  ipc_ring ring(memory.data(), memory.size());
+  std::string data(60, 'a');
+  std::size_t written = 0;
+  while (ring.write(data.data(), data.size())) {
+    written++;
+  }
+  CHECK(written >= 3 && written <= 4);
+
+  // Reading frees the space again.
+  std::vector<char> message;
+  CHECK(ring.read(message));
+  CHECK(std::string(message.begin(), message.end()) == data);
+  CHECK(ring.write(data.data(), data.size()));
+}
+
+void test_wrap()
+{
+  // Messages of varying sizes wrap around the ring many times and arrive in order.
+  std::vector<char> memory(ipc_ring::size(256), 0);
+  ipc_ring ring(memory.data(), memory.size());
+  std::vector<char> message;
+  int next_write = 0;
+  int next_read = 0;
+  for (int round = 0; round < 100000; round++) {
+    auto data = std::to_string(next_write) + ":" + std::string(round % 37, static_cast<char>('a' + round % 26));
+    if (ring.write(data.data(), data.size())) {
+      next_write++;
+    }
+    if (round % 3 == 0) {
+      while (ring.read(message)) {
+        std::string text(message.begin(), message.end());
+        CHECK(text.substr(0, text.find(':')) == std::to_string(next_read));
+        next_read++;
+      }
+    }
+  }
+  while (ring.read(message)) {
+    next_read++;
+  }
+  CHECK(next_read == next_write);
+}
+
+void test_threads()
+{
+  // Every message of every producer arrives once, intact and in producer order.
+  std::vector<char> memory(ipc_ring::size(1024), 0);
+  ipc_ring ring(memory.data(), memory.size());
+  const int producers = 4;
+  const int count = 50000;
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&ring, p]() {
+      for (int i = 0; i < count; i++) {
+        auto data = std::to_string(p) + " " + std::to_string(i) + " " + std::string(i % 50, 'x');
+        while (!ring.write(data.data(), data.size())) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<int> next(producers, 0);
+  std::vector<char> message;
+  for (int received = 0; received < producers * count;) {
+    if (!ring.read(message)) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::string text(message.begin(), message.end());
+    auto p = std::stoi(text);
+    auto i = std::stoi(text.substr(text.find(' ') + 1));
+    CHECK(p >= 0 && p < producers);
+    CHECK(i == next[p]);
+    CHECK(text.size() == text.rfind(' ') + 1 + static_cast<std::size_t>(i % 50));
+    next[p]++;
+    received++;
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+// Maps shared memory for a ring that is written by child processes.
+void* map_shared(std::size_t size)
+{
+  auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  CHECK(memory != MAP_FAILED);
+  return memory;
+}
+
+void test_abandoned()
+{
+  // A producer that crashes while it copies its message leaves a reserved record behind.
+  auto size = ipc_ring::size(256);
+  auto memory = map_shared(size);
+  ipc_ring ring(memory, size);
+  CHECK(ring.write("first", 5));
+  auto pid = fork();
+  if (!pid) {
+    auto page = mmap(nullptr, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ring.write(page, 16);
+    _exit(0);
+  }
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFSIGNALED(status));
+  CHECK(ring.write("second", 6));
+
+  // The consumer waits for the record until the timeout and then skips it.
+  std::vector<char> message;
+  CHECK(ring.read(message, 50));
+  CHECK(std::string(message.begin(), message.end()) == "first");
+  CHECK(!ring.read(message, 50));
+  CHECK(ring.stalled());
+  CHECK(!ring.read(message, 50));
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  CHECK(ring.read(message, 50));
+  CHECK(std::string(message.begin(), message.end()) == "second");
+  CHECK(ring.skipped() == 1);
+  CHECK(!ring.read(message, 50));
+  CHECK(!ring.stalled());
+
+  // The ring keeps working across many laps.
+  for (int i = 0; i < 1000; i++) {
+    auto data = std::to_string(i);
+    CHECK(ring.write(data.data(), data.size()));
+    CHECK(ring.read(message, 50));
+    CHECK(std::string(message.begin(), message.end()) == data);
+  }
+  munmap(memory, size);
+}
+
+// Fills a message with its producer, its number and a length and pattern that depend on the number.
+std::size_t make_message(char* data, char producer, std::uint32_t number)
+{
+  auto size = 64 + number % 1000;
+  data[0] = producer;
+  std::memcpy(data + 1, &number, 4);
+  std::memset(data + 5, static_cast<int>(number & 0xFF), size - 5);
+  return size;
+}
+
+bool check_message(const std::vector<char>& message, char& producer, std::uint32_t& number)
+{
+  char expected[1100];
+  if (message.size() < 5) {
+    return false;
+  }
+  producer = message[0];
+  std::memcpy(&number, message.data() + 1, 4);
+  auto size = make_message(expected, producer, number);
+  return message.size() == size && std::memcmp(message.data(), expected, size) == 0;
+}
+
+void test_killed()
+{
+  // Producer processes are killed at random points, also between reserving and publishing a message.
+  // The ring skips what they left behind, and the messages of a surviving thread arrive intact and in order.
+  auto size = ipc_ring::size(8192);
+  auto memory = map_shared(size);
+  ipc_ring ring(memory, size);
+
+  std::atomic<bool> done = { false };
+  std::thread killer([&ring, &done]() {
+    std::mt19937 random(1);
+    auto parent = getpid();
+    for (int kills = 0; kills < 200; kills++) {
+      auto pid = fork();
+      if (!pid) {
+        // Only write in the child, without allocating.
+        char data[1100];
+        for (std::uint32_t number = 0; getppid() == parent; number++) {
+          auto size = make_message(data, 'k', number);
+          while (!ring.write(data, size) && getppid() == parent) {
+            sched_yield();
+          }
+        }
+        _exit(0);
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(random() % 2000));
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+    done = true;
+  });
+
+  std::atomic<std::uint32_t> written = { 0 };
+  std::atomic<bool> finished = { false };
+  std::thread survivor([&ring, &done, &written, &finished]() {
+    char data[1100];
+    for (std::uint32_t number = 0; !done; number++) {
+      auto size = make_message(data, 's', number);
+      while (!ring.write(data, size)) {
+        std::this_thread::yield();
+      }
+      written = number + 1;
+    }
+    finished = true;
+  });
+
+  std::vector<char> message;
+  std::uint32_t received = 0;
+  std::uint64_t killed = 0;
+  while (!finished || received != written) {
+    if (!ring.read(message)) {
+      std::this_thread::yield();
+      continue;
+    }
+    char producer = 0;
+    std::uint32_t number = 0;
+    CHECK(check_message(message, producer, number));
+    if (producer == 's') {
+      CHECK(number == received);
+      received++;
+    } else {
+      killed++;
+    }
+  }
+  killer.join();
+  survivor.join();
+  CHECK(killed > 0);
+  munmap(memory, size);
+}
+
+}  // namespace
+
+int main()
+{
+  test_empty();
+  test_full();
+  test_wrap();
+  test_threads();
+  test_abandoned();
+  test_killed();
+}
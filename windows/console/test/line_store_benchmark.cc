@@ -0,0 +1,45 @@
+#include "line_store.h"
+#include "benchmark.h"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#define LINE_SIZE     80          // characters per line including the line break
+#define LINE_COUNT    10000000    // lines per run
+#define BATCH_LINES   1000        // lines per append, as in a console batch
+#define LOOKUPS       10000000    // random line lookups
+
+int main()
+{
+  // Append batches far beyond the default console limits.
+  line_store store;
+  store.set_limits(100000, 32 << 20);
+  std::wstring batch;
+  for (int i = 0; i < BATCH_LINES; i++) {
+    batch.append(LINE_SIZE - 1, L'x');
+    batch += L'\n';
+  }
+  auto start = clock_ticks();
+  for (int i = 0; i < LINE_COUNT / BATCH_LINES; i++) {
+    store.append(batch.data(), batch.size());
+  }
+  auto end = clock_ticks();
+  report("line_store append per line", elapsed_ns(start, end) / LINE_COUNT, "ns");
+
+  // Look up random lines like a paint of a random scroll position.
+  std::mt19937 random(1);
+  std::vector<std::size_t> indices(1 << 16);
+  for (auto& index : indices) {
+    index = random() % store.size();
+  }
+  std::size_t sum = 0;
+  start = clock_ticks();
+  for (std::size_t i = 0; i < LOOKUPS; i++) {
+    sum += store.get(indices[i & (indices.size() - 1)]).size;
+  }
+  end = clock_ticks();
+  report("line_store random lookup", elapsed_ns(start, end) / LOOKUPS, "ns");
+  report("line_store memory", static_cast<double>(store.memory()) / (1 << 20), "MiB");
+  return sum ? 0 : 1;
+}
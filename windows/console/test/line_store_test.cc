@@ -0,0 +1,222 @@
+#include "line_store.h"
+#include "check.h"
+#include "text_search.h"
+#include <atomic>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::wstring line_text(const line_store& store, std::size_t index)
+{
+  auto l = store.get(index);
+  return std::wstring(l.data, l.size);
+}
+
+void test_lines()
+{
+  line_store store;
+  store.append(L"a\tb\r\nc", 6);
+  CHECK(store.size() == 2);
+  CHECK(line_text(store, 0) == L"a       b");
+  CHECK(line_text(store, 1) == L"c");
+  CHECK(store.columns() == 9);
+
+  // The open line continues with the next append.
+  store.append(L"d\n\n", 3);
+  CHECK(store.size() == 3);
+  CHECK(line_text(store, 1) == L"cd");
+  CHECK(line_text(store, 2).empty());
+
+  store.clear();
+  CHECK(store.size() == 0);
+}
+
+void test_limits()
+{
+  line_store store;
+  store.set_limits(8, 1 << 20);
+  for (int i = 0; i < 9; i++) {
+    CHECK(store.append(L"line\n", 5) == 0);
+  }
+
+  // Lines are trimmed once the limit is exceeded by more than an eighth.
+  CHECK(store.append(L"last\n", 5) == 2);
+  CHECK(store.size() == 8);
+  CHECK(line_text(store, 7) == L"last");
+}
+
+void test_moved_line()
+{
+  line_store store(256);
+  store.set_limits(1, 1 << 20);
+  store.append(L"first\n", 6);
+
+  // The open line outgrows the first chunk and moves into a new one after the terminated line was trimmed.
+  std::wstring text(200, L'y');
+  CHECK(store.append(text.data(), text.size()) == 1);
+  store.append(std::wstring(300, L'y').data(), 300);
+  text.append(300, L'y');
+  CHECK(store.size() == 1);
+  CHECK(line_text(store, 0) == text);
+
+  // Only the chunk that holds the line remains.
+  CHECK(store.memory() < (1000 + 256) * sizeof(wchar_t));
+}
+
+// Compares the store against a list of expanded lines for random text with line breaks and tabs.
+void test_model()
+{
+  std::mt19937 random(1);
+  line_store store(256);
+  store.set_limits(100, 4000 * sizeof(wchar_t));
+  std::deque<std::wstring> model;
+  auto open = false;
+  for (int i = 0; i < 20000; i++) {
+    std::wstring text;
+    auto size = random() % 60;
+    for (std::size_t j = 0; j < size; j++) {
+      auto c = random() % 20;
+      text += c == 0 ? L'\n' : c == 1 ? L'\t' : c == 2 ? L'\r' : static_cast<wchar_t>(L'a' + c);
+    }
+
+    for (std::size_t j = 0; j < text.size(); j++) {
+      if (text[j] == L'\r' || text[j] == L'\n') {
+        if (text[j] == L'\r' && j + 1 < text.size() && text[j + 1] == L'\n') {
+          j++;
+        }
+        if (!open) {
+          model.emplace_back();
+        }
+        open = false;
+      } else {
+        if (!open) {
+          model.emplace_back();
+          open = true;
+        }
+        if (text[j] == L'\t') {
+          model.back().append(8 - model.back().size() % 8, L' ');
+        } else {
+          model.back() += text[j];
+        }
+      }
+    }
+
+    auto trimmed = store.append(text.data(), text.size());
+    CHECK(trimmed <= model.size());
+    model.erase(model.begin(), model.begin() + static_cast<std::ptrdiff_t>(trimmed));
+    CHECK(store.size() == model.size());
+    CHECK(store.size() <= 100 + 100 / 8 + 1);
+    for (std::size_t j = store.size() > 3 ? store.size() - 3 : 0; j < store.size(); j++) {
+      CHECK(line_text(store, j) == model[j]);
+    }
+    if (store.size()) {
+      CHECK(line_text(store, 0) == model[0]);
+    }
+  }
+}
+
+// Joins the lines with a line break after every terminated line.
+std::wstring joined_lines(const line_store& store, bool open)
+{
+  std::wstring text;
+  for (std::size_t i = 0; i < store.size(); i++) {
+    text += line_text(store, i);
+    if (i + 1 < store.size() || !open) {
+      text += L'\n';
+    }
+  }
+  return text;
+}
+
+// Joins the text of a snapshot.
+std::wstring joined_snapshot(const std::vector<line_store::text>& texts)
+{
+  std::wstring text;
+  for (const auto& t : texts) {
+    text.append(t.data, t.size);
+  }
+  return text;
+}
+
+void test_snapshot()
+{
+  line_store store(256);
+  CHECK(store.snapshot().empty());
+  store.set_limits(50, 1 << 20);
+  std::mt19937 random(2);
+  auto open = false;
+  for (int i = 0; i < 2000; i++) {
+    std::wstring text(random() % 100, L'x');
+    if (i % 3) {
+      text += L'\n';
+      open = false;
+    } else if (!text.empty()) {
+      open = true;
+    }
+    store.append(text.data(), text.size());
+
+    // The snapshot starts at the first line after trims and open lines that moved into a new chunk.
+    auto texts = store.snapshot();
+    CHECK(joined_snapshot(texts) == joined_lines(store, open));
+  }
+}
+
+// Searches snapshots on another thread while lines are appended and trimmed. Every line holds one match, so the
+// count equals the number of line breaks in the same snapshot.
+void test_concurrent_snapshot()
+{
+  line_store store(256);
+  store.set_limits(100, 1 << 20);
+  std::atomic<bool> done(false);
+  std::atomic<std::size_t> failures(0);
+  std::vector<line_store::text> texts;
+  std::atomic<int> pending(0);
+
+  std::thread reader([&]() {
+    while (!done.load()) {
+      if (pending.load(std::memory_order_acquire) != 1) {
+        continue;
+      }
+      std::size_t matches = 0;
+      std::size_t breaks = 0;
+      for (const auto& t : texts) {
+        matches += text_count(t.data, t.data + t.size, L"needle", 6);
+        breaks += text_count(t.data, t.data + t.size, L"\n", 1);
+      }
+      if (matches != breaks) {
+        failures++;
+      }
+      pending.store(0, std::memory_order_release);
+    }
+  });
+
+  std::wstring line = L"hay needle hay\n";
+  for (int i = 0; i < 20000; i++) {
+    store.append(line.data(), line.size());
+    if (pending.load(std::memory_order_acquire) == 0) {
+      texts = store.snapshot();
+      pending.store(1, std::memory_order_release);
+    }
+  }
+  while (pending.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+  done = true;
+  reader.join();
+  CHECK(failures == 0);
+}
+
+}  // namespace
+
+int main()
+{
+  test_lines();
+  test_limits();
+  test_moved_line();
+  test_model();
+  test_snapshot();
+  test_concurrent_snapshot();
+}
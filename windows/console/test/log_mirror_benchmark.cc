@@ -0,0 +1,58 @@
+#include "log_mirror.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#define SEGMENT_SIZE  (64 << 20)  // bytes per segment, as in the console template
+#define SEGMENTS      4           // segment files
+#define TOTAL_BYTES   (1 << 30)   // bytes appended per line size
+
+int main()
+{
+  char directory[] = "/tmp/log_mirror_benchmark.XXXXXX";
+  if (!mkdtemp(directory)) {
+    return 1;
+  }
+  auto base = std::string(directory) + "/mirror";
+
+  // Append lines of console output and time every append.
+  for (std::size_t size : { 80, 1000 }) {
+    std::vector<std::uint32_t> latencies;
+    log_mirror::statistics stats;
+    std::string line(size, 'x');
+    line.back() = '\n';
+    auto count = TOTAL_BYTES / size;
+    latencies.reserve(count);
+    auto start = clock_ticks();
+    {
+      log_mirror mirror;
+      mirror.open(base, SEGMENT_SIZE, SEGMENTS, 100);
+      for (std::size_t i = 0; i < count; i++) {
+        auto t = clock_ticks();
+        mirror.append(line.data(), line.size());
+        latencies.push_back(static_cast<std::uint32_t>(elapsed_ns(t, clock_ticks())));
+      }
+      stats = mirror.stats();
+    }
+    auto end = clock_ticks();
+    std::sort(latencies.begin(), latencies.end());
+
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "mirror %zu byte lines", size);
+    report(name, static_cast<double>(count * size) * 1e3 / elapsed_ns(start, end), "MB/s");
+    std::snprintf(name, sizeof(name), "mirror %zu byte lines p50", size);
+    report(name, latencies[count / 2], "ns");
+    std::snprintf(name, sizeof(name), "mirror %zu byte lines p99", size);
+    report(name, latencies[count * 99 / 100], "ns");
+    std::snprintf(name, sizeof(name), "mirror %zu byte lines drops", size);
+    report(name, static_cast<double>(stats.drops), "records");
+
+    for (std::size_t i = 0; i < SEGMENTS; i++) {
+      unlink(log_mirror::path(base, i).c_str());
+    }
+  }
+  rmdir(directory);
+}
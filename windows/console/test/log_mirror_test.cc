@@ -0,0 +1,241 @@
+#include "log_mirror.h"
+#include "check.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string base;
+
+void clean(std::size_t segments)
+{
+  for (std::size_t i = 0; i < segments; i++) {
+    unlink(log_mirror::path(base, i).c_str());
+  }
+}
+
+// Appends a line and appends it again after a pause while the mirror drops it for want of a segment.
+void append(log_mirror& mirror, const std::string& line)
+{
+  auto drops = mirror.stats().drops;
+  mirror.append(line.data(), line.size());
+  while (mirror.stats().drops != drops) {
+    drops = mirror.stats().drops;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    mirror.append(line.data(), line.size());
+  }
+}
+
+void test_round_trip()
+{
+  clean(3);
+  {
+    log_mirror mirror;
+    mirror.open(base, 4096, 3, 10);
+    CHECK(mirror.is_open());
+    for (int i = 0; i < 10; i++) {
+      auto line = "line " + std::to_string(i) + "\n";
+      mirror.append(line.data(), line.size());
+    }
+    mirror.append("", 0);
+  }
+  std::vector<std::string> records;
+  auto count = log_mirror::read(log_mirror::path(base, 0), [&records](std::uint64_t sequence, const char* data, std::size_t size) {
+    records.emplace_back(data, size);
+    CHECK(sequence == records.size());
+  });
+  CHECK(count == 10);
+  CHECK(records[0] == "line 0\n");
+  CHECK(records[9] == "line 9\n");
+
+  // A reopened mirror continues after the newest record. Closing writes the unterminated last line.
+  {
+    log_mirror mirror;
+    mirror.open(base, 4096, 3, 10);
+    mirror.append("more", 4);
+  }
+  std::uint64_t sequence = 0;
+  std::string last;
+  CHECK(log_mirror::recover(base, 3, sequence, last));
+  CHECK(sequence == 11);
+  CHECK(last == "more");
+}
+
+void test_lines()
+{
+  // Records end on line boundaries, whatever the appended chunks are.
+  clean(3);
+  {
+    log_mirror mirror;
+    mirror.open(base, 4096, 3, 10);
+    mirror.append("a\nb", 3);
+    mirror.append("c", 1);
+    mirror.append("c\nd", 3);
+    mirror.append("e\nf\ng\n", 6);
+    CHECK(mirror.stats().records == 3);
+
+    // A line that outgrows a segment is written in pieces that start in a new segment.
+    std::string line(5000, 'x');
+    mirror.append(line.data(), 4000);
+    CHECK(mirror.stats().records == 3);
+    mirror.append(line.data(), 1000);
+    CHECK(mirror.stats().records + mirror.stats().drops == 5);
+  }
+  std::vector<std::string> records;
+  log_mirror::read(log_mirror::path(base, 0), [&records](std::uint64_t, const char* data, std::size_t size) {
+    records.emplace_back(data, size);
+  });
+  CHECK(records.size() == 3);
+  CHECK(records[0] == "a\n");
+  CHECK(records[1] == "bcc\n");
+  CHECK(records[2] == "de\nf\ng\n");
+}
+
+void test_rotation()
+{
+  // Write far more than three segments of 4 KiB and a record larger than a segment.
+  clean(3);
+  std::uint64_t records = 0;
+  {
+    log_mirror mirror;
+    mirror.open(base, 4096, 3, 1);
+    std::string line(100, 'x');
+    line.back() = '\n';
+    for (int i = 0; i < 1000; i++) {
+      line[0] = static_cast<char>('a' + i % 26);
+      append(mirror, line);
+    }
+    auto stats = mirror.stats();
+    CHECK(stats.rotations > 20);
+    CHECK(stats.bytes == 1000 * 100);
+
+    // The writer does not wait for the flush thread. A line that needs two new segments at once is
+    // split into full segments, and the rest is dropped from the first piece that finds no segment ready.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::string large(10000, 'b');
+    mirror.append(large.data(), large.size());
+    auto after = mirror.stats();
+    CHECK(after.records + after.drops == stats.records + stats.drops + 3);
+    CHECK(after.drops > stats.drops || after.bytes == stats.bytes + 10000);
+    records = after.records;
+  }
+
+  // The last record is a piece of the large line.
+  std::uint64_t sequence = 0;
+  std::string last;
+  CHECK(log_mirror::recover(base, 3, sequence, last));
+  CHECK(sequence == records);
+  CHECK(last == std::string(last.size(), 'b'));
+  CHECK(last.size() == 4096 - 16 || last.size() == 10000 - (4096 - 16) * 2);
+
+  // The sequence numbers continue across the segments.
+  std::vector<std::uint64_t> sequences;
+  for (std::size_t i = 0; i < 3; i++) {
+    log_mirror::read(log_mirror::path(base, i), [&sequences](std::uint64_t s, const char*, std::size_t) {
+      sequences.push_back(s);
+    });
+  }
+  std::sort(sequences.begin(), sequences.end());
+  for (std::size_t i = 1; i < sequences.size(); i++) {
+    CHECK(sequences[i] == sequences[i - 1] + 1);
+  }
+  CHECK(sequences.back() == records);
+}
+
+// Returns the segment and the offset of a record.
+bool find(std::uint64_t sequence, std::size_t segments, std::string& path, off_t& offset)
+{
+  for (std::size_t i = 0; i < segments; i++) {
+    path = log_mirror::path(base, i);
+    std::vector<char> data(1 << 16);
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    auto size = fd >= 0 ? pread(fd, data.data(), data.size(), 0) : -1;
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    for (std::size_t pos = 0; size > 0 && pos + 16 <= static_cast<std::size_t>(size);) {
+      std::uint32_t length = 0;
+      std::uint64_t s = 0;
+      std::memcpy(&length, &data[pos], 4);
+      std::memcpy(&s, &data[pos + 8], 8);
+      if (!s) {
+        break;
+      }
+      if (s == sequence) {
+        offset = static_cast<off_t>(pos);
+        return true;
+      }
+      pos += 16 + ((length + 7) & ~7u);
+    }
+  }
+  return false;
+}
+
+void test_crash()
+{
+  // A writer that exits without closing leaves all appended records behind.
+  clean(4);
+  auto pid = fork();
+  if (!pid) {
+    log_mirror mirror;
+    mirror.open(base, 1 << 16, 4, 1000);
+    for (int i = 1; i <= 5000; i++) {
+      append(mirror, "record " + std::to_string(i) + "\n");
+    }
+    _exit(0);
+  }
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  std::uint64_t sequence = 0;
+  std::string last;
+  CHECK(log_mirror::recover(base, 4, sequence, last));
+  CHECK(sequence == 5000);
+  CHECK(last == "record 5000\n");
+
+  // A corrupted last record is ignored.
+  std::string path;
+  off_t offset = 0;
+  CHECK(find(5000, 4, path, offset));
+  auto fd = ::open(path.c_str(), O_RDWR);
+  CHECK(fd >= 0);
+  char byte = 'Z';
+  CHECK(pwrite(fd, &byte, 1, offset + 16) == 1);
+  ::close(fd);
+  CHECK(log_mirror::recover(base, 4, sequence, last));
+  CHECK(sequence == 4999);
+  CHECK(last == "record 4999\n");
+
+  // The next writer overwrites it.
+  {
+    log_mirror mirror;
+    mirror.open(base, 1 << 16, 4, 10);
+    mirror.append("after\n", 6);
+  }
+  CHECK(log_mirror::recover(base, 4, sequence, last));
+  CHECK(sequence == 5000);
+  CHECK(last == "after\n");
+  clean(4);
+}
+
+}  // namespace
+
+int main()
+{
+  char directory[] = "/tmp/log_mirror_test.XXXXXX";
+  CHECK(mkdtemp(directory));
+  base = std::string(directory) + "/mirror";
+  test_round_trip();
+  test_lines();
+  test_rotation();
+  test_crash();
+  clean(4);
+  rmdir(directory);
+}
@@ -0,0 +1,101 @@
+#include "log_queue.h"
+#include "benchmark.h"
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LINE_SIZE     80          // bytes per queued line
+#define LINE_COUNT    1000000     // lines per run
+#define BATCH_LIMIT   (1 << 20)   // bytes per drain, as in the console
+#define QUEUE_LIMIT   60000       // lines the producers let queue up
+
+namespace {
+
+// Baseline with one mutex around a deque of strings.
+class locked_queue {
+public:
+  void push(std::string str)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    strings_.push_back(std::move(str));
+  }
+
+  void drain(std::string& out, std::size_t limit)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!strings_.empty() && out.size() + strings_.front().size() <= limit) {
+      out += strings_.front();
+      strings_.pop_front();
+    }
+  }
+
+  std::size_t depth()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return strings_.size();
+  }
+
+private:
+  std::mutex mutex_;
+  std::deque<std::string> strings_;
+};
+
+// Producers push console lines while the consumer drains batches like the UI thread.
+template <typename Queue>
+void run(const char* label, int producers)
+{
+  Queue queue;
+  std::atomic<int> running = { producers };
+  std::string line(LINE_SIZE - 1, 'x');
+  line += '\n';
+
+  auto start = clock_ticks();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < LINE_COUNT / producers; i++) {
+        while (queue.depth() > QUEUE_LIMIT) {
+          std::this_thread::yield();
+        }
+        queue.push(line);
+      }
+      running--;
+    });
+  }
+  std::string batch;
+  std::size_t bytes = 0;
+  for (;;) {
+    auto done = running == 0;
+    batch.clear();
+    queue.drain(batch, BATCH_LIMIT);
+    bytes += batch.size();
+    if (done && !queue.depth()) {
+      break;
+    }
+    if (batch.empty()) {
+      std::this_thread::yield();
+    }
+  }
+  auto end = clock_ticks();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "%s, %d producers", label, producers);
+  report(name, elapsed_ns(start, end) / (bytes / LINE_SIZE), "ns/line");
+}
+
+}  // namespace
+
+int main()
+{
+  for (int producers = 1; producers <= 4; producers *= 2) {
+    run<log_queue>("log_queue", producers);
+    run<locked_queue>("mutex and deque", producers);
+  }
+}
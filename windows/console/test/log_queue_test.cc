@@ -0,0 +1,148 @@
+#include "log_queue.h"
+#include "check.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void test_order_and_wakeup()
+{
+  log_queue queue(8);
+  CHECK(queue.push("a"));
+  CHECK(!queue.push("b"));
+  CHECK(queue.depth() == 2);
+
+  std::string out;
+  CHECK(queue.drain(out) == 2);
+  CHECK(out == "ab");
+  CHECK(queue.depth() == 0);
+
+  // The first string after a drain wakes up the consumer again.
+  CHECK(queue.push("c"));
+}
+
+void test_dropped()
+{
+  log_queue queue(4);
+  for (int i = 0; i < 4; i++) {
+    queue.push(std::to_string(i));
+  }
+  queue.push("lost");
+  CHECK(queue.dropped() == 1);
+  CHECK(queue.reset_dropped() == 1);
+  CHECK(queue.dropped() == 0);
+
+  std::string out;
+  CHECK(queue.drain(out) == 4);
+  CHECK(out == "0123");
+}
+
+void test_try_push()
+{
+  log_queue queue(2);
+  std::string str = "a";
+  auto wake = false;
+  CHECK(queue.try_push(str, wake) && wake);
+  str = "b";
+  CHECK(queue.try_push(str, wake) && !wake);
+
+  // A full queue rejects the string without taking it or counting a drop.
+  str = "c";
+  CHECK(!queue.try_push(str, wake) && !wake);
+  CHECK(str == "c");
+  CHECK(queue.dropped() == 0);
+
+  std::string out;
+  CHECK(queue.drain(out) == 2);
+  CHECK(queue.try_push(str, wake) && wake);
+  CHECK(queue.drain(out) == 1);
+  CHECK(out == "abc");
+}
+
+void test_limit()
+{
+  log_queue queue(8);
+  queue.push(std::string(10, 'a'));
+  queue.push("x\xC3\xA9y");
+
+  // A string that does not fit is split and its rest stays queued.
+  std::string out;
+  CHECK(queue.drain(out, 4) == 0);
+  CHECK(out == "aaaa");
+  out.clear();
+  CHECK(queue.drain(out, 7) == 1);
+  CHECK(out == "aaaaaax");
+
+  // Splits never cut a UTF-8 sequence unless nothing else fits.
+  out = "z";
+  CHECK(queue.drain(out, 2) == 0);
+  CHECK(out == "z");
+  out.clear();
+  CHECK(queue.drain(out, 1) == 0);
+  CHECK(out == "\xC3");
+  out.clear();
+  CHECK(queue.drain(out, 2) == 1);
+  CHECK(out == "\xA9y");
+  out.clear();
+  CHECK(queue.drain(out) == 0);
+  CHECK(out.empty());
+}
+
+void test_producers()
+{
+  const int producers = 4;
+  const int count = 50000;
+  log_queue queue(1024);
+
+  std::atomic<int> running = { producers };
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&queue, &running, p]() {
+      for (int i = 0; i < count; i++) {
+        queue.push(std::to_string(p) + ":" + std::to_string(i) + "\n");
+      }
+      running--;
+    });
+  }
+
+  // Strings of every producer arrive in order, and every string either arrives or is dropped.
+  std::vector<int> last(producers, -1);
+  std::size_t received = 0;
+  std::string out;
+  for (;;) {
+    auto done = running == 0;
+    out.clear();
+    queue.drain(out);
+    for (std::size_t pos = 0; pos < out.size();) {
+      auto end = out.find('\n', pos);
+      CHECK(end != std::string::npos);
+      auto colon = out.find(':', pos);
+      auto p = std::stoi(out.substr(pos, colon - pos));
+      auto i = std::stoi(out.substr(colon + 1, end - colon - 1));
+      CHECK(i > last[p]);
+      last[p] = i;
+      received++;
+      pos = end + 1;
+    }
+    if (done && !queue.depth()) {
+      break;
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK(received + queue.dropped() == static_cast<std::size_t>(producers * count));
+}
+
+}  // namespace
+
+int main()
+{
+  test_order_and_wakeup();
+  test_dropped();
+  test_try_push();
+  test_limit();
+  test_producers();
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal stand-in for the Windows headers that lets window_base.h compile on other platforms.
+// A window is a plain object with a window procedure and the window and dialog data slots.
+
+typedef unsigned int UINT;
+typedef unsigned short WORD;
+typedef std::uint32_t DWORD;
+typedef int BOOL;
+typedef std::uintptr_t WPARAM;
+typedef std::uintptr_t UINT_PTR;
+typedef std::intptr_t LPARAM;
+typedef std::intptr_t LRESULT;
+typedef std::intptr_t LONG_PTR;
+typedef std::intptr_t INT_PTR;
+typedef void* HANDLE;
+
+#define CALLBACK
+#define TRUE 1
+#define FALSE 0
+
+struct mock_window;
+typedef mock_window* HWND;
+typedef LRESULT (CALLBACK* WNDPROC)(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+
+struct mock_window {
+  LONG_PTR proc = 0;
+  LONG_PTR user_data = 0;
+  LONG_PTR dialog_proc = 0;
+  LONG_PTR message_result = 0;
+  std::size_t default_calls = 0;
+  std::size_t destroyed = 0;
+};
+
+typedef struct {
+  void* lpCreateParams;
+} CREATESTRUCT, *LPCREATESTRUCT;
+
+#define WM_CREATE           0x0001
+#define WM_DESTROY          0x0002
+#define WM_SIZE             0x0005
+#define WM_PAINT            0x000F
+#define WM_CLOSE            0x0010
+#define WM_ERASEBKGND       0x0014
+#define WM_SETCURSOR        0x0020
+#define WM_WINDOWPOSCHANGING 0x0046
+#define WM_GETICON          0x007F
+#define WM_NCCREATE         0x0081
+#define WM_NCDESTROY        0x0082
+#define WM_NCHITTEST        0x0084
+#define WM_NCMOUSEMOVE      0x00A0
+#define WM_KEYDOWN          0x0100
+#define WM_INITDIALOG       0x0110
+#define WM_COMMAND          0x0111
+#define WM_TIMER            0x0113
+#define WM_HSCROLL          0x0114
+#define WM_VSCROLL          0x0115
+#define WM_MOUSEMOVE        0x0200
+#define WM_LBUTTONUP        0x0202
+#define WM_MOUSEWHEEL       0x020A
+#define WM_ENTERSIZEMOVE    0x0231
+#define WM_EXITSIZEMOVE     0x0232
+#define WM_APP              0x8000
+
+#define GWLP_WNDPROC    (-4)
+#define GWLP_USERDATA   (-21)
+#define DWLP_MSGRESULT  0
+#define DWLP_DLGPROC    8
+
+#define MB_OK         0x0000
+#define MB_ICONERROR  0x0010
+
+#define MEM_COMMIT              0x1000
+#define MEM_RESERVE             0x2000
+#define PAGE_EXECUTE_READ       0x20
+#define PAGE_EXECUTE_READWRITE  0x40
+
+#define LOWORD(l) (static_cast<WORD>(static_cast<std::uintptr_t>(l) & 0xFFFF))
+#define HIWORD(l) (static_cast<WORD>((static_cast<std::uintptr_t>(l) >> 16) & 0xFFFF))
+#define GET_WHEEL_DELTA_WPARAM(w) (static_cast<short>(HIWORD(w)))
+
+inline LONG_PTR* window_slot(HWND hwnd, int index)
+{
+  switch (index) {
+  case GWLP_WNDPROC:   return &hwnd->proc;
+  case GWLP_USERDATA:  return &hwnd->user_data;
+  case DWLP_DLGPROC:   return &hwnd->dialog_proc;
+  default:             return &hwnd->message_result;
+  }
+}
+
+inline LONG_PTR SetWindowLongPtr(HWND hwnd, int index, LONG_PTR value)
+{
+  auto slot = window_slot(hwnd, index);
+  auto previous = *slot;
+  *slot = value;
+  return previous;
+}
+
+inline LONG_PTR GetWindowLongPtr(HWND hwnd, int index)
+{
+  return *window_slot(hwnd, index);
+}
+
+inline LRESULT DefWindowProc(HWND hwnd, UINT, WPARAM, LPARAM)
+{
+  hwnd->default_calls++;
+  return 0;
+}
+
+inline BOOL DestroyWindow(HWND hwnd)
+{
+  hwnd->destroyed++;
+  return TRUE;
+}
+
+inline int MessageBox(HWND, const wchar_t*, const wchar_t*, UINT)
+{
+  return 0;
+}
+
+// Sends a message through the current window procedure like user32.
+inline LRESULT SendMessage(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+{
+  return reinterpret_cast<WNDPROC>(hwnd->proc)(hwnd, msg, wparam, lparam);
+}
+
+// Executable memory is never available, so window_base falls back to the window user data.
+inline void* VirtualAlloc(void*, std::size_t, DWORD, DWORD)
+{
+  return nullptr;
+}
+
+inline BOOL VirtualProtect(void*, std::size_t, DWORD, DWORD*)
+{
+  return FALSE;
+}
+
+inline HANDLE GetCurrentProcess()
+{
+  return nullptr;
+}
+
+inline BOOL FlushInstructionCache(HANDLE, const void*, std::size_t)
+{
+  return TRUE;
+}
+
+// The wide string overload of utf.h only exists on Windows.
+inline void utf8_to_utf16(const char* str, std::wstring& dst)
+{
+  dst.assign(str, str + std::char_traits<char>::length(str));
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+#define GET_X_LPARAM(l) (static_cast<int>(static_cast<short>(LOWORD(l))))
+#define GET_Y_LPARAM(l) (static_cast<int>(static_cast<short>(HIWORD(l))))
@@ -0,0 +1,46 @@
+#include "pipe_reader.h"
+#include "benchmark.h"
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#define TOTAL_SIZE    (256 << 20)   // bytes written per run
+#define WRITE_SIZE    4096          // bytes per write, like a flushed stdio buffer
+
+int main()
+{
+  // The consumer acknowledges every delivery at once, so the reader never stalls.
+  std::atomic<bool> closed = { false };
+  pipe_reader* self = nullptr;
+  pipe_reader reader([&self](int, const char*, std::size_t size) {
+    self->consume(size);
+    return true;
+  }, [&closed]() {
+    closed = true;
+  });
+  self = &reader;
+
+  int out[2] = {};
+  if (pipe(out)) {
+    return 1;
+  }
+  std::string data(WRITE_SIZE, 'x');
+  auto start = clock_ticks();
+  reader.start(out[0], -1);
+  for (std::size_t written = 0; written < TOTAL_SIZE; written += WRITE_SIZE) {
+    if (write(out[1], data.data(), data.size()) != WRITE_SIZE) {
+      return 1;
+    }
+  }
+  close(out[1]);
+  while (!closed) {
+    std::this_thread::yield();
+  }
+  auto end = clock_ticks();
+
+  auto stats = reader.stats();
+  report("pipe_reader throughput", static_cast<double>(stats.bytes) * 1e3 / elapsed_ns(start, end), "MB/s");
+  report("pipe_reader bytes per read", static_cast<double>(stats.bytes) / stats.reads, "bytes");
+  reader.stop();
+}
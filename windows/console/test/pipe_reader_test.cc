@@ -0,0 +1,285 @@
+#include "pipe_reader.h"
+#include "check.h"
+#include "log_queue.h"
+#include <unistd.h>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Collects the delivered data on the reader thread.
+struct sink {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::string streams[2];
+  std::size_t unconsumed = 0;
+  bool closed = false;
+
+  void data(int stream, const char* data, std::size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    streams[stream].append(data, size);
+    unconsumed += size;
+    changed.notify_all();
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    changed.notify_all();
+  }
+
+  // Waits for the condition for at most ten seconds.
+  template <typename Condition>
+  bool wait(Condition condition)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(10), condition);
+  }
+};
+
+void write_all(int fd, const std::string& data)
+{
+  for (std::size_t pos = 0; pos < data.size();) {
+    auto size = write(fd, data.data() + pos, data.size() - pos);
+    CHECK(size > 0);
+    pos += static_cast<std::size_t>(size);
+  }
+}
+
+void test_streams()
+{
+  sink s;
+  pipe_reader reader([&s](int stream, const char* data, std::size_t size) {
+    s.data(stream, data, size);
+    return true;
+  }, [&s]() {
+    s.close();
+  });
+  int out[2] = {};
+  int err[2] = {};
+  CHECK(pipe(out) == 0 && pipe(err) == 0);
+  reader.start(out[0], err[0]);
+
+  write_all(out[1], "standard output");
+  write_all(err[1], "standard error");
+  close(out[1]);
+  close(err[1]);
+  CHECK(s.wait([&s]() { return s.closed; }));
+  CHECK(s.streams[0] == "standard output");
+  CHECK(s.streams[1] == "standard error");
+  CHECK(reader.stats().bytes == 29);
+  reader.stop();
+}
+
+void test_backpressure()
+{
+  sink s;
+  pipe_reader reader([&s](int stream, const char* data, std::size_t size) {
+    s.data(stream, data, size);
+    return true;
+  }, [&s]() {
+    s.close();
+  }, 1024, 4096);
+  int out[2] = {};
+  CHECK(pipe(out) == 0);
+  reader.start(out[0], -1);
+
+  std::string data;
+  for (int i = 0; data.size() < 1 << 16; i++) {
+    data += std::to_string(i) + "\n";
+  }
+  std::thread writer([&]() {
+    write_all(out[1], data);
+    close(out[1]);
+  });
+
+  // The reader stalls once the pending data reaches the limit.
+  CHECK(s.wait([&s]() { return s.unconsumed >= 4096; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK(reader.stats().pending < 4096 + 1024);
+  CHECK(reader.stats().stalls >= 1);
+
+  // Acknowledging the data lets it continue until the pipe closes.
+  for (;;) {
+    std::size_t size = 0;
+    {
+      std::unique_lock<std::mutex> lock(s.mutex);
+      s.changed.wait_for(lock, std::chrono::milliseconds(10), [&s]() { return s.unconsumed || s.closed; });
+      size = s.unconsumed;
+      s.unconsumed = 0;
+      if (!size && s.closed) {
+        break;
+      }
+    }
+    reader.consume(size);
+  }
+  writer.join();
+  CHECK(s.streams[0] == data);
+  CHECK(reader.stats().pending == 0);
+  reader.stop();
+}
+
+// Line-sized output through a consumer queue that is much smaller than the credit. Rejected chunks are delivered
+// again after the consumer drained the queue, so nothing is lost and the credit returns to zero.
+void test_full_queue()
+{
+  log_queue queue(2);
+  std::atomic<bool> closed = { false };
+  std::atomic<bool> signaled = { false };
+  pipe_reader reader([&](int, const char* data, std::size_t size) {
+    std::string str(data, size);
+    auto wake = false;
+    if (!queue.try_push(str, wake)) {
+      return false;
+    }
+    if (wake) {
+      signaled = true;
+    }
+    return true;
+  }, [&closed]() {
+    closed = true;
+  }, 16, 1 << 22);
+  int out[2] = {};
+  CHECK(pipe(out) == 0);
+  reader.start(out[0], -1);
+
+  std::string data;
+  for (int i = 0; data.size() < 1 << 18; i++) {
+    data += std::to_string(i) + "\n";
+  }
+  std::thread writer([&]() {
+    for (std::size_t pos = 0; pos < data.size(); pos += 7) {
+      write_all(out[1], data.substr(pos, 7));
+    }
+    close(out[1]);
+  });
+
+  // Drain the queue like on_write, which runs on wakeups and acknowledges what it collected.
+  std::string received;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!closed || queue.depth()) {
+    CHECK(std::chrono::steady_clock::now() < deadline);
+    if (!signaled.exchange(false) && !queue.depth()) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::string batch;
+    queue.drain(batch, 4096);
+    received += batch;
+    reader.consume(batch.size());
+  }
+  writer.join();
+  CHECK(received == data);
+  CHECK(queue.dropped() == 0);
+  CHECK(reader.stats().pending == 0);
+  CHECK(reader.stats().stalls >= 1);
+  reader.stop();
+}
+
+// Output capture with the limits of capture.cc: printf lines from several threads share one pipe and a 1024-cell
+// queue with a 16 MiB budget. The console is busy until the queue is full, as while the controls are created,
+// and then drains slowly. Writers block instead of losing lines, and the credit does not leak.
+void test_capture()
+{
+  log_queue queue(1024);
+  std::atomic<bool> closed = { false };
+  pipe_reader reader([&](int, const char* data, std::size_t size) {
+    std::string str(data, size);
+    auto wake = false;
+    return queue.try_push(str, wake);
+  }, [&closed]() {
+    closed = true;
+  }, 1 << 16, 1 << 24);
+  int out[2] = {};
+  CHECK(pipe(out) == 0);
+  reader.start(out[0], -1);
+
+  const int threads = 4;
+  const int lines = 20000;
+  std::vector<std::thread> writers;
+  for (int t = 0; t < threads; t++) {
+    writers.emplace_back([&out, t]() {
+      for (int i = 0; i < lines; i++) {
+        write_all(out[1], std::to_string(t) + ":" + std::to_string(i) + "\n");
+      }
+    });
+  }
+  std::thread closer([&]() {
+    for (auto& w : writers) {
+      w.join();
+    }
+    close(out[1]);
+  });
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!reader.stats().stalls) {
+    CHECK(std::chrono::steady_clock::now() < deadline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  std::string received;
+  while (!closed || queue.depth()) {
+    CHECK(std::chrono::steady_clock::now() < deadline);
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+    std::string batch;
+    queue.drain(batch, 1 << 20);
+    received += batch;
+    reader.consume(batch.size());
+  }
+  closer.join();
+
+  // Every line of every thread arrives once and in order. Lines are shorter than PIPE_BUF, so writes never mix.
+  int next[threads] = {};
+  for (std::size_t pos = 0; pos < received.size();) {
+    auto end = received.find('\n', pos);
+    CHECK(end != std::string::npos);
+    auto colon = received.find(':', pos);
+    auto t = std::stoi(received.substr(pos, colon - pos));
+    CHECK(std::stoi(received.substr(colon + 1, end - colon - 1)) == next[t]++);
+    pos = end + 1;
+  }
+  for (auto n : next) {
+    CHECK(n == lines);
+  }
+  CHECK(queue.dropped() == 0);
+  CHECK(reader.stats().pending == 0);
+  reader.stop();
+}
+
+void test_stop()
+{
+  // Stopping a reader that waits for credit returns without calling the close handler.
+  sink s;
+  pipe_reader reader([&s](int stream, const char* data, std::size_t size) {
+    s.data(stream, data, size);
+    return true;
+  }, [&s]() {
+    s.close();
+  }, 1024, 1024);
+  int out[2] = {};
+  CHECK(pipe(out) == 0);
+  reader.start(out[0], -1);
+  write_all(out[1], std::string(4096, 'x'));
+  CHECK(s.wait([&s]() { return s.unconsumed >= 1024; }));
+  reader.stop();
+  CHECK(!s.closed);
+  close(out[1]);
+}
+
+}  // namespace
+
+int main()
+{
+  test_streams();
+  test_backpressure();
+  test_full_queue();
+  test_capture();
+  test_stop();
+}
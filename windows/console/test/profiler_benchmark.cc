@@ -0,0 +1,27 @@
+#include "profiler.h"
+#include "benchmark.h"
+
+#define MESSAGE_COUNT 10000000    // messages per run
+
+int main()
+{
+  // Cycle through a few common messages as a busy window would.
+  static const unsigned messages[] = { 0x000F, 0x0200, 0x0113, 0x0084, 0x0020, 0x8001, 0xC123, 0x0014 };
+  profiler p;
+
+  auto start = clock_ticks();
+  for (int i = 0; i < MESSAGE_COUNT; i++) {
+    p.leave(messages[i & 7], p.enter());
+  }
+  auto end = clock_ticks();
+  report("profiler enter and leave", elapsed_ns(start, end) / MESSAGE_COUNT, "ns");
+
+  // Compare with reading the clock twice, which is the minimum cost of timing a message.
+  start = clock_ticks();
+  for (int i = 0; i < MESSAGE_COUNT; i++) {
+    clock_ticks();
+    clock_ticks();
+  }
+  end = clock_ticks();
+  report("two clock reads", elapsed_ns(start, end) / MESSAGE_COUNT, "ns");
+}
@@ -0,0 +1,116 @@
+#include "profiler.h"
+#include "check.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Returns the report row of a message or an empty string.
+std::string row(const std::string& report, const std::string& label)
+{
+  std::size_t pos = 0;
+  while (pos < report.size()) {
+    auto end = report.find('\n', pos);
+    auto line = report.substr(pos, end - pos);
+    if (line.compare(0, label.size(), label) == 0 && line[label.size()] == ' ') {
+      return line;
+    }
+    pos = end + 1;
+  }
+  return {};
+}
+
+// Returns the call count and the slow count of a report row.
+void parse(const std::string& line, std::size_t label, unsigned long long& count, unsigned long long& slow)
+{
+  double total = 0.0;
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+  CHECK(std::sscanf(line.c_str() + label, "%llu %lf %lf %lf %lf %lf %llu", &count, &total, &p50, &p90, &p99, &max, &slow) == 7);
+}
+
+void test_report()
+{
+  profiler p(1.0);
+  for (int i = 0; i < 3; i++) {
+    p.leave(0x000F, p.enter());
+  }
+  p.leave(0x8005, p.enter());
+  p.leave(0x0401, p.enter());
+  p.leave(0x0000, p.enter());
+
+  auto report = p.report();
+  CHECK(report.compare(0, 7, "message") == 0);
+  unsigned long long count = 0;
+  unsigned long long slow = 0;
+  parse(row(report, "WM_PAINT"), 8, count, slow);
+  CHECK(count == 3);
+  CHECK(slow == 0);
+  CHECK(!row(report, "WM_APP + 5").empty());
+  CHECK(!row(report, "WM_USER + 1").empty());
+  CHECK(!row(report, "0x0000").empty());
+
+  // The time between the first and every later handler is recorded once.
+  parse(row(report, "(outside handlers)"), 18, count, slow);
+  CHECK(count == 5);
+
+  p.reset();
+  report = p.report();
+  CHECK(row(report, "WM_PAINT").empty());
+  parse(row(report, "(outside handlers)"), 18, count, slow);
+  CHECK(count == 0);
+}
+
+void test_budget()
+{
+  profiler p(1.0);
+  auto start = p.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  p.leave(0x0113, start);
+  p.leave(0x0113, p.enter());
+
+  unsigned long long count = 0;
+  unsigned long long slow = 0;
+  parse(row(p.report(), "WM_TIMER"), 8, count, slow);
+  CHECK(count == 2);
+  CHECK(slow == 1);
+}
+
+void test_nesting()
+{
+  // A nested message counts towards the outer message and not as time outside of handlers.
+  profiler p(1.0);
+  auto outer = p.enter();
+  auto inner = p.enter();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  p.leave(0x0005, inner);
+  p.leave(0x0014, outer);
+  p.leave(0x000F, p.enter());
+
+  auto report = p.report();
+  unsigned long long count = 0;
+  unsigned long long slow = 0;
+  parse(row(report, "WM_SIZE"), 7, count, slow);
+  CHECK(count == 1 && slow == 1);
+  parse(row(report, "WM_ERASEBKGND"), 13, count, slow);
+  CHECK(count == 1 && slow == 1);
+  parse(row(report, "(outside handlers)"), 18, count, slow);
+  CHECK(count == 1);
+
+  // The slowest handler comes first.
+  auto first = report.substr(report.find('\n') + 1);
+  CHECK(first.compare(0, 13, "WM_ERASEBKGND") == 0);
+}
+
+}  // namespace
+
+int main()
+{
+  test_report();
+  test_budget();
+  test_nesting();
+}
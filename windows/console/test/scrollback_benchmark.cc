@@ -0,0 +1,33 @@
+#include "scrollback.h"
+#include "benchmark.h"
+#include <string>
+
+#define LINE_SIZE     80          // characters per line including the line break
+#define LINE_COUNT    10000000    // lines per run
+#define BATCH_LINES   1000        // lines per append, as in a console batch
+
+int main()
+{
+  // Append batches far beyond the default console limits.
+  scrollback lines(100000, 32 << 20);
+  std::wstring batch;
+  for (int i = 0; i < BATCH_LINES; i++) {
+    batch.append(LINE_SIZE - 1, L'x');
+    batch += L'\n';
+  }
+
+  std::size_t trims = 0;
+  std::size_t trimmed = 0;
+  auto start = clock_ticks();
+  for (int i = 0; i < LINE_COUNT / BATCH_LINES; i++) {
+    if (auto trim = lines.append(batch.data(), batch.size())) {
+      trims++;
+      trimmed += trim;
+    }
+  }
+  auto end = clock_ticks();
+
+  report("scrollback append per line", elapsed_ns(start, end) / LINE_COUNT, "ns");
+  report("scrollback appends per trim", static_cast<double>(LINE_COUNT / BATCH_LINES) / trims, "batches");
+  report("scrollback characters per trim", static_cast<double>(trimmed) / trims, "chars");
+}
@@ -0,0 +1,94 @@
+#include "scrollback.h"
+#include "check.h"
+#include <algorithm>
+#include <random>
+#include <string>
+
+namespace {
+
+void test_lines()
+{
+  scrollback lines(100, 1 << 20);
+  CHECK(lines.append(L"ab\r\ncd\ne", 8) == 0);
+  CHECK(lines.lines() == 3);
+
+  // A CRLF pair is a single control character.
+  CHECK(lines.chars() == 7);
+  lines.clear();
+  CHECK(lines.lines() == 0);
+  CHECK(lines.chars() == 0);
+}
+
+void test_line_limit()
+{
+  // Nothing is trimmed until the limit is exceeded by a chunk of an eighth.
+  scrollback lines(80, 1 << 20);
+  for (int i = 0; i < 90; i++) {
+    CHECK(lines.append(L"line\n", 5) == 0);
+  }
+  CHECK(lines.append(L"line\n", 5) == 11 * 5);
+  CHECK(lines.lines() == 80);
+  CHECK(lines.chars() == 80 * 5);
+}
+
+void test_char_limit()
+{
+  scrollback lines(1000, 800 * sizeof(wchar_t));
+  std::wstring line(99, L'x');
+  line += L'\n';
+  std::size_t trimmed = 0;
+  for (int i = 0; i < 10; i++) {
+    trimmed += lines.append(line.data(), line.size());
+  }
+  CHECK(trimmed == 200);
+  CHECK(lines.chars() == 800);
+  CHECK(lines.capacity() == 900);
+}
+
+// Applies random appends to a model of the control text and checks that every trim ends at a line break.
+void test_model()
+{
+  std::mt19937 random(1);
+  scrollback lines(50, 2000 * sizeof(wchar_t));
+  std::wstring control;
+  for (int i = 0; i < 20000; i++) {
+    std::wstring text;
+    auto size = random() % 40;
+    for (std::size_t j = 0; j < size; j++) {
+      auto c = random() % 16;
+      text += c == 0 ? L'\n' : c == 1 ? L'\r' : L'a';
+    }
+
+    // The control stores CRLF as a single line break.
+    std::wstring stored;
+    for (std::size_t j = 0; j < text.size(); j++) {
+      stored += text[j] == L'\r' ? L'\n' : text[j];
+      if (text[j] == L'\r' && j + 1 < text.size() && text[j + 1] == L'\n') {
+        j++;
+      }
+    }
+    control += stored;
+
+    auto trim = lines.append(text.data(), text.size());
+    CHECK(trim <= control.size());
+    if (trim) {
+      CHECK(control[trim - 1] == L'\n');
+      control.erase(0, trim);
+    }
+    CHECK(lines.chars() == control.size());
+    CHECK(control.size() <= lines.capacity());
+    auto breaks = static_cast<std::size_t>(std::count(control.begin(), control.end(), L'\n'));
+    auto open = !control.empty() && control.back() != L'\n';
+    CHECK(lines.lines() == breaks + (open ? 1 : 0));
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_lines();
+  test_line_limit();
+  test_char_limit();
+  test_model();
+}
@@ -0,0 +1,88 @@
+#include "task_queue.h"
+#include "benchmark.h"
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TASK_COUNT    2000000   // tasks per run
+
+namespace {
+
+// Baseline with one mutex around a deque of closures.
+class locked_queue {
+public:
+  bool post(std::function<void()> t)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(t));
+    return tasks_.size() == 1;
+  }
+
+  std::size_t run()
+  {
+    std::deque<std::function<void()>> batch;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batch.swap(tasks_);
+    }
+    for (auto& t : batch) {
+      t();
+    }
+    return batch.size();
+  }
+
+private:
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+// Producers post small tasks while the consumer runs batches like the event loop.
+template <typename Queue>
+void run(const char* label, int producers)
+{
+  Queue queue;
+  std::atomic<int> running = { producers };
+  std::size_t sum = 0;
+  auto start = clock_ticks();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < TASK_COUNT / producers; i++) {
+        queue.post([&sum]() { sum++; });
+      }
+      running--;
+    });
+  }
+  for (;;) {
+    auto done = running == 0;
+    if (queue.run()) {
+      continue;
+    }
+    if (done) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  auto end = clock_ticks();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "%s, %d producers", label, producers);
+  report(name, elapsed_ns(start, end) / static_cast<double>(sum), "ns/task");
+}
+
+}  // namespace
+
+int main()
+{
+  for (int producers = 1; producers <= 4; producers *= 2) {
+    run<task_queue>("task_queue", producers);
+    run<locked_queue>("mutex and deque", producers);
+  }
+}
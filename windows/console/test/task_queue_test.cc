@@ -0,0 +1,96 @@
+#include "task_queue.h"
+#include "check.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void test_order()
+{
+  task_queue queue;
+  std::vector<int> order;
+  CHECK(queue.empty());
+  CHECK(queue.post([&order]() { order.push_back(1); }));
+  CHECK(!queue.post([&order]() { order.push_back(2); }));
+
+  // Tasks posted by a task run in the next batch.
+  CHECK(!queue.post([&queue, &order]() {
+    order.push_back(3);
+    queue.post([&order]() { order.push_back(4); });
+  }));
+  CHECK(queue.run() == 3);
+  CHECK((order == std::vector<int>{ 1, 2, 3 }));
+  CHECK(!queue.empty());
+  CHECK(queue.run() == 1);
+  CHECK(order.back() == 4);
+  CHECK(queue.empty());
+  CHECK(queue.run() == 0);
+}
+
+void test_exception()
+{
+  // The rest of a batch runs on the next call when a task throws.
+  task_queue queue;
+  auto count = 0;
+  queue.post([&count]() { count++; });
+  queue.post([]() { throw std::runtime_error("task"); });
+  queue.post([&count]() { count++; });
+  auto thrown = false;
+  try {
+    queue.run();
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  CHECK(count == 1);
+  CHECK(queue.run() == 1);
+  CHECK(count == 2);
+
+  // Unexecuted tasks are released by the destructor.
+  queue.post([]() {});
+}
+
+void test_producers()
+{
+  const int producers = 4;
+  const int count = 100000;
+  task_queue queue;
+  std::vector<int> last(producers, -1);
+  std::atomic<int> running = { producers };
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < count; i++) {
+        queue.post([&last, p, i]() {
+          CHECK(last[p] == i - 1);
+          last[p] = i;
+        });
+      }
+      running--;
+    });
+  }
+  std::size_t executed = 0;
+  for (;;) {
+    auto done = running == 0;
+    executed += queue.run();
+    if (done && queue.empty()) {
+      break;
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK(executed == static_cast<std::size_t>(producers * count));
+}
+
+}  // namespace
+
+int main()
+{
+  test_order();
+  test_exception();
+  test_producers();
+}
@@ -0,0 +1,75 @@
+#include "text_search.h"
+#include "benchmark.h"
+#include <random>
+#include <string>
+
+#define TEXT_SIZE  (32 << 20)  // characters of log text, 128 MiB with 32-bit characters
+#define ROUNDS     4           // searches per pattern
+
+namespace {
+
+// Builds log lines of words from a small vocabulary, similar to build output.
+std::wstring log_text()
+{
+  static const wchar_t* words[] = { L"compiling", L"src/console_view.cc", L"warning", L"C4100", L"unreferenced",
+                                    L"parameter", L"linking", L"done", L"0x00007ff6", L"[info]", L"elapsed", L"ms" };
+  std::mt19937 random(1);
+  std::wstring text;
+  text.reserve(TEXT_SIZE + 64);
+  while (text.size() < TEXT_SIZE) {
+    auto count = 4 + random() % 8;
+    for (std::size_t i = 0; i < count; i++) {
+      text += words[random() % (sizeof(words) / sizeof(words[0]))];
+      text += L' ';
+    }
+    text += L'\n';
+  }
+  return text;
+}
+
+// Reports the throughput of a search that finds no match and must scan the whole text.
+template <typename Search>
+void run(const char* name, const std::wstring& text, Search search)
+{
+  std::size_t found = 0;
+  auto start = clock_ticks();
+  for (int i = 0; i < ROUNDS; i++) {
+    found += search();
+  }
+  auto end = clock_ticks();
+  if (found) {
+    std::printf("unexpected match\n");
+  }
+  report(name, static_cast<double>(text.size() * sizeof(wchar_t) * ROUNDS) / elapsed_ns(start, end), "GB/s");
+}
+
+}  // namespace
+
+int main()
+{
+  auto text = log_text();
+  auto first = text.data();
+  auto last = first + text.size();
+
+  // The patterns do not occur. The last one starts with the most common character of the text.
+  struct {
+    const char* name;
+    const wchar_t* pattern;
+  } patterns[] = { { "3 chars", L"C4X" },
+                   { "5 chars", L"fatal" },
+                   { "13 chars", L"error LNK2019" },
+                   { "26 chars", L"unresolved external symbol" },
+                   { "common first char", L" missing" } };
+  for (const auto& entry : patterns) {
+    std::wstring p(entry.pattern);
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "text_find %s", entry.name);
+    run(name, text, [&]() {
+      return text_find(first, last, p.data(), p.size()) != last;
+    });
+    std::snprintf(name, sizeof(name), "wstring::find %s", entry.name);
+    run(name, text, [&]() {
+      return text.find(p) != std::wstring::npos;
+    });
+  }
+}
@@ -0,0 +1,92 @@
+#include "text_search.h"
+#include "check.h"
+#include <random>
+#include <string>
+
+namespace {
+
+// Counts non-overlapping matches with std::wstring::find.
+std::size_t reference_count(const std::wstring& text, const std::wstring& pattern)
+{
+  std::size_t count = 0;
+  for (auto pos = text.find(pattern); pos != std::wstring::npos; pos = text.find(pattern, pos + pattern.size())) {
+    count++;
+  }
+  return count;
+}
+
+void test_edges()
+{
+  std::wstring text = L"needle in the haystack ends with needle";
+  auto first = text.data();
+  auto last = first + text.size();
+  CHECK(text_find(first, last, L"needle", 6) == first);
+  CHECK(text_find(first + 1, last, L"needle", 6) == last - 6);
+  CHECK(text_find(first, last, L"needles", 7) == last);
+  CHECK(text_find(first, last, L"x", 0) == first);
+  CHECK(text_count(first, last, L"needle", 6) == 2);
+  CHECK(text_count(first, last, L"x", 0) == 0);
+
+  // The pattern is longer than the text.
+  CHECK(text_find(first, first + 5, L"needle", 6) == first + 5);
+  CHECK(text_find(first, first, L"n", 1) == first);
+
+  // Matches do not overlap.
+  std::wstring repeated(10, L'a');
+  CHECK(text_count(repeated.data(), repeated.data() + repeated.size(), L"aa", 2) == 5);
+  CHECK(text_count(repeated.data(), repeated.data() + repeated.size(), L"aaa", 3) == 3);
+}
+
+// Compares the search against std::wstring::find for random text over a small alphabet, so that the first and last
+// characters of the pattern match often, at every alignment of the text and across the vector block boundaries.
+void test_random()
+{
+  std::mt19937 random(1);
+  for (int i = 0; i < 20000; i++) {
+    auto alphabet = 2 + random() % 4;
+    std::wstring text(random() % 100, L' ');
+    for (auto& c : text) {
+      c = static_cast<wchar_t>(L'a' + random() % alphabet);
+    }
+    std::wstring pattern(1 + random() % 40, L' ');
+    if (text.size() > pattern.size() && random() % 2) {
+      pattern = text.substr(random() % (text.size() - pattern.size() + 1), pattern.size());
+    } else {
+      for (auto& c : pattern) {
+        c = static_cast<wchar_t>(L'a' + random() % alphabet);
+      }
+    }
+
+    auto offset = random() % 8;
+    auto first = text.data() + (offset < text.size() ? offset : 0);
+    auto last = text.data() + text.size();
+    std::wstring view(first, last);
+    auto match = text_find(first, last, pattern.data(), pattern.size());
+    auto pos = view.find(pattern);
+    CHECK(match == (pos == std::wstring::npos ? last : first + pos));
+    CHECK(text_count(first, last, pattern.data(), pattern.size()) == reference_count(view, pattern));
+  }
+}
+
+// Finds patterns with characters outside of 16 bits and characters that differ only in the high bytes.
+void test_wide_characters()
+{
+  std::wstring text(300, static_cast<wchar_t>(0x4100));
+  text[250] = L'A';
+  text[251] = static_cast<wchar_t>(0x1F600);
+  auto first = text.data();
+  auto last = first + text.size();
+  const wchar_t pattern[] = { L'A', static_cast<wchar_t>(0x1F600) };
+  CHECK(text_find(first, last, pattern, 2) == first + 250);
+  CHECK(text_find(first, last, L"A", 1) == first + 250);
+  CHECK(text_count(first, last, text.data() + 100, 100) == 2);
+}
+
+}  // namespace
+
+int main()
+{
+  test_edges();
+  test_random();
+  test_wide_characters();
+}
@@ -0,0 +1,58 @@
+#include "thread_pool.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define TASK_COUNT    1000000   // tasks per run
+#define FAN_OUT       1000      // tasks submitted by every worker task
+
+int main()
+{
+  // Double the workers up to the number of cores and end with the number of cores itself.
+  std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<std::size_t> counts;
+  for (std::size_t workers = 1; workers < cores; workers *= 2) {
+    counts.push_back(workers);
+  }
+  counts.push_back(cores);
+
+  for (auto workers : counts) {
+    thread_pool pool(workers);
+    std::atomic<std::size_t> count = { 0 };
+    char name[64];
+
+    // External submissions are distributed round-robin.
+    auto start = clock_ticks();
+    for (int i = 0; i < TASK_COUNT; i++) {
+      pool.submit([&count]() { count++; });
+    }
+    pool.wait();
+    auto end = clock_ticks();
+    std::snprintf(name, sizeof(name), "thread_pool %zu workers, external", workers);
+    report(name, elapsed_ns(start, end) / TASK_COUNT, "ns/task");
+
+    // Worker submissions go to the own deque and are stolen by idle workers.
+    start = clock_ticks();
+    for (int i = 0; i < TASK_COUNT / FAN_OUT; i++) {
+      pool.submit([&pool, &count]() {
+        for (int j = 0; j < FAN_OUT; j++) {
+          pool.submit([&count]() { count++; });
+        }
+      });
+    }
+    pool.wait();
+    end = clock_ticks();
+    std::snprintf(name, sizeof(name), "thread_pool %zu workers, from workers", workers);
+    report(name, elapsed_ns(start, end) / TASK_COUNT, "ns/task");
+
+    std::uint64_t steals = 0;
+    for (const auto& s : pool.stats()) {
+      steals += s.steals;
+    }
+    std::snprintf(name, sizeof(name), "thread_pool %zu workers, steals", workers);
+    report(name, static_cast<double>(steals), "tasks");
+  }
+}
@@ -0,0 +1,91 @@
+#include "thread_pool.h"
+#include "task_queue.h"
+#include "check.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+void test_tasks()
+{
+  thread_pool pool(4);
+  CHECK(pool.size() == 4);
+  std::atomic<int> count = { 0 };
+  for (int i = 0; i < 10000; i++) {
+    pool.submit([&count]() { count++; });
+  }
+  pool.wait();
+  CHECK(count == 10000);
+
+  std::uint64_t executed = 0;
+  for (const auto& s : pool.stats()) {
+    executed += s.executed;
+    CHECK(s.depth == 0);
+  }
+  CHECK(executed == 10000);
+}
+
+void test_nested()
+{
+  // Tasks submitted by workers go to their own deque and idle workers steal them.
+  thread_pool pool(4);
+  std::atomic<int> count = { 0 };
+  for (int i = 0; i < 8; i++) {
+    pool.submit([&pool, &count]() {
+      for (int j = 0; j < 1000; j++) {
+        pool.submit([&count]() { count++; });
+      }
+    });
+  }
+  pool.wait();
+  CHECK(count == 8000);
+}
+
+void test_continuations()
+{
+  // Continuations and exceptions reach the dispatcher, like the event loop in the templates.
+  task_queue queue;
+  thread_pool pool(2, [&queue](thread_pool::task t) {
+    queue.post(std::move(t));
+  });
+  auto main = std::this_thread::get_id();
+  std::string result;
+  auto done = false;
+  pool.submit([]() {
+    return std::string("result");
+  }, [&](std::string value) {
+    CHECK(std::this_thread::get_id() == main);
+    result = std::move(value);
+  });
+  pool.submit([]() {}, [&done]() {
+    done = true;
+  });
+  pool.submit([]() {
+    throw std::runtime_error("work");
+  });
+  pool.wait();
+
+  auto errors = 0;
+  while (!queue.empty()) {
+    try {
+      queue.run();
+    }
+    catch (const std::runtime_error&) {
+      errors++;
+    }
+  }
+  CHECK(result == "result");
+  CHECK(done);
+  CHECK(errors == 1);
+}
+
+}  // namespace
+
+int main()
+{
+  test_tasks();
+  test_nested();
+  test_continuations();
+}
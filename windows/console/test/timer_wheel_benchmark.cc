@@ -0,0 +1,79 @@
+#include "timer_wheel.h"
+#include "benchmark.h"
+#include <map>
+#include <random>
+#include <vector>
+
+#define TIMER_COUNT   1000000     // timers per run
+#define MAX_DELAY     60000       // delays are uniform up to a minute
+
+int main()
+{
+  std::mt19937_64 random(1);
+  std::vector<std::uint64_t> delays(TIMER_COUNT);
+  for (auto& delay : delays) {
+    delay = random() % MAX_DELAY;
+  }
+
+  // Schedule all timers, cancel and reschedule half of them and expire them in steps of one millisecond.
+  {
+    std::vector<timer_wheel::timer> timers(TIMER_COUNT);
+    std::size_t expired = 0;
+    for (auto& t : timers) {
+      t.bind([](void* context) {
+        ++*static_cast<std::size_t*>(context);
+      }, &expired);
+    }
+    timer_wheel wheel;
+    auto t0 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i++) {
+      wheel.schedule(timers[i], delays[i]);
+    }
+    auto t1 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i += 2) {
+      wheel.cancel(timers[i]);
+    }
+    auto t2 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i += 2) {
+      wheel.schedule(timers[i], delays[i]);
+    }
+    auto t3 = clock_ticks();
+    for (std::uint64_t now = 1; wheel.size(); now++) {
+      wheel.advance(now);
+    }
+    auto t4 = clock_ticks();
+    report("timer_wheel schedule", elapsed_ns(t0, t1) / TIMER_COUNT, "ns");
+    report("timer_wheel cancel", elapsed_ns(t1, t2) / (TIMER_COUNT / 2), "ns");
+    report("timer_wheel reschedule", elapsed_ns(t2, t3) / (TIMER_COUNT / 2), "ns");
+    report("timer_wheel expire", elapsed_ns(t3, t4) / expired, "ns");
+  }
+
+  // Compare with an ordered multimap, the usual priority queue with cancellation.
+  {
+    std::multimap<std::uint64_t, int> timers;
+    std::vector<std::multimap<std::uint64_t, int>::iterator> handles(TIMER_COUNT);
+    auto t0 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i++) {
+      handles[i] = timers.emplace(delays[i], i);
+    }
+    auto t1 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i += 2) {
+      timers.erase(handles[i]);
+    }
+    auto t2 = clock_ticks();
+    for (int i = 0; i < TIMER_COUNT; i += 2) {
+      handles[i] = timers.emplace(delays[i], i);
+    }
+    auto t3 = clock_ticks();
+    std::size_t expired = 0;
+    while (!timers.empty()) {
+      timers.erase(timers.begin());
+      expired++;
+    }
+    auto t4 = clock_ticks();
+    report("multimap schedule", elapsed_ns(t0, t1) / TIMER_COUNT, "ns");
+    report("multimap cancel", elapsed_ns(t1, t2) / (TIMER_COUNT / 2), "ns");
+    report("multimap reschedule", elapsed_ns(t2, t3) / (TIMER_COUNT / 2), "ns");
+    report("multimap expire", elapsed_ns(t3, t4) / expired, "ns");
+  }
+}
@@ -0,0 +1,242 @@
+#include "timer_wheel.h"
+#include "check.h"
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+struct record {
+  timer_wheel* wheel = nullptr;
+  std::uint64_t expiry = 0;  // expected expiry, zero if cancelled
+  int fired = 0;
+  std::uint64_t at = 0;
+  timer_wheel::timer t;
+
+  void expire()
+  {
+    fired++;
+    at = wheel->now();
+  }
+};
+
+std::uint64_t random_delay(std::mt19937_64& random)
+{
+  // Mix delays of every level.
+  switch (random() % 4) {
+  case 0:
+    return random() % 300;
+  case 1:
+    return random() % 70000;
+  case 2:
+    return random() % 20000000;
+  default:
+    return random() % 3;
+  }
+}
+
+// Schedules random timers, cancels a third of them and advances in random steps.
+// Every timer must expire once and never early.
+void test_random()
+{
+  std::mt19937_64 random(1);
+  for (int round = 0; round < 20; round++) {
+    auto start = random() % 100000;
+    timer_wheel wheel(start);
+    std::vector<std::unique_ptr<record>> records;
+    for (int i = 0; i < 20000; i++) {
+      std::unique_ptr<record> r(new record);
+      r->wheel = &wheel;
+      r->t.bind<record, &record::expire>(r.get());
+      auto delay = random_delay(random);
+      wheel.schedule(r->t, delay);
+      r->expiry = start + delay;
+      records.push_back(std::move(r));
+    }
+    for (std::size_t i = 0; i < records.size(); i += 3) {
+      wheel.cancel(records[i]->t);
+      records[i]->expiry = 0;
+    }
+    CHECK(wheel.size() == records.size() - (records.size() + 2) / 3);
+
+    auto now = start;
+    std::size_t expired = 0;
+    while (wheel.size()) {
+      auto timeout = wheel.timeout();
+      CHECK(timeout >= 1);
+      now = random() % 2 ? wheel.now() + timeout : now + 1 + random() % 5000;
+      expired += wheel.advance(now);
+    }
+    std::size_t scheduled = 0;
+    for (const auto& r : records) {
+      if (!r->expiry) {
+        CHECK(!r->fired);
+        continue;
+      }
+      CHECK(r->fired == 1);
+      CHECK(r->at >= r->expiry);
+      scheduled++;
+    }
+    CHECK(expired == scheduled);
+  }
+}
+
+// Advancing by the timeout wakes up exactly at every expiry.
+void test_exact()
+{
+  std::mt19937_64 random(2);
+  timer_wheel wheel(12345);
+  std::vector<std::unique_ptr<record>> records;
+  for (int i = 0; i < 50000; i++) {
+    std::unique_ptr<record> r(new record);
+    r->wheel = &wheel;
+    r->t.bind<record, &record::expire>(r.get());
+    auto delay = random() % 5000000;
+    wheel.schedule(r->t, delay);
+    r->expiry = 12345 + delay;
+    records.push_back(std::move(r));
+  }
+  while (wheel.size()) {
+    wheel.advance(wheel.now() + wheel.timeout());
+  }
+  for (const auto& r : records) {
+    CHECK(r->at == r->expiry);
+  }
+}
+
+void test_callbacks()
+{
+  timer_wheel wheel;
+
+  // A periodic timer reschedules itself.
+  struct periodic {
+    timer_wheel* wheel;
+    int count = 0;
+    timer_wheel::timer t;
+    void tick()
+    {
+      if (++count < 5) {
+        wheel->schedule(t, 10);
+      }
+    }
+  } p;
+  p.wheel = &wheel;
+  p.t.bind<periodic, &periodic::tick>(&p);
+  wheel.schedule(p.t, 10);
+  wheel.advance(100);
+  CHECK(p.count == 5);
+
+  // A timer without delay that reschedules itself expires once per advance.
+  p.count = 0;
+  p.t.bind([](void* context) {
+    auto self = static_cast<periodic*>(context);
+    if (++self->count < 3) {
+      self->wheel->schedule(self->t, 0);
+    }
+  }, &p);
+  wheel.schedule(p.t, 0);
+  CHECK(wheel.advance(101) == 1 && p.count == 1);
+  CHECK(wheel.advance(102) == 1 && p.count == 2);
+  CHECK(wheel.advance(200) == 1 && p.count == 3);
+
+  // A callback can cancel another timer of the same batch.
+  timer_wheel::timer a;
+  timer_wheel::timer b;
+  struct canceller {
+    timer_wheel* wheel;
+    timer_wheel::timer* other;
+    void tick()
+    {
+      wheel->cancel(*other);
+    }
+  } c = { &wheel, &b };
+  a.bind<canceller, &canceller::tick>(&c);
+  b.bind([](void*) {
+    CHECK(false);
+  }, nullptr);
+  wheel.schedule(b, 5);
+  wheel.schedule(a, 5);
+  CHECK(wheel.advance(205) == 1);
+  CHECK(!b.active());
+  CHECK(wheel.size() == 0);
+
+  // A callback can destroy its own timer.
+  auto owned = new timer_wheel::timer;
+  owned->bind([](void* context) {
+    delete static_cast<timer_wheel::timer*>(context);
+  }, owned);
+  wheel.schedule(*owned, 1);
+  CHECK(wheel.advance(300) == 1);
+
+  // Destroying a timer cancels it.
+  {
+    timer_wheel::timer scoped;
+    scoped.bind([](void*) {}, nullptr);
+    wheel.schedule(scoped, 50);
+    CHECK(wheel.size() == 1);
+  }
+  CHECK(wheel.size() == 0);
+  CHECK(wheel.timeout() == UINT64_MAX);
+
+  // Far timers report a timeout at the next level wrap at the latest.
+  timer_wheel::timer far;
+  far.bind([](void*) {}, nullptr);
+  wheel.schedule(far, UINT64_MAX);
+  CHECK(wheel.timeout() <= 256);
+}
+
+void test_exception()
+{
+  // The callbacks after a throwing callback run on the next advance.
+  timer_wheel wheel;
+  int count = 0;
+  timer_wheel::timer timers[3];
+  timers[0].bind([](void*) {
+    throw std::runtime_error("timer");
+  }, nullptr);
+  for (int i = 1; i < 3; i++) {
+    timers[i].bind([](void* context) {
+      ++*static_cast<int*>(context);
+    }, &count);
+  }
+  for (auto& t : timers) {
+    wheel.schedule(t, 10);
+  }
+  auto thrown = false;
+  try {
+    wheel.advance(10);
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  CHECK(wheel.size() + count == 2);
+  CHECK(wheel.advance(10) + count == 2);
+  CHECK(count == 2);
+  CHECK(wheel.size() == 0);
+}
+
+void test_destroy()
+{
+  // Timers may outlive the wheel.
+  timer_wheel::timer t;
+  t.bind([](void*) {}, nullptr);
+  {
+    timer_wheel wheel;
+    wheel.schedule(t, 100);
+    CHECK(t.active());
+  }
+  CHECK(!t.active());
+}
+
+}  // namespace
+
+int main()
+{
+  test_random();
+  test_exact();
+  test_callbacks();
+  test_exception();
+  test_destroy();
+}
@@ -0,0 +1,46 @@
+#include "tracer.h"
+#include "benchmark.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define SPAN_COUNT    10000000    // spans per thread and run
+#define JSON_COUNT    100         // serializations of a full ring per run
+
+int main()
+{
+  // Record spans from one and from several threads into a ring of the default size.
+  for (int threads : { 1, 2, 4 }) {
+    tracer t;
+    auto start = clock_ticks();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+      workers.emplace_back([&t]() {
+        for (int j = 0; j < SPAN_COUNT; j++) {
+          t.record("span", "benchmark", j, j + 1, j & 0xFFFF);
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    auto end = clock_ticks();
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "tracer record, %d threads", threads);
+    report(name, elapsed_ns(start, end) / (static_cast<double>(SPAN_COUNT) * threads), "ns");
+  }
+
+  // Serialize a full ring, as at exit.
+  tracer t;
+  for (int j = 0; j < 8192; j++) {
+    t.record("span", "benchmark", clock_ticks(), clock_ticks(), j);
+  }
+  std::size_t size = 0;
+  auto start = clock_ticks();
+  for (int i = 0; i < JSON_COUNT; i++) {
+    size += t.json().size();
+  }
+  auto end = clock_ticks();
+  report("tracer json of 8192 spans", elapsed_ns(start, end) / JSON_COUNT / 1e3, "us");
+  report("tracer json size", static_cast<double>(size / JSON_COUNT) / 1024, "KiB");
+}
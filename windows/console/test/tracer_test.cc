@@ -0,0 +1,278 @@
+#include "tracer.h"
+#include "check.h"
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Minimal JSON validator that accepts exactly the RFC 8259 grammar.
+class json_validator {
+public:
+  explicit json_validator(const std::string& text) : p_(text.c_str())
+  {}
+
+  bool valid()
+  {
+    return value() && (space(), !*p_);
+  }
+
+private:
+  void space()
+  {
+    while (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r') {
+      p_++;
+    }
+  }
+
+  bool literal(const char* str)
+  {
+    auto size = std::strlen(str);
+    if (std::strncmp(p_, str, size)) {
+      return false;
+    }
+    p_ += size;
+    return true;
+  }
+
+  bool string()
+  {
+    if (*p_++ != '"') {
+      return false;
+    }
+    while (*p_ != '"') {
+      auto c = static_cast<unsigned char>(*p_++);
+      if (c < 0x20) {
+        return false;
+      }
+      if (c == '\\') {
+        c = static_cast<unsigned char>(*p_++);
+        if (c == 'u') {
+          for (int i = 0; i < 4; i++) {
+            if (!std::isxdigit(static_cast<unsigned char>(*p_++))) {
+              return false;
+            }
+          }
+        } else if (!std::strchr("\"\\/bfnrt", c) || !c) {
+          return false;
+        }
+      }
+    }
+    p_++;
+    return true;
+  }
+
+  bool number()
+  {
+    p_ += *p_ == '-';
+    if (*p_ == '0') {
+      p_++;
+    } else if (*p_ >= '1' && *p_ <= '9') {
+      while (std::isdigit(static_cast<unsigned char>(*p_))) {
+        p_++;
+      }
+    } else {
+      return false;
+    }
+    if (*p_ == '.') {
+      p_++;
+      if (!std::isdigit(static_cast<unsigned char>(*p_))) {
+        return false;
+      }
+      while (std::isdigit(static_cast<unsigned char>(*p_))) {
+        p_++;
+      }
+    }
+    return true;
+  }
+
+  bool value()
+  {
+    space();
+    switch (*p_) {
+    case '{':
+      p_++;
+      space();
+      if (*p_ == '}') {
+        p_++;
+        return true;
+      }
+      for (;;) {
+        space();
+        if (!string() || (space(), *p_++ != ':') || !value()) {
+          return false;
+        }
+        space();
+        if (*p_ == '}') {
+          p_++;
+          return true;
+        }
+        if (*p_++ != ',') {
+          return false;
+        }
+      }
+    case '[':
+      p_++;
+      space();
+      if (*p_ == ']') {
+        p_++;
+        return true;
+      }
+      for (;;) {
+        if (!value()) {
+          return false;
+        }
+        space();
+        if (*p_ == ']') {
+          p_++;
+          return true;
+        }
+        if (*p_++ != ',') {
+          return false;
+        }
+      }
+    case '"':
+      return string();
+    case 't':
+      return literal("true");
+    case 'f':
+      return literal("false");
+    case 'n':
+      return literal("null");
+    default:
+      return number();
+    }
+  }
+
+  const char* p_;
+};
+
+// Returns the number of occurrences of a string.
+std::size_t count(const std::string& text, const std::string& str)
+{
+  std::size_t n = 0;
+  for (auto pos = text.find(str); pos != std::string::npos; pos = text.find(str, pos + 1)) {
+    n++;
+  }
+  return n;
+}
+
+void test_empty()
+{
+  tracer t(4);
+  auto json = t.json();
+  CHECK(json_validator(json).valid());
+  CHECK(count(json, "\"ph\"") == 0);
+}
+
+void test_spans()
+{
+  tracer t(16);
+  auto start = clock_ticks();
+  t.record("paint", "message", start, start + static_cast<std::uint64_t>(clock_frequency() / 1000), 0x000F);
+  t.record("quote \" and \\ and \n", "startup", start, start);
+  t.record("reversed", "startup", start + 10, start);
+
+  auto json = t.json();
+  CHECK(json_validator(json).valid());
+  CHECK(count(json, "\"ph\":\"X\"") == 3);
+  CHECK(json.find("\"args\":{\"id\":\"0x000F\"}") != std::string::npos);
+  CHECK(count(json, "\"args\"") == 1);
+  CHECK(json.find("\"dur\":1000.000") != std::string::npos);
+  CHECK(json.find("\"quote \\\" and \\\\ and \\u000A\"") != std::string::npos);
+
+  // A span that ends before it starts has no duration.
+  CHECK(json.find("\"name\":\"reversed\",\"cat\":\"startup\",\"ph\":\"X\"") != std::string::npos);
+  CHECK(count(json, "\"dur\":0.000") == 2);
+}
+
+void test_ring()
+{
+  // Only the newest spans are kept, from the oldest to the newest.
+  static const char* names[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+  tracer t(4);
+  for (auto name : names) {
+    t.record(name, "test", clock_ticks(), clock_ticks());
+  }
+  auto json = t.json();
+  CHECK(json_validator(json).valid());
+  CHECK(count(json, "\"ph\"") == 4);
+  auto a = json.find("\"name\":\"6\"");
+  auto b = json.find("\"name\":\"7\"");
+  auto c = json.find("\"name\":\"8\"");
+  auto d = json.find("\"name\":\"9\"");
+  CHECK(a != std::string::npos && a < b && b < c && c < d && d != std::string::npos);
+  CHECK(json.find("\"name\":\"5\"") == std::string::npos);
+}
+
+void test_threads()
+{
+  // Every thread gets its own ID and no span is lost while the ring has room.
+  tracer t(4 * 1000);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&t]() {
+      for (int j = 0; j < 1000; j++) {
+        t.record("work", "thread", clock_ticks(), clock_ticks());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto json = t.json();
+  CHECK(json_validator(json).valid());
+  CHECK(count(json, "\"ph\"") == 4000);
+  std::size_t ids = 0;
+  for (unsigned id = 1; id < 16; id++) {
+    auto n = count(json, "\"tid\":" + std::to_string(id) + "}");
+    CHECK(n == 0 || n == 1000);
+    ids += n != 0;
+  }
+  CHECK(ids == 4);
+}
+
+void test_handlers()
+{
+  // Every handler is recorded during startup, afterwards only the slow ones.
+  auto& t = tracer::instance();
+  CHECK(t.startup());
+  {
+    trace_handler handler(0x0001, false);
+  }
+  CHECK(t.startup());
+  {
+    trace_handler handler(0x000F, true);
+  }
+  CHECK(!t.startup());
+  {
+    trace_handler handler(0x0200, false);
+  }
+  {
+    trace_handler handler(0x0113, false);
+    auto start = clock_ticks();
+    while (clock_ticks() - start <= t.threshold()) {
+      std::this_thread::yield();
+    }
+  }
+
+  auto json = t.json();
+  CHECK(json_validator(json).valid());
+  CHECK(count(json, "\"cat\":\"startup\"") == 2);
+  CHECK(count(json, "\"cat\":\"long handler\"") == 1);
+  CHECK(json.find("\"0x0113\"") != std::string::npos);
+  CHECK(json.find("\"0x0200\"") == std::string::npos);
+}
+
+}  // namespace
+
+int main()
+{
+  test_empty();
+  test_spans();
+  test_ring();
+  test_threads();
+  test_handlers();
+}
@@ -0,0 +1,50 @@
+#include "utf.h"
+#include "benchmark.h"
+#include <string>
+#include <vector>
+
+#define TEXT_SIZE     (1 << 20)   // bytes per conversion
+#define ROUNDS        200         // conversions per text
+
+namespace {
+
+// Reports the throughput of every kernel that the processor supports.
+void run(const char* name, const std::string& text)
+{
+  std::vector<char16_t> out(text.size());
+  auto src = reinterpret_cast<const unsigned char*>(text.data());
+  for (const auto& kernel : utf_detail::kernels()) {
+    std::size_t written = 0;
+    auto start = clock_ticks();
+    for (int i = 0; i < ROUNDS; i++) {
+      kernel.convert(src, text.size(), out.data(), written, false);
+    }
+    auto end = clock_ticks();
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s %s", name, kernel.name);
+    report(label, static_cast<double>(text.size()) * ROUNDS / elapsed_ns(start, end), "GB/s");
+  }
+}
+
+std::string repeat(const char* piece)
+{
+  std::string text;
+  while (text.size() < TEXT_SIZE) {
+    text += piece;
+  }
+  return text;
+}
+
+}  // namespace
+
+int main()
+{
+  // Log output is mostly ASCII with the occasional accented character.
+  std::string latin;
+  for (int i = 0; latin.size() < TEXT_SIZE; i++) {
+    latin += i % 50 == 0 ? "\xC3\xA9" : "x";
+  }
+  run("utf8_to_utf16 ascii", repeat("The quick brown fox jumps over the lazy dog.\n"));
+  run("utf8_to_utf16 ascii with 2% latin", latin);
+  run("utf8_to_utf16 cjk", repeat("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\n"));
+}
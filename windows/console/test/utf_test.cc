@@ -0,0 +1,161 @@
+#include "utf.h"
+#include "check.h"
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Straightforward decoder that follows the table of well-formed byte sequences and replaces
+// every maximal invalid subpart with U+FFFD.
+bool reference(const std::string& str, bool strict, std::u16string& out)
+{
+  out.clear();
+  auto src = reinterpret_cast<const unsigned char*>(str.data());
+  std::size_t i = 0;
+  while (i < str.size()) {
+    unsigned c = src[i];
+    std::size_t length = 0;
+    unsigned lo = 0x80;
+    unsigned hi = 0xBF;
+    if (c < 0x80) {
+      out += static_cast<char16_t>(c);
+      i++;
+      continue;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+      length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      length = 3;
+      lo = c == 0xE0 ? 0xA0 : 0x80;
+      hi = c == 0xED ? 0x9F : 0xBF;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      length = 4;
+      lo = c == 0xF0 ? 0x90 : 0x80;
+      hi = c == 0xF4 ? 0x8F : 0xBF;
+    }
+
+    // Count the valid continuation bytes.
+    std::size_t n = 1;
+    while (length && n < length && i + n < str.size()) {
+      unsigned b = src[i + n];
+      if (b < (n == 1 ? lo : 0x80) || b > (n == 1 ? hi : 0xBF)) {
+        break;
+      }
+      n++;
+    }
+    if (length && n == length) {
+      unsigned cp = c & (0x7F >> length);
+      for (std::size_t k = 1; k < length; k++) {
+        cp = (cp << 6) | (src[i + k] & 0x3F);
+      }
+      if (cp >= 0x10000) {
+        cp -= 0x10000;
+        out += static_cast<char16_t>(0xD800 + (cp >> 10));
+        out += static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+      } else {
+        out += static_cast<char16_t>(cp);
+      }
+      i += length;
+      continue;
+    }
+    if (strict) {
+      return false;
+    }
+    out += u'\xFFFD';
+    i += n;
+  }
+  return true;
+}
+
+std::u16string convert(const std::string& str)
+{
+  std::vector<char16_t> out(str.size() + 1);
+  out.resize(utf8_to_utf16(str.data(), str.size(), out.data()));
+  return std::u16string(out.begin(), out.end());
+}
+
+void test_sequences()
+{
+  CHECK(convert("") == u"");
+  CHECK(convert("abc") == u"abc");
+  CHECK(convert("\xC3\xA9\xE2\x82\xAC") == u"\u00E9\u20AC");
+  CHECK(convert("\xF0\x9F\x98\x80") == u"\U0001F600");
+
+  // Overlong forms, surrogates and code points above U+10FFFF.
+  CHECK(convert("\xC0\xAF") == u"\xFFFD\xFFFD");
+  CHECK(convert("\xE0\x80\xAF") == u"\xFFFD\xFFFD\xFFFD");
+  CHECK(convert("\xED\xA0\x80") == u"\xFFFD\xFFFD\xFFFD");
+  CHECK(convert("\xF4\x90\x80\x80") == u"\xFFFD\xFFFD\xFFFD\xFFFD");
+
+  // A truncated sequence is one maximal subpart.
+  CHECK(convert("\xE2\x82z") == u"\xFFFDz");
+  CHECK(convert("\xF0\x9F\x98") == u"\xFFFD");
+
+  std::size_t written = 0;
+  char16_t out[8] = {};
+  CHECK(utf8_to_utf16_strict("ab\xC3\xA9", 4, out, written));
+  CHECK(written == 3);
+  CHECK(!utf8_to_utf16_strict("ab\xFF", 3, out, written));
+  CHECK(written == 2);
+}
+
+// Compares random mixes of text, sequences and bytes against the reference at every length,
+// so that every vector block boundary is crossed. Every kernel that the processor supports is run.
+void test_random(const utf_detail::kernel& kernel)
+{
+  const char* pieces[] = {
+    "a", "hello world ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\xA0\x80", "\xC0\xAF",
+    "\xE0\x80", "\xF4\x90\x80\x80", "\x80", "\xFF", "\xF0\x9F\x98", "abcdefghijklmnopqrstuvwxyz0123456789",
+  };
+  std::mt19937 random(1);
+  std::u16string expected;
+  std::vector<char16_t> out;
+  for (int i = 0; i < 100000; i++) {
+    std::string str;
+    for (auto n = random() % 24; n > 0; n--) {
+      if (random() % 4 == 0) {
+        str += static_cast<char>(random());
+      } else {
+        str += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+      }
+    }
+    auto strict = i % 2 == 1;
+    auto valid = reference(str, strict, expected);
+    out.assign(str.size() + 1, 0);
+    std::size_t written = 0;
+    auto src = reinterpret_cast<const unsigned char*>(str.data());
+    CHECK(kernel.convert(src, str.size(), out.data(), written, strict) == valid);
+    CHECK(!valid || written == expected.size());
+    if (valid) {
+      CHECK(std::memcmp(out.data(), expected.data(), written * sizeof(char16_t)) == 0);
+    }
+  }
+}
+
+// The public functions use the widest kernel.
+void test_dispatch()
+{
+  auto kernels = utf_detail::kernels();
+  CHECK(!kernels.empty());
+  CHECK(std::string(kernels.front().name) == "scalar");
+
+  std::string str = "caf\xC3\xA9 \xE2\x82\xAC \xFF and a long ASCII tail that fills a vector block";
+  std::vector<char16_t> expected(str.size());
+  std::size_t written = 0;
+  kernels.back().convert(reinterpret_cast<const unsigned char*>(str.data()), str.size(), expected.data(), written, false);
+  expected.resize(written);
+  auto actual = convert(str);
+  CHECK(actual == std::u16string(expected.begin(), expected.end()));
+}
+
+}  // namespace
+
+int main()
+{
+  test_sequences();
+  test_dispatch();
+  for (const auto& kernel : utf_detail::kernels()) {
+    test_random(kernel);
+  }
+}
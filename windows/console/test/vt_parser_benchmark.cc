@@ -0,0 +1,36 @@
+#include "vt_parser.h"
+#include "benchmark.h"
+#include <string>
+#include <vector>
+
+#define TEXT_SIZE     (1 << 20)   // bytes per parse
+#define ROUNDS        200         // parses per text
+
+namespace {
+
+void run(const char* name, const char* line)
+{
+  std::string text;
+  while (text.size() < TEXT_SIZE) {
+    text += line;
+  }
+
+  vt_parser parser;
+  std::vector<vt_span> spans;
+  auto start = clock_ticks();
+  for (int i = 0; i < ROUNDS; i++) {
+    spans.clear();
+    parser.parse(text.data(), text.size(), spans);
+  }
+  auto end = clock_ticks();
+  report(name, static_cast<double>(text.size()) * ROUNDS / elapsed_ns(start, end), "GB/s");
+}
+
+}  // namespace
+
+int main()
+{
+  run("vt_parser plain", "2024-01-01 12:00:00.000 [info] request handled in 12 ms\n");
+  run("vt_parser colored level", "2024-01-01 12:00:00.000 [\x1B[32minfo\x1B[0m] request handled in 12 ms\n");
+  run("vt_parser true color", "\x1B[38;2;200;100;50m2024-01-01\x1B[0m \x1B[1;38;5;214mwarn\x1B[0m disk almost full\n");
+}
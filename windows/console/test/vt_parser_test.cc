@@ -0,0 +1,165 @@
+#include "vt_parser.h"
+#include "check.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Text and style of every output character.
+struct styled {
+  std::string text;
+  std::vector<vt_style> styles;
+};
+
+void parse(vt_parser& parser, const std::string& input, styled& out)
+{
+  std::vector<vt_span> spans;
+  parser.parse(input.data(), input.size(), spans);
+  for (const auto& span : spans) {
+    // Only characters that were split across calls come from the parser.
+    CHECK((span.data >= input.data() && span.data + span.size <= input.data() + input.size()) || span.size <= 4);
+    out.text.append(span.data, span.size);
+    out.styles.insert(out.styles.end(), span.size, span.style);
+  }
+}
+
+styled parse(const std::string& input)
+{
+  vt_parser parser;
+  styled out;
+  parse(parser, input, out);
+  return out;
+}
+
+void test_sgr()
+{
+  auto out = parse("plain \x1B[1;31mred\x1B[0m plain");
+  CHECK(out.text == "plain red plain");
+  CHECK(out.styles[0] == vt_style());
+  CHECK(out.styles[6].foreground == 0xCD0000);
+  CHECK(out.styles[6].attributes == VT_BOLD);
+  CHECK(out.styles[9] == vt_style());
+
+  // 256 colors and true colors.
+  out = parse("\x1B[38;5;196;48;2;1;2;3mx\x1B[39;4;7my\x1B[24;27;49mz");
+  CHECK(out.styles[0].foreground == 0xFF0000);
+  CHECK(out.styles[0].background == 0x010203);
+  CHECK(out.styles[1].foreground == VT_DEFAULT_COLOR);
+  CHECK(out.styles[1].attributes == (VT_UNDERLINE | VT_INVERSE));
+  CHECK(out.styles[2] == vt_style());
+
+  // Bright colors.
+  out = parse("\x1B[92;104mx");
+  CHECK(out.styles[0].foreground == 0x00FF00);
+  CHECK(out.styles[0].background == 0x5C5CFF);
+}
+
+void test_removed()
+{
+  // Other CSI sequences, private modes, OSC strings and two-character escapes are removed.
+  auto out = parse("a\x1B[2Jb\x1B[?25lc\x1B]0;title\x07" "d\x1B]0;t\x1B\\e\x1B(Bf\x1B" "7g");
+  CHECK(out.text == "abcdefg");
+  for (const auto& style : out.styles) {
+    CHECK(style == vt_style());
+  }
+}
+
+void test_split()
+{
+  // Sequences split across calls keep their state.
+  vt_parser parser;
+  styled out;
+  parse(parser, "\x1B[3", out);
+  parse(parser, "2mgreen\x1B", out);
+  parse(parser, "]0;t", out);
+  parse(parser, "itle\x07!", out);
+  CHECK(out.text == "green!");
+  CHECK(out.styles[0].foreground == 0x00CD00);
+  CHECK(parser.style().foreground == 0x00CD00);
+  parser.reset();
+  CHECK(parser.style() == vt_style());
+}
+
+void test_utf8()
+{
+  // Characters split across calls come out whole, in spans of their own.
+  vt_parser parser;
+  std::vector<vt_span> spans;
+  std::string first = "caf\xC3";
+  std::string second = "\xA9 \xF0\x9F";
+  std::string third = "\x98";
+  std::string fourth = "\x80!";
+  parser.parse(first.data(), first.size(), spans);
+  CHECK(spans.size() == 1 && std::string(spans[0].data, spans[0].size) == "caf");
+  spans.clear();
+  parser.parse(second.data(), second.size(), spans);
+  CHECK(spans.size() == 2);
+  CHECK(std::string(spans[0].data, spans[0].size) == "\xC3\xA9");
+  CHECK(std::string(spans[1].data, spans[1].size) == " ");
+  spans.clear();
+  parser.parse(third.data(), third.size(), spans);
+  CHECK(spans.empty());
+  parser.parse(fourth.data(), fourth.size(), spans);
+  CHECK(spans.size() == 2);
+  CHECK(std::string(spans[0].data, spans[0].size) == "\xF0\x9F\x98\x80");
+  CHECK(std::string(spans[1].data, spans[1].size) == "!");
+
+  // An interrupted sequence is passed on as it is, and reset() drops a held back one.
+  styled out;
+  parse(parser, "\x1B[31m\xE2\x82", out);
+  parse(parser, "\x1B[0mx\xE2", out);
+  CHECK(out.text == "\xE2\x82x");
+  CHECK(out.styles[0].foreground == 0xCD0000 && out.styles[1].foreground == 0xCD0000);
+  CHECK(out.styles[2] == vt_style());
+  parser.reset();
+  parse(parser, "\x82\xAC", out);
+  CHECK(out.text == "\xE2\x82x\x82\xAC");
+}
+
+// Parses random streams at once and split at random positions and compares the results.
+void test_random()
+{
+  const char* pieces[] = {
+    "text ", "\n", "\x1B[0m", "\x1B[1m", "\x1B[31m", "\x1B[38;5;99m", "\x1B[48;2;10;20;30m", "\x1B[K",
+    "\x1B[?1049h", "\x1B]2;title\x07", "\x1B]8;;url\x1B\\", "\x1B", "[", ";", "m", "7",
+    "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xE2\x82",
+  };
+  std::mt19937 random(1);
+  for (int i = 0; i < 20000; i++) {
+    std::string input;
+    for (auto n = random() % 32; n > 0; n--) {
+      input += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    auto whole = parse(input);
+
+    vt_parser parser;
+    styled split;
+    std::vector<std::string> parts;
+    for (std::size_t pos = 0; pos < input.size();) {
+      auto size = std::min<std::size_t>(1 + random() % 8, input.size() - pos);
+      parts.push_back(input.substr(pos, size));
+      pos += size;
+    }
+    for (const auto& part : parts) {
+      parse(parser, part, split);
+    }
+    CHECK(split.text == whole.text);
+    CHECK(split.styles.size() == whole.styles.size());
+    for (std::size_t j = 0; j < whole.styles.size(); j++) {
+      CHECK(split.styles[j] == whole.styles[j]);
+    }
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_sgr();
+  test_removed();
+  test_split();
+  test_utf8();
+  test_random();
+}
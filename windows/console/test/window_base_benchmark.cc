@@ -0,0 +1,188 @@
+#include "window_base.h"
+#include "benchmark.h"
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#define MESSAGE_COUNT (1 << 20)  // messages per stream
+#define ROUNDS        20         // passes over every stream
+
+#define WM_APP_WRITE (WM_APP + 1)
+
+namespace {
+
+struct message {
+  UINT msg;
+  WPARAM wparam;
+  LPARAM lparam;
+};
+
+// Handlers of the console window before the message map. They only count, so the dispatch dominates.
+struct handlers {
+  void on_create() { count++; }
+  void on_destroy() { count++; }
+  void on_size(int cx, int cy) { count += static_cast<std::size_t>(cx + cy); }
+  void on_command(UINT id) { count += id; }
+  void on_timer(UINT_PTR id) { count += id; }
+  void on_write() { count++; }
+
+  std::size_t count = 0;
+};
+
+// Copy of the window procedure and the handle() switch that the console template used before window_base.
+class switch_window : public handlers {
+public:
+  static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    auto self = reinterpret_cast<switch_window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    if (msg == WM_CREATE) {
+      self = reinterpret_cast<switch_window*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
+    } else if (msg == WM_DESTROY) {
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+    }
+    return self ? self->handle(hwnd, msg, wparam, lparam) : DefWindowProc(hwnd, msg, wparam, lparam);
+  }
+
+private:
+  LRESULT handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    try {
+      switch (msg) {
+      case WM_CREATE:
+        hwnd_ = hwnd;
+        on_create();
+        return 0;
+      case WM_DESTROY:
+        on_destroy();
+        hwnd_ = nullptr;
+        return 0;
+      case WM_SIZE:
+        on_size(LOWORD(lparam), HIWORD(lparam));
+        return 0;
+      case WM_COMMAND:
+        on_command(LOWORD(wparam));
+        return 0;
+      case WM_TIMER:
+        on_timer(static_cast<UINT_PTR>(wparam));
+        return 0;
+      case WM_APP_WRITE:
+        on_write();
+        return 0;
+      }
+    }
+    catch (const std::exception& e) {
+      std::wstring msg;
+      utf8_to_utf16(e.what(), msg);
+      MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
+      DestroyWindow(hwnd);
+    }
+    return DefWindowProc(hwnd, msg, wparam, lparam);
+  }
+
+  HWND hwnd_ = nullptr;
+};
+
+// The same handlers through the generated message map, with the application message listed for on_message.
+class map_window : public window_base<map_window>, public handlers {
+public:
+  using messages = message_list<WM_APP_WRITE>;
+  bool on_message(UINT msg, WPARAM, LPARAM, LRESULT&)
+  {
+    if (msg == WM_APP_WRITE) {
+      on_write();
+      return true;
+    }
+    return false;
+  }
+};
+
+// The message map with on_message taking every message of the stream, as when on_message was unfiltered.
+class unfiltered_window : public window_base<unfiltered_window>, public handlers {
+public:
+  using messages = message_list<WM_APP_WRITE, WM_MOUSEMOVE, WM_NCHITTEST, WM_SETCURSOR, WM_NCMOUSEMOVE, WM_GETICON,
+    WM_WINDOWPOSCHANGING, WM_ERASEBKGND, WM_PAINT>;
+  bool on_message(UINT msg, WPARAM, LPARAM, LRESULT&)
+  {
+    if (msg == WM_APP_WRITE) {
+      on_write();
+      return true;
+    }
+    return false;
+  }
+};
+
+// Builds a stream like the one a console window sees while output is written and the mouse moves over it.
+// Most messages have no handler.
+std::vector<message> make_stream(bool handled)
+{
+  struct weight {
+    UINT msg;
+    int percent;
+  };
+  static const weight mixed[] = {
+    { WM_MOUSEMOVE, 20 }, { WM_NCHITTEST, 20 }, { WM_SETCURSOR, 20 }, { WM_NCMOUSEMOVE, 5 }, { WM_GETICON, 5 },
+    { WM_WINDOWPOSCHANGING, 4 }, { WM_ERASEBKGND, 2 }, { WM_PAINT, 4 }, { WM_APP_WRITE, 12 }, { WM_TIMER, 5 },
+    { WM_SIZE, 2 }, { WM_COMMAND, 1 },
+  };
+  std::mt19937 random(1);
+  std::vector<message> stream(MESSAGE_COUNT);
+  for (auto& m : stream) {
+    int pick = static_cast<int>(random() % 100);
+    for (const auto& w : mixed) {
+      if ((pick -= w.percent) < 0) {
+        m.msg = w.msg;
+        break;
+      }
+    }
+    if (!handled) {
+      m.msg = m.msg == WM_APP_WRITE || m.msg == WM_TIMER || m.msg == WM_SIZE || m.msg == WM_COMMAND ? WM_NCHITTEST : m.msg;
+    }
+    m.wparam = random() % 4;
+    m.lparam = static_cast<LPARAM>(random() % 1024);
+  }
+  return stream;
+}
+
+// Creates the window and sends the stream through the window procedure like the message loop.
+template <typename T>
+double run(const std::vector<message>& stream, std::size_t& sink)
+{
+  mock_window w;
+  T t;
+  CREATESTRUCT cs = { &t };
+  WNDPROC volatile proc = &T::window_proc;
+  w.proc = reinterpret_cast<LONG_PTR>(proc);
+  SendMessage(&w, WM_NCCREATE, 0, reinterpret_cast<LPARAM>(&cs));
+  SendMessage(&w, WM_CREATE, 0, reinterpret_cast<LPARAM>(&cs));
+
+  auto start = clock_ticks();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const auto& m : stream) {
+      WNDPROC current = reinterpret_cast<WNDPROC>(w.proc);
+      sink += static_cast<std::size_t>(current(&w, m.msg, m.wparam, m.lparam));
+    }
+  }
+  auto end = clock_ticks();
+  sink += t.count + w.default_calls;
+  return elapsed_ns(start, end) / (static_cast<double>(stream.size()) * ROUNDS);
+}
+
+}  // namespace
+
+int main()
+{
+  std::size_t sink = 0;
+  for (auto handled : { true, false }) {
+    auto stream = make_stream(handled);
+    auto suffix = handled ? "mixed" : "unhandled";
+    char name[64];
+    std::snprintf(name, sizeof(name), "old switch, %s", suffix);
+    report(name, run<switch_window>(stream, sink), "ns/message");
+    std::snprintf(name, sizeof(name), "message map, %s", suffix);
+    report(name, run<map_window>(stream, sink), "ns/message");
+    std::snprintf(name, sizeof(name), "message map unfiltered, %s", suffix);
+    report(name, run<unfiltered_window>(stream, sink), "ns/message");
+  }
+  return sink == 0;
+}
@@ -0,0 +1,208 @@
+#include "window_base.h"
+#include "check.h"
+#include "thread_pool.h"
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#define WM_APP_TEST (WM_APP + 1)
+
+namespace {
+
+// Declares handlers for the message map only.
+class plain_window : public window_base<plain_window> {
+public:
+  void on_create() { created++; }
+  void on_destroy() { destroyed++; }
+  void on_size(int cx, int cy) { width = cx + cy; }
+
+  void on_command(UINT id)
+  {
+    if (id == 1) {
+      throw std::runtime_error("failed");
+    }
+    commands++;
+  }
+
+  int created = 0;
+  int destroyed = 0;
+  int commands = 0;
+  int width = 0;
+};
+
+// Takes one application message through on_message.
+class app_window : public window_base<app_window> {
+public:
+  void on_paint() { painted++; }
+
+  using messages = message_list<WM_APP_TEST, WM_ERASEBKGND>;
+  bool on_message(UINT msg, WPARAM, LPARAM, LRESULT& result)
+  {
+    seen++;
+    if (msg == WM_APP_TEST) {
+      result = 42;
+      return true;
+    }
+    return false;
+  }
+
+  int painted = 0;
+  int seen = 0;
+};
+
+// Loads its resources on a pool like the console window in the fast start mode.
+class loading_window : public window_base<loading_window> {
+public:
+  void load(thread_pool& pool, bool fail_work, bool fail_continuation)
+  {
+    pool.submit([fail_work]() {
+      std::exception_ptr error;
+      try {
+        if (fail_work) {
+          throw std::runtime_error("could not load");
+        }
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      return error;
+    }, [this, fail_continuation](std::exception_ptr error) {
+      guarded([&]() {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        if (fail_continuation) {
+          throw std::runtime_error("could not create the controls");
+        }
+        loaded++;
+      });
+    });
+  }
+
+  int loaded = 0;
+};
+
+class test_dialog : public dialog_base<test_dialog> {
+public:
+  void on_initdialog() { initialized++; }
+  void on_command(UINT id) { commands += id; }
+
+  int initialized = 0;
+  UINT commands = 0;
+};
+
+static_assert(window_messages::handles<plain_window>(WM_SIZE), "declared handler");
+static_assert(!window_messages::handles<plain_window>(WM_PAINT), "undeclared handler");
+static_assert(!window_messages::handles<plain_window>(WM_APP_TEST), "no on_message");
+static_assert(window_messages::handles<app_window>(WM_APP_TEST), "listed message");
+static_assert(!window_messages::handles<app_window>(WM_MOUSEMOVE), "unlisted message");
+static_assert(message_list<1, 2, 3>::contains(3) && !message_list<1, 2, 3>::contains(4), "message list");
+static_assert(!message_list<>::contains(0), "empty message list");
+
+template <typename T>
+void create(mock_window& w, T& t)
+{
+  CREATESTRUCT cs = { &t };
+  w.proc = reinterpret_cast<LONG_PTR>(&T::window_proc);
+  SendMessage(&w, WM_NCCREATE, 0, reinterpret_cast<LPARAM>(&cs));
+  SendMessage(&w, WM_CREATE, 0, reinterpret_cast<LPARAM>(&cs));
+}
+
+void test_dispatch()
+{
+  mock_window w;
+  plain_window t;
+  create(w, t);
+  CHECK(t.created == 1);
+  CHECK(t.hwnd() == &w);
+
+  // Handled messages do not reach the default procedure.
+  auto calls = w.default_calls;
+  SendMessage(&w, WM_SIZE, 0, (3 << 16) | 4);
+  SendMessage(&w, WM_COMMAND, 2, 0);
+  CHECK(t.width == 7);
+  CHECK(t.commands == 1);
+  CHECK(w.default_calls == calls);
+
+  SendMessage(&w, WM_MOUSEMOVE, 0, 0);
+  CHECK(w.default_calls == calls + 1);
+
+  // An exception is reported, destroys the window and falls back to the default procedure.
+  SendMessage(&w, WM_COMMAND, 1, 0);
+  CHECK(w.destroyed == 1);
+  CHECK(w.default_calls == calls + 2);
+
+  SendMessage(&w, WM_DESTROY, 0, 0);
+  CHECK(t.destroyed == 1);
+  CHECK(t.hwnd() == nullptr);
+  SendMessage(&w, WM_NCDESTROY, 0, 0);
+  CHECK(w.user_data == 0);
+}
+
+void test_message_list()
+{
+  mock_window w;
+  app_window t;
+  create(w, t);
+
+  // Only the listed messages reach on_message.
+  CHECK(SendMessage(&w, WM_APP_TEST, 0, 0) == 42);
+  SendMessage(&w, WM_ERASEBKGND, 0, 0);
+  SendMessage(&w, WM_MOUSEMOVE, 0, 0);
+  SendMessage(&w, WM_NCHITTEST, 0, 0);
+  SendMessage(&w, WM_SIZE, 0, 0);
+  CHECK(t.seen == 2);
+  SendMessage(&w, WM_PAINT, 0, 0);
+  CHECK(t.painted == 1);
+  CHECK(t.seen == 2);
+}
+
+void test_guarded()
+{
+  // Continuations run on the test thread like on the UI thread.
+  std::mutex mutex;
+  std::vector<thread_pool::task> continuations;
+  thread_pool pool(1, [&](thread_pool::task t) {
+    std::lock_guard<std::mutex> lock(mutex);
+    continuations.push_back(std::move(t));
+  });
+
+  // Failures on the pool and in the continuation both destroy the window instead of leaving it loading.
+  for (int i = 0; i < 3; i++) {
+    mock_window w;
+    loading_window t;
+    create(w, t);
+    t.load(pool, i == 1, i == 2);
+    pool.wait();
+    CHECK(continuations.size() == 1);
+    continuations.front()();
+    continuations.clear();
+    CHECK(t.loaded == (i == 0 ? 1 : 0));
+    CHECK(w.destroyed == (i == 0 ? 0u : 1u));
+  }
+}
+
+void test_dialog_result()
+{
+  mock_window w;
+  test_dialog t;
+  CHECK(test_dialog::dialog_proc(&w, WM_INITDIALOG, 0, reinterpret_cast<LPARAM>(&t)) == TRUE);
+  CHECK(t.initialized == 1);
+
+  // Handled dialog messages return TRUE and leave the result in DWLP_MSGRESULT.
+  auto proc = reinterpret_cast<INT_PTR (CALLBACK*)(HWND, UINT, WPARAM, LPARAM)>(w.dialog_proc);
+  CHECK(proc(&w, WM_COMMAND, 5, 0) == TRUE);
+  CHECK(t.commands == 5);
+  CHECK(proc(&w, WM_MOUSEMOVE, 0, 0) == FALSE);
+}
+
+}  // namespace
+
+int main()
+{
+  test_dispatch();
+  test_message_list();
+  test_guarded();
+  test_dialog_result();
+}
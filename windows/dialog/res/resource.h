@@ -10,3 +10,6 @@
 #define IDM_EXIT 103
 
 #define IDD_MAIN 104
+
+#define IDM_PROFILE 105
+#define IDM_TRACE 106
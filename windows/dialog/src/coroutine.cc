@@ -0,0 +1,112 @@
+#include "coroutine.h"
+#ifdef __cpp_impl_coroutine
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#define FRAME_GRANULARITY 64    // size class granularity in bytes
+#define FRAME_CLASSES     16    // number of pooled size classes
+#define FRAME_CACHE       64    // frames kept per size class and thread
+
+namespace coroutine_frames {
+namespace {
+
+// Frames that were returned by threads with full caches.
+struct shared_pool {
+  std::mutex mutex;
+  std::vector<void*> frames[FRAME_CLASSES];
+};
+
+shared_pool& shared()
+{
+  static shared_pool pool;
+  return pool;
+}
+
+// Frames cached by the current thread, handed to the shared pool when the thread exits.
+struct thread_cache {
+  std::vector<void*> frames[FRAME_CLASSES];
+
+  ~thread_cache()
+  {
+    auto& pool = shared();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (std::size_t i = 0; i < FRAME_CLASSES; i++) {
+      pool.frames[i].insert(pool.frames[i].end(), frames[i].begin(), frames[i].end());
+    }
+  }
+};
+
+thread_local thread_cache cache;
+
+}  // namespace
+
+void* allocate(std::size_t size)
+{
+  auto index = (size - 1) / FRAME_GRANULARITY;
+  if (index >= FRAME_CLASSES) {
+    return ::operator new(size);
+  }
+
+  // Refill the thread cache from the shared pool before allocating a new frame.
+  auto& frames = cache.frames[index];
+  if (frames.empty()) {
+    auto& pool = shared();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto& source = pool.frames[index];
+    auto count = std::min<std::size_t>(source.size(), FRAME_CACHE / 2);
+    frames.insert(frames.end(), source.end() - count, source.end());
+    source.resize(source.size() - count);
+  }
+  if (frames.empty()) {
+    return ::operator new((index + 1) * FRAME_GRANULARITY);
+  }
+  auto frame = frames.back();
+  frames.pop_back();
+  return frame;
+}
+
+void deallocate(void* frame, std::size_t size)
+{
+  auto index = (size - 1) / FRAME_GRANULARITY;
+  if (index >= FRAME_CLASSES) {
+    ::operator delete(frame);
+    return;
+  }
+
+  // Return half of a full thread cache to the shared pool.
+  auto& frames = cache.frames[index];
+  if (frames.size() >= FRAME_CACHE) {
+    auto& pool = shared();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.frames[index].insert(pool.frames[index].end(), frames.begin() + FRAME_CACHE / 2, frames.end());
+    frames.resize(FRAME_CACHE / 2);
+  }
+  frames.push_back(frame);
+}
+
+}  // namespace coroutine_frames
+
+namespace {
+
+async::error_handler error_function = nullptr;
+void* error_context = nullptr;
+
+}  // namespace
+
+void async::set_error_handler(error_handler handler, void* context)
+{
+  error_function = handler;
+  error_context = context;
+}
+
+void async::report(std::exception_ptr e) noexcept
+{
+  if (!error_function) {
+    std::terminate();
+  }
+  error_function(e, error_context);
+}
+
+#endif
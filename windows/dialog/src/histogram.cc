@@ -0,0 +1,74 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+std::uint64_t histogram::count() const
+{
+  return count_;
+}
+
+std::uint64_t histogram::sum() const
+{
+  return sum_;
+}
+
+std::uint64_t histogram::max() const
+{
+  return max_;
+}
+
+double histogram::mean() const
+{
+  return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+}
+
+std::uint64_t histogram::percentile(double p) const
+{
+  if (!count_) {
+    return 0;
+  }
+
+  // Find the bucket that contains the rank of the percentile.
+  auto rank = static_cast<std::uint64_t>(std::ceil(std::min(std::max(p, 0.0), 100.0) / 100.0 * static_cast<double>(count_)));
+  rank = std::max<std::uint64_t>(rank, 1);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(upper_bound(i), max_);
+    }
+  }
+  return max_;
+}
+
+void histogram::merge(const histogram& other)
+{
+  for (std::size_t i = 0; i < buckets; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void histogram::reset()
+{
+  std::fill(std::begin(counts_), std::end(counts_), 0);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+std::uint64_t histogram::upper_bound(std::size_t index)
+{
+  if (index < (1u << sub_bits)) {
+    return index;
+  }
+  if (index >= buckets - 1) {
+    return UINT64_MAX;
+  }
+  auto shift = static_cast<unsigned>(index >> sub_bits) - 1;
+  auto mantissa = static_cast<std::uint64_t>((index & ((1u << sub_bits) - 1)) + (1u << sub_bits));
+  return ((mantissa + 1) << shift) - 1;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Log-linear histogram of non-negative values with a relative bucket error below 1/16.
+// Values below 16 have their own buckets, larger values are split into 16 linear buckets
+// per power of two. Recording is a few instructions and does not allocate.
+class histogram {
+public:
+  static const unsigned sub_bits = 4;
+  static const unsigned max_bits = 40;
+  static const std::size_t buckets = (max_bits - sub_bits + 1) << sub_bits;
+
+  void record(std::uint64_t value)
+  {
+    counts_[bucket(value)]++;
+    count_++;
+    sum_ += value;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  std::uint64_t count() const;
+  std::uint64_t sum() const;
+  std::uint64_t max() const;
+  double mean() const;
+
+  // Returns the upper bound of the bucket that contains the given percentile, limited by the maximum.
+  std::uint64_t percentile(double p) const;
+
+  void merge(const histogram& other);
+  void reset();
+
+  // Returns the bucket index of a value. Values above 2^max_bits share the last bucket.
+  static std::size_t bucket(std::uint64_t value)
+  {
+    if (value < (1u << sub_bits)) {
+      return static_cast<std::size_t>(value);
+    }
+    auto shift = log2(value) - sub_bits;
+    auto index = (static_cast<std::size_t>(shift + 1) << sub_bits) + static_cast<std::size_t>((value >> shift) - (1u << sub_bits));
+    return index < buckets ? index : buckets - 1;
+  }
+
+  // Returns the largest value that falls into the bucket.
+  static std::uint64_t upper_bound(std::size_t index);
+
+private:
+  static unsigned log2(std::uint64_t value);
+
+  std::uint64_t counts_[buckets] = {};
+  std::uint64_t count_ = 0;
+  std::uint64_t sum_ = 0;
+  std::uint64_t max_ = 0;
+};
+
+inline unsigned histogram::log2(std::uint64_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+  _BitScanReverse64(&index, value);
+#else
+  if (value >> 32) {
+    _BitScanReverse(&index, static_cast<unsigned long>(value >> 32));
+    index += 32;
+  } else {
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+  }
+#endif
+  return static_cast<unsigned>(index);
+#else
+  return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
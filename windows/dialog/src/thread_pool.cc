@@ -0,0 +1,174 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+
+// Identifies the pool and the deque of the current worker thread.
+struct worker_context {
+  const thread_pool* pool = nullptr;
+  std::size_t index = 0;
+};
+
+thread_local worker_context context;
+
+}  // namespace
+
+thread_pool::thread_pool(std::size_t threads, dispatcher dispatch) : dispatch_(std::move(dispatch))
+{
+  if (!threads) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for (std::size_t i = 0; i < threads; i++) {
+    workers_.emplace_back(new worker);
+  }
+  for (std::size_t i = 0; i < threads; i++) {
+    workers_[i]->thread = std::thread([this, i]() {
+      run(i);
+    });
+  }
+}
+
+thread_pool::~thread_pool()
+{
+  // Stop the workers. Tasks that did not start yet are discarded.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  ready_.notify_all();
+  for (auto& w : workers_) {
+    w->thread.join();
+  }
+}
+
+void thread_pool::submit(task t)
+{
+  // Prefer the deque of the current worker and distribute external tasks round-robin.
+  auto index = context.pool == this ? context.index : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  queued_.fetch_add(1);
+  {
+    auto& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.tasks.push_back(std::move(t));
+  }
+
+  // Only wake up a worker if one is about to sleep. Both counters are sequentially consistent,
+  // so either the worker sees the task or the producer sees the sleeping worker.
+  if (sleeping_.load()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.notify_one();
+  }
+}
+
+void thread_pool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() {
+    return pending_.load() == 0;
+  });
+}
+
+std::size_t thread_pool::size() const
+{
+  return workers_.size();
+}
+
+std::vector<thread_pool::statistics> thread_pool::stats() const
+{
+  std::vector<statistics> stats(workers_.size());
+  for (std::size_t i = 0; i < workers_.size(); i++) {
+    auto& w = *workers_[i];
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      stats[i].depth = w.tasks.size();
+    }
+    stats[i].executed = w.executed.load(std::memory_order_relaxed);
+    stats[i].steals = w.steals.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void thread_pool::run(std::size_t index)
+{
+  context.pool = this;
+  context.index = index;
+  auto& self = *workers_[index];
+
+  task t;
+  for (;;) {
+    if (!pop(index, t)) {
+      // Sleep until a task is queued.
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_.fetch_add(1);
+      ready_.wait(lock, [this]() {
+        return stop_ || queued_.load() != 0;
+      });
+      sleeping_.fetch_sub(1);
+      if (stop_) {
+        return;
+      }
+      continue;
+    }
+
+    // Report exceptions through the dispatcher.
+    try {
+      t();
+    }
+    catch (...) {
+      if (dispatch_) {
+        auto e = std::current_exception();
+        dispatch_([e]() {
+          std::rethrow_exception(e);
+        });
+      }
+    }
+    t = nullptr;
+    self.executed.fetch_add(1, std::memory_order_relaxed);
+
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      idle_.notify_all();
+    }
+  }
+}
+
+bool thread_pool::pop(std::size_t index, task& t)
+{
+  // Take the newest task from the own deque.
+  {
+    auto& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (!w.tasks.empty()) {
+      t = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+
+  // Steal the oldest task from another worker.
+  auto size = workers_.size();
+  for (std::size_t i = 1; i < size; i++) {
+    auto& w = *workers_[(index + i) % size];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (!w.tasks.empty()) {
+      t = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      queued_.fetch_sub(1);
+      workers_[index]->steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void thread_pool::dispatch(task t)
+{
+  // Run the continuation on the worker if there is no dispatcher.
+  if (dispatch_) {
+    dispatch_(std::move(t));
+  } else {
+    t();
+  }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Work-stealing thread pool with one task deque per worker.
+// Workers execute their own tasks in LIFO order and steal the oldest tasks of other workers.
+// Continuations and exceptions are handed to a dispatcher, which usually posts them to the UI thread.
+class thread_pool {
+public:
+  using task = std::function<void()>;
+  using dispatcher = std::function<void(task)>;
+
+  struct statistics {
+    std::size_t depth = 0;
+    std::uint64_t executed = 0;
+    std::uint64_t steals = 0;
+  };
+
+  // Starts the given number of workers or one worker per core.
+  explicit thread_pool(std::size_t threads = 0, dispatcher dispatch = nullptr);
+  ~thread_pool();
+
+  thread_pool(const thread_pool& other) = delete;
+  thread_pool& operator=(const thread_pool& other) = delete;
+
+  // Queues a task from any thread. Tasks submitted by a worker go to its own deque.
+  void submit(task t);
+
+  // Runs the work on the pool and passes its result to the continuation through the dispatcher.
+  template <typename Work, typename Continuation>
+  void submit(Work work, Continuation then)
+  {
+    submit(std::move(work), std::move(then), std::is_void<decltype(work())>());
+  }
+
+  // Blocks until all submitted tasks were executed. Must not be called from a worker.
+  void wait();
+
+  // Returns the number of workers.
+  std::size_t size() const;
+
+  // Returns the queue depth, the number of executed tasks and the number of stolen tasks per worker.
+  std::vector<statistics> stats() const;
+
+private:
+  struct worker {
+    mutable std::mutex mutex;
+    std::deque<task> tasks;
+    std::atomic<std::uint64_t> executed = { 0 };
+    std::atomic<std::uint64_t> steals = { 0 };
+    std::thread thread;
+  };
+
+  template <typename Work, typename Continuation>
+  void submit(Work work, Continuation then, std::true_type)
+  {
+    submit([this, work, then]() mutable {
+      work();
+      dispatch(then);
+    });
+  }
+
+  template <typename Work, typename Continuation>
+  void submit(Work work, Continuation then, std::false_type)
+  {
+    submit([this, work, then]() mutable {
+      auto result = std::make_shared<decltype(work())>(work());
+      dispatch([result, then]() mutable {
+        then(std::move(*result));
+      });
+    });
+  }
+
+  void run(std::size_t index);
+  bool pop(std::size_t index, task& t);
+  void dispatch(task t);
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  dispatcher dispatch_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable idle_;
+  bool stop_ = false;
+
+  std::atomic<std::size_t> queued_ = { 0 };
+  std::atomic<std::size_t> pending_ = { 0 };
+  std::atomic<std::size_t> sleeping_ = { 0 };
+  std::atomic<std::size_t> next_ = { 0 };
+};
@@ -0,0 +1,114 @@
+#include "tracer.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <stdexcept>
+#endif
+
+#define TRACER_THRESHOLD 0.004  // long handler threshold in seconds
+
+namespace {
+
+// Assigns small sequential thread IDs.
+std::uint32_t thread_id()
+{
+  static std::atomic<std::uint32_t> next = { 1 };
+  thread_local std::uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+void append_string(std::string& out, const char* str)
+{
+  out += '"';
+  for (; *str; str++) {
+    auto c = static_cast<unsigned char>(*str);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += static_cast<char>(c);
+    } else if (c < 0x20) {
+      char buffer[8] = {};
+      std::snprintf(buffer, sizeof(buffer), "\\u%04X", c);
+      out += buffer;
+    } else {
+      out += static_cast<char>(c);
+    }
+  }
+  out += '"';
+}
+
+}  // namespace
+
+tracer::tracer(std::size_t capacity) :
+  events_(new event[capacity]), capacity_(capacity), origin_(clock_ticks()), last_phase_(origin_),
+  threshold_(static_cast<std::uint64_t>(clock_frequency() * TRACER_THRESHOLD)),
+  scale_(1e6 / clock_frequency())
+{}
+
+tracer& tracer::instance()
+{
+  static tracer instance;
+  return instance;
+}
+
+void tracer::record(const char* name, const char* category, std::uint64_t start, std::uint64_t end, long long arg)
+{
+  auto index = next_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+  events_[index] = { name, category, start, end, arg, thread_id() };
+}
+
+std::string tracer::json() const
+{
+  // Write the retained spans from the oldest to the newest.
+  auto next = next_.load(std::memory_order_relaxed);
+  auto count = next < capacity_ ? next : capacity_;
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  char buffer[128] = {};
+  for (std::size_t i = 0; i < count; i++) {
+    const auto& e = events_[(next - count + i) % capacity_];
+    if (i) {
+      out += ',';
+    }
+    out += "\n{\"name\":";
+    append_string(out, e.name);
+    out += ",\"cat\":";
+    append_string(out, e.category);
+    auto ts = e.start > origin_ ? (e.start - origin_) * scale_ : 0.0;
+    auto dur = e.end > e.start ? (e.end - e.start) * scale_ : 0.0;
+    std::snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u", ts, dur, e.thread);
+    out += buffer;
+    if (e.arg >= 0) {
+      std::snprintf(buffer, sizeof(buffer), ",\"args\":{\"id\":\"0x%04llX\"}", e.arg);
+      out += buffer;
+    }
+    out += '}';
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+#ifdef _WIN32
+std::wstring tracer::save() const
+{
+  // Use the executable name with a trace extension.
+  std::wstring path(MAX_PATH, L'\0');
+  auto size = GetModuleFileName(nullptr, &path[0], static_cast<DWORD>(path.size()));
+  if (!size || size >= path.size()) {
+    throw std::runtime_error("Could not determine the trace file name.");
+  }
+  path.resize(size);
+  path += L".trace.json";
+
+  auto text = json();
+  auto file = _wfopen(path.c_str(), L"wb");
+  if (!file) {
+    throw std::runtime_error("Could not create the trace file.");
+  }
+  auto written = std::fwrite(text.data(), 1, text.size(), file);
+  std::fclose(file);
+  if (written != text.size()) {
+    throw std::runtime_error("Could not write the trace file.");
+  }
+  return path;
+}
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+#include "clock.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Records named spans into a fixed-size ring buffer and serializes them as Chrome trace JSON,
+// which can be opened in chrome://tracing and Perfetto. Span names must be string literals.
+// Recording does not allocate and can be used from any thread. When the buffer is full,
+// the oldest spans are overwritten.
+class tracer {
+public:
+  explicit tracer(std::size_t capacity = 8192);
+
+  // Returns the tracer of the process.
+  static tracer& instance();
+
+  // Records a span. The argument is written as a hexadecimal value if it is not negative.
+  void record(const char* name, const char* category, std::uint64_t start, std::uint64_t end, long long arg = -1);
+
+  // Returns true until the end of the startup phase. Message handlers are only traced during startup
+  // and when they take longer than the long handler threshold.
+  bool startup() const
+  {
+    return startup_.load(std::memory_order_relaxed);
+  }
+
+  void end_startup()
+  {
+    startup_.store(false, std::memory_order_relaxed);
+  }
+
+  // Records a startup phase that lasted since the previous phase or since the tracer was created.
+  // Must be called on the UI thread.
+  void phase(const char* name)
+  {
+    auto now = clock_ticks();
+    record(name, "startup", last_phase_, now);
+    last_phase_ = now;
+  }
+
+  // Returns the long handler threshold in counter ticks.
+  std::uint64_t threshold() const
+  {
+    return threshold_;
+  }
+
+  // Returns the recorded spans as Chrome trace JSON. Spans that are recorded concurrently may be incomplete.
+  std::string json() const;
+
+#ifdef _WIN32
+  // Writes the trace next to the executable and returns the file name. Throws on failure.
+  std::wstring save() const;
+#endif
+
+private:
+  struct event {
+    const char* name;
+    const char* category;
+    std::uint64_t start;
+    std::uint64_t end;
+    long long arg;
+    std::uint32_t thread;
+  };
+
+  std::unique_ptr<event[]> events_;
+  std::size_t capacity_;
+  std::atomic<std::size_t> next_ = { 0 };
+  std::atomic<bool> startup_ = { true };
+  std::uint64_t origin_;
+  std::uint64_t last_phase_;
+  std::uint64_t threshold_;
+  double scale_;
+};
+
+// Starts the trace. Does nothing unless TRACER is defined.
+inline void trace_begin()
+{
+#ifdef TRACER
+  tracer::instance();
+#endif
+}
+
+// Records a startup phase. Does nothing unless TRACER is defined.
+inline void trace_phase(const char* name)
+{
+#ifdef TRACER
+  tracer::instance().phase(name);
+#else
+  static_cast<void>(name);
+#endif
+}
+
+// Records the enclosing scope as a span.
+class trace_scope {
+public:
+  explicit trace_scope(const char* name, const char* category = "startup") :
+    name_(name), category_(category), start_(clock_ticks())
+  {}
+
+  ~trace_scope()
+  {
+    tracer::instance().record(name_, category_, start_, clock_ticks());
+  }
+
+  trace_scope(const trace_scope& other) = delete;
+  trace_scope& operator=(const trace_scope& other) = delete;
+
+private:
+  const char* name_;
+  const char* category_;
+  std::uint64_t start_;
+};
+
+// Records a message handler that started during the startup phase or took longer than the long handler
+// threshold. The startup phase ends when a handler created with ends_startup returns, usually the first paint.
+class trace_handler {
+public:
+  trace_handler(unsigned msg, bool ends_startup) :
+    msg_(msg), ends_startup_(ends_startup), startup_(tracer::instance().startup()), start_(clock_ticks())
+  {}
+
+  ~trace_handler()
+  {
+    auto& t = tracer::instance();
+    auto end = clock_ticks();
+    if (startup_) {
+      t.record("message", "startup", start_, end, msg_);
+      if (ends_startup_) {
+        t.end_startup();
+      }
+    } else if (end - start_ >= t.threshold()) {
+      t.record("message", "long handler", start_, end, msg_);
+    }
+  }
+
+  trace_handler(const trace_handler& other) = delete;
+  trace_handler& operator=(const trace_handler& other) = delete;
+
+private:
+  unsigned msg_;
+  bool ends_startup_;
+  bool startup_;
+  std::uint64_t start_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Converts UTF-8 to UTF-16 and replaces invalid sequences with U+FFFD.
+// The output buffer must hold at least as many code units as there are input bytes.
+// Returns the number of code units written.
+std::size_t utf8_to_utf16(const char* src, std::size_t size, char16_t* dst);
+
+// Converts UTF-8 to UTF-16 and stops at the first invalid sequence.
+// The output buffer must hold at least as many code units as there are input bytes.
+// Returns false if the input is invalid. The written argument is set in both cases.
+bool utf8_to_utf16_strict(const char* src, std::size_t size, char16_t* dst, std::size_t& written);
+
+// Conversion kernels behind utf8_to_utf16, exposed so that tests and benchmarks can run each of them.
+namespace utf_detail {
+
+using convert_function = bool (*)(const unsigned char* src, std::size_t size, char16_t* dst, std::size_t& written, bool strict);
+
+struct kernel {
+  const char* name;
+  convert_function convert;
+};
+
+// Returns the kernels that the processor supports, starting with the scalar fallback.
+// utf8_to_utf16 uses the last one.
+std::vector<kernel> kernels();
+
+}  // namespace utf_detail
+
+#ifdef _WIN32
+
+// Converts UTF-8 into a reusable wide string buffer.
+void utf8_to_utf16(const char* src, std::size_t size, std::wstring& dst);
+void utf8_to_utf16(const char* str, std::wstring& dst);
+
+#endif
@@ -1,27 +1,18 @@
 #include "window.h"
 #include <resource.h>
-#include <stdexcept>
-#include <string>
 
-window::window(HINSTANCE instance) : instance_(instance)
+window::window(HINSTANCE instance, event_loop& loop, thread_pool& pool) :
+  instance_(instance), loop_(loop), pool_(pool)
 {
   // Create the main application window.
-  auto hwnd = CreateDialogParam(instance, MAKEINTRESOURCE(IDD_MAIN), nullptr, [](HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) -> INT_PTR {
-    auto self = reinterpret_cast<window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-    if (msg == WM_INITDIALOG) {
-      self = reinterpret_cast<window*>(lparam);
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
-    } else if (msg == WM_DESTROY) {
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
-    }
-    return self ? self->handle(hwnd, msg, wparam, lparam) : FALSE;
-  }, reinterpret_cast<LPARAM>(this));
+  auto hwnd = CreateDialogParam(instance, MAKEINTRESOURCE(IDD_MAIN), nullptr, dialog_proc, reinterpret_cast<LPARAM>(this));
 
   if (!hwnd) {
     MessageBox(nullptr, L"Could not create the main application window.", PROJECT, MB_OK | MB_ICONERROR | MB_SETFOREGROUND);
     PostQuitMessage(1);
     return;
   }
+  trace_phase("CreateDialogParam");
 }
 
 void window::on_initdialog()
@@ -62,6 +53,18 @@ void window::on_initdialog()
   ShowWindow(hwnd_, SW_SHOW);
 }
 
+void window::open(const std::vector<std::wstring>& commands)
+{
+  // Show the window of the running instance.
+  if (!hwnd_) {
+    return;
+  }
+  if (IsIconic(hwnd_)) {
+    ShowWindow(hwnd_, SW_RESTORE);
+  }
+  SetForegroundWindow(hwnd_);
+}
+
 void window::on_destroy()
 {
   // Stop the main message loop.
@@ -76,7 +79,21 @@ void window::on_close()
 
 void window::on_size(int cx, int cy)
 {
-  // Resize the controls.
+  // Resize the controls at once and let the end of a live resize redraw them.
+  layout_.solve(cx, cy);
+  layout_.apply(!sizing_);
+}
+
+void window::on_entersizemove()
+{
+  sizing_ = true;
+}
+
+void window::on_exitsizemove()
+{
+  // Redraw the controls that were moved without redrawing.
+  sizing_ = false;
+  RedrawWindow(hwnd_, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN);
 }
 
 void window::on_command(UINT id)
@@ -86,39 +103,15 @@ void window::on_command(UINT id)
   case IDM_EXIT:
     PostMessage(hwnd_, WM_CLOSE, 0, 0);
     break;
+#ifdef PROFILER
+  case IDM_PROFILE:
+    MessageBox(hwnd_, (L"The profile was saved to " + profiler::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
+#ifdef TRACER
+  case IDM_TRACE:
+    MessageBox(hwnd_, (L"The trace was saved to " + tracer::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
   }
 }
-
-INT_PTR window::handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
-{
-  // Handle windows messages.
-  try {
-    switch (msg) {
-    case WM_INITDIALOG:
-      hwnd_ = hwnd;
-      on_initdialog();
-      return TRUE;
-    case WM_DESTROY:
-      on_destroy();
-      hwnd_ = nullptr;
-      return TRUE;
-    case WM_CLOSE:
-      on_close();
-      return TRUE;
-    case WM_SIZE:
-      on_size(LOWORD(lparam), HIWORD(lparam));
-      return 0;
-    case WM_COMMAND:
-      on_command(LOWORD(wparam));
-      return TRUE;
-    }
-  }
-  catch (const std::exception& e) {
-    std::wstring msg;
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0) + 1);
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &msg[0], static_cast<int>(msg.size())));
-    MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
-    DestroyWindow(hwnd);
-  }
-  return FALSE;
-}
@@ -1,19 +1,33 @@
 #pragma once
+#include "event_loop.h"
+#include "layout.h"
+#include "thread_pool.h"
+#include "window_base.h"
 #include <windows.h>
+#include <string>
+#include <vector>
 
-class window {
+class window : public dialog_base<window> {
 public:
-  window(HINSTANCE instance);
+  window(HINSTANCE instance, event_loop& loop, thread_pool& pool);
+
+  // Activates the window when another instance forwards its command line.
+  void open(const std::vector<std::wstring>& commands);
 
   void on_initdialog();
   void on_destroy();
   void on_close();
   void on_size(int cx, int cy);
+  void on_entersizemove();
+  void on_exitsizemove();
   void on_command(UINT id);
 
 private:
-  INT_PTR handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
-
   HINSTANCE instance_;
-  HWND hwnd_ = nullptr;
+  event_loop& loop_;
+  thread_pool& pool_;
+
+  // Add controls to the layout to resize them with the window.
+  layout layout_;
+  bool sizing_ = false;
 };
@@ -0,0 +1,623 @@
+#pragma once
+#include "profiler.h"
+#include "tracer.h"
+#include "utf.h"
+#include <windows.h>
+#include <windowsx.h>
+#include <resource.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Pool of executable slots for window thunks. Like the ATL thunk allocator, one allocation granule holds the
+// thunks of many windows instead of one VirtualAlloc per window. Blocks stay executable and are made writable
+// only while a slot is written, so the thunks of other windows in the same block keep running.
+// Blocks are kept until the process exits and freed slots are reused.
+class window_thunk_pool {
+public:
+  static const std::size_t slot_size = 32;
+  static const std::size_t block_size = 64 * 1024;
+
+  static window_thunk_pool& instance()
+  {
+    static window_thunk_pool pool;
+    return pool;
+  }
+
+  // Returns a free slot or null if no memory could be allocated.
+  void* allocate()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      auto block = static_cast<std::uint8_t*>(VirtualAlloc(nullptr, block_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READ));
+      if (!block) {
+        return nullptr;
+      }
+      for (auto i = block_size / slot_size; i > 0; i--) {
+        free_.push_back(block + (i - 1) * slot_size);
+      }
+    }
+    auto slot = free_.back();
+    free_.pop_back();
+    return slot;
+  }
+
+  // Copies code into a slot. Returns false if the page protection could not be changed.
+  bool write(void* slot, const void* code, std::size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DWORD protect = 0;
+    if (size > slot_size || !VirtualProtect(slot, size, PAGE_EXECUTE_READWRITE, &protect)) {
+      return false;
+    }
+    std::memcpy(slot, code, size);
+    VirtualProtect(slot, size, PAGE_EXECUTE_READ, &protect);
+    FlushInstructionCache(GetCurrentProcess(), slot, size);
+    return true;
+  }
+
+  // Returns a slot to the pool.
+  void free(void* slot)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+  }
+
+private:
+  window_thunk_pool() = default;
+
+  std::mutex mutex_;
+  std::vector<void*> free_;
+};
+
+// Executable stub that replaces the window handle argument with an object pointer and jumps to a
+// static window procedure. This avoids the GWLP_USERDATA lookup on every message.
+class window_thunk {
+public:
+  window_thunk() = default;
+  window_thunk(const window_thunk& other) = delete;
+  window_thunk& operator=(const window_thunk& other) = delete;
+
+  ~window_thunk()
+  {
+    if (code_) {
+      window_thunk_pool::instance().free(code_);
+    }
+  }
+
+  // Creates the stub. Returns false if the architecture is not supported or memory could not be allocated.
+  bool create(void* self, const void* proc)
+  {
+#if defined(_M_IX86) || defined(_M_X64)
+#pragma pack(push, 1)
+#ifdef _M_IX86
+    // mov dword ptr [esp + 4], self
+    // jmp proc
+    struct {
+      std::uint8_t mov[4];
+      std::uint32_t self;
+      std::uint8_t jmp;
+      std::int32_t proc;
+    } code = {
+      { 0xC7, 0x44, 0x24, 0x04 }, 0, 0xE9, 0,
+    };
+#else
+    // mov rcx, self
+    // mov rax, proc
+    // jmp rax
+    struct {
+      std::uint8_t mov_rcx[2];
+      std::uint64_t self;
+      std::uint8_t mov_rax[2];
+      std::uint64_t proc;
+      std::uint8_t jmp[2];
+    } code = {
+      { 0x48, 0xB9 }, 0, { 0x48, 0xB8 }, 0, { 0xFF, 0xE0 },
+    };
+#endif
+#pragma pack(pop)
+
+    // Take a slot from the pool and write the code into it.
+    auto& pool = window_thunk_pool::instance();
+    auto memory = pool.allocate();
+    if (!memory) {
+      return false;
+    }
+#ifdef _M_IX86
+    code.self = reinterpret_cast<std::uint32_t>(self);
+    code.proc = static_cast<std::int32_t>(reinterpret_cast<std::intptr_t>(proc) - (reinterpret_cast<std::intptr_t>(memory) + sizeof(code)));
+#else
+    code.self = reinterpret_cast<std::uint64_t>(self);
+    code.proc = reinterpret_cast<std::uint64_t>(proc);
+#endif
+    if (!pool.write(memory, &code, sizeof(code))) {
+      pool.free(memory);
+      return false;
+    }
+    code_ = memory;
+    return true;
+#else
+    static_cast<void>(self);
+    static_cast<void>(proc);
+    return false;
+#endif
+  }
+
+  // Returns the stub as a pointer-sized value for SetWindowLongPtr.
+  LONG_PTR get() const
+  {
+    return reinterpret_cast<LONG_PTR>(code_);
+  }
+
+private:
+  void* code_ = nullptr;
+};
+
+// Compile-time list of the messages that an on_message handler takes.
+template <UINT... Messages>
+struct message_list {
+  static constexpr bool contains(UINT msg)
+  {
+    const UINT messages[] = { Messages..., 0 };
+    for (std::size_t i = 0; i < sizeof...(Messages); i++) {
+      if (messages[i] == msg) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Message map built at compile time from the handlers that a class declares.
+// Every message has a handler overload that is selected if the class declares the handler
+// and a fallback that returns std::false_type, which the compiler removes from the dispatch.
+// Handlers must be public or the class must declare window_messages as a friend.
+// Other messages can be handled with: bool on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
+// The class must then list these messages with: using messages = message_list<...>;
+// Only the listed messages reach on_message, so all others still go straight to the default procedure.
+struct window_messages {
+  template <typename T>
+  static auto initdialog(T& t, WPARAM, LPARAM, int) -> decltype(t.on_initdialog(), std::true_type())
+  {
+    t.on_initdialog();
+    return {};
+  }
+
+  template <typename T>
+  static auto create(T& t, WPARAM, LPARAM, int) -> decltype(t.on_create(), std::true_type())
+  {
+    t.on_create();
+    return {};
+  }
+
+  template <typename T>
+  static auto destroy(T& t, WPARAM, LPARAM, int) -> decltype(t.on_destroy(), std::true_type())
+  {
+    t.on_destroy();
+    return {};
+  }
+
+  template <typename T>
+  static auto close(T& t, WPARAM, LPARAM, int) -> decltype(t.on_close(), std::true_type())
+  {
+    t.on_close();
+    return {};
+  }
+
+  template <typename T>
+  static auto size(T& t, WPARAM, LPARAM lparam, int) -> decltype(t.on_size(0, 0), std::true_type())
+  {
+    t.on_size(LOWORD(lparam), HIWORD(lparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto command(T& t, WPARAM wparam, LPARAM, int) -> decltype(t.on_command(UINT()), std::true_type())
+  {
+    t.on_command(LOWORD(wparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto timer(T& t, WPARAM wparam, LPARAM, int) -> decltype(t.on_timer(UINT_PTR()), std::true_type())
+  {
+    t.on_timer(static_cast<UINT_PTR>(wparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto paint(T& t, WPARAM, LPARAM, int) -> decltype(t.on_paint(), std::true_type())
+  {
+    t.on_paint();
+    return {};
+  }
+
+  template <typename T>
+  static auto vscroll(T& t, WPARAM wparam, LPARAM, int) -> decltype(t.on_vscroll(0), std::true_type())
+  {
+    t.on_vscroll(LOWORD(wparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto hscroll(T& t, WPARAM wparam, LPARAM, int) -> decltype(t.on_hscroll(0), std::true_type())
+  {
+    t.on_hscroll(LOWORD(wparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto mousewheel(T& t, WPARAM wparam, LPARAM, int) -> decltype(t.on_mousewheel(0), std::true_type())
+  {
+    t.on_mousewheel(GET_WHEEL_DELTA_WPARAM(wparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto mousemove(T& t, WPARAM, LPARAM lparam, int) -> decltype(t.on_mousemove(0, 0), std::true_type())
+  {
+    t.on_mousemove(GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam));
+    return {};
+  }
+
+  template <typename T>
+  static auto lbuttonup(T& t, WPARAM, LPARAM, int) -> decltype(t.on_lbuttonup(), std::true_type())
+  {
+    t.on_lbuttonup();
+    return {};
+  }
+
+  template <typename T>
+  static auto entersizemove(T& t, WPARAM, LPARAM, int) -> decltype(t.on_entersizemove(), std::true_type())
+  {
+    t.on_entersizemove();
+    return {};
+  }
+
+  template <typename T>
+  static auto exitsizemove(T& t, WPARAM, LPARAM, int) -> decltype(t.on_exitsizemove(), std::true_type())
+  {
+    t.on_exitsizemove();
+    return {};
+  }
+
+  // Unhandled keys are passed to the default procedure.
+  template <typename T>
+  static auto keydown(T& t, WPARAM wparam, LPARAM, int) -> decltype(bool(t.on_keydown(UINT())))
+  {
+    return t.on_keydown(static_cast<UINT>(wparam));
+  }
+
+  template <typename T>
+  static auto message(T& t, UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result, int) -> decltype(bool(t.on_message(msg, wparam, lparam, result)))
+  {
+    return t.on_message(msg, wparam, lparam, result);
+  }
+
+  template <typename T> static std::false_type initdialog(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type create(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type destroy(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type close(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type size(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type command(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type timer(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type paint(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type vscroll(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type hscroll(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type mousewheel(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type mousemove(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type lbuttonup(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type entersizemove(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type exitsizemove(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type keydown(T&, WPARAM, LPARAM, long) { return {}; }
+  template <typename T> static std::false_type message(T&, UINT, WPARAM, LPARAM, LRESULT&, long) { return {}; }
+
+  // Returns true if the class declares a handler for the message. Evaluated at compile time for constant messages.
+  template <typename T>
+  static constexpr bool handles(UINT msg)
+  {
+    static_assert(!has<decltype(message(std::declval<T&>(), 0, 0, 0, std::declval<LRESULT&>(), 0))>() || has_list<T>(0),
+      "A class with on_message must list its messages with: using messages = message_list<...>;");
+    return declared<T>(msg) || listed<T>(msg, 0);
+  }
+
+  // Calls the handler of the message. Returns false if the message was not handled.
+  template <typename T>
+  static bool dispatch(T& t, UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
+  {
+    result = 0;
+    switch (msg) {
+    case WM_INITDIALOG:
+      if (initdialog(t, wparam, lparam, 0)) {
+        result = TRUE;
+        return true;
+      }
+      break;
+    case WM_CREATE:     if (create(t, wparam, lparam, 0)) return true; break;
+    case WM_DESTROY:    if (destroy(t, wparam, lparam, 0)) return true; break;
+    case WM_CLOSE:      if (close(t, wparam, lparam, 0)) return true; break;
+    case WM_SIZE:       if (size(t, wparam, lparam, 0)) return true; break;
+    case WM_COMMAND:    if (command(t, wparam, lparam, 0)) return true; break;
+    case WM_TIMER:      if (timer(t, wparam, lparam, 0)) return true; break;
+    case WM_PAINT:      if (paint(t, wparam, lparam, 0)) return true; break;
+    case WM_VSCROLL:    if (vscroll(t, wparam, lparam, 0)) return true; break;
+    case WM_HSCROLL:    if (hscroll(t, wparam, lparam, 0)) return true; break;
+    case WM_MOUSEWHEEL: if (mousewheel(t, wparam, lparam, 0)) return true; break;
+    case WM_MOUSEMOVE:  if (mousemove(t, wparam, lparam, 0)) return true; break;
+    case WM_LBUTTONUP:  if (lbuttonup(t, wparam, lparam, 0)) return true; break;
+    case WM_ENTERSIZEMOVE: if (entersizemove(t, wparam, lparam, 0)) return true; break;
+    case WM_EXITSIZEMOVE:  if (exitsizemove(t, wparam, lparam, 0)) return true; break;
+    case WM_KEYDOWN:    if (keydown(t, wparam, lparam, 0)) return true; break;
+    }
+    return listed<T>(msg, 0) && message(t, msg, wparam, lparam, result, 0);
+  }
+
+private:
+  template <typename R>
+  static constexpr bool has()
+  {
+    return !std::is_same<R, std::false_type>::value;
+  }
+
+  template <typename T>
+  static constexpr auto has_list(int) -> decltype(T::messages::contains(0), bool())
+  {
+    return true;
+  }
+
+  template <typename T>
+  static constexpr bool has_list(long)
+  {
+    return false;
+  }
+
+  template <typename T>
+  static constexpr auto listed(UINT msg, int) -> decltype(T::messages::contains(msg))
+  {
+    return T::messages::contains(msg);
+  }
+
+  template <typename T>
+  static constexpr bool listed(UINT, long)
+  {
+    return false;
+  }
+
+  template <typename T>
+  static constexpr bool declared(UINT msg)
+  {
+    using W = WPARAM;
+    using L = LPARAM;
+    return
+      msg == WM_INITDIALOG ? has<decltype(initdialog(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_CREATE ? has<decltype(create(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_DESTROY ? has<decltype(destroy(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_CLOSE ? has<decltype(close(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_SIZE ? has<decltype(size(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_COMMAND ? has<decltype(command(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_TIMER ? has<decltype(timer(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_PAINT ? has<decltype(paint(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_VSCROLL ? has<decltype(vscroll(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_HSCROLL ? has<decltype(hscroll(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_MOUSEWHEEL ? has<decltype(mousewheel(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_MOUSEMOVE ? has<decltype(mousemove(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_LBUTTONUP ? has<decltype(lbuttonup(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_ENTERSIZEMOVE ? has<decltype(entersizemove(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_EXITSIZEMOVE ? has<decltype(exitsizemove(std::declval<T&>(), W(), L(), 0))>() :
+      msg == WM_KEYDOWN ? has<decltype(keydown(std::declval<T&>(), W(), L(), 0))>() :
+      false;
+  }
+};
+
+// Reports an exception that escaped a message handler and destroys the window.
+inline void report_window_error(HWND hwnd, const std::exception& e)
+{
+  std::wstring msg;
+  utf8_to_utf16(e.what(), msg);
+  MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
+  DestroyWindow(hwnd);
+}
+
+// Base class for windows that dispatches messages to the handlers declared by Derived.
+// Use window_proc as the window procedure of the class and pass the Derived object as the
+// creation parameter. The hwnd_ member is valid from WM_NCCREATE until the end of WM_DESTROY.
+template <typename Derived>
+class window_base {
+public:
+  window_base() = default;
+  window_base(const window_base& other) = delete;
+  window_base& operator=(const window_base& other) = delete;
+
+  HWND hwnd() const
+  {
+    return hwnd_;
+  }
+
+  // Initial window procedure that attaches the object to the window on WM_NCCREATE.
+  static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    if (msg != WM_NCCREATE) {
+      return DefWindowProc(hwnd, msg, wparam, lparam);
+    }
+
+    // Route further messages through the thunk or through the user data of the window.
+    auto self = static_cast<Derived*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
+    self->window_ = hwnd;
+    self->hwnd_ = hwnd;
+    if (self->thunk_.create(self, reinterpret_cast<const void*>(&thunk_proc))) {
+      SetWindowLongPtr(hwnd, GWLP_WNDPROC, self->thunk_.get());
+    } else {
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
+      SetWindowLongPtr(hwnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(&userdata_proc));
+    }
+    return self->handle(msg, wparam, lparam);
+  }
+
+protected:
+  ~window_base() = default;
+
+  // Runs code outside of a message handler, like the continuation of background work, and reports
+  // its exceptions like those of message handlers.
+  template <typename Function>
+  void guarded(Function f)
+  {
+    try {
+      f();
+    }
+    catch (const std::exception& e) {
+      report_window_error(hwnd_, e);
+    }
+  }
+
+  HWND hwnd_ = nullptr;
+
+private:
+  static LRESULT CALLBACK thunk_proc(HWND self, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    return reinterpret_cast<Derived*>(self)->handle(msg, wparam, lparam);
+  }
+
+  static LRESULT CALLBACK userdata_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    auto self = reinterpret_cast<Derived*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    return self ? self->handle(msg, wparam, lparam) : DefWindowProc(hwnd, msg, wparam, lparam);
+  }
+
+  LRESULT handle(UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+#ifdef PROFILER
+    profile_scope profile(msg);
+#endif
+#ifdef TRACER
+    trace_handler trace(msg, msg == WM_PAINT);
+#endif
+
+    // Messages without a handler skip the exception handler.
+    auto hwnd = window_;
+    if (window_messages::handles<Derived>(msg)) {
+      try {
+        LRESULT result = 0;
+        auto handled = window_messages::dispatch(static_cast<Derived&>(*this), msg, wparam, lparam, result);
+        if (msg == WM_DESTROY) {
+          hwnd_ = nullptr;
+        }
+        if (handled) {
+          return result;
+        }
+      }
+      catch (const std::exception& e) {
+        report_window_error(hwnd, e);
+      }
+    }
+    if (msg == WM_DESTROY) {
+      hwnd_ = nullptr;
+    } else if (msg == WM_NCDESTROY) {
+      window_ = nullptr;
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+    }
+    return DefWindowProc(hwnd, msg, wparam, lparam);
+  }
+
+  HWND window_ = nullptr;
+  window_thunk thunk_;
+};
+
+// Base class for modeless dialogs that dispatches messages to the handlers declared by Derived.
+// Use dialog_proc as the dialog procedure and pass the Derived object as the initialization parameter.
+template <typename Derived>
+class dialog_base {
+public:
+  dialog_base() = default;
+  dialog_base(const dialog_base& other) = delete;
+  dialog_base& operator=(const dialog_base& other) = delete;
+
+  HWND hwnd() const
+  {
+    return hwnd_;
+  }
+
+  // Initial dialog procedure that attaches the object to the dialog on WM_INITDIALOG.
+  static INT_PTR CALLBACK dialog_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    if (msg != WM_INITDIALOG) {
+      return FALSE;
+    }
+
+    // Route further messages through the thunk or through the user data of the dialog.
+    auto self = reinterpret_cast<Derived*>(lparam);
+    self->window_ = hwnd;
+    self->hwnd_ = hwnd;
+    if (self->thunk_.create(self, reinterpret_cast<const void*>(&thunk_proc))) {
+      SetWindowLongPtr(hwnd, DWLP_DLGPROC, self->thunk_.get());
+    } else {
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
+      SetWindowLongPtr(hwnd, DWLP_DLGPROC, reinterpret_cast<LONG_PTR>(&userdata_proc));
+    }
+    return self->handle(msg, wparam, lparam);
+  }
+
+protected:
+  ~dialog_base() = default;
+
+  HWND hwnd_ = nullptr;
+
+private:
+  static INT_PTR CALLBACK thunk_proc(HWND self, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    return reinterpret_cast<Derived*>(self)->handle(msg, wparam, lparam);
+  }
+
+  static INT_PTR CALLBACK userdata_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+    auto self = reinterpret_cast<Derived*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    return self ? self->handle(msg, wparam, lparam) : FALSE;
+  }
+
+  INT_PTR handle(UINT msg, WPARAM wparam, LPARAM lparam)
+  {
+#ifdef PROFILER
+    profile_scope profile(msg);
+#endif
+#ifdef TRACER
+    trace_handler trace(msg, msg == WM_PAINT);
+#endif
+
+    // Messages without a handler skip the exception handler.
+    auto hwnd = window_;
+    if (window_messages::handles<Derived>(msg)) {
+      try {
+        LRESULT result = 0;
+        auto handled = window_messages::dispatch(static_cast<Derived&>(*this), msg, wparam, lparam, result);
+        if (msg == WM_DESTROY) {
+          hwnd_ = nullptr;
+        }
+        if (handled) {
+          if (msg == WM_INITDIALOG) {
+            return result;
+          }
+          SetWindowLongPtr(hwnd, DWLP_MSGRESULT, result);
+          return TRUE;
+        }
+      }
+      catch (const std::exception& e) {
+        report_window_error(hwnd, e);
+      }
+    }
+    if (msg == WM_DESTROY) {
+      hwnd_ = nullptr;
+    } else if (msg == WM_NCDESTROY) {
+      window_ = nullptr;
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+    }
+    return FALSE;
+  }
+
+  HWND window_ = nullptr;
+  window_thunk thunk_;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include "clock.h"
+#include <cstdint>
+#include <cstdio>
+
+// Returns the nanoseconds between two clock_ticks() timestamps.
+inline double elapsed_ns(std::uint64_t start, std::uint64_t end)
+{
+  return static_cast<double>(end - start) * 1e9 / clock_frequency();
+}
+
+// Prints one benchmark result line.
+inline void report(const char* name, double value, const char* unit)
+{
+  std::printf("%-40s %12.1f %s\n", name, value, unit);
+}
@@ -0,0 +1,49 @@
+#include "layout.h"
+#include "benchmark.h"
+
+#define CONTROLS_PER_ROW  8       // controls in every row of the form
+#define SOLVE_NODES       1000000 // nodes solved per measurement
+
+// Builds a form of labeled rows, like a large property page, with about the given number of nodes.
+void build(layout& l, int nodes)
+{
+  l.clear();
+  l[layout::root].direction = layout_direction::column;
+  l[layout::root].padding = { 8, 8, 8, 8 };
+  while (static_cast<int>(l.size()) < nodes) {
+    layout_node row;
+    row.direction = layout_direction::row;
+    row.height = 24;
+    row.margin.bottom = 4;
+    auto parent = l.add(layout::root, row);
+    for (int i = 0; i < CONTROLS_PER_ROW; i++) {
+      layout_node control;
+      control.width = 80;
+      control.grow = i % 2;
+      control.anchors = layout_top | layout_bottom;
+      control.margin.right = 4;
+      control.handle = &l;
+      l.add(parent, control);
+    }
+  }
+}
+
+int main()
+{
+  layout l;
+  for (int nodes : { 64, 1024, 4096, 16384 }) {
+    build(l, nodes);
+    auto runs = SOLVE_NODES / nodes;
+    auto start = clock_ticks();
+    for (int i = 0; i < runs; i++) {
+      l.solve(1000 + (i & 1), 800);
+    }
+    auto end = clock_ticks();
+
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "layout solve, %zu nodes", l.size());
+    report(name, elapsed_ns(start, end) / runs / 1e3, "us");
+    std::snprintf(name, sizeof(name), "layout solve per node, %zu nodes", l.size());
+    report(name, elapsed_ns(start, end) / runs / l.size(), "ns");
+  }
+}
@@ -0,0 +1,214 @@
+#include "layout.h"
+#include "check.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+layout_node fixed(int width, int height, unsigned anchors = layout_fill)
+{
+  layout_node n;
+  n.anchors = anchors;
+  n.width = width;
+  n.height = height;
+  return n;
+}
+
+layout_node grow(int factor)
+{
+  layout_node n;
+  n.grow = factor;
+  return n;
+}
+
+bool equal(const layout_rect& rc, int left, int top, int right, int bottom)
+{
+  return rc.left == left && rc.top == top && rc.right == right && rc.bottom == bottom;
+}
+
+void test_column()
+{
+  // A fixed header and footer around a growing body, as in a dialog with a button row.
+  layout_node root;
+  root.direction = layout_direction::column;
+  root.padding = { 10, 10, 10, 10 };
+  layout l(root);
+  auto header = l.add(layout::root, fixed(0, 20));
+  auto body = l.add(layout::root, grow(1));
+  l[body].margin = { 0, 5, 0, 5 };
+  auto footer = l.add(layout::root, fixed(0, 30));
+  l.solve(200, 300);
+
+  CHECK(equal(l.rect(layout::root), 0, 0, 200, 300));
+  CHECK(equal(l.rect(header), 10, 10, 190, 30));
+  CHECK(equal(l.rect(body), 10, 35, 190, 255));
+  CHECK(equal(l.rect(footer), 10, 260, 190, 290));
+
+  // The layout can be solved again for another size.
+  l.solve(100, 100);
+  CHECK(equal(l.rect(body), 10, 35, 90, 55));
+  CHECK(equal(l.rect(footer), 10, 60, 90, 90));
+}
+
+void test_row()
+{
+  // Remaining space is split by the grow factors and the rounding error goes to the last node.
+  layout_node root;
+  root.direction = layout_direction::row;
+  layout l(root);
+  auto a = l.add(layout::root, grow(1));
+  auto b = l.add(layout::root, grow(1));
+  auto c = l.add(layout::root, grow(1));
+  auto d = l.add(layout::root, fixed(25, 10, layout_left | layout_bottom));
+  l.solve(125, 50);
+  CHECK(equal(l.rect(a), 0, 0, 33, 50));
+  CHECK(equal(l.rect(b), 33, 0, 66, 50));
+  CHECK(equal(l.rect(c), 66, 0, 100, 50));
+  CHECK(equal(l.rect(d), 100, 40, 125, 50));
+
+  l[a].grow = 2;
+  l.solve(125, 50);
+  CHECK(l.rect(a).width() == 50);
+  CHECK(l.rect(b).width() == 25);
+  CHECK(l.rect(c).width() == 25);
+
+  // Growing nodes collapse when the fixed nodes do not fit.
+  l.solve(10, 50);
+  CHECK(l.rect(a).width() == 0);
+  CHECK(l.rect(c).width() == 0);
+  CHECK(equal(l.rect(d), 0, 40, 25, 50));
+}
+
+void test_anchors()
+{
+  layout l;
+  auto left = l.add(layout::root, fixed(10, 20, layout_left | layout_top));
+  auto right = l.add(layout::root, fixed(10, 20, layout_right | layout_bottom));
+  auto center = l.add(layout::root, fixed(10, 20, 0));
+  auto fill = l.add(layout::root, fixed(10, 20));
+  l[fill].margin = { 1, 2, 3, 4 };
+  auto stretch = l.add(layout::root, fixed(10, 20, layout_left | layout_right));
+  l.solve(100, 50);
+  CHECK(equal(l.rect(left), 0, 0, 10, 20));
+  CHECK(equal(l.rect(right), 90, 30, 100, 50));
+  CHECK(equal(l.rect(center), 45, 15, 55, 35));
+  CHECK(equal(l.rect(fill), 1, 2, 97, 46));
+  CHECK(equal(l.rect(stretch), 0, 15, 100, 35));
+
+  // Margins larger than the available space leave an empty rectangle.
+  l[fill].margin = { 60, 30, 60, 30 };
+  l.solve(100, 50);
+  CHECK(l.rect(fill).width() == 0);
+  CHECK(l.rect(fill).height() == 0);
+}
+
+void test_nesting()
+{
+  layout_node root;
+  root.direction = layout_direction::column;
+  layout l(root);
+  auto row = l.add(layout::root, grow(1));
+  l[row].direction = layout_direction::row;
+  l[row].padding = { 5, 5, 5, 5 };
+  auto a = l.add(row, fixed(20, 0));
+  auto b = l.add(row, grow(1));
+  auto buttons = l.add(layout::root, fixed(0, 30));
+  l[buttons].direction = layout_direction::row;
+  auto spacer = l.add(buttons, grow(1));
+  auto ok = l.add(buttons, fixed(40, 20, layout_top));
+  l[ok].margin = { 5, 5, 5, 5 };
+  l.solve(200, 130);
+
+  CHECK(equal(l.rect(row), 0, 0, 200, 100));
+  CHECK(equal(l.rect(a), 5, 5, 25, 95));
+  CHECK(equal(l.rect(b), 25, 5, 195, 95));
+  CHECK(equal(l.rect(buttons), 0, 100, 200, 130));
+  CHECK(equal(l.rect(spacer), 0, 100, 150, 130));
+  CHECK(equal(l.rect(ok), 155, 105, 195, 125));
+
+  // Clearing keeps the root node.
+  l.clear();
+  CHECK(l.size() == 1);
+  auto n = l.add(layout::root, fixed(10, 10, 0));
+  l.solve(30, 30);
+  CHECK(equal(l.rect(n), 10, 0, 20, 10));
+}
+
+// Builds random trees and checks that rows and columns hand out exactly the space they have.
+void test_random()
+{
+  std::mt19937 random(1);
+  for (int round = 0; round < 200; round++) {
+    layout l;
+    std::vector<layout::node_id> parents = { layout::root };
+    std::vector<std::vector<layout::node_id>> children(1);
+    auto count = 1 + random() % 200;
+    for (unsigned i = 0; i < count; i++) {
+      auto parent = parents[random() % parents.size()];
+      layout_node n;
+      n.direction = static_cast<layout_direction>(random() % 3);
+      n.anchors = random() % 16;
+      n.margin = { static_cast<int>(random() % 4), static_cast<int>(random() % 4), static_cast<int>(random() % 4), static_cast<int>(random() % 4) };
+      n.padding = { static_cast<int>(random() % 4), static_cast<int>(random() % 4), static_cast<int>(random() % 4), static_cast<int>(random() % 4) };
+      n.width = static_cast<int>(random() % 50);
+      n.height = static_cast<int>(random() % 50);
+      n.grow = random() % 2 ? static_cast<int>(random() % 4) : 0;
+      auto id = l.add(parent, n);
+      parents.push_back(id);
+      children.emplace_back();
+      children[parent].push_back(id);
+    }
+    l[layout::root].direction = static_cast<layout_direction>(random() % 3);
+    l.solve(static_cast<int>(random() % 2000), static_cast<int>(random() % 2000));
+
+    for (layout::node_id id = 0; id < l.size(); id++) {
+      const auto& n = l[id];
+      const auto& rc = l.rect(id);
+      if (n.direction == layout_direction::overlay || children[id].empty()) {
+        continue;
+      }
+      auto row = n.direction == layout_direction::row;
+      auto begin = row ? rc.left + n.padding.left : rc.top + n.padding.top;
+      auto end = row ? std::max(begin, rc.right - n.padding.right) : std::max(begin, rc.bottom - n.padding.bottom);
+
+      // Children follow each other without gaps beyond their margins.
+      int fixed_size = 0;
+      int grow_size = 0;
+      int grow_sum = 0;
+      auto position = begin;
+      for (auto c : children[id]) {
+        const auto& child = l[c];
+        const auto& out = l.rect(c);
+        auto margin_begin = row ? child.margin.left : child.margin.top;
+        auto margin_end = row ? child.margin.right : child.margin.bottom;
+        auto out_begin = row ? out.left : out.top;
+        auto out_end = row ? out.right : out.bottom;
+        CHECK(out_begin == position + margin_begin);
+        CHECK(out_end >= out_begin);
+        position = out_end + margin_end;
+        fixed_size += margin_begin + margin_end;
+        if (child.grow > 0) {
+          grow_size += out_end - out_begin;
+          grow_sum += child.grow;
+        } else {
+          CHECK(out_end - out_begin == (row ? child.width : child.height));
+          fixed_size += out_end - out_begin;
+        }
+      }
+      if (grow_sum) {
+        CHECK(grow_size == std::max(0, end - begin - fixed_size));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_column();
+  test_row();
+  test_anchors();
+  test_nesting();
+  test_random();
+}
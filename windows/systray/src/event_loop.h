@@ -0,0 +1,63 @@
+#pragma once
+#include "task_queue.h"
+#include "timer_wheel.h"
+#include <windows.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Main loop that waits for window messages, registered kernel handles, posted tasks and timers.
+// Tasks are executed on the thread that calls run(), in batches of everything posted
+// since the last wakeup. Modal loops such as message boxes and menus delay tasks and
+// handle callbacks until they return. Timers keep running because the wheel is also
+// advanced by a thread timer whose WM_TIMER messages are dispatched by modal loops.
+class event_loop {
+public:
+  using handler = std::function<void()>;
+
+  event_loop();
+  ~event_loop();
+
+  event_loop(const event_loop& other) = delete;
+  event_loop& operator=(const event_loop& other) = delete;
+
+  // Calls the handler on the loop thread whenever the handle is signaled.
+  // Auto-reset objects are reset by the wait, manual-reset objects must be reset or removed by the handler.
+  // Throws if MAXIMUM_WAIT_OBJECTS - 1 handles are already registered.
+  void add(HANDLE handle, handler h);
+
+  // Stops waiting for the handle. Can be called from a handler.
+  void remove(HANDLE handle);
+
+  // Queues a task from any thread.
+  void post(task_queue::task t);
+
+  // Returns the application timers. They are driven by the wait timeout of the loop and by a
+  // single thread timer, so they have the resolution of GetTickCount64. Must only be used on
+  // the loop thread.
+  timer_wheel& timers()
+  {
+    return timers_;
+  }
+
+  // Runs until WM_QUIT is received and returns its exit code.
+  int run();
+
+private:
+  static void CALLBACK on_timer(HWND hwnd, UINT msg, UINT_PTR id, DWORD time);
+
+  // Advances the wheel and sets the thread timer to the next timeout.
+  void advance();
+
+  task_queue tasks_;
+  timer_wheel timers_;
+  HANDLE wake_ = nullptr;
+
+  // Thread timer and the tick it is due at, or UINT64_MAX if it is not set.
+  UINT_PTR timer_ = 0;
+  std::uint64_t timer_due_ = UINT64_MAX;
+
+  // The wake event is always the first handle.
+  std::vector<HANDLE> handles_;
+  std::vector<handler> handlers_;
+};
@@ -0,0 +1,200 @@
+#include "menu_model.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+const std::size_t none = std::numeric_limits<std::size_t>::max();
+
+std::uint64_t key(const menu_item& item)
+{
+  return item.key ? item.key : item.id;
+}
+
+bool equal(const menu_item& a, const menu_item& b)
+{
+  return a.id == b.id && a.flags == b.flags && a.submenu == b.submenu && a.text == b.text;
+}
+
+#ifdef _WIN32
+void set_info(MENUITEMINFO& mii, const menu_item& item, HMENU submenu)
+{
+  mii.cbSize = sizeof(mii);
+  mii.fMask = MIIM_FTYPE | MIIM_STATE | MIIM_ID | MIIM_STRING | MIIM_SUBMENU;
+  mii.fType = (item.flags & menu_separator) ? MFT_SEPARATOR : MFT_STRING;
+  mii.fState = 0;
+  mii.fState |= (item.flags & menu_checked) ? MFS_CHECKED : 0;
+  mii.fState |= (item.flags & menu_disabled) ? MFS_DISABLED : 0;
+  mii.fState |= (item.flags & menu_default) ? MFS_DEFAULT : 0;
+  mii.wID = item.id;
+  mii.hSubMenu = submenu;
+  mii.dwTypeData = const_cast<wchar_t*>(item.text.c_str());
+  mii.cch = static_cast<UINT>(item.text.size());
+}
+#endif
+
+}  // namespace
+
+const std::vector<menu_edit>& menu_differ::diff(const std::vector<menu_item>& from, const std::vector<menu_item>& to)
+{
+  edits_.clear();
+
+  // Chain the previous items with equal keys so that duplicates are matched in order.
+  first_.clear();
+  same_.assign(from.size(), none);
+  for (auto i = from.size(); i-- > 0;) {
+    auto it = first_.find(key(from[i]));
+    if (it != first_.end()) {
+      same_[i] = it->second;
+      it->second = i;
+    } else {
+      first_.emplace(key(from[i]), i);
+    }
+  }
+
+  // Match every next item to the first unused previous item with the same key.
+  match_.assign(to.size(), none);
+  for (std::size_t i = 0; i < to.size(); i++) {
+    auto it = first_.find(key(to[i]));
+    if (it != first_.end() && it->second != none) {
+      match_[i] = it->second;
+      it->second = same_[it->second];
+    }
+  }
+
+  // Keep the longest increasing run of matched previous positions with patience sorting.
+  tails_.clear();
+  prev_.assign(to.size(), none);
+  for (std::size_t i = 0; i < to.size(); i++) {
+    if (match_[i] == none) {
+      continue;
+    }
+    auto pos = std::lower_bound(tails_.begin(), tails_.end(), i, [this](std::size_t a, std::size_t b) {
+      return match_[a] < match_[b];
+    });
+    if (pos != tails_.begin()) {
+      prev_[i] = *(pos - 1);
+    }
+    if (pos == tails_.end()) {
+      tails_.push_back(i);
+    } else {
+      *pos = i;
+    }
+  }
+  kept_.assign(from.size(), false);
+  for (auto i = tails_.empty() ? none : tails_.back(); i != none; i = prev_[i]) {
+    kept_[match_[i]] = true;
+  }
+
+  // Remove everything else from the back so that the positions of the remaining items stay valid.
+  for (auto i = from.size(); i-- > 0;) {
+    if (!kept_[i]) {
+      edits_.push_back({ menu_edit::remove, i, none });
+    }
+  }
+
+  // The kept items are now in order. Insert the others and update the kept items that changed.
+  for (std::size_t i = 0; i < to.size(); i++) {
+    auto m = match_[i];
+    if (m == none || !kept_[m]) {
+      edits_.push_back({ menu_edit::insert, i, i });
+    } else if (!equal(from[m], to[i])) {
+      edits_.push_back({ menu_edit::modify, i, i });
+    }
+  }
+  return edits_;
+}
+
+menu_model::~menu_model()
+{
+#ifdef _WIN32
+  // Detach the submenus first, because destroying a menu also destroys its submenus.
+  if (auto menu = static_cast<HMENU>(menu_)) {
+    for (auto i = applied_.size(); i-- > 0;) {
+      RemoveMenu(menu, static_cast<UINT>(i), MF_BYPOSITION);
+    }
+    DestroyMenu(menu);
+  }
+#endif
+}
+
+void menu_model::set(std::vector<menu_item> items)
+{
+  items_ = std::move(items);
+}
+
+void menu_model::set_filler(filler f)
+{
+  filler_ = std::move(f);
+}
+
+std::size_t menu_model::update()
+{
+  const auto& edits = differ_.diff(applied_, items_);
+#ifdef _WIN32
+  if (auto menu = static_cast<HMENU>(menu_)) {
+    for (const auto& edit : edits) {
+      auto index = static_cast<UINT>(edit.index);
+      if (edit.kind == menu_edit::remove) {
+        RemoveMenu(menu, index, MF_BYPOSITION);
+        continue;
+      }
+      const auto& item = items_[edit.item];
+      MENUITEMINFO mii = {};
+      set_info(mii, item, item.submenu ? item.submenu->handle() : nullptr);
+      if (edit.kind == menu_edit::insert) {
+        InsertMenuItem(menu, index, TRUE, &mii);
+      } else {
+        SetMenuItemInfo(menu, index, TRUE, &mii);
+      }
+    }
+  }
+#endif
+  applied_ = items_;
+  return edits.size();
+}
+
+bool menu_model::popup(void* handle)
+{
+  auto model = find(handle);
+  if (!model) {
+    return false;
+  }
+  if (model->filler_) {
+    model->filler_(model->items_);
+    model->update();
+  }
+  return true;
+}
+
+#ifdef _WIN32
+HMENU menu_model::handle()
+{
+  // Build the menu once from an empty item list.
+  if (!menu_) {
+    menu_ = CreatePopupMenu();
+    applied_.clear();
+    update();
+  }
+  return static_cast<HMENU>(menu_);
+}
+#endif
+
+menu_model* menu_model::find(void* handle)
+{
+  if (!handle) {
+    return nullptr;
+  }
+  if (handle == menu_) {
+    return this;
+  }
+  for (const auto& item : applied_) {
+    if (item.submenu) {
+      if (auto model = item.submenu->find(handle)) {
+        return model;
+      }
+    }
+  }
+  return nullptr;
+}
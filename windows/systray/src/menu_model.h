@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+class menu_model;
+
+enum menu_flags : unsigned {
+  menu_separator = 0x1,
+  menu_checked = 0x2,
+  menu_disabled = 0x4,
+  menu_default = 0x8,
+};
+
+// Entry of a menu model. Entries are matched across updates by key, or by command ID if the key is zero.
+struct menu_item {
+  std::uint64_t key = 0;
+  unsigned id = 0;
+  std::wstring text;
+  unsigned flags = 0;
+  menu_model* submenu = nullptr;  // not owned
+};
+
+// Change that turns the previous item list of a menu into the next one.
+struct menu_edit {
+  enum type {
+    insert,  // inserts the next item at the index
+    remove,  // removes the item at the index
+    modify,  // replaces the item at the index with the next item
+  };
+  type kind;
+  std::size_t index;  // position in the menu when the edit is applied
+  std::size_t item;   // index in the next item list, unused for remove
+};
+
+// Computes the edits that turn one item list into the other. Removes come first from the last position
+// to the first, followed by inserts and modifications in ascending order. Items that keep their relative
+// order are not moved: the longest increasing run of matched items stays and everything else is reinserted.
+class menu_differ {
+public:
+  // Replaces the edits with the difference of the lists. Reuses the buffers of previous calls.
+  const std::vector<menu_edit>& diff(const std::vector<menu_item>& from, const std::vector<menu_item>& to);
+
+  const std::vector<menu_edit>& edits() const
+  {
+    return edits_;
+  }
+
+private:
+  std::vector<menu_edit> edits_;
+  std::unordered_map<std::uint64_t, std::size_t> first_;
+  std::vector<std::size_t> same_;
+  std::vector<std::size_t> match_;
+  std::vector<std::size_t> tails_;
+  std::vector<std::size_t> prev_;
+  std::vector<bool> kept_;
+};
+
+// Menu whose native menu handle is built once and patched in place with the differences to the
+// previously applied items. Lazy menus fill their items right before they are shown.
+class menu_model {
+public:
+  using filler = std::function<void(std::vector<menu_item>& items)>;
+
+  menu_model() = default;
+  ~menu_model();
+
+  menu_model(const menu_model& other) = delete;
+  menu_model& operator=(const menu_model& other) = delete;
+
+  // Replaces the items. The menu is patched by the next update.
+  void set(std::vector<menu_item> items);
+
+  const std::vector<menu_item>& items() const
+  {
+    return items_;
+  }
+
+  // Calls the filler with the current items whenever the menu is about to be shown.
+  void set_filler(filler f);
+
+  // Patches the menu with the changes since the last update and returns the number of edits.
+  std::size_t update();
+
+  // Fills and updates the lazy menu with the given handle in this menu or its submenus.
+  // Returns false if the handle does not belong to the menu tree.
+  bool popup(void* handle);
+
+#ifdef _WIN32
+  // Returns the menu handle. Creates the menu and its submenus on first use.
+  HMENU handle();
+#endif
+
+private:
+  menu_model* find(void* handle);
+
+  std::vector<menu_item> items_;
+  std::vector<menu_item> applied_;
+  menu_differ differ_;
+  filler filler_;
+  void* menu_ = nullptr;
+};
@@ -0,0 +1,343 @@
+#include "process_sampler.h"
+#include "clock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+std::uint64_t filetime(const FILETIME& ft)
+{
+  return (static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+#else
+// Reads a file into the buffer without allocating and returns the number of bytes, or -1 on errors.
+ssize_t read_file(const std::string& path, std::vector<char>& buffer)
+{
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  auto size = read(fd, buffer.data(), buffer.size() - 1);
+  close(fd);
+  if (size >= 0) {
+    buffer[static_cast<std::size_t>(size)] = '\0';
+  }
+  return size;
+}
+
+// Returns the value after the given key in a "key: value" file.
+std::uint64_t find_value(const char* data, const char* key)
+{
+  auto pos = std::strstr(data, key);
+  return pos ? std::strtoull(pos + std::strlen(key), nullptr, 10) : 0;
+}
+#endif
+
+}  // namespace
+
+sample_ring::sample_ring(std::size_t capacity)
+{
+  // Round the capacity up to a power of two.
+  std::size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  samples_.reset(new process_sample[size]);
+  mask_ = size - 1;
+}
+
+bool sample_ring::push(const process_sample& sample)
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) > mask_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  samples_[head & mask_] = sample;
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+bool sample_ring::pop(process_sample& sample)
+{
+  auto tail = tail_.load(std::memory_order_relaxed);
+  if (tail == head_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  sample = samples_[tail & mask_];
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+std::uint64_t sample_ring::dropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+void process_stats::add(const process_sample& sample)
+{
+  cpu.add(sample.cpu);
+  io.add(sample.io);
+  working_set.add(static_cast<double>(sample.working_set));
+  handles.add(static_cast<double>(sample.handles));
+}
+
+rolling_stats::rolling_stats(std::size_t window)
+{
+  values_.reserve(window ? window : 1);
+  sorted_.reserve(window ? window : 1);
+}
+
+void rolling_stats::add(double value)
+{
+  // Replace the oldest value once the window is full.
+  if (values_.size() < values_.capacity()) {
+    values_.push_back(value);
+    sorted_.insert(std::upper_bound(sorted_.begin(), sorted_.end(), value), value);
+    sum_ += value;
+    return;
+  }
+  auto old = values_[next_];
+  values_[next_] = value;
+  next_ = (next_ + 1) % values_.size();
+  sum_ += value - old;
+
+  // Shift the values between the old and the new position by one instead of erasing and inserting.
+  auto from = std::lower_bound(sorted_.begin(), sorted_.end(), old);
+  auto to = std::upper_bound(sorted_.begin(), sorted_.end(), value);
+  if (to > from) {
+    std::move(from + 1, to, from);
+    *(to - 1) = value;
+  } else {
+    std::move_backward(to, from, from + 1);
+    *to = value;
+  }
+}
+
+double rolling_stats::min() const
+{
+  return sorted_.empty() ? 0.0 : sorted_.front();
+}
+
+double rolling_stats::max() const
+{
+  return sorted_.empty() ? 0.0 : sorted_.back();
+}
+
+double rolling_stats::mean() const
+{
+  return sorted_.empty() ? 0.0 : sum_ / sorted_.size();
+}
+
+double rolling_stats::percentile(double p) const
+{
+  if (sorted_.empty()) {
+    return 0.0;
+  }
+  auto rank = static_cast<std::size_t>(p / 100.0 * sorted_.size() + 0.5);
+  rank = std::min(std::max<std::size_t>(rank, 1), sorted_.size());
+  return sorted_[rank - 1];
+}
+
+process_sampler::process_sampler(std::vector<std::uint32_t> pids, std::uint64_t interval, std::size_t capacity) :
+  pids_(std::move(pids)), targets_(pids_.size()), buffer_(4096), interval_(interval), ring_(capacity)
+{
+  for (std::size_t i = 0; i < pids_.size(); i++) {
+    auto& t = targets_[i];
+    t.pid = pids_[i];
+#ifdef _WIN32
+    // Windows 7 requires full query rights for the memory counters.
+    t.handle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, t.pid);
+    if (!t.handle) {
+      t.handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, t.pid);
+    }
+#else
+    t.path = "/proc/" + std::to_string(t.pid) + "/";
+    path_.reserve(t.path.size() + 8);
+#endif
+  }
+}
+
+process_sampler::~process_sampler()
+{
+  stop();
+#ifdef _WIN32
+  for (auto& t : targets_) {
+    if (t.handle) {
+      CloseHandle(t.handle);
+    }
+  }
+#endif
+}
+
+void process_sampler::start()
+{
+  if (thread_.joinable()) {
+    return;
+  }
+  stop_ = false;
+  thread_ = std::thread([this]() {
+    run();
+  });
+}
+
+void process_sampler::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::size_t process_sampler::sample()
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < targets_.size(); i++) {
+    process_sample s;
+    s.slot = static_cast<std::uint32_t>(i);
+    if (read(targets_[i], s) && ring_.push(s)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void process_sampler::run()
+{
+  // Sample at fixed deadlines so that the time spent sampling does not shift the interval.
+  auto interval = std::chrono::milliseconds(interval_);
+  auto deadline = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    lock.unlock();
+    sample();
+    lock.lock();
+    deadline += interval;
+    auto now = std::chrono::steady_clock::now();
+    if (deadline < now) {
+      deadline = now;
+    }
+    wake_.wait_until(lock, deadline, [this]() {
+      return stop_;
+    });
+  }
+}
+
+#ifndef _WIN32
+const std::string& process_sampler::path(const target& t, const char* name)
+{
+  // Reuse the path buffer so that sampling does not allocate.
+  path_.assign(t.path).append(name);
+  return path_;
+}
+#endif
+
+bool process_sampler::read(target& t, process_sample& sample)
+{
+  std::uint64_t cpu_time = 0;
+  std::uint64_t io_bytes = 0;
+  sample.pid = t.pid;
+  sample.time = clock_ticks();
+
+#ifdef _WIN32
+  DWORD code = 0;
+  if (!t.handle || !GetExitCodeProcess(t.handle, &code) || code != STILL_ACTIVE) {
+    return false;
+  }
+
+  // CPU times are in 100 nanosecond intervals.
+  FILETIME creation = {};
+  FILETIME exit = {};
+  FILETIME kernel = {};
+  FILETIME user = {};
+  if (GetProcessTimes(t.handle, &creation, &exit, &kernel, &user)) {
+    cpu_time = (filetime(kernel) + filetime(user)) * 100;
+  }
+
+  PROCESS_MEMORY_COUNTERS pmc = {};
+  if (GetProcessMemoryInfo(t.handle, &pmc, sizeof(pmc))) {
+    sample.working_set = pmc.WorkingSetSize;
+  }
+
+  DWORD handles = 0;
+  if (GetProcessHandleCount(t.handle, &handles)) {
+    sample.handles = handles;
+  }
+
+  IO_COUNTERS io = {};
+  if (GetProcessIoCounters(t.handle, &io)) {
+    io_bytes = io.ReadTransferCount + io.WriteTransferCount;
+  }
+#else
+  // The CPU times are the 14th and 15th field of the stat file after the command name in parentheses.
+  static const auto tick = 1e9 / sysconf(_SC_CLK_TCK);
+  static const auto page = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+  if (read_file(path(t, "stat"), buffer_) <= 0) {
+    return false;
+  }
+  auto pos = std::strrchr(buffer_.data(), ')');
+  if (!pos) {
+    return false;
+  }
+  char* end = pos + 2;
+  std::uint64_t fields[22] = {};
+  for (auto& field : fields) {
+    while (*end == ' ') {
+      end++;
+    }
+    if (*end >= '0' && *end <= '9') {
+      field = std::strtoull(end, &end, 10);
+    } else {
+      while (*end && *end != ' ') {
+        end++;
+      }
+    }
+  }
+  cpu_time = static_cast<std::uint64_t>((fields[11] + fields[12]) * tick);
+  sample.working_set = fields[21] * page;
+
+  // The I/O counters are only readable by the owner of the process.
+  if (read_file(path(t, "io"), buffer_) > 0) {
+    io_bytes = find_value(buffer_.data(), "rchar: ") + find_value(buffer_.data(), "wchar: ");
+  }
+
+  if (auto dir = opendir(path(t, "fd").c_str())) {
+    while (auto entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        sample.handles++;
+      }
+    }
+    closedir(dir);
+  }
+#endif
+
+  // Rates need a previous sample, so the first sample of a process is not reported.
+  auto rated = t.sampled;
+  if (rated && sample.time > t.time) {
+    auto seconds = (sample.time - t.time) / clock_frequency();
+    sample.cpu = (cpu_time - t.cpu_time) / 1e9 / seconds * 100.0;
+    sample.io = (io_bytes - t.io_bytes) / seconds;
+  }
+  t.time = sample.time;
+  t.cpu_time = cpu_time;
+  t.io_bytes = io_bytes;
+  t.sampled = true;
+  return rated;
+}
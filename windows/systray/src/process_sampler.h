@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Resource usage of a process at one point in time.
+struct process_sample {
+  std::uint32_t pid = 0;
+  std::uint32_t slot = 0;          // index of the process in the sampler configuration
+  std::uint64_t time = 0;          // clock_ticks() when the sample was taken
+  double cpu = 0.0;                // percent of one core since the previous sample
+  double io = 0.0;                 // bytes read and written per second since the previous sample
+  std::uint64_t working_set = 0;   // bytes
+  std::uint64_t handles = 0;       // open handles or file descriptors
+};
+
+// Bounded lock-free single-producer single-consumer ring of samples.
+class sample_ring {
+public:
+  explicit sample_ring(std::size_t capacity = 1024);
+
+  // Adds a sample from the producer thread. Returns false and drops the sample if the ring is full.
+  bool push(const process_sample& sample);
+
+  // Removes the oldest sample on the consumer thread. Returns false if the ring is empty.
+  bool pop(process_sample& sample);
+
+  // Returns the number of samples that were dropped because the ring was full.
+  std::uint64_t dropped() const;
+
+private:
+  std::unique_ptr<process_sample[]> samples_;
+  std::size_t mask_ = 0;
+
+  alignas(64) std::atomic<std::size_t> head_ = { 0 };
+  alignas(64) std::atomic<std::size_t> tail_ = { 0 };
+  alignas(64) std::atomic<std::uint64_t> dropped_ = { 0 };
+};
+
+// Minimum, average, maximum and percentiles of the last values in a fixed window.
+// Values are kept in insertion order and in sorted order, so adding a value costs one
+// binary search and one move of at most the window size, and queries are constant time.
+class rolling_stats {
+public:
+  explicit rolling_stats(std::size_t window = 600);
+
+  void add(double value);
+
+  std::size_t size() const
+  {
+    return sorted_.size();
+  }
+
+  double min() const;
+  double max() const;
+  double mean() const;
+
+  // Returns the nearest-rank percentile for p in [0, 100].
+  double percentile(double p) const;
+
+private:
+  std::vector<double> values_;
+  std::vector<double> sorted_;
+  std::size_t next_ = 0;
+  double sum_ = 0.0;
+};
+
+// Rolling aggregates of the samples of one process.
+struct process_stats {
+  explicit process_stats(std::size_t window = 600) : cpu(window), io(window), working_set(window), handles(window)
+  {}
+
+  void add(const process_sample& sample);
+
+  rolling_stats cpu;
+  rolling_stats io;
+  rolling_stats working_set;
+  rolling_stats handles;
+};
+
+// Samples a fixed set of processes on a background thread and writes the samples into a ring.
+// All buffers are allocated up front. Processes that can not be opened or have exited are skipped.
+class process_sampler {
+public:
+  // Samples the processes every interval in milliseconds.
+  process_sampler(std::vector<std::uint32_t> pids, std::uint64_t interval = 100, std::size_t capacity = 1024);
+  ~process_sampler();
+
+  process_sampler(const process_sampler& other) = delete;
+  process_sampler& operator=(const process_sampler& other) = delete;
+
+  // Starts the sampling thread.
+  void start();
+
+  // Stops the sampling thread.
+  void stop();
+
+  // Samples all processes once on the calling thread. Used by the sampling thread and benchmarks.
+  std::size_t sample();
+
+  const std::vector<std::uint32_t>& pids() const
+  {
+    return pids_;
+  }
+
+  sample_ring& samples()
+  {
+    return ring_;
+  }
+
+private:
+  struct target {
+    std::uint32_t pid = 0;
+    void* handle = nullptr;       // process handle on Windows
+    std::string path;             // /proc directory of the process elsewhere
+    std::uint64_t time = 0;       // clock_ticks() of the previous sample
+    std::uint64_t cpu_time = 0;   // CPU time in nanoseconds at the previous sample
+    std::uint64_t io_bytes = 0;   // bytes read and written at the previous sample
+    bool sampled = false;
+  };
+
+  void run();
+  bool read(target& t, process_sample& sample);
+#ifndef _WIN32
+  const std::string& path(const target& t, const char* name);
+#endif
+
+  std::vector<std::uint32_t> pids_;
+  std::vector<target> targets_;
+  std::vector<char> buffer_;
+  std::string path_;
+  std::uint64_t interval_;
+  sample_ring ring_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread thread_;
+};
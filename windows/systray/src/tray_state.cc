@@ -0,0 +1,101 @@
+#include "tray_state.h"
+#include <utility>
+
+tray_state::tray_state(std::uint64_t interval) : interval_(interval)
+{}
+
+bool tray_state::set_tip(std::wstring tip)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.updates++;
+  if (!(pending_.changed & tray_tip) && tip == tip_) {
+    stats_.coalesced++;
+    return false;
+  }
+  pending_.tip = std::move(tip);
+  return changed(tray_tip);
+}
+
+bool tray_state::set_icon(void* icon)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.updates++;
+  if (!(pending_.changed & tray_icon) && icon == icon_) {
+    stats_.coalesced++;
+    return false;
+  }
+  pending_.icon = icon;
+  return changed(tray_icon);
+}
+
+bool tray_state::set_balloon(std::wstring title, std::wstring text, balloon_icon type)
+{
+  // Balloons are events and only the latest one before a flush is shown.
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.updates++;
+  pending_.title = std::move(title);
+  pending_.text = std::move(text);
+  pending_.type = type;
+  return changed(tray_balloon);
+}
+
+bool tray_state::flush(std::uint64_t now, update& u, std::uint64_t& delay)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  delay = 0;
+  if (!pending_.changed) {
+    scheduled_ = false;
+    return false;
+  }
+  if (flushed_ && now - last_ < interval_) {
+    delay = interval_ - (now - last_);
+    return false;
+  }
+
+  // A value that was set back to the applied value while it was pending is not a change.
+  if ((pending_.changed & tray_tip) && pending_.tip == tip_) {
+    pending_.changed &= ~tray_tip;
+    stats_.coalesced++;
+  }
+  if ((pending_.changed & tray_icon) && pending_.icon == icon_) {
+    pending_.changed &= ~tray_icon;
+    stats_.coalesced++;
+  }
+  if (pending_.changed & tray_tip) {
+    tip_ = pending_.tip;
+  }
+  if (pending_.changed & tray_icon) {
+    icon_ = pending_.icon;
+  }
+  scheduled_ = false;
+  if (!pending_.changed) {
+    return false;
+  }
+
+  u = std::move(pending_);
+  pending_ = update();
+  last_ = now;
+  flushed_ = true;
+  stats_.flushes++;
+  return true;
+}
+
+tray_state::statistics tray_state::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool tray_state::changed(unsigned field)
+{
+  // Replacing a pending value drops the previous update.
+  if (pending_.changed & field) {
+    stats_.coalesced++;
+  }
+  pending_.changed |= field;
+  if (scheduled_) {
+    return false;
+  }
+  scheduled_ = true;
+  return true;
+}
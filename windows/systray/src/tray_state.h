@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Latest values of the systray icon fields, updated from any thread and applied at a limited rate.
+// Only the last value of every field is kept until the next flush, which applies all changed
+// fields at once. Icons are opaque handles so that the coalescing does not depend on the shell.
+class tray_state {
+public:
+  enum field : unsigned {
+    tray_tip = 0x1,
+    tray_icon = 0x2,
+    tray_balloon = 0x4,
+  };
+
+  enum balloon_icon : unsigned {
+    balloon_none,
+    balloon_info,
+    balloon_warning,
+    balloon_error,
+  };
+
+  // Fields to apply in one flush. Only the fields in changed are valid.
+  struct update {
+    unsigned changed = 0;
+    std::wstring tip;
+    void* icon = nullptr;
+    std::wstring title;
+    std::wstring text;
+    balloon_icon type = balloon_none;
+  };
+
+  struct statistics {
+    std::uint64_t updates = 0;
+    std::uint64_t coalesced = 0;
+    std::uint64_t flushes = 0;
+  };
+
+  // Applies changes at most once per interval in milliseconds.
+  explicit tray_state(std::uint64_t interval = 250);
+
+  // Sets a field from any thread. Values equal to the applied value are ignored.
+  // Returns true if the caller is responsible for scheduling a flush.
+  bool set_tip(std::wstring tip);
+  bool set_icon(void* icon);
+  bool set_balloon(std::wstring title, std::wstring text, balloon_icon type = balloon_info);
+
+  // Moves the changed fields into the update if the interval since the last flush has passed.
+  // Otherwise returns false and sets delay to the milliseconds until the next flush is allowed.
+  // Returns false with a zero delay if nothing changed. Must only be called from the consumer thread.
+  bool flush(std::uint64_t now, update& u, std::uint64_t& delay);
+
+  // Returns the number of updates, the number of updates that were replaced by a later value or
+  // ignored before they were applied, and the number of flushes.
+  statistics stats() const;
+
+private:
+  bool changed(unsigned field);
+
+  mutable std::mutex mutex_;
+  std::uint64_t interval_;
+  std::uint64_t last_ = 0;
+  bool flushed_ = false;
+
+  // Pending and applied values.
+  update pending_;
+  std::wstring tip_;
+  void* icon_ = nullptr;
+
+  // The caller was asked to schedule a flush that did not happen yet.
+  bool scheduled_ = false;
+
+  statistics stats_;
+};
@@ -0,0 +1,304 @@
+#include "utf.h"
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define UTF_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define UTF_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define UTF_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// Decodes a single non-ASCII sequence according to the well-formed byte sequences of the Unicode standard.
+// Invalid sequences are replaced with U+FFFD and the maximal valid prefix is skipped.
+inline bool decode(const unsigned char* src, std::size_t size, std::size_t& i, char16_t* dst, std::size_t& o, bool strict)
+{
+  auto c0 = src[i];
+  auto left = size - i;
+  auto cont = [&](std::size_t n, unsigned char lo, unsigned char hi) {
+    return n < left && src[i + n] >= lo && src[i + n] <= hi;
+  };
+
+  if (c0 >= 0xC2 && c0 <= 0xDF) {
+    if (cont(1, 0x80, 0xBF)) {
+      dst[o++] = static_cast<char16_t>(((c0 & 0x1F) << 6) | (src[i + 1] & 0x3F));
+      i += 2;
+      return true;
+    }
+  } else if (c0 >= 0xE0 && c0 <= 0xEF) {
+    auto lo = c0 == 0xE0 ? 0xA0 : 0x80;
+    auto hi = c0 == 0xED ? 0x9F : 0xBF;
+    if (cont(1, lo, hi)) {
+      if (cont(2, 0x80, 0xBF)) {
+        dst[o++] = static_cast<char16_t>(((c0 & 0x0F) << 12) | ((src[i + 1] & 0x3F) << 6) | (src[i + 2] & 0x3F));
+        i += 3;
+        return true;
+      }
+      i++;
+    }
+  } else if (c0 >= 0xF0 && c0 <= 0xF4) {
+    auto lo = c0 == 0xF0 ? 0x90 : 0x80;
+    auto hi = c0 == 0xF4 ? 0x8F : 0xBF;
+    if (cont(1, lo, hi)) {
+      if (cont(2, 0x80, 0xBF)) {
+        if (cont(3, 0x80, 0xBF)) {
+          auto cp = (static_cast<unsigned>(c0 & 0x07) << 18) | ((src[i + 1] & 0x3Fu) << 12) | ((src[i + 2] & 0x3Fu) << 6) | (src[i + 3] & 0x3Fu);
+          cp -= 0x10000;
+          dst[o++] = static_cast<char16_t>(0xD800 + (cp >> 10));
+          dst[o++] = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+          i += 4;
+          return true;
+        }
+        i++;
+      }
+      i++;
+    }
+  }
+
+  // Replace the invalid sequence.
+  if (strict) {
+    return false;
+  }
+  dst[o++] = 0xFFFD;
+  i++;
+  return true;
+}
+
+bool convert_scalar(const unsigned char* src, std::size_t size, char16_t* dst, std::size_t& written, bool strict)
+{
+  std::size_t i = 0;
+  std::size_t o = 0;
+  while (i < size) {
+    // Convert ASCII eight bytes at a time.
+    while (i + 8 <= size) {
+      unsigned long long block = 0;
+      std::memcpy(&block, src + i, 8);
+      if (block & 0x8080808080808080ULL) {
+        break;
+      }
+      for (auto n = 0; n < 8; n++) {
+        dst[o++] = src[i++];
+      }
+    }
+    while (i < size && src[i] < 0x80) {
+      dst[o++] = src[i++];
+    }
+    if (i < size && !decode(src, size, i, dst, o, strict)) {
+      written = o;
+      return false;
+    }
+  }
+  written = o;
+  return true;
+}
+
+#ifdef UTF_X86
+
+inline unsigned trailing_zeros(unsigned mask)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+bool convert_sse2(const unsigned char* src, std::size_t size, char16_t* dst, std::size_t& written, bool strict)
+{
+  const auto zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  std::size_t o = 0;
+  while (i < size) {
+    if (i + 16 <= size) {
+      // Widen sixteen bytes and keep the ASCII prefix. The output never overtakes the input,
+      // so the whole block fits into the output buffer.
+      auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      auto mask = static_cast<unsigned>(_mm_movemask_epi8(v));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + o), _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + o + 8), _mm_unpackhi_epi8(v, zero));
+      if (!mask) {
+        i += 16;
+        o += 16;
+        continue;
+      }
+      auto n = trailing_zeros(mask);
+      i += n;
+      o += n;
+    } else {
+      while (i < size && src[i] < 0x80) {
+        dst[o++] = src[i++];
+      }
+      if (i == size) {
+        break;
+      }
+    }
+
+    // Decode a run of multibyte sequences.
+    do {
+      if (!decode(src, size, i, dst, o, strict)) {
+        written = o;
+        return false;
+      }
+    } while (i < size && src[i] >= 0x80);
+  }
+  written = o;
+  return true;
+}
+
+UTF_TARGET_AVX2 bool convert_avx2(const unsigned char* src, std::size_t size, char16_t* dst, std::size_t& written, bool strict)
+{
+  std::size_t i = 0;
+  std::size_t o = 0;
+  while (i < size) {
+    if (i + 32 <= size) {
+      // Widen thirty-two bytes and keep the ASCII prefix.
+      auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+      auto mask = static_cast<unsigned>(_mm256_movemask_epi8(v));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + o), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + o + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+      if (!mask) {
+        i += 32;
+        o += 32;
+        continue;
+      }
+      auto n = trailing_zeros(mask);
+      i += n;
+      o += n;
+    } else {
+      while (i < size && src[i] < 0x80) {
+        dst[o++] = src[i++];
+      }
+      if (i == size) {
+        break;
+      }
+    }
+
+    // Decode a run of multibyte sequences.
+    do {
+      if (!decode(src, size, i, dst, o, strict)) {
+        written = o;
+        return false;
+      }
+    } while (i < size && src[i] >= 0x80);
+  }
+  written = o;
+  return true;
+}
+
+#endif
+
+#ifdef UTF_X86
+
+// Returns true if the processor and the operating system support AVX2.
+bool has_avx2()
+{
+  unsigned regs[4] = {};
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 0);
+  auto max = info[0];
+  __cpuid(info, 1);
+  regs[2] = static_cast<unsigned>(info[2]);
+#else
+  auto max = static_cast<int>(__get_cpuid_max(0, nullptr));
+  __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+  auto osxsave = (regs[2] & (1u << 27)) != 0;
+  auto avx = (regs[2] & (1u << 28)) != 0;
+  if (max < 7 || !osxsave || !avx) {
+    return false;
+  }
+#ifdef _MSC_VER
+  auto xcr0 = _xgetbv(0);
+  __cpuidex(info, 7, 0);
+  auto avx2 = (info[1] & (1 << 5)) != 0;
+#else
+  unsigned lo = 0;
+  unsigned hi = 0;
+  __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  auto xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+  unsigned ext[4] = {};
+  __get_cpuid_count(7, 0, &ext[0], &ext[1], &ext[2], &ext[3]);
+  auto avx2 = (ext[1] & (1u << 5)) != 0;
+#endif
+  return avx2 && (xcr0 & 0x6) == 0x6;
+}
+
+// Returns true if the processor supports SSE2.
+bool has_sse2()
+{
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+#else
+  unsigned regs[4] = {};
+  __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+  return (regs[3] & (1u << 26)) != 0;
+#endif
+}
+
+#endif
+
+bool convert(const unsigned char* src, std::size_t size, char16_t* dst, std::size_t& written, bool strict)
+{
+  // Use the widest instruction set supported by the processor and the operating system.
+  static const auto function = utf_detail::kernels().back().convert;
+  return function(src, size, dst, written, strict);
+}
+
+}  // namespace
+
+std::vector<utf_detail::kernel> utf_detail::kernels()
+{
+  std::vector<kernel> kernels = { { "scalar", convert_scalar } };
+#ifdef UTF_X86
+  if (has_sse2()) {
+    kernels.push_back({ "sse2", convert_sse2 });
+  }
+  if (has_avx2()) {
+    kernels.push_back({ "avx2", convert_avx2 });
+  }
+#endif
+  return kernels;
+}
+
+std::size_t utf8_to_utf16(const char* src, std::size_t size, char16_t* dst)
+{
+  std::size_t written = 0;
+  convert(reinterpret_cast<const unsigned char*>(src), size, dst, written, false);
+  return written;
+}
+
+bool utf8_to_utf16_strict(const char* src, std::size_t size, char16_t* dst, std::size_t& written)
+{
+  return convert(reinterpret_cast<const unsigned char*>(src), size, dst, written, true);
+}
+
+#ifdef _WIN32
+
+static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t must hold UTF-16 code units");
+
+void utf8_to_utf16(const char* src, std::size_t size, std::wstring& dst)
+{
+  // Reuse the capacity of the output buffer.
+  dst.resize(size);
+  if (size) {
+    dst.resize(utf8_to_utf16(src, size, reinterpret_cast<char16_t*>(&dst[0])));
+  }
+}
+
+void utf8_to_utf16(const char* str, std::wstring& dst)
+{
+  utf8_to_utf16(str, std::strlen(str), dst);
+}
+
+#endif
@@ -1,14 +1,38 @@
 #include "window.h"
 #include <windowsx.h>
 #include <resource.h>
-#include <stdexcept>
-#include <string>
+#include <cstddef>
+#include <cstdint>
 #include <cwchar>
+#include <string>
+#include <utility>
+
+#define TRAY_UPDATE_INTERVAL 250  // minimum milliseconds between systray icon updates
 
-#define WM_APP_TRAY (WM_APP + 1)
+#define SAMPLER_INTERVAL 100         // milliseconds between process samples
+#define SAMPLER_WINDOW 600           // samples in the rolling aggregates
+#define SAMPLER_REPORT_INTERVAL 1000 // milliseconds between tooltip updates
+#define SAMPLER_CPU_ALERT 90.0       // 95th percentile of the CPU usage in percent that raises an alert
+#define SAMPLER_MEMORY_ALERT 1024.0  // working set in MiB that raises an alert
 
-window::window(HINSTANCE instance) : instance_(instance)
+#define ALERT_CPU    0x1
+#define ALERT_MEMORY 0x2
+
+// Copies a string into a fixed size NOTIFYICONDATA field and truncates it if necessary.
+template <std::size_t N>
+static void copy_field(wchar_t (&dst)[N], const std::wstring& src)
 {
+  std::wcsncpy(dst, src.c_str(), N - 1);
+  dst[N - 1] = L'\0';
+}
+
+window::window(HINSTANCE instance, event_loop& loop, thread_pool& pool) :
+  instance_(instance), loop_(loop), pool_(pool), tray_state_(TRAY_UPDATE_INTERVAL)
+{
+  // Apply coalesced systray updates that arrived before the end of the interval.
+  tray_timer_.bind<window, &window::on_tray_update>(this);
+  sampler_timer_.bind<window, &window::on_samples>(this);
+
   // Load the window icon.
   auto icon = LoadIcon(instance, MAKEINTRESOURCE(IDI_MAIN));
 
@@ -23,16 +47,7 @@ window::window(HINSTANCE instance) : instance_(instance)
   WNDCLASSEX wc = {};
   wc.cbSize = sizeof(wc);
   wc.style = CS_HREDRAW | CS_VREDRAW;
-  wc.lpfnWndProc = [](HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) -> LRESULT {
-    auto self = reinterpret_cast<window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-    if (msg == WM_CREATE) {
-      self = reinterpret_cast<window*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
-    } else if (msg == WM_DESTROY) {
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
-    }
-    return self ? self->handle(hwnd, msg, wparam, lparam) : DefWindowProc(hwnd, msg, wparam, lparam);
-  };
+  wc.lpfnWndProc = window_proc;
   wc.hInstance = instance;
   wc.hIcon = icon;
   wc.hIconSm = icon;
@@ -46,6 +61,7 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("RegisterClassEx");
 
   // Create the main application window.
   auto es = 0x0L;
@@ -56,6 +72,68 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("CreateWindowEx");
+}
+
+void window::set_tip(std::wstring tip)
+{
+  if (tray_state_.set_tip(std::move(tip))) {
+    loop_.post([this]() {
+      on_tray_update();
+    });
+  }
+}
+
+void window::set_icon(HICON icon)
+{
+  if (tray_state_.set_icon(icon)) {
+    loop_.post([this]() {
+      on_tray_update();
+    });
+  }
+}
+
+void window::notify(std::wstring title, std::wstring text, tray_state::balloon_icon type)
+{
+  if (tray_state_.set_balloon(std::move(title), std::move(text), type)) {
+    loop_.post([this]() {
+      on_tray_update();
+    });
+  }
+}
+
+void window::monitor(std::vector<std::uint32_t> pids)
+{
+  // Aggregate the samples on the loop thread and update the tooltip periodically.
+  stats_.assign(pids.size(), process_stats(SAMPLER_WINDOW));
+  alerts_.assign(pids.size(), 0);
+  sampler_.reset(new process_sampler(std::move(pids), SAMPLER_INTERVAL));
+  sampler_->start();
+  loop_.timers().schedule(sampler_timer_, SAMPLER_REPORT_INTERVAL);
+}
+
+void window::open(const std::vector<std::wstring>& commands)
+{
+  // Parse the process IDs of the last command line that contains any.
+  std::vector<std::uint32_t> pids;
+  for (auto it = commands.rbegin(); it != commands.rend() && pids.empty(); ++it) {
+    for (auto pos = it->c_str(); *pos;) {
+      wchar_t* end = nullptr;
+      auto pid = std::wcstoul(pos, &end, 10);
+      if (end == pos) {
+        break;
+      }
+      pids.push_back(static_cast<std::uint32_t>(pid));
+      pos = end;
+    }
+  }
+  if (pids.empty()) {
+    if (sampler_) {
+      return;
+    }
+    pids.push_back(GetCurrentProcessId());
+  }
+  monitor(std::move(pids));
 }
 
 void window::on_create()
@@ -67,11 +145,26 @@ void window::on_create()
   // Set the systray icon version.
   tray_.uVersion = NOTIFYICON_VERSION_4;
   Shell_NotifyIcon(NIM_SETVERSION, &tray_);
+
+  // Create the context menu model.
+  create_menu();
+
+#ifdef TRACER
+  // The window is never painted. End the startup phase once the icon was added.
+  tracer::instance().end_startup();
+#endif
 }
 
 void window::on_destroy()
 {
+  // Stop sampling.
+  loop_.timers().cancel(sampler_timer_);
+  if (sampler_) {
+    sampler_->stop();
+  }
+
   // Destroy the systray icon.
+  loop_.timers().cancel(tray_timer_);
   Shell_NotifyIcon(NIM_DELETE, &tray_);
 
   // Stop the main message loop.
@@ -85,6 +178,16 @@ void window::on_command(UINT id)
   case IDM_EXIT:
     PostMessage(hwnd_, WM_CLOSE, 0, 0);
     break;
+#ifdef PROFILER
+  case IDM_PROFILE:
+    MessageBox(hwnd_, (L"The profile was saved to " + profiler::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
+#ifdef TRACER
+  case IDM_TRACE:
+    MessageBox(hwnd_, (L"The trace was saved to " + tracer::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
   }
 }
 
@@ -96,51 +199,162 @@ void window::on_tray(UINT id)
 
 void window::on_tray(UINT id, int x, int y)
 {
-  // Handle the systray icon context menu message.
-  if (auto menu = LoadMenu(instance_, MAKEINTRESOURCE(IDM_MAIN))) {
-    if (auto submenu = GetSubMenu(menu, 0)) {
-      SetForegroundWindow(hwnd_);
-      auto align = (GetSystemMetrics(SM_MENUDROPALIGNMENT) != 0) ? TPM_RIGHTALIGN : TPM_LEFTALIGN;
-      TrackPopupMenuEx(submenu, TPM_RIGHTBUTTON | align, x, y, hwnd_, nullptr);
+  // Show the cached context menu. Lazy submenus are filled when they open.
+  if (auto menu = menu_.handle()) {
+    SetForegroundWindow(hwnd_);
+    auto align = (GetSystemMetrics(SM_MENUDROPALIGNMENT) != 0) ? TPM_RIGHTALIGN : TPM_LEFTALIGN;
+    TrackPopupMenuEx(menu, TPM_RIGHTBUTTON | align, x, y, hwnd_, nullptr);
+  }
+}
+
+void window::on_tray_update()
+{
+  if (!hwnd_) {
+    return;
+  }
+
+  // Wait for the end of the interval or take all fields that changed since the last update.
+  tray_state::update update;
+  std::uint64_t delay = 0;
+  if (!tray_state_.flush(GetTickCount64(), update, delay)) {
+    if (delay) {
+      loop_.timers().schedule(tray_timer_, delay);
     }
-    DestroyMenu(menu);
+    return;
+  }
+
+  // Send only the changed fields to the shell and keep the others for the next NIM_ADD.
+  auto data = tray_;
+  data.uFlags = 0;
+  if (update.changed & tray_state::tray_tip) {
+    copy_field(tray_.szTip, update.tip);
+    copy_field(data.szTip, update.tip);
+    data.uFlags |= NIF_TIP | NIF_SHOWTIP;
+  }
+  if (update.changed & tray_state::tray_icon) {
+    tray_.hIcon = static_cast<HICON>(update.icon);
+    data.hIcon = tray_.hIcon;
+    data.uFlags |= NIF_ICON;
+  }
+  if (update.changed & tray_state::tray_balloon) {
+    static const DWORD types[] = { NIIF_NONE, NIIF_INFO, NIIF_WARNING, NIIF_ERROR };
+    copy_field(data.szInfoTitle, update.title);
+    copy_field(data.szInfo, update.text);
+    data.dwInfoFlags = types[update.type];
+    data.uFlags |= NIF_INFO;
   }
+  Shell_NotifyIcon(NIM_MODIFY, &data);
 }
 
-LRESULT window::handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
-{
-  // Handle windows messages.
-  try {
-    switch (msg) {
-    case WM_CREATE:
-      hwnd_ = hwnd;
-      on_create();
-      return 0;
-    case WM_DESTROY:
-      on_destroy();
-      hwnd_ = nullptr;
-      return 0;
-    case WM_COMMAND:
-      on_command(LOWORD(wparam));
-      return 0;
-    case WM_APP_TRAY:
-      switch (LOWORD(lparam)) {
-      case NIN_SELECT:
-        on_tray(HIWORD(lparam));
-        break;
-      case WM_CONTEXTMENU:
-        on_tray(HIWORD(lparam), GET_X_LPARAM(wparam), GET_Y_LPARAM(wparam));
-        break;
+void window::on_samples()
+{
+  // Add the new samples to the rolling aggregates.
+  process_sample sample;
+  while (sampler_->samples().pop(sample)) {
+    stats_[sample.slot].add(sample);
+  }
+
+  // Show the latest values and the 95th percentiles in the tooltip and raise alerts when a threshold is crossed.
+  std::wstring tip = PROJECT;
+  const auto& pids = sampler_->pids();
+  for (std::size_t i = 0; i < stats_.size(); i++) {
+    const auto& stats = stats_[i];
+    if (!stats.cpu.size()) {
+      continue;
+    }
+    auto cpu = stats.cpu.percentile(95);
+    auto memory = stats.working_set.max() / (1024.0 * 1024.0);
+    wchar_t line[128] = {};
+    std::swprintf(line, 128, L"\n%u: %.0f%% cpu (p95 %.0f%%), %.0f MiB, %.0f handles", pids[i], stats.cpu.mean(), cpu, memory,
+      stats.handles.max());
+    tip += line;
+
+    auto raise = [&](unsigned alert, bool over, bool under, const wchar_t* text) {
+      if (over && !(alerts_[i] & alert)) {
+        alerts_[i] |= alert;
+        notify(PROJECT, L"Process " + std::to_wstring(pids[i]) + text, tray_state::balloon_warning);
+      } else if (under) {
+        alerts_[i] &= ~alert;
       }
-      return 0;
+    };
+    raise(ALERT_CPU, cpu >= SAMPLER_CPU_ALERT, cpu < SAMPLER_CPU_ALERT * 0.9, L" has a high CPU usage.");
+    raise(ALERT_MEMORY, memory >= SAMPLER_MEMORY_ALERT, memory < SAMPLER_MEMORY_ALERT * 0.9, L" has a large working set.");
+  }
+  set_tip(std::move(tip));
+  loop_.timers().schedule(sampler_timer_, SAMPLER_REPORT_INTERVAL);
+}
+
+bool window::on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
+{
+  // Fill lazy submenus of the context menu right before they are shown.
+  if (msg == WM_INITMENUPOPUP) {
+    if (menu_.popup(reinterpret_cast<void*>(wparam))) {
+      result = 0;
+      return true;
     }
+    return false;
+  }
+
+  // Handle systray notifications.
+  if (msg != WM_APP_TRAY) {
+    return false;
   }
-  catch (const std::exception& e) {
-    std::wstring msg;
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0) + 1);
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &msg[0], static_cast<int>(msg.size())));
-    MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
-    DestroyWindow(hwnd);
+  switch (LOWORD(lparam)) {
+  case NIN_SELECT:
+    on_tray(HIWORD(lparam));
+    break;
+  case WM_CONTEXTMENU:
+    on_tray(HIWORD(lparam), GET_X_LPARAM(wparam), GET_Y_LPARAM(wparam));
+    break;
+  }
+  return true;
+}
+
+void window::create_menu()
+{
+  // Show the thread pool statistics in a submenu that is only filled when it opens.
+  workers_menu_.set_filler([this](std::vector<menu_item>& items) {
+    auto stats = pool_.stats();
+    items.resize(stats.size());
+    for (std::size_t i = 0; i < stats.size(); i++) {
+      items[i].key = i + 1;
+      items[i].text = L"Worker " + std::to_wstring(i + 1) + L": " + std::to_wstring(stats[i].executed) + L" tasks, " +
+        std::to_wstring(stats[i].steals) + L" stolen, " + std::to_wstring(stats[i].depth) + L" queued";
+      items[i].flags = menu_disabled;
+    }
+  });
+
+  std::vector<menu_item> items;
+  menu_item workers;
+  workers.key = reinterpret_cast<std::uintptr_t>(&workers_menu_);
+  workers.text = L"&Workers";
+  workers.submenu = &workers_menu_;
+  items.push_back(workers);
+  menu_item separator;
+  separator.flags = menu_separator;
+  items.push_back(separator);
+
+  // Copy the items of the menu resource once.
+  if (auto menu = LoadMenu(instance_, MAKEINTRESOURCE(IDM_MAIN))) {
+    if (auto submenu = GetSubMenu(menu, 0)) {
+      for (int i = 0, count = GetMenuItemCount(submenu); i < count; i++) {
+        wchar_t text[256] = {};
+        MENUITEMINFO mii = {};
+        mii.cbSize = sizeof(mii);
+        mii.fMask = MIIM_FTYPE | MIIM_ID | MIIM_STRING;
+        mii.dwTypeData = text;
+        mii.cch = ARRAYSIZE(text);
+        if (GetMenuItemInfo(submenu, i, TRUE, &mii)) {
+          menu_item item;
+          item.id = mii.wID;
+          item.text = text;
+          item.flags = (mii.fType & MFT_SEPARATOR) ? menu_separator : 0;
+          items.push_back(std::move(item));
+        }
+      }
+    }
+    DestroyMenu(menu);
   }
-  return DefWindowProc(hwnd, msg, wparam, lparam);
+  menu_.set(std::move(items));
+  menu_.update();
 }
@@ -1,10 +1,35 @@
 #pragma once
+#include "event_loop.h"
+#include "menu_model.h"
+#include "process_sampler.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
+#include "tray_state.h"
+#include "window_base.h"
 #include <windows.h>
 #include <shellapi.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
-class window {
+#define WM_APP_TRAY (WM_APP + 1)
+
+class window : public window_base<window> {
 public:
-  window(HINSTANCE instance);
+  window(HINSTANCE instance, event_loop& loop, thread_pool& pool);
+
+  // Updates the systray tooltip, icon or balloon notification. Can be called from any thread.
+  // Updates are coalesced and applied with one NIM_MODIFY at most every TRAY_UPDATE_INTERVAL.
+  void set_tip(std::wstring tip);
+  void set_icon(HICON icon);
+  void notify(std::wstring title, std::wstring text, tray_state::balloon_icon type = tray_state::balloon_info);
+
+  // Samples the resource usage of the processes in the background and shows it in the tooltip.
+  void monitor(std::vector<std::uint32_t> pids);
+
+  // Monitors the process IDs of the last command line that contains any, or this process at startup.
+  void open(const std::vector<std::wstring>& commands);
 
   void on_create();
   void on_destroy();
@@ -12,12 +37,31 @@ public:
 
   void on_tray(UINT id);
   void on_tray(UINT id, int x, int y);
+  void on_tray_update();
+  void on_samples();
+
+  using messages = message_list<WM_INITMENUPOPUP, WM_APP_TRAY>;
+  bool on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result);
 
 private:
-  LRESULT handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+  // Builds the context menu model from the menu resource.
+  void create_menu();
 
   HINSTANCE instance_;
-  HWND hwnd_ = nullptr;
+  event_loop& loop_;
+  thread_pool& pool_;
 
   NOTIFYICONDATA tray_ = {};
+  tray_state tray_state_;
+  timer_wheel::timer tray_timer_;
+
+  // The context menu is built once and patched when the models change.
+  menu_model workers_menu_;
+  menu_model menu_;
+
+  // Rolling aggregates and raised alerts of the monitored processes.
+  std::unique_ptr<process_sampler> sampler_;
+  std::vector<process_stats> stats_;
+  std::vector<unsigned> alerts_;
+  timer_wheel::timer sampler_timer_;
 };
@@ -0,0 +1,56 @@
+#include "menu_model.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <string>
+
+#define ITEM_COUNT    500         // items of a large dynamic menu
+#define UPDATE_COUNT  20000       // updates per run
+
+namespace {
+
+menu_item job(std::uint64_t key, unsigned id, const std::wstring& text)
+{
+  menu_item m;
+  m.key = key;
+  m.id = id;
+  m.text = text;
+  return m;
+}
+
+}  // namespace
+
+int main()
+{
+  std::vector<menu_item> items;
+  for (unsigned i = 0; i < ITEM_COUNT; i++) {
+    items.push_back(job(i + 1, 1000 + i, L"Recent job number " + std::to_wstring(i)));
+  }
+
+  // Toggle, remove and insert one item per update, as a list of recent jobs would.
+  menu_differ differ;
+  auto next = items;
+  std::uint64_t ticks = 0;
+  std::size_t edits = 0;
+  for (unsigned k = 0; k < UPDATE_COUNT; k++) {
+    auto previous = next;
+    next[k % next.size()].flags ^= menu_checked;
+    next.erase(next.begin() + (k * 7) % next.size());
+    next.insert(next.begin() + (k * 13) % next.size(), job(100000 + k, 5000 + k, L"New job " + std::to_wstring(k)));
+    auto start = clock_ticks();
+    edits += differ.diff(previous, next).size();
+    ticks += clock_ticks() - start;
+  }
+  report("menu diff, 3 changes in 500 items", elapsed_ns(0, ticks) / UPDATE_COUNT / 1e3, "us");
+  report("menu edits per update", static_cast<double>(edits) / UPDATE_COUNT, "edits");
+
+  // Reversing the menu is the worst case for the kept run.
+  auto reversed = items;
+  std::reverse(reversed.begin(), reversed.end());
+  auto start = clock_ticks();
+  for (int k = 0; k < UPDATE_COUNT / 10; k++) {
+    differ.diff(items, reversed);
+  }
+  auto end = clock_ticks();
+  report("menu diff, 500 items reversed", elapsed_ns(start, end) / (UPDATE_COUNT / 10) / 1e3, "us");
+  report("menu edits when reversed", static_cast<double>(differ.edits().size()), "edits");
+}
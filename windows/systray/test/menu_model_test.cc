@@ -0,0 +1,151 @@
+#include "menu_model.h"
+#include "check.h"
+#include <random>
+#include <string>
+
+namespace {
+
+menu_item item(unsigned id, const std::wstring& text, unsigned flags = 0)
+{
+  menu_item m;
+  m.id = id;
+  m.text = text;
+  m.flags = flags;
+  return m;
+}
+
+// Replays the edits on the previous list, checks their order and compares the result with the next list.
+void replay(const std::vector<menu_item>& from, const std::vector<menu_item>& to, const std::vector<menu_edit>& edits)
+{
+  auto items = from;
+  auto removing = true;
+  auto last_remove = items.size();
+  std::size_t next_index = 0;
+  for (const auto& edit : edits) {
+    if (edit.kind == menu_edit::remove) {
+      CHECK(removing);
+      CHECK(edit.index < last_remove);
+      last_remove = edit.index;
+      items.erase(items.begin() + edit.index);
+      continue;
+    }
+    removing = false;
+    CHECK(edit.index >= next_index);
+    CHECK(edit.index <= items.size());
+    next_index = edit.index + 1;
+    if (edit.kind == menu_edit::insert) {
+      items.insert(items.begin() + edit.index, to[edit.item]);
+    } else {
+      items[edit.index] = to[edit.item];
+    }
+  }
+  CHECK(items.size() == to.size());
+  for (std::size_t i = 0; i < to.size(); i++) {
+    CHECK(items[i].key == to[i].key);
+    CHECK(items[i].id == to[i].id);
+    CHECK(items[i].text == to[i].text);
+    CHECK(items[i].flags == to[i].flags);
+  }
+}
+
+void test_diff()
+{
+  menu_differ differ;
+  std::vector<menu_item> a = {
+    item(1, L"Open"),
+    item(0, L"", menu_separator),
+    item(2, L"Start"),
+    item(3, L"Stop"),
+    item(0, L"", menu_separator),
+    item(4, L"Exit"),
+  };
+  auto b = a;
+  CHECK(differ.diff(a, b).empty());
+
+  // A changed item is modified in place.
+  b[2].flags = menu_checked;
+  CHECK(differ.diff(a, b).size() == 1);
+  CHECK(differ.edits()[0].kind == menu_edit::modify);
+  CHECK(differ.edits()[0].index == 2);
+
+  // A moved item is removed and inserted, everything else stays.
+  b = { a[5], a[0], a[1], a[2], a[3], a[4] };
+  differ.diff(a, b);
+  replay(a, b, differ.edits());
+  CHECK(differ.edits().size() == 2);
+
+  // Keys take precedence over command IDs.
+  b = a;
+  b[0].key = 100;
+  differ.diff(a, b);
+  replay(a, b, differ.edits());
+  CHECK(differ.edits().size() == 2);
+
+  differ.diff(a, {});
+  replay(a, {}, differ.edits());
+  CHECK(differ.edits().size() == a.size());
+  differ.diff({}, a);
+  replay({}, a, differ.edits());
+  CHECK(differ.edits().size() == a.size());
+}
+
+// Compares random lists with duplicate IDs and checks that a single changed item gives at most one edit.
+void test_random()
+{
+  menu_differ differ;
+  std::mt19937 random(7);
+  for (int round = 0; round < 3000; round++) {
+    std::vector<menu_item> from;
+    std::vector<menu_item> to;
+    auto from_size = random() % 30;
+    auto to_size = random() % 30;
+    for (unsigned i = 0; i < from_size; i++) {
+      from.push_back(item(random() % 20, std::to_wstring(random() % 3), random() % 2 ? static_cast<unsigned>(menu_separator) : 0u));
+    }
+    for (unsigned i = 0; i < to_size; i++) {
+      to.push_back(item(random() % 20, std::to_wstring(random() % 3), random() % 2 ? static_cast<unsigned>(menu_separator) : 0u));
+    }
+    differ.diff(from, to);
+    replay(from, to, differ.edits());
+
+    if (!from.empty()) {
+      auto changed = from;
+      changed[random() % changed.size()].text = L"changed";
+      differ.diff(from, changed);
+      replay(from, changed, differ.edits());
+      CHECK(differ.edits().size() <= 1);
+    }
+  }
+}
+
+void test_model()
+{
+  // Without a native menu the model only tracks the applied items.
+  menu_model model;
+  std::vector<menu_item> items = { item(1, L"Open"), item(2, L"Exit") };
+  model.set(items);
+  CHECK(model.update() == 2);
+  CHECK(model.update() == 0);
+  items[1].flags = menu_disabled;
+  model.set(items);
+  CHECK(model.update() == 1);
+  CHECK(model.items()[1].flags == menu_disabled);
+
+  // Handles that do not belong to the menu tree are not filled.
+  auto filled = false;
+  model.set_filler([&filled](std::vector<menu_item>&) {
+    filled = true;
+  });
+  CHECK(!model.popup(nullptr));
+  CHECK(!model.popup(&filled));
+  CHECK(!filled);
+}
+
+}  // namespace
+
+int main()
+{
+  test_diff();
+  test_random();
+  test_model();
+}
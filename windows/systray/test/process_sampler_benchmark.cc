@@ -0,0 +1,69 @@
+#include "process_sampler.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+#define SAMPLE_COUNT  20000       // /proc samples per run
+#define WINDOW        600         // one minute at 10 Hz
+#define ADD_COUNT     1000000     // aggregated samples per run
+
+int main()
+{
+  // One sample of this process, as the sampling thread takes it.
+  process_sampler sampler({ static_cast<std::uint32_t>(getpid()) }, 100);
+  process_sample sample;
+  auto start = clock_ticks();
+  for (int i = 0; i < SAMPLE_COUNT; i++) {
+    sampler.sample();
+    while (sampler.samples().pop(sample)) {
+    }
+  }
+  auto end = clock_ticks();
+  auto per_sample = elapsed_ns(start, end) / SAMPLE_COUNT;
+  report("process sample", per_sample / 1e3, "us");
+  report("sampling time per second at 10 Hz", per_sample * 10 / 1e3, "us");
+
+  // Aggregation of four metrics per sample.
+  std::mt19937 random(1);
+  std::vector<process_sample> samples(4096);
+  for (auto& s : samples) {
+    s.cpu = random() % 1000 / 10.0;
+    s.io = random() % 100000;
+    s.working_set = 100000000 + random() % 1000000;
+    s.handles = 300 + random() % 20;
+  }
+  process_stats stats(WINDOW);
+  start = clock_ticks();
+  for (int i = 0; i < ADD_COUNT; i++) {
+    stats.add(samples[i & 4095]);
+  }
+  end = clock_ticks();
+  report("aggregate, 4 metrics", elapsed_ns(start, end) / ADD_COUNT, "ns");
+
+  double sum = 0.0;
+  start = clock_ticks();
+  for (int i = 0; i < ADD_COUNT; i++) {
+    sum += stats.cpu.percentile(i % 100);
+  }
+  end = clock_ticks();
+  report("percentile query", elapsed_ns(start, end) / ADD_COUNT, "ns");
+  report("average queried CPU", sum / ADD_COUNT, "%");
+
+  // Compare with sorting a copy of the window for every query, as a tooltip refresh would without the index.
+  std::vector<double> window(WINDOW);
+  std::vector<double> sorted;
+  const int sort_count = ADD_COUNT / 100;
+  double p95 = 0.0;
+  start = clock_ticks();
+  for (int i = 0; i < sort_count; i++) {
+    window[i % WINDOW] = samples[i & 4095].cpu;
+    sorted = window;
+    std::sort(sorted.begin(), sorted.end());
+    p95 += sorted[sorted.size() * 95 / 100];
+  }
+  end = clock_ticks();
+  report("sorted window query", elapsed_ns(start, end) / sort_count, "ns");
+  report("average p95 CPU", p95 / sort_count, "%");
+}
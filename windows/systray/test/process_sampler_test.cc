@@ -0,0 +1,136 @@
+#include "process_sampler.h"
+#include "check.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+// Compares the rolling statistics with a sorted copy of the window after every value.
+void test_rolling_stats()
+{
+  std::mt19937 random(3);
+  for (std::size_t window : { 1, 2, 7, 100 }) {
+    rolling_stats stats(window);
+    std::vector<double> values;
+    for (int i = 0; i < 3000; i++) {
+      // Many duplicates.
+      auto value = static_cast<double>(random() % 50);
+      stats.add(value);
+      values.push_back(value);
+
+      std::vector<double> sorted(values.end() - std::min(window, values.size()), values.end());
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0.0;
+      for (auto v : sorted) {
+        sum += v;
+      }
+      CHECK(stats.size() == sorted.size());
+      CHECK(stats.min() == sorted.front());
+      CHECK(stats.max() == sorted.back());
+      CHECK(std::fabs(stats.mean() - sum / sorted.size()) < 1e-9);
+      for (double p : { 0.0, 50.0, 95.0, 100.0 }) {
+        auto rank = std::min(std::max<std::size_t>(static_cast<std::size_t>(p / 100.0 * sorted.size() + 0.5), 1), sorted.size());
+        CHECK(stats.percentile(p) == sorted[rank - 1]);
+      }
+    }
+  }
+}
+
+void test_ring()
+{
+  // A full ring drops samples.
+  sample_ring ring(4);
+  process_sample sample;
+  std::size_t pushed = 0;
+  for (int i = 0; i < 10; i++) {
+    sample.time = i;
+    pushed += ring.push(sample);
+  }
+  CHECK(pushed >= 4 && pushed < 10);
+  CHECK(ring.dropped() == 10 - pushed);
+  for (std::size_t i = 0; i < pushed; i++) {
+    CHECK(ring.pop(sample));
+    CHECK(sample.time == i);
+  }
+  CHECK(!ring.pop(sample));
+}
+
+void test_ring_threads()
+{
+  // The consumer sees every sample in order.
+  sample_ring ring(64);
+  const std::uint64_t count = 1000000;
+  std::thread producer([&ring, count]() {
+    process_sample sample;
+    for (std::uint64_t i = 0; i < count; i++) {
+      sample.time = i;
+      while (!ring.push(sample)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  process_sample sample;
+  for (std::uint64_t expected = 0; expected < count;) {
+    if (ring.pop(sample)) {
+      CHECK(sample.time == expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+void test_sampler()
+{
+  // Sample this process while a thread spins. Processes that do not exist are skipped.
+  std::atomic<bool> busy = { true };
+  std::thread spin([&busy]() {
+    volatile double x = 0.0;
+    while (busy.load(std::memory_order_relaxed)) {
+      x = x + 1.0;
+    }
+  });
+  process_sampler sampler({ static_cast<std::uint32_t>(getpid()), 999999999u }, 100);
+
+  // The first sample only primes the rates.
+  CHECK(sampler.sample() == 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  CHECK(sampler.sample() == 1);
+  process_sample sample;
+  CHECK(sampler.samples().pop(sample));
+  CHECK(sample.pid == static_cast<std::uint32_t>(getpid()));
+  CHECK(sample.slot == 0);
+  CHECK(sample.cpu > 50.0);
+  CHECK(sample.working_set > 0);
+  CHECK(sample.handles >= 3);
+  busy = false;
+  spin.join();
+
+  // The sampling thread writes samples at the interval.
+  process_sampler background({ static_cast<std::uint32_t>(getpid()) }, 10);
+  background.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  background.stop();
+  int count = 0;
+  while (background.samples().pop(sample)) {
+    count++;
+  }
+  CHECK(count >= 5);
+}
+
+}  // namespace
+
+int main()
+{
+  test_rolling_stats();
+  test_ring();
+  test_ring_threads();
+  test_sampler();
+}
@@ -0,0 +1,90 @@
+#include "tray_state.h"
+#include "benchmark.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define RUN_MS        2000        // milliseconds per run
+#define INTERVAL_MS   250         // flush interval of the systray window
+
+namespace {
+
+std::uint64_t now_ms()
+{
+  return static_cast<std::uint64_t>(elapsed_ns(0, clock_ticks()) / 1e6);
+}
+
+// Producers set the tooltip as fast as they can. The consumer acts like the event loop:
+// it waits for a flush request and for the delay of the rate limit, then applies the update.
+void run(int threads)
+{
+  tray_state state(INTERVAL_MS);
+  std::mutex mutex;
+  std::condition_variable requested;
+  bool request = false;
+  std::atomic<bool> done = { false };
+  std::uint64_t requests = 0;
+
+  std::vector<std::thread> producers;
+  auto start = clock_ticks();
+  for (int i = 0; i < threads; i++) {
+    producers.emplace_back([&, i]() {
+      auto text = L"Progress " + std::to_wstring(i) + L": ";
+      for (std::uint64_t k = 0; !done.load(std::memory_order_relaxed); k++) {
+        if (state.set_tip(text + std::to_wstring(k % 1000))) {
+          std::lock_guard<std::mutex> lock(mutex);
+          request = true;
+          requests++;
+          requested.notify_one();
+        }
+      }
+    });
+  }
+
+  std::uint64_t applied = 0;
+  auto end = now_ms() + RUN_MS;
+  while (now_ms() < end) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      requested.wait_for(lock, std::chrono::milliseconds(10), [&request]() {
+        return request;
+      });
+      request = false;
+    }
+    tray_state::update u;
+    std::uint64_t delay = 0;
+    while (!state.flush(now_ms(), u, delay) && delay) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+    applied += u.changed != 0;
+  }
+  done = true;
+  for (auto& p : producers) {
+    p.join();
+  }
+  auto stop = clock_ticks();
+
+  auto st = state.stats();
+  char name[64] = {};
+  std::snprintf(name, sizeof(name), "tray_state set, %d producers", threads);
+  report(name, elapsed_ns(start, stop) / st.updates, "ns");
+  std::snprintf(name, sizeof(name), "tooltip updates, %d producers", threads);
+  report(name, static_cast<double>(st.updates), "updates");
+  std::snprintf(name, sizeof(name), "shell updates, %d producers", threads);
+  report(name, static_cast<double>(applied), "updates");
+  std::snprintf(name, sizeof(name), "flush requests, %d producers", threads);
+  report(name, static_cast<double>(requests), "wakeups");
+}
+
+}  // namespace
+
+int main()
+{
+  for (int threads : { 1, 4 }) {
+    run(threads);
+  }
+}
@@ -0,0 +1,130 @@
+#include "tray_state.h"
+#include "check.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void test_coalescing()
+{
+  tray_state s(100);
+  tray_state::update u;
+  std::uint64_t delay = 0;
+  CHECK(!s.flush(0, u, delay) && delay == 0);
+
+  // Only the first change asks for a flush and the latest value wins.
+  CHECK(s.set_tip(L"a"));
+  CHECK(!s.set_tip(L"b"));
+  CHECK(!s.set_icon(reinterpret_cast<void*>(1)));
+  CHECK(s.flush(1000, u, delay));
+  CHECK(u.changed == (tray_state::tray_tip | tray_state::tray_icon));
+  CHECK(u.tip == L"b");
+  CHECK(u.icon == reinterpret_cast<void*>(1));
+  CHECK(s.stats().coalesced == 1);
+
+  // A value equal to the applied value is ignored.
+  CHECK(!s.set_tip(L"b"));
+  CHECK(!s.set_icon(reinterpret_cast<void*>(1)));
+  CHECK(s.stats().coalesced == 3);
+  CHECK(!s.flush(2000, u, delay) && delay == 0);
+}
+
+void test_rate_limit()
+{
+  tray_state s(100);
+  tray_state::update u;
+  std::uint64_t delay = 0;
+  CHECK(s.set_tip(L"a"));
+  CHECK(s.flush(1000, u, delay));
+
+  // Changes inside the interval wait for its end.
+  CHECK(s.set_tip(L"b"));
+  CHECK(!s.flush(1050, u, delay) && delay == 50);
+  CHECK(!s.set_balloon(L"title", L"text", tray_state::balloon_warning));
+  CHECK(s.flush(1100, u, delay));
+  CHECK(u.changed == (tray_state::tray_tip | tray_state::tray_balloon));
+  CHECK(u.tip == L"b");
+  CHECK(u.title == L"title" && u.text == L"text" && u.type == tray_state::balloon_warning);
+
+  // Balloons are events and are shown even if they repeat.
+  CHECK(s.set_balloon(L"title", L"text", tray_state::balloon_warning));
+  CHECK(s.flush(1200, u, delay));
+  CHECK(u.changed == tray_state::tray_balloon);
+}
+
+void test_revert()
+{
+  // A value that is set back to the applied value while it is pending is not applied.
+  tray_state s(100);
+  tray_state::update u;
+  std::uint64_t delay = 0;
+  CHECK(s.set_tip(L"a"));
+  CHECK(s.flush(1000, u, delay));
+  CHECK(s.set_tip(L"b"));
+  CHECK(!s.set_tip(L"a"));
+  CHECK(!s.flush(1300, u, delay) && delay == 0);
+
+  // The next change asks for a flush again.
+  CHECK(s.set_icon(reinterpret_cast<void*>(2)));
+  CHECK(s.flush(1300, u, delay));
+  CHECK(u.changed == tray_state::tray_icon);
+  auto st = s.stats();
+  CHECK(st.updates == 4);
+  CHECK(st.coalesced == 2);
+  CHECK(st.flushes == 2);
+}
+
+void test_threads()
+{
+  // Four producers and a consumer that flushes whenever it is asked to, with one millisecond per iteration.
+  tray_state s(10);
+  std::atomic<int> requests = { 0 };
+  std::atomic<bool> done = { false };
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; i++) {
+    producers.emplace_back([&s, &requests, i]() {
+      for (int k = 0; k < 100000; k++) {
+        if (s.set_tip(std::to_wstring(i * 1000000 + k))) {
+          requests++;
+        }
+      }
+    });
+  }
+  std::uint64_t now = 0;
+  std::thread consumer([&]() {
+    while (!done) {
+      tray_state::update u;
+      std::uint64_t delay = 0;
+      s.flush(now++, u, delay);
+      std::this_thread::yield();
+    }
+  });
+  for (auto& p : producers) {
+    p.join();
+  }
+  done = true;
+  consumer.join();
+
+  // Flush the rest and check that every update was applied or coalesced.
+  tray_state::update u;
+  std::uint64_t delay = 0;
+  while (!s.flush(now, u, delay) && delay) {
+    now += delay;
+  }
+  auto st = s.stats();
+  CHECK(st.updates == 400000);
+  CHECK(st.updates - st.coalesced == st.flushes);
+  CHECK(static_cast<std::uint64_t>(requests) >= st.flushes);
+}
+
+}  // namespace
+
+int main()
+{
+  test_coalescing();
+  test_rate_limit();
+  test_revert();
+  test_threads();
+}
@@ -8,3 +8,5 @@
 
 #define IDM_MAIN 102
 #define IDM_EXIT 103
+#define IDM_PROFILE 105
+#define IDM_TRACE 106
@@ -0,0 +1,57 @@
+#include "back_buffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+back_buffer::~back_buffer()
+{
+  reset();
+}
+
+bool back_buffer::resize(HDC reference, int cx, int cy)
+{
+  if (dc_ && cx <= cx_ && cy <= cy_) {
+    return false;
+  }
+
+  // Grow by at least half of the current size to keep the number of reallocations low.
+  auto width = std::max(cx, cx_ + cx_ / 2);
+  auto height = std::max(cy, cy_ + cy_ / 2);
+  reset();
+
+  dc_ = CreateCompatibleDC(reference);
+  if (!dc_) {
+    throw std::runtime_error("Could not create the back buffer device context.");
+  }
+  bitmap_ = CreateCompatibleBitmap(reference, std::max(width, 1), std::max(height, 1));
+  if (!bitmap_) {
+    reset();
+    throw std::runtime_error("Could not create the back buffer bitmap.");
+  }
+  original_ = SelectObject(dc_, bitmap_);
+  cx_ = width;
+  cy_ = height;
+  return true;
+}
+
+void back_buffer::reset()
+{
+  if (dc_) {
+    if (original_) {
+      SelectObject(dc_, original_);
+    }
+    DeleteDC(dc_);
+  }
+  if (bitmap_) {
+    DeleteObject(bitmap_);
+  }
+  dc_ = nullptr;
+  bitmap_ = nullptr;
+  original_ = nullptr;
+  cx_ = 0;
+  cy_ = 0;
+}
+
+void back_buffer::blit(HDC target, const dirty_rect& rc) const
+{
+  BitBlt(target, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, dc_, rc.left, rc.top, SRCCOPY);
+}
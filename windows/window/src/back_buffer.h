@@ -0,0 +1,37 @@
+#pragma once
+#include "dirty_region.h"
+#include <windows.h>
+
+// Persistent off-screen bitmap that the window renders into. The bitmap grows geometrically
+// and is not shrunk, so that a live resize does not allocate a new bitmap for every size.
+class back_buffer {
+public:
+  back_buffer() = default;
+  ~back_buffer();
+
+  back_buffer(const back_buffer& other) = delete;
+  back_buffer& operator=(const back_buffer& other) = delete;
+
+  // Makes the bitmap at least as large as the given size. Returns true if a new bitmap was created
+  // and its contents must be rendered again. Throws on failure.
+  bool resize(HDC reference, int cx, int cy);
+
+  // Releases the bitmap.
+  void reset();
+
+  // Returns the memory device context with the bitmap selected.
+  HDC dc() const
+  {
+    return dc_;
+  }
+
+  // Copies a rectangle of the bitmap to the same position in the target.
+  void blit(HDC target, const dirty_rect& rc) const;
+
+private:
+  HDC dc_ = nullptr;
+  HBITMAP bitmap_ = nullptr;
+  HGDIOBJ original_ = nullptr;
+  int cx_ = 0;
+  int cy_ = 0;
+};
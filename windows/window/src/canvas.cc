@@ -0,0 +1,206 @@
+#include "canvas.h"
+#include "raster.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+#define CANVAS_PARALLEL_PIXELS (1 << 18)  // minimum number of pixels that are split into bands
+
+canvas::canvas(thread_pool* pool) : pool_(pool)
+{}
+
+canvas::~canvas()
+{
+  reset();
+}
+
+bool canvas::resize(int cx, int cy)
+{
+  cx = std::max(cx, 1);
+  cy = std::max(cy, 1);
+  auto allocated = false;
+  if (!pixels_ || cx > capacity_width_ || cy > capacity_height_) {
+    // Grow by at least half of the current size to keep the number of reallocations low.
+    auto width = std::max(cx, capacity_width_ + capacity_width_ / 2);
+    auto height = std::max(cy, capacity_height_ + capacity_height_ / 2);
+    reset();
+#ifdef _WIN32
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+    bi.bmiHeader.biWidth = width;
+    bi.bmiHeader.biHeight = -height;
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    dc_ = CreateCompatibleDC(nullptr);
+    bitmap_ = dc_ ? CreateDIBSection(dc_, &bi, DIB_RGB_COLORS, &bits, nullptr, 0) : nullptr;
+    if (!bitmap_) {
+      reset();
+      throw std::runtime_error("Could not create the canvas bitmap.");
+    }
+    original_ = SelectObject(dc_, bitmap_);
+    pixels_ = static_cast<std::uint32_t*>(bits);
+#else
+    storage_.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+    pixels_ = storage_.data();
+#endif
+    stride_ = width;
+    capacity_width_ = width;
+    capacity_height_ = height;
+    allocated = true;
+  }
+  width_ = cx;
+  height_ = cy;
+  clip_ = { 0, 0, width_, height_ };
+  return allocated;
+}
+
+void canvas::reset()
+{
+#ifdef _WIN32
+  if (dc_) {
+    if (original_) {
+      SelectObject(dc_, original_);
+    }
+    DeleteDC(dc_);
+  }
+  if (bitmap_) {
+    DeleteObject(bitmap_);
+  }
+  dc_ = nullptr;
+  bitmap_ = nullptr;
+  original_ = nullptr;
+#else
+  storage_.clear();
+  storage_.shrink_to_fit();
+#endif
+  pixels_ = nullptr;
+  stride_ = 0;
+  width_ = 0;
+  height_ = 0;
+  capacity_width_ = 0;
+  capacity_height_ = 0;
+  clip_ = {};
+}
+
+void canvas::clip(const dirty_rect& rc)
+{
+  clip_.left = std::max(rc.left, 0);
+  clip_.top = std::max(rc.top, 0);
+  clip_.right = std::min(rc.right, width_);
+  clip_.bottom = std::min(rc.bottom, height_);
+}
+
+template <typename Function>
+void canvas::rows(int top, int bottom, int width, Function function)
+{
+  auto bands = pool_ ? static_cast<int>(pool_->size()) + 1 : 1;
+  bands = std::min(bands, bottom - top);
+  if (bands < 2 || static_cast<std::int64_t>(bottom - top) * width < CANVAS_PARALLEL_PIXELS) {
+    function(top, bottom);
+    return;
+  }
+
+  // Run all bands but the last one on the pool and wait for them.
+  struct state {
+    std::mutex mutex;
+    std::condition_variable done;
+    int pending = 0;
+  } s;
+  s.pending = bands - 1;
+  auto height = (bottom - top + bands - 1) / bands;
+  for (auto i = 0; i < bands - 1; i++) {
+    auto y0 = top + i * height;
+    auto y1 = std::min(bottom, y0 + height);
+    pool_->submit([&s, &function, y0, y1]() {
+      function(y0, y1);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (!--s.pending) {
+        s.done.notify_one();
+      }
+    });
+  }
+  function(std::min(bottom, top + (bands - 1) * height), bottom);
+  std::unique_lock<std::mutex> lock(s.mutex);
+  s.done.wait(lock, [&s]() {
+    return !s.pending;
+  });
+}
+
+void canvas::fill(const dirty_rect& rc, std::uint32_t color)
+{
+  auto left = std::max(rc.left, clip_.left);
+  auto top = std::max(rc.top, clip_.top);
+  auto right = std::min(rc.right, clip_.right);
+  auto bottom = std::min(rc.bottom, clip_.bottom);
+  if (left >= right || top >= bottom || !(color >> 24)) {
+    return;
+  }
+
+  // Opaque colors overwrite the pixels, translucent colors are blended.
+  auto count = static_cast<std::size_t>(right - left);
+  auto opaque = (color >> 24) == 0xFF;
+  auto value = raster_premultiply(color);
+  rows(top, bottom, right - left, [this, left, count, opaque, value](int y0, int y1) {
+    for (auto y = y0; y < y1; y++) {
+      if (opaque) {
+        raster_fill(row(y) + left, count, value);
+      } else {
+        raster_blend(row(y) + left, count, value);
+      }
+    }
+  });
+}
+
+void canvas::hline(int x0, int x1, int y, std::uint32_t color)
+{
+  fill({ std::min(x0, x1), y, std::max(x0, x1) + 1, y + 1 }, color);
+}
+
+void canvas::vline(int x, int y0, int y1, std::uint32_t color)
+{
+  auto top = std::max(std::min(y0, y1), clip_.top);
+  auto bottom = std::min(std::max(y0, y1) + 1, clip_.bottom);
+  if (x < clip_.left || x >= clip_.right || top >= bottom || !(color >> 24)) {
+    return;
+  }
+
+  // Columns are strided, so every pixel is blended on its own.
+  auto value = raster_premultiply(color);
+  auto opaque = (color >> 24) == 0xFF;
+  for (auto y = top; y < bottom; y++) {
+    if (opaque) {
+      row(y)[x] = value;
+    } else {
+      raster_blend(row(y) + x, 1, value);
+    }
+  }
+}
+
+void canvas::draw(const canvas_image& image, int x, int y)
+{
+  auto left = std::max(x, clip_.left);
+  auto top = std::max(y, clip_.top);
+  auto right = std::min(x + image.width, clip_.right);
+  auto bottom = std::min(y + image.height, clip_.bottom);
+  if (left >= right || top >= bottom) {
+    return;
+  }
+
+  auto count = static_cast<std::size_t>(right - left);
+  rows(top, bottom, right - left, [this, &image, x, y, left, count](int y0, int y1) {
+    for (auto dy = y0; dy < y1; dy++) {
+      raster_blend(row(dy) + left, image.pixels + (dy - y) * image.stride + (left - x), count);
+    }
+  });
+}
+
+#ifdef _WIN32
+void canvas::blit(HDC target, const dirty_rect& rc) const
+{
+  BitBlt(target, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, dc_, rc.left, rc.top, SRCCOPY);
+}
+#endif
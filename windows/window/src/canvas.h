@@ -0,0 +1,96 @@
+#pragma once
+#include "dirty_region.h"
+#include "thread_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Image in 32-bit premultiplied BGRA pixels. The stride is the distance between rows in pixels.
+struct canvas_image {
+  const std::uint32_t* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  std::ptrdiff_t stride = 0;
+};
+
+// Software raster canvas. On Windows the pixels live in a DIB section that is presented with a single BitBlt.
+// Operations are clipped to the clip rectangle. Large operations are split into horizontal bands that
+// run on the thread pool, so drawing must not happen on a pool worker. Colors are straight alpha 0xAARRGGBB values.
+class canvas {
+public:
+  explicit canvas(thread_pool* pool = nullptr);
+  ~canvas();
+
+  canvas(const canvas& other) = delete;
+  canvas& operator=(const canvas& other) = delete;
+
+  // Makes the canvas at least as large as the given size. The storage grows geometrically.
+  // Returns true if new storage was allocated and its contents must be rendered again. Throws on failure.
+  bool resize(int cx, int cy);
+
+  // Releases the storage.
+  void reset();
+
+  int width() const
+  {
+    return width_;
+  }
+
+  int height() const
+  {
+    return height_;
+  }
+
+  std::uint32_t* row(int y)
+  {
+    return pixels_ + y * stride_;
+  }
+
+  // Restricts the operations to a rectangle. The clip rectangle is reset by resize.
+  void clip(const dirty_rect& rc);
+
+  void fill(const dirty_rect& rc, std::uint32_t color);
+  void hline(int x0, int x1, int y, std::uint32_t color);
+  void vline(int x, int y0, int y1, std::uint32_t color);
+
+  // Blends an image with its top left corner at the given position.
+  void draw(const canvas_image& image, int x, int y);
+
+#ifdef _WIN32
+  // Returns the memory device context with the DIB section selected.
+  HDC dc() const
+  {
+    return dc_;
+  }
+
+  // Copies a rectangle of the canvas to the same position in the target.
+  void blit(HDC target, const dirty_rect& rc) const;
+#endif
+
+private:
+  // Runs the function for the rows in [top, bottom) and splits them into bands on the pool
+  // when the area is large enough.
+  template <typename Function>
+  void rows(int top, int bottom, int width, Function function);
+
+  thread_pool* pool_;
+  std::uint32_t* pixels_ = nullptr;
+  std::ptrdiff_t stride_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  int capacity_width_ = 0;
+  int capacity_height_ = 0;
+  dirty_rect clip_;
+
+#ifdef _WIN32
+  HDC dc_ = nullptr;
+  HBITMAP bitmap_ = nullptr;
+  HGDIOBJ original_ = nullptr;
+#else
+  std::vector<std::uint32_t> storage_;
+#endif
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+// Returns a monotonic timestamp of the high-resolution performance counter.
+inline std::uint64_t clock_ticks()
+{
+#ifdef _WIN32
+  LARGE_INTEGER counter = {};
+  QueryPerformanceCounter(&counter);
+  return static_cast<std::uint64_t>(counter.QuadPart);
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Returns the number of performance counter ticks per second.
+inline double clock_frequency()
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency = {};
+  QueryPerformanceFrequency(&frequency);
+  return static_cast<double>(frequency.QuadPart);
+#else
+  return 1e9;
+#endif
+}
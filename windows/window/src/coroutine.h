@@ -0,0 +1,189 @@
+#pragma once
+#ifdef __cpp_impl_coroutine
+#include "thread_pool.h"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#ifdef _WIN32
+#include "event_loop.h"
+#include <windows.h>
+#include <chrono>
+#include <cstdint>
+#endif
+
+// Allocates coroutine frames from per-thread free lists of 64 byte size classes.
+// Frames can be released on a different thread than the one that allocated them.
+namespace coroutine_frames {
+
+void* allocate(std::size_t size);
+void deallocate(void* frame, std::size_t size);
+
+}  // namespace coroutine_frames
+
+// Return type of coroutines that start immediately and destroy themselves when they finish.
+// Unhandled exceptions are passed to the error handler.
+class async {
+public:
+  using error_handler = void (*)(std::exception_ptr e, void* context);
+
+  struct promise_type {
+    async get_return_object() noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never initial_suspend() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never final_suspend() const noexcept
+    {
+      return {};
+    }
+
+    void return_void() const noexcept
+    {}
+
+    void unhandled_exception() const noexcept
+    {
+      async::report(std::current_exception());
+    }
+
+    static void* operator new(std::size_t size)
+    {
+      return coroutine_frames::allocate(size);
+    }
+
+    static void operator delete(void* frame, std::size_t size)
+    {
+      coroutine_frames::deallocate(frame, size);
+    }
+  };
+
+  // Sets the handler for exceptions that escape a coroutine. Terminates the process if no handler is set.
+  static void set_error_handler(error_handler handler, void* context);
+
+private:
+  static void report(std::exception_ptr e) noexcept;
+};
+
+// Resumes the coroutine on a worker of the thread pool.
+inline auto resume_background(thread_pool& pool)
+{
+  struct awaiter {
+    thread_pool& pool;
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      pool.submit([h]() {
+        h.resume();
+      });
+    }
+
+    void await_resume() const noexcept
+    {}
+  };
+  return awaiter{ pool };
+}
+
+// Resumes the coroutine with a function that schedules a task, such as the post method of a task queue.
+template <typename Post>
+auto resume_on(Post post)
+{
+  struct awaiter {
+    Post post;
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      post([h]() {
+        h.resume();
+      });
+    }
+
+    void await_resume() const noexcept
+    {}
+  };
+  return awaiter{ std::move(post) };
+}
+
+#ifdef _WIN32
+
+// Resumes the coroutine on the event loop thread.
+inline auto resume_on_ui(event_loop& loop)
+{
+  return resume_on([&loop](thread_pool::task t) {
+    loop.post(std::move(t));
+  });
+}
+
+// Resumes the coroutine on the event loop thread once the handle is signaled.
+// Must be awaited on the event loop thread.
+inline auto resume_on_signal(event_loop& loop, HANDLE handle)
+{
+  struct awaiter {
+    event_loop& loop;
+    HANDLE handle;
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      loop.add(handle, [this, h]() {
+        loop.remove(handle);
+        h.resume();
+      });
+    }
+
+    void await_resume() const noexcept
+    {}
+  };
+  return awaiter{ loop, handle };
+}
+
+// Resumes the coroutine on the event loop thread after the given duration.
+// Must be awaited on the event loop thread.
+inline auto resume_after(event_loop& loop, std::chrono::milliseconds duration)
+{
+  struct awaiter {
+    event_loop& loop;
+    std::chrono::milliseconds duration;
+    timer_wheel::timer timer;
+
+    bool await_ready() const noexcept
+    {
+      return duration.count() <= 0;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      // The timer lives in the coroutine frame and is cancelled if the coroutine is destroyed.
+      timer.bind([](void* address) {
+        std::coroutine_handle<>::from_address(address).resume();
+      }, h.address());
+      loop.timers().schedule(timer, static_cast<std::uint64_t>(duration.count()));
+    }
+
+    void await_resume() const noexcept
+    {}
+  };
+  return awaiter{ loop, duration };
+}
+
+#endif
+#endif
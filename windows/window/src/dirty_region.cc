@@ -0,0 +1,83 @@
+#include "dirty_region.h"
+#include <algorithm>
+
+namespace {
+
+bool touches(const dirty_rect& a, const dirty_rect& b)
+{
+  return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+bool contains(const dirty_rect& a, const dirty_rect& b)
+{
+  return a.left <= b.left && a.top <= b.top && a.right >= b.right && a.bottom >= b.bottom;
+}
+
+dirty_rect unite(const dirty_rect& a, const dirty_rect& b)
+{
+  dirty_rect rc;
+  rc.left = std::min(a.left, b.left);
+  rc.top = std::min(a.top, b.top);
+  rc.right = std::max(a.right, b.right);
+  rc.bottom = std::max(a.bottom, b.bottom);
+  return rc;
+}
+
+}  // namespace
+
+dirty_region::dirty_region(std::size_t max_rects) : max_rects_(std::max<std::size_t>(max_rects, 1))
+{
+  rects_.reserve(max_rects_ + 1);
+}
+
+void dirty_region::set_bounds(int width, int height)
+{
+  width_ = width;
+  height_ = height;
+}
+
+void dirty_region::add(dirty_rect rc)
+{
+  // Clip the rectangle to the bounds.
+  rc.left = std::max(rc.left, 0);
+  rc.top = std::max(rc.top, 0);
+  rc.right = std::min(rc.right, width_);
+  rc.bottom = std::min(rc.bottom, height_);
+  if (rc.empty()) {
+    return;
+  }
+
+  // Absorb the rectangles that touch the new one until it is disjoint from the rest.
+  for (std::size_t i = 0; i < rects_.size();) {
+    if (contains(rects_[i], rc)) {
+      return;
+    }
+    if (touches(rects_[i], rc)) {
+      rc = unite(rects_[i], rc);
+      rects_[i] = rects_.back();
+      rects_.pop_back();
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+  rects_.push_back(rc);
+
+  // Collapse the region when blitting many small rectangles costs more than a larger one.
+  if (rects_.size() > max_rects_) {
+    auto bounds = rects_[0];
+    for (const auto& r : rects_) {
+      bounds = unite(bounds, r);
+    }
+    rects_.assign(1, bounds);
+  }
+}
+
+std::uint64_t dirty_region::pixels() const
+{
+  std::uint64_t pixels = 0;
+  for (const auto& rc : rects_) {
+    pixels += rc.area();
+  }
+  return pixels;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct dirty_rect {
+  int left = 0;
+  int top = 0;
+  int right = 0;
+  int bottom = 0;
+
+  bool empty() const
+  {
+    return right <= left || bottom <= top;
+  }
+
+  std::uint64_t area() const
+  {
+    return empty() ? 0 : static_cast<std::uint64_t>(right - left) * static_cast<std::uint64_t>(bottom - top);
+  }
+};
+
+// Set of disjoint rectangles that need to be repainted. Overlapping and adjacent invalidations are merged
+// into their bounding rectangle. When there are too many rectangles, they collapse into a single one.
+class dirty_region {
+public:
+  explicit dirty_region(std::size_t max_rects = 8);
+
+  // Limits the region to the given size. Rectangles outside of it are clipped when they are added.
+  void set_bounds(int width, int height);
+
+  // Adds a rectangle to the region.
+  void add(dirty_rect rc);
+
+  void clear()
+  {
+    rects_.clear();
+  }
+
+  bool empty() const
+  {
+    return rects_.empty();
+  }
+
+  const std::vector<dirty_rect>& rects() const
+  {
+    return rects_;
+  }
+
+  // Returns the number of pixels in the region.
+  std::uint64_t pixels() const;
+
+private:
+  std::vector<dirty_rect> rects_;
+  std::size_t max_rects_;
+  int width_ = 0;
+  int height_ = 0;
+};
@@ -0,0 +1,151 @@
+#include "event_loop.h"
+#include "utf.h"
+#include <resource.h>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Loop that owns the thread timer. Thread timers only pass their id to the callback.
+event_loop* timer_loop = nullptr;
+
+}  // namespace
+
+event_loop::event_loop() : timers_(GetTickCount64())
+{
+  wake_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  if (!wake_) {
+    throw std::runtime_error("Could not create the event loop wake event.");
+  }
+  handles_.push_back(wake_);
+  handlers_.push_back(nullptr);
+}
+
+event_loop::~event_loop()
+{
+  if (timer_) {
+    KillTimer(nullptr, timer_);
+  }
+  if (timer_loop == this) {
+    timer_loop = nullptr;
+  }
+  CloseHandle(wake_);
+}
+
+void event_loop::add(HANDLE handle, handler h)
+{
+  if (handles_.size() >= MAXIMUM_WAIT_OBJECTS - 1) {
+    throw std::runtime_error("Too many handles in the event loop.");
+  }
+  handles_.push_back(handle);
+  handlers_.push_back(std::move(h));
+}
+
+void event_loop::remove(HANDLE handle)
+{
+  for (std::size_t i = 1; i < handles_.size(); i++) {
+    if (handles_[i] == handle) {
+      handles_.erase(handles_.begin() + i);
+      handlers_.erase(handlers_.begin() + i);
+      return;
+    }
+  }
+}
+
+void event_loop::post(task_queue::task t)
+{
+  // Only wake up the loop once per batch.
+  if (tasks_.post(std::move(t))) {
+    SetEvent(wake_);
+  }
+}
+
+int event_loop::run()
+{
+  timer_loop = this;
+  for (;;) {
+    try {
+      // Run the posted tasks on every iteration so that a flood of messages can not starve them.
+      tasks_.run();
+
+      // Call the expired timers and wait until the next one is due.
+      advance();
+      auto timeout = timers_.timeout();
+      auto wait = timeout < INFINITE ? static_cast<DWORD>(timeout) : INFINITE;
+
+      auto count = static_cast<DWORD>(handles_.size());
+      auto result = MsgWaitForMultipleObjectsEx(count, handles_.data(), wait, QS_ALLINPUT, MWMO_ALERTABLE | MWMO_INPUTAVAILABLE);
+      if (result == WAIT_OBJECT_0 + count) {
+        // Dispatch all queued messages.
+        MSG msg = {};
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+          if (msg.message == WM_QUIT) {
+            return static_cast<int>(msg.wParam);
+          }
+          TranslateMessage(&msg);
+          DispatchMessage(&msg);
+        }
+      } else if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + count) {
+        // Copy the handler in case it removes itself.
+        auto h = handlers_[result - WAIT_OBJECT_0];
+        h();
+      } else if (result > WAIT_ABANDONED_0 && result < WAIT_ABANDONED_0 + count) {
+        auto h = handlers_[result - WAIT_ABANDONED_0];
+        h();
+      } else if (result == WAIT_FAILED) {
+        // Do not spin on a handle that was closed while it was registered.
+        MessageBox(nullptr, L"Could not wait for the event loop handles.", PROJECT, MB_OK | MB_ICONERROR);
+        return 1;
+      }
+    }
+    catch (const std::exception& e) {
+      std::wstring msg;
+      utf8_to_utf16(e.what(), msg);
+      MessageBox(nullptr, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
+    }
+  }
+}
+
+void CALLBACK event_loop::on_timer(HWND, UINT, UINT_PTR id, DWORD)
+{
+  // Exceptions must not unwind through DispatchMessage.
+  try {
+    if (timer_loop && timer_loop->timer_ == id) {
+      // The timer can fire before the tick it is due at. Always set it again.
+      timer_loop->timer_due_ = 0;
+      timer_loop->advance();
+    }
+  }
+  catch (const std::exception& e) {
+    std::wstring msg;
+    utf8_to_utf16(e.what(), msg);
+    MessageBox(nullptr, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
+  }
+}
+
+void event_loop::advance()
+{
+  auto now = GetTickCount64();
+  timers_.advance(now);
+
+  // The thread timer only matters while a modal loop runs, but it is cheaper to keep it
+  // set than to detect modal loops. Only call into the system when the due tick changes.
+  auto timeout = timers_.timeout();
+  auto due = timeout < UINT64_MAX ? now + timeout : UINT64_MAX;
+  if (due == timer_due_) {
+    return;
+  }
+  if (due == UINT64_MAX) {
+    KillTimer(nullptr, timer_);
+    timer_ = 0;
+  } else {
+    auto delay = timeout < USER_TIMER_MAXIMUM ? static_cast<UINT>(timeout) : USER_TIMER_MAXIMUM;
+    timer_ = SetTimer(nullptr, timer_, delay, on_timer);
+    if (!timer_) {
+      throw std::runtime_error("Could not set the event loop timer.");
+    }
+  }
+  timer_due_ = due;
+}
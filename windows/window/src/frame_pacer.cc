@@ -0,0 +1,103 @@
+#include "frame_pacer.h"
+#include <algorithm>
+
+#define FRAME_PACER_TOLERANCE 0.0005  // seconds before a deadline that are close enough to render
+
+frame_pacer::frame_pacer(double fps, double frequency, std::size_t history) :
+  frequency_(frequency), period_(static_cast<std::uint64_t>(frequency / fps)),
+  tolerance_(static_cast<std::uint64_t>(frequency * FRAME_PACER_TOLERANCE)), history_(std::max<std::size_t>(history, 1))
+{}
+
+void frame_pacer::start(std::uint64_t now)
+{
+  deadline_ = now;
+  last_ = 0;
+}
+
+std::uint64_t frame_pacer::sleep(std::uint64_t now)
+{
+  // Wake up early by the expected oversleep and render when the rest is within the tolerance
+  // instead of spinning towards the deadline.
+  wake_ = 0;
+  if (now + tolerance_ >= deadline_) {
+    return 0;
+  }
+  auto remaining = deadline_ - now;
+  if (remaining <= oversleep_ + tolerance_) {
+    return 0;
+  }
+  auto duration = remaining - oversleep_;
+  wake_ = now + duration;
+  return duration;
+}
+
+void frame_pacer::woke(std::uint64_t now)
+{
+  if (!wake_) {
+    return;
+  }
+
+  // Track the oversleep as a moving average that reacts faster to increases than to decreases.
+  auto late = now > wake_ ? now - wake_ : 0;
+  if (late > oversleep_) {
+    oversleep_ += (late - oversleep_) / 2;
+  } else {
+    oversleep_ -= (oversleep_ - late) / 8;
+  }
+  oversleep_ = std::min(oversleep_, period_ / 2);
+  wake_ = 0;
+}
+
+void frame_pacer::frame(std::uint64_t now)
+{
+  if (last_) {
+    history_[next_] = now - last_;
+    next_ = (next_ + 1) % history_.size();
+    count_ = std::min(count_ + 1, history_.size());
+  }
+  last_ = now;
+  frames_++;
+  advance(now);
+}
+
+void frame_pacer::skip(std::uint64_t now)
+{
+  // Do not count the time while the window was hidden as a frame time.
+  last_ = 0;
+  skipped_++;
+  advance(now);
+}
+
+void frame_pacer::advance(std::uint64_t now)
+{
+  // Keep the phase of the deadlines unless a whole period was missed.
+  deadline_ += period_;
+  if (deadline_ + tolerance_ <= now) {
+    missed_ += (now - deadline_) / period_ + 1;
+    deadline_ = now + period_;
+  }
+}
+
+frame_pacer::statistics frame_pacer::stats() const
+{
+  statistics s;
+  s.frames = frames_;
+  s.missed = missed_;
+  s.skipped = skipped_;
+  if (!count_) {
+    return s;
+  }
+
+  std::vector<std::uint64_t> times(history_.begin(), history_.begin() + count_);
+  auto scale = 1e3 / frequency_;
+  auto percentile = [&times, scale](double p) {
+    auto n = std::min(times.size() - 1, static_cast<std::size_t>(p * times.size()));
+    std::nth_element(times.begin(), times.begin() + n, times.end());
+    return times[n] * scale;
+  };
+  s.p50 = percentile(0.50);
+  s.p95 = percentile(0.95);
+  s.p99 = percentile(0.99);
+  s.max = *std::max_element(times.begin(), times.end()) * scale;
+  return s;
+}
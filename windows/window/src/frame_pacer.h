@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Paces a continuous render loop at a target frame rate. The caller sleeps for the returned durations
+// and reports when it woke up and when it rendered. Timestamps are clock ticks at the given frequency,
+// so the controller can be driven by a simulated clock.
+class frame_pacer {
+public:
+  struct statistics {
+    double p50 = 0.0;  // frame time percentiles in milliseconds
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    std::uint64_t frames = 0;   // rendered frames
+    std::uint64_t missed = 0;   // deadlines that passed before a frame was rendered
+    std::uint64_t skipped = 0;  // frames that were not rendered because the window was hidden
+  };
+
+  frame_pacer(double fps, double frequency, std::size_t history = 256);
+
+  // Sets the first frame deadline.
+  void start(std::uint64_t now);
+
+  // Returns the number of ticks to sleep before the next frame. The sleep ends early by the amount that
+  // past sleeps overslept. Returns zero when the frame should be rendered now.
+  std::uint64_t sleep(std::uint64_t now);
+
+  // Records the end of a sleep and updates the oversleep estimate.
+  void woke(std::uint64_t now);
+
+  // Records a rendered frame that started at the given time and advances the deadline.
+  void frame(std::uint64_t now);
+
+  // Advances the deadline without rendering a frame.
+  void skip(std::uint64_t now);
+
+  // Returns the statistics of the frames in the history.
+  statistics stats() const;
+
+  std::uint64_t period() const
+  {
+    return period_;
+  }
+
+  std::uint64_t oversleep() const
+  {
+    return oversleep_;
+  }
+
+private:
+  void advance(std::uint64_t now);
+
+  double frequency_;
+  std::uint64_t period_;
+  std::uint64_t tolerance_;
+  std::uint64_t deadline_ = 0;
+  std::uint64_t wake_ = 0;
+  std::uint64_t oversleep_ = 0;
+  std::uint64_t last_ = 0;
+
+  std::vector<std::uint64_t> history_;
+  std::size_t next_ = 0;
+  std::size_t count_ = 0;
+  std::uint64_t frames_ = 0;
+  std::uint64_t missed_ = 0;
+  std::uint64_t skipped_ = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include "ipc_ring.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Single-instance channel. The first process that opens a channel becomes the primary instance
+// and receives the messages that later instances write into a named shared memory ring.
+// On Windows an auto-reset event signals the primary after every message. The shared objects
+// are only accessible to the current user.
+class instance_channel {
+public:
+  instance_channel() = default;
+  ~instance_channel();
+
+  instance_channel(const instance_channel& other) = delete;
+  instance_channel& operator=(const instance_channel& other) = delete;
+
+  // Creates or opens the named channel. Returns false if the shared objects could not be created.
+  bool open(const std::wstring& name, std::size_t capacity = 65536);
+
+  // Returns true if this process created the channel.
+  bool primary() const
+  {
+    return primary_;
+  }
+
+  // Sends a message to the primary instance. Retries while the ring is full until the timeout
+  // in milliseconds expired. Returns false if the message could not be written.
+  bool send(const std::wstring& message, unsigned timeout = 100);
+
+  // Appends all pending messages in one batch and returns their number. Must only be called by the primary instance.
+  std::size_t receive(std::vector<std::wstring>& messages);
+
+  // Returns true if the last receive() stopped at a message that a later instance has not written yet.
+  // The message is skipped by a later receive() if its instance does not finish it within a second.
+  bool stalled() const
+  {
+    return ring_ && ring_->stalled();
+  }
+
+#ifdef _WIN32
+  // Returns the event that is signaled when messages were sent.
+  HANDLE event() const
+  {
+    return event_;
+  }
+#endif
+
+private:
+  void close();
+
+  bool primary_ = false;
+  void* memory_ = nullptr;
+  std::size_t size_ = 0;
+  std::unique_ptr<ipc_ring> ring_;
+  std::vector<char> buffer_;
+
+#ifdef _WIN32
+  HANDLE event_ = nullptr;
+  HANDLE mapping_ = nullptr;
+#else
+  std::string name_;
+#endif
+};
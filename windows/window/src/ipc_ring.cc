@@ -0,0 +1,182 @@
+#include "ipc_ring.h"
+#include <cstring>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error The ring requires lock-free atomics in shared memory.
+#endif
+
+namespace {
+
+// Every record starts with a 32 bit word that holds the type, the lap of the ring in which the record
+// was written and the length. Words without a type or of another lap are not a record yet.
+const std::uint32_t record_type = 0xC0000000;
+const std::uint32_t record_message = 0x40000000;   // a message of the given length follows
+const std::uint32_t record_padding = 0x80000000;   // the rest of the ring is skipped
+const std::uint32_t record_reserved = 0xC0000000;  // reserved space of the given length, not published yet
+const std::uint32_t record_lap = 0x3F000000;
+const std::uint32_t record_length = 0x00FFFFFF;
+const unsigned lap_shift = 24;
+const std::size_t record_header = 8;
+const std::size_t max_capacity = 1 << 23;
+
+std::size_t record_size(std::size_t size)
+{
+  return record_header + ((size + 7) & ~std::size_t(7));
+}
+
+}  // namespace
+
+ipc_ring::ipc_ring(void* memory, std::size_t size)
+{
+  static_assert(sizeof(std::atomic<std::uint64_t>) == 8 && sizeof(std::atomic<std::uint32_t>) == 4, "Unexpected atomic size.");
+  header_ = static_cast<header*>(memory);
+  data_ = static_cast<char*>(memory) + sizeof(header);
+  capacity_ = 0;
+  shift_ = 3;
+  if (size > sizeof(header)) {
+    capacity_ = 8;
+    while (capacity_ * 2 <= size - sizeof(header) && capacity_ < max_capacity) {
+      capacity_ *= 2;
+      shift_++;
+    }
+  }
+}
+
+std::size_t ipc_ring::size(std::size_t capacity)
+{
+  std::size_t size = 8;
+  while (size < capacity && size < max_capacity) {
+    size *= 2;
+  }
+  return sizeof(header) + size;
+}
+
+bool ipc_ring::write(const void* data, std::size_t size)
+{
+  auto need = record_size(size);
+  if (need > capacity_) {
+    return false;
+  }
+
+  // Reserve the record and a padding record if it does not fit before the end of the ring.
+  auto head = header_->head.load(std::memory_order_acquire);
+  std::uint32_t pos = 0;
+  std::uint32_t reserved = 0;
+  for (;;) {
+    pos = static_cast<std::uint32_t>(head);
+    auto tail = static_cast<std::uint32_t>(header_->tail.load(std::memory_order_acquire));
+
+    // The previous producer marks its reservation right after reserving it. If it died before, mark it
+    // in its place before the head, which records the length of the reservation, is replaced.
+    // A head that is older than the tail is retried by the compare-and-swap.
+    auto last = static_cast<std::uint32_t>(head >> 32);
+    if (last && pos - tail >= last && pos - tail <= capacity_) {
+      auto start = pos - last;
+      auto value = word(start).load(std::memory_order_acquire);
+      if (!current(value, start)) {
+        word(start).compare_exchange_strong(value, stamp(record_reserved, start, last), std::memory_order_acq_rel, std::memory_order_relaxed);
+      }
+    }
+
+    auto offset = pos & (capacity_ - 1);
+    reserved = static_cast<std::uint32_t>(capacity_ - offset < need ? capacity_ - offset + need : need);
+    if (pos + reserved - tail > capacity_) {
+      return false;
+    }
+    auto next = static_cast<std::uint64_t>(reserved) << 32 | static_cast<std::uint32_t>(pos + reserved);
+    if (header_->head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      break;
+    }
+  }
+
+  // Mark the reservation at once, publish the message after its contents and then the padding record,
+  // so that the consumer always finds a published message after the padding.
+  word(pos).store(stamp(record_reserved, pos, reserved), std::memory_order_release);
+  auto padding = reserved - static_cast<std::uint32_t>(need);
+  auto at = pos + padding;
+  std::memcpy(data_ + (at & (capacity_ - 1)) + record_header, data, size);
+  word(at).store(stamp(record_message, at, size), std::memory_order_release);
+  if (padding) {
+    word(pos).store(stamp(record_padding, pos, padding), std::memory_order_release);
+  }
+  return true;
+}
+
+bool ipc_ring::read(std::vector<char>& message, unsigned timeout)
+{
+  auto tail = static_cast<std::uint32_t>(header_->tail.load(std::memory_order_relaxed));
+  for (;;) {
+    auto head = header_->head.load(std::memory_order_acquire);
+    if (tail == static_cast<std::uint32_t>(head)) {
+      stalled_ = false;
+      return false;
+    }
+    auto value = word(tail).load(std::memory_order_acquire);
+    auto type = current(value, tail) ? value & record_type : 0;
+
+    if (!type || type == record_reserved) {
+      // The record was reserved but not published yet. The head holds the length of the last
+      // reservation and the next producer marked all others.
+      std::size_t reserved = type ? value & record_length : 0;
+      if (!type && static_cast<std::uint32_t>(head) - tail == static_cast<std::uint32_t>(head >> 32)) {
+        reserved = static_cast<std::uint32_t>(head >> 32);
+      }
+      if (!reserved) {
+        return false;
+      }
+
+      // Wait for the producer and skip the record when it seems to be dead.
+      auto now = std::chrono::steady_clock::now();
+      if (!stalled_ || stalled_at_ != tail) {
+        stalled_ = true;
+        stalled_at_ = tail;
+        stalled_since_ = now;
+        return false;
+      }
+      if (now - stalled_since_ < std::chrono::milliseconds(timeout)) {
+        return false;
+      }
+      stalled_ = false;
+      skipped_++;
+      release(tail);
+      tail += static_cast<std::uint32_t>(reserved);
+      header_->tail.store(tail, std::memory_order_release);
+      continue;
+    }
+
+    stalled_ = false;
+    std::size_t used = 0;
+    if (type == record_padding) {
+      used = value & record_length;
+    } else {
+      auto size = value & record_length;
+      auto offset = tail & (capacity_ - 1);
+      message.assign(data_ + offset + record_header, data_ + offset + record_header + size);
+      used = record_size(size);
+    }
+    release(tail);
+    tail += static_cast<std::uint32_t>(used);
+    header_->tail.store(tail, std::memory_order_release);
+    if (type == record_message) {
+      return true;
+    }
+  }
+}
+
+std::uint32_t ipc_ring::stamp(std::uint32_t type, std::uint32_t pos, std::size_t size) const
+{
+  return type | ((pos >> shift_) << lap_shift & record_lap) | static_cast<std::uint32_t>(size);
+}
+
+bool ipc_ring::current(std::uint32_t value, std::uint32_t pos) const
+{
+  // Words of an older lap were left behind by a dead or stalled producer.
+  return (value & record_type) && (value & record_lap) == stamp(0, pos, 0);
+}
+
+void ipc_ring::release(std::uint32_t pos)
+{
+  // Leave a word of the current lap without a type, so that a producer that marks the record
+  // late can not take it for an unmarked one. The rest of the record is not cleared.
+  word(pos).store(stamp(0, pos, 0), std::memory_order_relaxed);
+}
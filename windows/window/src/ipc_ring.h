@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Multi-producer single-consumer ring of variable length messages in a memory block that can be
+// shared between processes. Zero-filled memory is an empty ring, so new shared memory needs no
+// initialization. Producers reserve space with a compare-and-swap of the head, which also records the
+// length of the reservation, then mark the reservation and publish the message with its length.
+// Before reserving, a producer marks the previous reservation in case its producer died before it
+// could, so the consumer always knows the length of an unpublished record and skips it after a timeout.
+class ipc_ring {
+public:
+  // Attaches to the memory block. The capacity is the largest power of two up to 8 MiB that fits after the header.
+  ipc_ring(void* memory, std::size_t size);
+
+  // Returns the number of bytes of a memory block whose ring can hold the given number of message bytes.
+  static std::size_t size(std::size_t capacity);
+
+  // Writes a message from any thread or process. Returns false if the ring is full or the message is too large.
+  bool write(const void* data, std::size_t size);
+
+  // Reads the oldest message on the consumer. Returns false if no complete message is available.
+  // A message that stays reserved but unpublished for the timeout in milliseconds is skipped, because
+  // its producer most likely died. A producer that stalls for longer may overwrite later messages.
+  bool read(std::vector<char>& message, unsigned timeout = 1000);
+
+  // Returns true if the last read() waited for an unpublished message.
+  bool stalled() const
+  {
+    return stalled_;
+  }
+
+  // Returns the number of messages that read() skipped.
+  std::uint64_t skipped() const
+  {
+    return skipped_;
+  }
+
+  std::size_t capacity() const
+  {
+    return capacity_;
+  }
+
+private:
+  // The head holds the position in the low and the length of the last reservation in the high 32 bits.
+  // Positions wrap at 2^32, which is a multiple of the capacity.
+  struct header {
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+  };
+
+  std::atomic<std::uint32_t>& word(std::uint32_t pos) const
+  {
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(data_ + (pos & (capacity_ - 1)));
+  }
+
+  std::uint32_t stamp(std::uint32_t type, std::uint32_t pos, std::size_t size) const;
+  bool current(std::uint32_t value, std::uint32_t pos) const;
+  void release(std::uint32_t pos);
+
+  header* header_ = nullptr;
+  char* data_ = nullptr;
+  std::size_t capacity_ = 0;
+  unsigned shift_ = 0;
+
+  // Consumer state.
+  bool stalled_ = false;
+  std::uint32_t stalled_at_ = 0;
+  std::chrono::steady_clock::time_point stalled_since_;
+  std::uint64_t skipped_ = 0;
+};
@@ -0,0 +1,163 @@
+#include "layout.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+// Places a node along one axis of the available space [begin, end).
+void place(int begin, int end, int margin_begin, int margin_end, int size, bool anchor_begin, bool anchor_end, int& out_begin, int& out_end)
+{
+  begin += margin_begin;
+  end = std::max(begin, end - margin_end);
+  if (anchor_begin && anchor_end) {
+    out_begin = begin;
+    out_end = end;
+  } else if (anchor_begin) {
+    out_begin = begin;
+    out_end = begin + size;
+  } else if (anchor_end) {
+    out_begin = end - size;
+    out_end = end;
+  } else {
+    out_begin = begin + (end - begin - size) / 2;
+    out_end = out_begin + size;
+  }
+}
+
+}  // namespace
+
+constexpr layout::node_id layout::root;
+
+layout::layout(const layout_node& root_node) :
+  nodes_(1, root_node), links_(1), rects_(1)
+{}
+
+layout::node_id layout::add(node_id parent, const layout_node& n)
+{
+  auto id = static_cast<node_id>(nodes_.size());
+  nodes_.push_back(n);
+  links_.emplace_back();
+  rects_.emplace_back();
+  auto& p = links_[parent];
+  if (p.last) {
+    links_[p.last].next = id;
+  } else {
+    p.first = id;
+  }
+  p.last = id;
+  if (n.handle) {
+    windows_++;
+  }
+  return id;
+}
+
+void layout::clear()
+{
+  nodes_.resize(1);
+  links_.assign(1, links());
+  rects_.resize(1);
+  windows_ = 0;
+}
+
+void layout::solve(int width, int height)
+{
+  // Place the root node in the client area.
+  const auto& r = nodes_[root];
+  auto& rc = rects_[root];
+  place(0, width, r.margin.left, r.margin.right, r.width, (r.anchors & layout_left) != 0, (r.anchors & layout_right) != 0, rc.left, rc.right);
+  place(0, height, r.margin.top, r.margin.bottom, r.height, (r.anchors & layout_top) != 0, (r.anchors & layout_bottom) != 0, rc.top, rc.bottom);
+
+  // Parents precede their children, so every node is placed before its children are arranged.
+  for (node_id id = 0; id < nodes_.size(); id++) {
+    if (links_[id].first) {
+      arrange(id);
+    }
+  }
+}
+
+void layout::arrange(node_id id)
+{
+  // Determine the content area of the node.
+  const auto& n = nodes_[id];
+  const auto& rc = rects_[id];
+  auto left = rc.left + n.padding.left;
+  auto top = rc.top + n.padding.top;
+  auto right = std::max(left, rc.right - n.padding.right);
+  auto bottom = std::max(top, rc.bottom - n.padding.bottom);
+
+  if (n.direction == layout_direction::overlay) {
+    for (auto c = links_[id].first; c; c = links_[c].next) {
+      const auto& child = nodes_[c];
+      auto& out = rects_[c];
+      place(left, right, child.margin.left, child.margin.right, child.width,
+        (child.anchors & layout_left) != 0, (child.anchors & layout_right) != 0, out.left, out.right);
+      place(top, bottom, child.margin.top, child.margin.bottom, child.height,
+        (child.anchors & layout_top) != 0, (child.anchors & layout_bottom) != 0, out.top, out.bottom);
+    }
+    return;
+  }
+
+  // Sum up the fixed sizes and the grow factors along the main axis.
+  auto row = n.direction == layout_direction::row;
+  auto fixed = 0;
+  auto grow = 0;
+  for (auto c = links_[id].first; c; c = links_[c].next) {
+    const auto& child = nodes_[c];
+    fixed += row ? child.margin.left + child.margin.right : child.margin.top + child.margin.bottom;
+    if (child.grow > 0) {
+      grow += child.grow;
+    } else {
+      fixed += row ? child.width : child.height;
+    }
+  }
+
+  // Distribute the remaining space in proportion to the grow factors without losing rounding errors.
+  auto remaining = std::max(0, (row ? right - left : bottom - top) - fixed);
+  auto position = row ? left : top;
+  for (auto c = links_[id].first; c; c = links_[c].next) {
+    const auto& child = nodes_[c];
+    auto size = row ? child.width : child.height;
+    if (child.grow > 0) {
+      size = static_cast<int>(static_cast<long long>(remaining) * child.grow / grow);
+      remaining -= size;
+      grow -= child.grow;
+    }
+    auto& out = rects_[c];
+    if (row) {
+      out.left = position + child.margin.left;
+      out.right = out.left + size;
+      position = out.right + child.margin.right;
+      place(top, bottom, child.margin.top, child.margin.bottom, child.height,
+        (child.anchors & layout_top) != 0, (child.anchors & layout_bottom) != 0, out.top, out.bottom);
+    } else {
+      out.top = position + child.margin.top;
+      out.bottom = out.top + size;
+      position = out.bottom + child.margin.bottom;
+      place(left, right, child.margin.left, child.margin.right, child.width,
+        (child.anchors & layout_left) != 0, (child.anchors & layout_right) != 0, out.left, out.right);
+    }
+  }
+}
+
+#ifdef _WIN32
+bool layout::apply(bool redraw) const
+{
+  if (!windows_) {
+    return true;
+  }
+
+  // Move all windows at once so that each of them is only redrawn once.
+  auto flags = SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOOWNERZORDER | (redraw ? 0 : SWP_NOREDRAW);
+  auto hdwp = BeginDeferWindowPos(static_cast<int>(windows_));
+  for (std::size_t i = 0; hdwp && i < nodes_.size(); i++) {
+    if (auto hwnd = static_cast<HWND>(nodes_[i].handle)) {
+      const auto& rc = rects_[i];
+      hdwp = DeferWindowPos(hdwp, hwnd, nullptr, rc.left, rc.top, rc.width(), rc.height(), flags);
+    }
+  }
+  return hdwp && EndDeferWindowPos(hdwp);
+}
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sizes of the four edges of a margin or padding.
+struct layout_edges {
+  int left = 0;
+  int top = 0;
+  int right = 0;
+  int bottom = 0;
+};
+
+struct layout_rect {
+  int left = 0;
+  int top = 0;
+  int right = 0;
+  int bottom = 0;
+
+  int width() const
+  {
+    return right - left;
+  }
+
+  int height() const
+  {
+    return bottom - top;
+  }
+};
+
+// Edges of the available space that a node sticks to. A node that sticks to two opposite edges is stretched,
+// a node that sticks to neither is centered.
+enum layout_anchor : unsigned {
+  layout_left = 0x1,
+  layout_top = 0x2,
+  layout_right = 0x4,
+  layout_bottom = 0x8,
+  layout_fill = 0xF,
+};
+
+// Arrangement of the children of a node.
+enum class layout_direction {
+  overlay,  // children share the content area
+  row,      // children are placed from left to right
+  column,   // children are placed from top to bottom
+};
+
+// Node of a layout. Groups arrange their children, nodes with a window handle are positioned by apply.
+struct layout_node {
+  layout_direction direction = layout_direction::overlay;
+  unsigned anchors = layout_fill;
+  layout_edges margin;   // space around the node
+  layout_edges padding;  // space between the node and its children
+  int width = 0;         // size along axes that are not stretched
+  int height = 0;
+  int grow = 0;          // share of the remaining space in rows and columns; fixed size if zero
+  void* handle = nullptr;  // window that is positioned by apply, null for groups
+};
+
+// Box layout of child windows. Nodes form a tree below the root node, which covers the parent client area.
+// The solver computes all rectangles in a single pass over the nodes, because parents are always added
+// before their children.
+class layout {
+public:
+  using node_id = std::uint32_t;
+  static constexpr node_id root = 0;
+
+  explicit layout(const layout_node& root_node = layout_node());
+
+  // Adds a node as the last child of the parent and returns its ID.
+  node_id add(node_id parent, const layout_node& n);
+
+  // Removes all nodes except the root node.
+  void clear();
+
+  layout_node& operator[](node_id id)
+  {
+    return nodes_[id];
+  }
+
+  const layout_node& operator[](node_id id) const
+  {
+    return nodes_[id];
+  }
+
+  // Returns the rectangle that was computed for the node.
+  const layout_rect& rect(node_id id) const
+  {
+    return rects_[id];
+  }
+
+  std::size_t size() const
+  {
+    return nodes_.size();
+  }
+
+  // Computes the rectangles of all nodes for the given client area size.
+  void solve(int width, int height);
+
+#ifdef _WIN32
+  // Moves all windows with a single DeferWindowPos batch. Returns false if the batch failed.
+  bool apply(bool redraw = true) const;
+#endif
+
+private:
+  struct links {
+    node_id first = 0;  // first child, zero if none
+    node_id last = 0;   // last child, zero if none
+    node_id next = 0;   // next sibling, zero if none
+  };
+
+  void arrange(node_id id);
+
+  std::vector<layout_node> nodes_;
+  std::vector<links> links_;
+  std::vector<layout_rect> rects_;
+  std::size_t windows_ = 0;
+};
@@ -0,0 +1,238 @@
+#include "raster.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SSE2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RASTER_AVX2
+#else
+#define RASTER_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// Divides a product of two 8-bit values by 255 with correct rounding.
+inline std::uint32_t div255(std::uint32_t x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+// Blends a premultiplied source pixel over a destination pixel.
+inline std::uint32_t blend_pixel(std::uint32_t dst, std::uint32_t src)
+{
+  auto inv = 255 - (src >> 24);
+  std::uint32_t result = 0;
+  for (auto shift = 0; shift < 32; shift += 8) {
+    auto value = ((src >> shift) & 0xFF) + div255(((dst >> shift) & 0xFF) * inv);
+    result |= (value > 255 ? 255 : value) << shift;
+  }
+  return result;
+}
+
+#ifdef RASTER_SSE2
+
+// Blends 16-bit source channels over 16-bit destination channels with 16-bit inverse alpha values.
+inline __m128i blend_sse2(__m128i dst, __m128i inv)
+{
+  auto x = _mm_add_epi16(_mm_mullo_epi16(dst, inv), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Returns the inverse alpha of every pixel in all four 16-bit channels.
+inline __m128i inverse_alpha_sse2(__m128i src)
+{
+  auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+}
+
+void fill_sse2(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  auto value = _mm_set1_epi32(static_cast<int>(color));
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+  }
+  raster_fill_scalar(dst + i, count - i, color);
+}
+
+void blend_color_sse2(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  auto zero = _mm_setzero_si128();
+  auto src = _mm_set1_epi32(static_cast<int>(color));
+  auto inv = _mm_set1_epi16(static_cast<short>(255 - (color >> 24)));
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    auto lo = blend_sse2(_mm_unpacklo_epi8(d, zero), inv);
+    auto hi = blend_sse2(_mm_unpackhi_epi8(d, zero), inv);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), src));
+  }
+  raster_blend_scalar(dst + i, count - i, color);
+}
+
+void blend_pixels_sse2(std::uint32_t* dst, const std::uint32_t* src, std::size_t count)
+{
+  auto zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    auto lo = blend_sse2(_mm_unpacklo_epi8(d, zero), inverse_alpha_sse2(_mm_unpacklo_epi8(s, zero)));
+    auto hi = blend_sse2(_mm_unpackhi_epi8(d, zero), inverse_alpha_sse2(_mm_unpackhi_epi8(s, zero)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+  }
+  raster_blend_scalar(dst + i, src + i, count - i);
+}
+
+RASTER_AVX2 inline __m256i blend_avx2(__m256i dst, __m256i inv)
+{
+  auto x = _mm256_add_epi16(_mm256_mullo_epi16(dst, inv), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+RASTER_AVX2 inline __m256i inverse_alpha_avx2(__m256i src)
+{
+  auto alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+}
+
+RASTER_AVX2 void fill_avx2(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  auto value = _mm256_set1_epi32(static_cast<int>(color));
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+  }
+  raster_fill_scalar(dst + i, count - i, color);
+}
+
+RASTER_AVX2 void blend_color_avx2(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  auto zero = _mm256_setzero_si256();
+  auto src = _mm256_set1_epi32(static_cast<int>(color));
+  auto inv = _mm256_set1_epi16(static_cast<short>(255 - (color >> 24)));
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    auto lo = blend_avx2(_mm256_unpacklo_epi8(d, zero), inv);
+    auto hi = blend_avx2(_mm256_unpackhi_epi8(d, zero), inv);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), src));
+  }
+  raster_blend_scalar(dst + i, count - i, color);
+}
+
+RASTER_AVX2 void blend_pixels_avx2(std::uint32_t* dst, const std::uint32_t* src, std::size_t count)
+{
+  auto zero = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    auto s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    auto lo = blend_avx2(_mm256_unpacklo_epi8(d, zero), inverse_alpha_avx2(_mm256_unpacklo_epi8(s, zero)));
+    auto hi = blend_avx2(_mm256_unpackhi_epi8(d, zero), inverse_alpha_avx2(_mm256_unpackhi_epi8(s, zero)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s));
+  }
+  raster_blend_scalar(dst + i, src + i, count - i);
+}
+
+// Returns true if the CPU and the operating system support AVX2.
+bool has_avx2()
+{
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+// Selects the kernels for the CPU once.
+const raster_detail::kernel& select()
+{
+  static const auto k = raster_detail::kernels().back();
+  return k;
+}
+
+}  // namespace
+
+std::uint32_t raster_premultiply(std::uint32_t color)
+{
+  auto alpha = color >> 24;
+  auto r = div255(((color >> 16) & 0xFF) * alpha);
+  auto g = div255(((color >> 8) & 0xFF) * alpha);
+  auto b = div255((color & 0xFF) * alpha);
+  return (alpha << 24) | (r << 16) | (g << 8) | b;
+}
+
+void raster_fill(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  select().fill(dst, count, color);
+}
+
+void raster_blend(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  select().blend_color(dst, count, color);
+}
+
+void raster_blend(std::uint32_t* dst, const std::uint32_t* src, std::size_t count)
+{
+  select().blend_pixels(dst, src, count);
+}
+
+void raster_copy(std::uint32_t* dst, const std::uint32_t* src, std::size_t count)
+{
+  std::memmove(dst, src, count * sizeof(std::uint32_t));
+}
+
+void raster_fill_scalar(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  for (std::size_t i = 0; i < count; i++) {
+    dst[i] = color;
+  }
+}
+
+void raster_blend_scalar(std::uint32_t* dst, std::size_t count, std::uint32_t color)
+{
+  for (std::size_t i = 0; i < count; i++) {
+    dst[i] = blend_pixel(dst[i], color);
+  }
+}
+
+void raster_blend_scalar(std::uint32_t* dst, const std::uint32_t* src, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; i++) {
+    dst[i] = blend_pixel(dst[i], src[i]);
+  }
+}
+
+const char* raster_isa()
+{
+  return select().name;
+}
+
+std::vector<raster_detail::kernel> raster_detail::kernels()
+{
+  std::vector<kernel> kernels = { { "scalar", raster_fill_scalar, raster_blend_scalar, raster_blend_scalar } };
+#ifdef RASTER_SSE2
+  kernels.push_back({ "sse2", fill_sse2, blend_color_sse2, blend_pixels_sse2 });
+  if (has_avx2()) {
+    kernels.push_back({ "avx2", fill_avx2, blend_color_avx2, blend_pixels_avx2 });
+  }
+#endif
+  return kernels;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixel kernels for 32-bit premultiplied BGRA pixels, which is the memory layout of 0xAARRGGBB values
+// on little-endian machines and of 32-bit DIB sections. The kernels use AVX2 or SSE2 when the CPU supports
+// them and produce the same results as the scalar reference implementations.
+
+// Converts a straight alpha 0xAARRGGBB color to premultiplied alpha.
+std::uint32_t raster_premultiply(std::uint32_t color);
+
+// Sets pixels to a color.
+void raster_fill(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+
+// Blends a premultiplied color over pixels.
+void raster_blend(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+
+// Blends premultiplied source pixels over destination pixels.
+void raster_blend(std::uint32_t* dst, const std::uint32_t* src, std::size_t count);
+
+// Copies pixels.
+void raster_copy(std::uint32_t* dst, const std::uint32_t* src, std::size_t count);
+
+// Scalar reference implementations.
+void raster_fill_scalar(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+void raster_blend_scalar(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+void raster_blend_scalar(std::uint32_t* dst, const std::uint32_t* src, std::size_t count);
+
+// Returns the name of the instruction set that the kernels use.
+const char* raster_isa();
+
+// Kernel sets behind the raster functions, exposed so that tests and benchmarks can run each of them.
+namespace raster_detail {
+
+struct kernel {
+  const char* name;
+  void (*fill)(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+  void (*blend_color)(std::uint32_t* dst, std::size_t count, std::uint32_t color);
+  void (*blend_pixels)(std::uint32_t* dst, const std::uint32_t* src, std::size_t count);
+};
+
+// Returns the kernel sets that the CPU supports, starting with the scalar references.
+// The raster functions use the last one.
+std::vector<kernel> kernels();
+
+}  // namespace raster_detail
@@ -0,0 +1,219 @@
+#include "timer_wheel.h"
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Returns the index of the lowest set bit of a non-zero value.
+inline int lowest_bit(std::uint64_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward64(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+}  // namespace
+
+constexpr int timer_wheel::levels;
+constexpr int timer_wheel::bits;
+constexpr int timer_wheel::slots;
+
+timer_wheel::timer::~timer()
+{
+  if (wheel_) {
+    wheel_->cancel(*this);
+  }
+}
+
+timer_wheel::timer_wheel(std::uint64_t now) : current_(now + 1)
+{}
+
+timer_wheel::~timer_wheel()
+{
+  // Detach the remaining timers so that they can outlive the wheel.
+  auto detach = [](timer* t) {
+    while (t) {
+      auto next = t->next_;
+      t->next_ = nullptr;
+      t->prev_ = nullptr;
+      t->list_ = nullptr;
+      t->wheel_ = nullptr;
+      t = next;
+    }
+  };
+  for (auto& level : slots_) {
+    for (auto head : level) {
+      detach(head);
+    }
+  }
+  detach(expired_);
+}
+
+void timer_wheel::schedule(timer& t, std::uint64_t delay)
+{
+  if (t.wheel_) {
+    t.wheel_->cancel(t);
+  }
+  const std::uint64_t max = std::numeric_limits<std::uint32_t>::max();
+  t.expiry_ = now() + (delay < max ? delay : max);
+  t.wheel_ = this;
+  insert(t);
+  size_++;
+}
+
+void timer_wheel::cancel(timer& t)
+{
+  if (t.wheel_ != this) {
+    return;
+  }
+  unlink(t);
+  t.wheel_ = nullptr;
+  size_--;
+}
+
+std::size_t timer_wheel::advance(std::uint64_t now)
+{
+  // Finish a batch that was interrupted by an exception in a callback.
+  auto count = expire();
+  while (current_ <= now) {
+    auto index = static_cast<int>(current_ & (slots - 1));
+
+    // Move the timers of the next upper level slot down when a level wraps.
+    if (index == 0) {
+      for (auto level = 1; level < levels; level++) {
+        auto upper = static_cast<int>((current_ >> (bits * level)) & (slots - 1));
+        cascade(level, upper);
+        if (upper != 0) {
+          break;
+        }
+      }
+    }
+
+    // Skip the empty slots up to the next occupied slot or the next wrap.
+    auto& head = slots_[0][index];
+    if (!head) {
+      auto next = next_tick();
+      current_ = next <= now ? next : now + 1;
+      continue;
+    }
+
+    // Detach the slot before the callbacks run, because they may schedule timers into it.
+    expired_ = head;
+    head = nullptr;
+    occupied_[0][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    for (auto t = expired_; t; t = t->next_) {
+      t->list_ = &expired_;
+    }
+    current_++;
+    count += expire();
+  }
+  return count;
+}
+
+std::uint64_t timer_wheel::timeout() const
+{
+  if (size_ == 0) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+
+  // The upper levels must be cascaded at a wrap before the next occupied level 0 slot is known.
+  if ((current_ & (slots - 1)) == 0) {
+    return 1;
+  }
+  return next_tick() - now();
+}
+
+std::size_t timer_wheel::expire()
+{
+  // Callbacks may cancel other expired timers or destroy their own.
+  std::size_t count = 0;
+  while (auto t = expired_) {
+    unlink(*t);
+    t->wheel_ = nullptr;
+    size_--;
+    count++;
+    t->callback_(t->context_);
+  }
+  return count;
+}
+
+void timer_wheel::insert(timer& t)
+{
+  // Pick the level by the distance to the expiry and the slot by the bits of the expiry on that level.
+  // Timers that are already due go into the slot of the next tick.
+  auto expiry = t.expiry_ < current_ ? current_ : t.expiry_;
+  auto distance = expiry - current_;
+  auto level = 0;
+  while (level < levels - 1 && distance >= (std::uint64_t(1) << (bits * (level + 1)))) {
+    level++;
+  }
+  auto index = static_cast<int>((expiry >> (bits * level)) & (slots - 1));
+
+  auto& head = slots_[level][index];
+  t.prev_ = nullptr;
+  t.next_ = head;
+  if (head) {
+    head->prev_ = &t;
+  }
+  head = &t;
+  t.list_ = &head;
+  occupied_[level][index / 64] |= std::uint64_t(1) << (index % 64);
+}
+
+void timer_wheel::unlink(timer& t)
+{
+  if (t.prev_) {
+    t.prev_->next_ = t.next_;
+  } else {
+    *t.list_ = t.next_;
+  }
+  if (t.next_) {
+    t.next_->prev_ = t.prev_;
+  }
+
+  // Clear the occupancy bit when a slot becomes empty.
+  if (!*t.list_ && t.list_ != &expired_) {
+    auto offset = t.list_ - &slots_[0][0];
+    auto level = static_cast<int>(offset / slots);
+    auto index = static_cast<int>(offset % slots);
+    occupied_[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+  }
+  t.next_ = nullptr;
+  t.prev_ = nullptr;
+  t.list_ = nullptr;
+}
+
+void timer_wheel::cascade(int level, int index)
+{
+  auto t = slots_[level][index];
+  slots_[level][index] = nullptr;
+  occupied_[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+  while (t) {
+    auto next = t->next_;
+    insert(*t);
+    t = next;
+  }
+}
+
+std::uint64_t timer_wheel::next_tick() const
+{
+  // Find the next occupied level 0 slot before the wrap with the occupancy bitmap.
+  auto index = static_cast<int>(current_ & (slots - 1));
+  for (auto word = index / 64; word < slots / 64; word++) {
+    auto mask = occupied_[0][word];
+    if (word == index / 64) {
+      mask &= ~std::uint64_t(0) << (index % 64);
+    }
+    if (mask) {
+      return current_ + (word * 64 + lowest_bit(mask)) - index;
+    }
+  }
+  return current_ + (slots - index);
+}
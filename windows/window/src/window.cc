@@ -1,32 +1,54 @@
 #include "window.h"
+#include "clock.h"
 #include <resource.h>
+#include <algorithm>
+#include <cmath>
+#include <cwchar>
 #include <stdexcept>
-#include <string>
 
-window::window(HINSTANCE instance) : instance_(instance)
+#define STATS_INTERVAL 1000  // milliseconds between paint statistics updates
+
+#define WINDOW_FPS 60  // target frame rate of the continuous render loop
+#define WINDOW_MIN_SLEEP 0.001  // seconds between frames that let queued input through when rendering is too slow
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+window::window(HINSTANCE instance, event_loop& loop, thread_pool& pool) :
+  instance_(instance), loop_(loop), pool_(pool)
+#ifdef WINDOW_CANVAS
+  , buffer_(&pool)
+#endif
+#ifdef WINDOW_CONTINUOUS
+  , pacer_(WINDOW_FPS, clock_frequency())
+#endif
 {
+#ifdef WINDOW_BUFFERED
+  // Report the paint statistics from a timer of the event loop.
+  stats_timer_.bind<window, &window::on_stats>(this);
+#endif
+
   // Load the window icon.
   auto icon = LoadIcon(instance, MAKEINTRESOURCE(IDI_MAIN));
 
   // Register the main application window class.
   WNDCLASSEX wc = {};
   wc.cbSize = sizeof(wc);
+#ifdef WINDOW_BUFFERED
+  // Only repaint the invalidated regions and let the back buffer draw the background.
+  wc.style = 0;
+#else
   wc.style = CS_HREDRAW | CS_VREDRAW;
-  wc.lpfnWndProc = [](HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) -> LRESULT {
-    auto self = reinterpret_cast<window*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-    if (msg == WM_CREATE) {
-      self = reinterpret_cast<window*>(reinterpret_cast<LPCREATESTRUCT>(lparam)->lpCreateParams);
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
-    } else if (msg == WM_DESTROY) {
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
-    }
-    return self ? self->handle(hwnd, msg, wparam, lparam) : DefWindowProc(hwnd, msg, wparam, lparam);
-  };
+#endif
+  wc.lpfnWndProc = window_proc;
   wc.hInstance = instance;
   wc.hIcon = icon;
   wc.hIconSm = icon;
   wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+#ifndef WINDOW_BUFFERED
   wc.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_WINDOW);
+#endif
   wc.lpszMenuName = MAKEINTRESOURCE(IDM_MAIN);
   wc.lpszClassName = PRODUCT;
 
@@ -35,6 +57,7 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("RegisterClassEx");
 
   // Create the main application window.
   auto es = 0x0L;
@@ -45,6 +68,7 @@ window::window(HINSTANCE instance) : instance_(instance)
     PostQuitMessage(1);
     return;
   }
+  trace_phase("CreateWindowEx");
 }
 
 void window::on_create()
@@ -76,20 +100,258 @@ void window::on_create()
     }
   }
 
+#ifdef WINDOW_BUFFERED
+  // Report the paint statistics in the title bar.
+  loop_.timers().schedule(stats_timer_, STATS_INTERVAL);
+#endif
+
+#ifdef WINDOW_CONTINUOUS
+  // Render continuously with a high resolution waitable timer if the system supports one.
+  frame_timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  if (!frame_timer_) {
+    frame_timer_ = CreateWaitableTimer(nullptr, FALSE, nullptr);
+  }
+  if (!frame_timer_) {
+    throw std::runtime_error("Could not create the frame timer.");
+  }
+  loop_.add(frame_timer_, [this]() {
+    on_frame();
+  });
+  pacer_.start(clock_ticks());
+  schedule(0);
+#endif
+
   // Show the window.
   ShowWindow(hwnd_, SW_SHOW);
 }
 
+void window::open(const std::vector<std::wstring>& commands)
+{
+  // Show the window of the running instance.
+  if (!hwnd_) {
+    return;
+  }
+  if (IsIconic(hwnd_)) {
+    ShowWindow(hwnd_, SW_RESTORE);
+  }
+  SetForegroundWindow(hwnd_);
+}
+
 void window::on_destroy()
 {
+#ifdef WINDOW_CONTINUOUS
+  // Stop rendering.
+  if (frame_timer_) {
+    loop_.remove(frame_timer_);
+    CancelWaitableTimer(frame_timer_);
+    CloseHandle(frame_timer_);
+    frame_timer_ = nullptr;
+  }
+#endif
+
+#ifdef WINDOW_BUFFERED
+  // Release the back buffer.
+  loop_.timers().cancel(stats_timer_);
+  buffer_.reset();
+#endif
+
   // Stop the main message loop.
   PostQuitMessage(0);
 }
 
 void window::on_size(int cx, int cy)
 {
-  // Resize the controls.
+  // Resize the controls at once and let the end of a live resize redraw them.
+  layout_.solve(cx, cy);
+  layout_.apply(!sizing_);
+
+#ifdef WINDOW_BUFFERED
+  dirty_.set_bounds(cx, cy);
+#endif
+#ifdef WINDOW_CANVAS
+  // The chart scales with the window, so all of it is rendered again.
+  InvalidateRect(hwnd_, nullptr, FALSE);
+#endif
+}
+
+void window::on_entersizemove()
+{
+  sizing_ = true;
+}
+
+void window::on_exitsizemove()
+{
+  // Redraw the controls that were moved without redrawing.
+  sizing_ = false;
+  RedrawWindow(hwnd_, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN);
+}
+
+#ifdef WINDOW_BUFFERED
+void window::invalidate(const RECT& rc)
+{
+  dirty_.add({ rc.left, rc.top, rc.right, rc.bottom });
+  InvalidateRect(hwnd_, &rc, FALSE);
+}
+
+void window::on_paint()
+{
+  PAINTSTRUCT ps = {};
+  auto hdc = BeginPaint(hwnd_, &ps);
+  auto start = clock_ticks();
+
+  // Add the regions that the system invalidated, for example when the window was uncovered.
+  RECT rc = {};
+  GetClientRect(hwnd_, &rc);
+  dirty_.set_bounds(rc.right, rc.bottom);
+  dirty_.add({ ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right, ps.rcPaint.bottom });
+
+  // Render the whole client area when the back buffer was recreated.
+#ifdef WINDOW_CANVAS
+  if (buffer_.resize(rc.right, rc.bottom)) {
+#else
+  if (buffer_.resize(hdc, rc.right, rc.bottom)) {
+#endif
+    dirty_.clear();
+    dirty_.add({ 0, 0, rc.right, rc.bottom });
+  }
+
+  // Render and copy only the dirty rectangles.
+  for (const auto& dirty : dirty_.rects()) {
+    render(dirty);
+    buffer_.blit(hdc, dirty);
+  }
+
+  frames_++;
+  frame_pixels_ += dirty_.pixels();
+  frame_ticks_ += clock_ticks() - start;
+  dirty_.clear();
+  EndPaint(hwnd_, &ps);
+}
+
+void window::on_stats()
+{
+  // Show the average paint time and pixel count per frame.
+  wchar_t title[256] = {};
+  auto size = 0;
+  if (frames_) {
+    size = std::swprintf(title, 256, L"%ls - %u frames, %.3f ms/frame, %llu px/frame", PROJECT, frames_,
+      frame_ticks_ * 1e3 / clock_frequency() / frames_, static_cast<unsigned long long>(frame_pixels_ / frames_));
+  } else {
+    size = std::swprintf(title, 256, L"%ls", PROJECT);
+  }
+#ifdef WINDOW_CONTINUOUS
+  // Add the frame time percentiles of the continuous render loop.
+  auto stats = pacer_.stats();
+  if (size > 0 && stats.frames) {
+    std::swprintf(title + size, 256 - size, L", frame time p50 %.1f p95 %.1f p99 %.1f ms, %llu missed", stats.p50, stats.p95, stats.p99,
+      static_cast<unsigned long long>(stats.missed));
+  }
+#endif
+  SetWindowText(hwnd_, title);
+  frames_ = 0;
+  frame_ticks_ = 0;
+  frame_pixels_ = 0;
+  loop_.timers().schedule(stats_timer_, STATS_INTERVAL);
+}
+
+#ifdef WINDOW_CONTINUOUS
+void window::on_frame()
+{
+  if (!hwnd_) {
+    return;
+  }
+
+  // Sleep again when the timer fired too early for the deadline.
+  pacer_.woke(clock_ticks());
+  auto ticks = pacer_.sleep(clock_ticks());
+  if (!ticks) {
+    // Render the whole client area unless the window is hidden.
+    auto now = clock_ticks();
+    if (visible()) {
+      RECT rc = {};
+      GetClientRect(hwnd_, &rc);
+      invalidate(rc);
+      UpdateWindow(hwnd_);
+      pacer_.frame(now);
+    } else {
+      pacer_.skip(now);
+    }
+
+    // Always sleep a little when rendering is too slow, because the signaled timer takes precedence over input.
+    ticks = std::max(pacer_.sleep(clock_ticks()), static_cast<std::uint64_t>(clock_frequency() * WINDOW_MIN_SLEEP));
+  }
+  schedule(ticks);
+}
+
+void window::schedule(std::uint64_t ticks)
+{
+  // Negative due times are relative and in 100 nanosecond intervals.
+  LARGE_INTEGER due = {};
+  due.QuadPart = -std::max(1LL, static_cast<long long>(ticks * 1e7 / clock_frequency()));
+  if (!SetWaitableTimer(frame_timer_, &due, 0, nullptr, nullptr, FALSE)) {
+    throw std::runtime_error("Could not set the frame timer.");
+  }
+}
+
+bool window::visible() const
+{
+  // Minimized windows and windows without a visible region are not rendered. The clip box only shrinks
+  // for covered windows when desktop composition is disabled.
+  if (IsIconic(hwnd_) || !IsWindowVisible(hwnd_)) {
+    return false;
+  }
+  auto hdc = GetDC(hwnd_);
+  RECT rc = {};
+  auto region = GetClipBox(hdc, &rc);
+  ReleaseDC(hwnd_, hdc);
+  return region != NULLREGION;
 }
+#endif
+
+bool window::on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result)
+{
+  // The back buffer covers the whole client area, so the background is never erased.
+  if (msg == WM_ERASEBKGND) {
+    result = 1;
+    return true;
+  }
+  return false;
+}
+
+#ifdef WINDOW_CANVAS
+void window::render(const dirty_rect& rc)
+{
+  // Finish pending GDI operations before writing to the DIB section.
+  GdiFlush();
+  buffer_.clip(rc);
+
+  // Draw a bar chart with a grid.
+  auto cx = buffer_.width();
+  auto cy = buffer_.height();
+  auto background = GetSysColor(COLOR_WINDOW);
+  buffer_.fill({ 0, 0, cx, cy }, 0xFF000000 | (GetRValue(background) << 16) | (GetGValue(background) << 8) | GetBValue(background));
+  for (auto y = cy - 20; y > 0; y -= 40) {
+    buffer_.hline(0, cx - 1, y, 0x40000000);
+  }
+  const auto bars = 24;
+  auto width = std::max(1, (cx - 20) / bars);
+  for (auto i = 0; i < bars; i++) {
+    auto height = static_cast<int>((cy - 40) * (0.55 + 0.4 * std::sin(i * 0.5)));
+    auto x = 10 + i * width;
+    buffer_.fill({ x + 2, cy - 20 - height, x + width - 2, cy - 20 }, 0xB03070D0);
+    buffer_.hline(x + 2, x + width - 3, cy - 20 - height, 0xFF1040A0);
+  }
+  buffer_.clip({ 0, 0, cx, cy });
+}
+#else
+void window::render(const dirty_rect& rc)
+{
+  // Draw the window contents.
+  RECT rect = { rc.left, rc.top, rc.right, rc.bottom };
+  FillRect(buffer_.dc(), &rect, GetSysColorBrush(COLOR_WINDOW));
+}
+#endif
+#endif
 
 void window::on_command(UINT id)
 {
@@ -98,36 +360,15 @@ void window::on_command(UINT id)
   case IDM_EXIT:
     PostMessage(hwnd_, WM_CLOSE, 0, 0);
     break;
+#ifdef PROFILER
+  case IDM_PROFILE:
+    MessageBox(hwnd_, (L"The profile was saved to " + profiler::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
+#ifdef TRACER
+  case IDM_TRACE:
+    MessageBox(hwnd_, (L"The trace was saved to " + tracer::instance().save() + L".").c_str(), PROJECT, MB_OK | MB_ICONINFORMATION);
+    break;
+#endif
   }
 }
-
-LRESULT window::handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
-{
-  // Handle windows messages.
-  try {
-    switch (msg) {
-    case WM_CREATE:
-      hwnd_ = hwnd;
-      on_create();
-      return 0;
-    case WM_DESTROY:
-      on_destroy();
-      hwnd_ = nullptr;
-      return 0;
-    case WM_SIZE:
-      on_size(LOWORD(lparam), HIWORD(lparam));
-      return 0;
-    case WM_COMMAND:
-      on_command(LOWORD(wparam));
-      return 0;
-    }
-  }
-  catch (const std::exception& e) {
-    std::wstring msg;
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0) + 1);
-    msg.resize(MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &msg[0], static_cast<int>(msg.size())));
-    MessageBox(hwnd, msg.c_str(), PROJECT, MB_OK | MB_ICONERROR);
-    DestroyWindow(hwnd);
-  }
-  return DefWindowProc(hwnd, msg, wparam, lparam);
-}
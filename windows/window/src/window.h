@@ -1,18 +1,81 @@
 #pragma once
+#include "back_buffer.h"
+#include "canvas.h"
+#include "dirty_region.h"
+#include "event_loop.h"
+#include "frame_pacer.h"
+#include "layout.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
+#include "window_base.h"
 #include <windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
 
-class window {
+class window : public window_base<window> {
 public:
-  window(HINSTANCE instance);
+  window(HINSTANCE instance, event_loop& loop, thread_pool& pool);
+
+  // Activates the window when another instance forwards its command line.
+  void open(const std::vector<std::wstring>& commands);
+
+#ifdef WINDOW_BUFFERED
+  // Marks a client area rectangle for rendering in the next paint.
+  void invalidate(const RECT& rc);
+#endif
 
   void on_create();
   void on_destroy();
   void on_size(int cx, int cy);
+  void on_entersizemove();
+  void on_exitsizemove();
   void on_command(UINT id);
+#ifdef WINDOW_BUFFERED
+  void on_paint();
+  void on_stats();
+
+  using messages = message_list<WM_ERASEBKGND>;
+  bool on_message(UINT msg, WPARAM wparam, LPARAM lparam, LRESULT& result);
+#endif
 
 private:
-  LRESULT handle(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+#ifdef WINDOW_BUFFERED
+  // Draws the window contents in the given rectangle of the back buffer.
+  void render(const dirty_rect& rc);
+#endif
+#ifdef WINDOW_CONTINUOUS
+  // Renders a frame when the frame timer fires and sets the timer for the next frame.
+  void on_frame();
+  void schedule(std::uint64_t ticks);
+  bool visible() const;
+#endif
 
   HINSTANCE instance_;
-  HWND hwnd_ = nullptr;
+  event_loop& loop_;
+  thread_pool& pool_;
+
+  // Add controls to the layout to resize them with the window.
+  layout layout_;
+  bool sizing_ = false;
+
+#ifdef WINDOW_BUFFERED
+#ifdef WINDOW_CANVAS
+  canvas buffer_;
+#else
+  back_buffer buffer_;
+#endif
+  dirty_region dirty_;
+
+  // Paint statistics since the last report.
+  unsigned frames_ = 0;
+  std::uint64_t frame_ticks_ = 0;
+  std::uint64_t frame_pixels_ = 0;
+  timer_wheel::timer stats_timer_;
+#endif
+
+#ifdef WINDOW_CONTINUOUS
+  HANDLE frame_timer_ = nullptr;
+  frame_pacer pacer_;
+#endif
 };
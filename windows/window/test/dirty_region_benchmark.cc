@@ -0,0 +1,73 @@
+#include "dirty_region.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define WIDTH         1920        // client area size
+#define HEIGHT        1080
+#define FRAME_COUNT   100000      // frames per pattern
+#define RECT_COUNT    4096        // precomputed invalidations
+
+// Measures the cost of adding the invalidations of a frame and the pixels that are repainted,
+// compared with repainting the bounding rectangle of all invalidations.
+void run(const char* pattern, const std::vector<dirty_rect>& rects, int per_frame)
+{
+  dirty_region region;
+  region.set_bounds(WIDTH, HEIGHT);
+  std::uint64_t pixels = 0;
+  std::uint64_t bounds = 0;
+  std::size_t next = 0;
+  std::uint64_t ticks = 0;
+  for (int frame = 0; frame < FRAME_COUNT; frame++) {
+    auto start = clock_ticks();
+    for (int i = 0; i < per_frame; i++) {
+      region.add(rects[next++ % rects.size()]);
+    }
+    ticks += clock_ticks() - start;
+
+    dirty_rect all = region.rects()[0];
+    for (const auto& rc : region.rects()) {
+      all.left = std::min(all.left, rc.left);
+      all.top = std::min(all.top, rc.top);
+      all.right = std::max(all.right, rc.right);
+      all.bottom = std::max(all.bottom, rc.bottom);
+    }
+    pixels += region.pixels();
+    bounds += all.area();
+    region.clear();
+  }
+
+  char name[64] = {};
+  std::snprintf(name, sizeof(name), "dirty_region add, %s", pattern);
+  report(name, elapsed_ns(0, ticks) / (static_cast<double>(FRAME_COUNT) * per_frame), "ns");
+  std::snprintf(name, sizeof(name), "repainted of bounds, %s", pattern);
+  report(name, 100.0 * pixels / bounds, "%");
+  std::snprintf(name, sizeof(name), "repainted of window, %s", pattern);
+  report(name, 100.0 * pixels / (static_cast<double>(FRAME_COUNT) * WIDTH * HEIGHT), "%");
+}
+
+int main()
+{
+  std::mt19937 random(1);
+  std::vector<dirty_rect> rects(RECT_COUNT);
+
+  // Small widgets such as a blinking caret, a clock and a progress bar spread over the window.
+  for (auto& rc : rects) {
+    rc.left = static_cast<int>(random() % (WIDTH - 64));
+    rc.top = static_cast<int>(random() % (HEIGHT - 32));
+    rc.right = rc.left + 8 + static_cast<int>(random() % 56);
+    rc.bottom = rc.top + 8 + static_cast<int>(random() % 24);
+  }
+  run("4 widgets", rects, 4);
+  run("16 widgets", rects, 16);
+
+  // Lines of a text view that scroll by, which are adjacent and merge.
+  for (std::size_t i = 0; i < rects.size(); i++) {
+    rects[i].left = 0;
+    rects[i].top = static_cast<int>(i % 60) * 18;
+    rects[i].right = WIDTH;
+    rects[i].bottom = rects[i].top + 18;
+  }
+  run("3 text lines", rects, 3);
+}
@@ -0,0 +1,139 @@
+#include "dirty_region.h"
+#include "check.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+dirty_rect rect(int left, int top, int right, int bottom)
+{
+  dirty_rect rc;
+  rc.left = left;
+  rc.top = top;
+  rc.right = right;
+  rc.bottom = bottom;
+  return rc;
+}
+
+bool equal(const dirty_rect& rc, int left, int top, int right, int bottom)
+{
+  return rc.left == left && rc.top == top && rc.right == right && rc.bottom == bottom;
+}
+
+bool touches(const dirty_rect& a, const dirty_rect& b)
+{
+  return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+void test_clip()
+{
+  dirty_region region;
+  region.add(rect(0, 0, 10, 10));
+  CHECK(region.empty());
+
+  region.set_bounds(100, 50);
+  region.add(rect(-10, -10, 10, 10));
+  region.add(rect(90, 40, 200, 200));
+  region.add(rect(5, 60, 10, 70));
+  region.add(rect(20, 20, 20, 30));
+  CHECK(region.rects().size() == 2);
+  CHECK(equal(region.rects()[0], 0, 0, 10, 10));
+  CHECK(equal(region.rects()[1], 90, 40, 100, 50));
+  CHECK(region.pixels() == 200);
+
+  region.clear();
+  CHECK(region.empty());
+  CHECK(region.pixels() == 0);
+}
+
+void test_merge()
+{
+  dirty_region region;
+  region.set_bounds(100, 100);
+
+  // Contained rectangles change nothing.
+  region.add(rect(10, 10, 50, 50));
+  region.add(rect(20, 20, 30, 30));
+  CHECK(region.rects().size() == 1);
+
+  // Adjacent rectangles merge into their bounding rectangle.
+  region.add(rect(50, 10, 60, 50));
+  CHECK(region.rects().size() == 1);
+  CHECK(equal(region.rects()[0], 10, 10, 60, 50));
+
+  // A rectangle that bridges two others merges all three.
+  region.add(rect(80, 80, 90, 90));
+  CHECK(region.rects().size() == 2);
+  region.add(rect(55, 45, 85, 85));
+  CHECK(region.rects().size() == 1);
+  CHECK(equal(region.rects()[0], 10, 10, 90, 90));
+}
+
+void test_collapse()
+{
+  dirty_region region(4);
+  region.set_bounds(100, 100);
+  for (int i = 0; i < 4; i++) {
+    region.add(rect(i * 20, i * 20, i * 20 + 5, i * 20 + 5));
+  }
+  CHECK(region.rects().size() == 4);
+  region.add(rect(90, 0, 95, 5));
+  CHECK(region.rects().size() == 1);
+  CHECK(equal(region.rects()[0], 0, 0, 95, 65));
+}
+
+// Adds random rectangles and checks that the region stays disjoint and covers every invalidated pixel.
+void test_random()
+{
+  const int width = 64;
+  const int height = 48;
+  std::mt19937 random(1);
+  for (int round = 0; round < 2000; round++) {
+    dirty_region region(1 + random() % 10);
+    region.set_bounds(width, height);
+    std::vector<bool> dirty(width * height);
+    auto count = random() % 20;
+    for (unsigned i = 0; i < count; i++) {
+      auto left = static_cast<int>(random() % (width + 20)) - 10;
+      auto top = static_cast<int>(random() % (height + 20)) - 10;
+      auto rc = rect(left, top, left + static_cast<int>(random() % 16), top + static_cast<int>(random() % 16));
+      region.add(rc);
+      for (int y = std::max(rc.top, 0); y < std::min(rc.bottom, height); y++) {
+        for (int x = std::max(rc.left, 0); x < std::min(rc.right, width); x++) {
+          dirty[y * width + x] = true;
+        }
+      }
+    }
+
+    const auto& rects = region.rects();
+    std::vector<bool> covered(width * height);
+    for (std::size_t i = 0; i < rects.size(); i++) {
+      CHECK(!rects[i].empty());
+      CHECK(rects[i].left >= 0 && rects[i].top >= 0 && rects[i].right <= width && rects[i].bottom <= height);
+      for (std::size_t j = i + 1; j < rects.size(); j++) {
+        CHECK(!touches(rects[i], rects[j]));
+      }
+      for (int y = rects[i].top; y < rects[i].bottom; y++) {
+        for (int x = rects[i].left; x < rects[i].right; x++) {
+          covered[y * width + x] = true;
+        }
+      }
+    }
+    std::uint64_t pixels = 0;
+    for (int i = 0; i < width * height; i++) {
+      CHECK(!dirty[i] || covered[i]);
+      pixels += covered[i];
+    }
+    CHECK(region.pixels() == pixels);
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  test_clip();
+  test_merge();
+  test_collapse();
+  test_random();
+}
@@ -0,0 +1,111 @@
+#include "frame_pacer.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define FPS           60.0        // target frame rate
+#define SIM_FRAMES    100000      // simulated frames per scenario
+#define REAL_FRAMES   300         // frames paced with real sleeps
+#define RENDER_MS     2.0         // render time per frame
+
+namespace {
+
+double percentile(std::vector<double> times, double p)
+{
+  auto n = std::min(times.size() - 1, static_cast<std::size_t>(p * times.size()));
+  std::nth_element(times.begin(), times.begin() + n, times.end());
+  return times[n];
+}
+
+void report_times(const char* scenario, const std::vector<double>& times, double late)
+{
+  char name[64] = {};
+  std::snprintf(name, sizeof(name), "%s p50", scenario);
+  report(name, percentile(times, 0.50), "ms");
+  std::snprintf(name, sizeof(name), "%s p99", scenario);
+  report(name, percentile(times, 0.99), "ms");
+  std::snprintf(name, sizeof(name), "%s late", scenario);
+  report(name, late / times.size(), "ms per frame");
+}
+
+// Simulates a timer that oversleeps by 1-2 ms, paced by the controller and by sleeping until each deadline.
+void simulate()
+{
+  const double frequency = 1e7;
+  const auto period = static_cast<std::uint64_t>(frequency / FPS);
+  const auto render = static_cast<std::uint64_t>(frequency * RENDER_MS / 1e3);
+  std::mt19937 random(1);
+  std::uniform_int_distribution<std::uint64_t> oversleep(static_cast<std::uint64_t>(frequency * 0.001), static_cast<std::uint64_t>(frequency * 0.002));
+
+  for (auto paced : { false, true }) {
+    frame_pacer pacer(FPS, frequency);
+    std::vector<double> times;
+    double late = 0.0;
+    std::uint64_t now = 0;
+    std::uint64_t deadline = 0;
+    std::uint64_t last = 0;
+    pacer.start(now);
+    while (times.size() < SIM_FRAMES) {
+      if (paced) {
+        if (auto duration = pacer.sleep(now)) {
+          now += duration + oversleep(random);
+          pacer.woke(now);
+          continue;
+        }
+        pacer.frame(now);
+      } else if (now < deadline) {
+        now = deadline + oversleep(random);
+      }
+      late += now > deadline ? (now - deadline) * 1e3 / frequency : 0.0;
+      if (last) {
+        times.push_back((now - last) * 1e3 / frequency);
+      }
+      last = now;
+      deadline += period;
+      now += render;
+    }
+    report_times(paced ? "simulated, paced" : "simulated, sleep to deadline", times, late);
+  }
+}
+
+// Paces frames with the sleeps of this system.
+void measure()
+{
+  frame_pacer pacer(FPS, clock_frequency());
+  std::vector<double> times;
+  std::uint64_t sleeps = 0;
+  std::uint64_t last = 0;
+  pacer.start(clock_ticks());
+  while (times.size() < REAL_FRAMES) {
+    auto now = clock_ticks();
+    if (auto duration = pacer.sleep(now)) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<std::int64_t>(elapsed_ns(0, duration))));
+      pacer.woke(clock_ticks());
+      sleeps++;
+      continue;
+    }
+    pacer.frame(now);
+    if (last) {
+      times.push_back(elapsed_ns(last, now) / 1e6);
+    }
+    last = now;
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<std::int64_t>(RENDER_MS * 1e3)));
+  }
+  auto s = pacer.stats();
+  report("real sleeps p50", percentile(times, 0.50), "ms");
+  report("real sleeps p99", percentile(times, 0.99), "ms");
+  report("real sleeps missed", static_cast<double>(s.missed), "frames");
+  report("real sleeps oversleep", elapsed_ns(0, pacer.oversleep()) / 1e6, "ms");
+  report("real sleeps per frame", static_cast<double>(sleeps) / REAL_FRAMES, "sleeps");
+}
+
+}  // namespace
+
+int main()
+{
+  simulate();
+  measure();
+}
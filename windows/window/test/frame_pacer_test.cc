@@ -0,0 +1,137 @@
+#include "frame_pacer.h"
+#include "check.h"
+#include <cmath>
+#include <random>
+
+#define FREQUENCY 10000000.0  // simulated clock ticks per second, as the performance counter
+
+namespace {
+
+std::uint64_t ms(double value)
+{
+  return static_cast<std::uint64_t>(value * FREQUENCY / 1e3);
+}
+
+// Drives the pacer with a simulated clock. Every sleep lasts longer by a random oversleep and
+// every frame takes the given render time. Returns the number of sleeps.
+std::uint64_t simulate(frame_pacer& pacer, std::uint64_t& now, int frames, double min_oversleep, double max_oversleep, double render)
+{
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> oversleep(min_oversleep, max_oversleep);
+  std::uint64_t sleeps = 0;
+  for (int i = 0; i < frames;) {
+    if (auto duration = pacer.sleep(now)) {
+      now += duration + ms(oversleep(random));
+      pacer.woke(now);
+      sleeps++;
+      continue;
+    }
+    pacer.frame(now);
+    now += ms(render);
+    i++;
+  }
+  return sleeps;
+}
+
+bool near(double a, double b, double tolerance)
+{
+  return std::fabs(a - b) <= tolerance;
+}
+
+void test_empty()
+{
+  frame_pacer pacer(60.0, FREQUENCY);
+  auto s = pacer.stats();
+  CHECK(s.frames == 0 && s.missed == 0 && s.skipped == 0);
+  CHECK(s.p50 == 0.0 && s.max == 0.0);
+  CHECK(pacer.period() == ms(1000.0 / 60.0));
+}
+
+void test_ideal()
+{
+  // An exact timer gives exact frame times with one sleep per frame.
+  frame_pacer pacer(60.0, FREQUENCY);
+  std::uint64_t now = ms(1000);
+  pacer.start(now);
+  auto sleeps = simulate(pacer, now, 600, 0.0, 0.0, 2.0);
+  auto s = pacer.stats();
+  CHECK(s.frames == 600);
+  CHECK(s.missed == 0);
+  CHECK(sleeps == 599);
+  CHECK(near(s.p50, 1000.0 / 60.0, 0.001));
+  CHECK(near(s.max, 1000.0 / 60.0, 0.001));
+  CHECK(pacer.oversleep() == 0);
+}
+
+void test_oversleep()
+{
+  // The sleeps end early by the learned oversleep, so the frames stay close to the period.
+  frame_pacer pacer(60.0, FREQUENCY);
+  std::uint64_t now = 0;
+  pacer.start(now);
+  auto sleeps = simulate(pacer, now, 600, 1.0, 2.0, 2.0);
+  auto s = pacer.stats();
+  CHECK(s.missed == 0);
+  CHECK(sleeps == 599);
+  CHECK(near(s.p50, 1000.0 / 60.0, 0.5));
+  CHECK(s.p99 < 1000.0 / 60.0 + 1.0);
+  CHECK(pacer.oversleep() >= ms(1.0) && pacer.oversleep() <= ms(2.0));
+}
+
+void test_overload()
+{
+  // Frames that take longer than the period miss deadlines and are rendered without sleeping.
+  frame_pacer pacer(60.0, FREQUENCY);
+  std::uint64_t now = 0;
+  pacer.start(now);
+  auto sleeps = simulate(pacer, now, 100, 0.0, 0.0, 25.0);
+  auto s = pacer.stats();
+  CHECK(sleeps == 0);
+  CHECK(near(s.p50, 25.0, 0.001));
+
+  // Frames of one and a half periods fall a whole period behind on every third frame.
+  CHECK(s.missed == 33);
+}
+
+void test_skip()
+{
+  // Hidden frames advance the deadline without adding the hidden time to the frame times.
+  frame_pacer pacer(60.0, FREQUENCY);
+  std::uint64_t now = 0;
+  pacer.start(now);
+  simulate(pacer, now, 10, 0.0, 0.0, 1.0);
+  for (int i = 0; i < 60; i++) {
+    pacer.skip(now);
+    now += ms(1000.0);
+  }
+  simulate(pacer, now, 10, 0.0, 0.0, 1.0);
+  auto s = pacer.stats();
+  CHECK(s.frames == 20);
+  CHECK(s.skipped == 60);
+  CHECK(s.max < 1000.0 / 60.0 + 0.001);
+}
+
+void test_history()
+{
+  // Only the newest frames are in the statistics.
+  frame_pacer pacer(60.0, FREQUENCY, 16);
+  std::uint64_t now = 0;
+  pacer.start(now);
+  simulate(pacer, now, 100, 0.0, 0.0, 30.0);
+  simulate(pacer, now, 20, 0.0, 0.0, 1.0);
+  auto s = pacer.stats();
+  CHECK(s.frames == 120);
+  CHECK(near(s.max, 1000.0 / 60.0, 0.001));
+}
+
+}  // namespace
+
+int main()
+{
+  test_empty();
+  test_ideal();
+  test_oversleep();
+  test_overload();
+  test_skip();
+  test_history();
+}
@@ -0,0 +1,72 @@
+#include "raster.h"
+#include "canvas.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define WIDTH         1920        // frame size
+#define HEIGHT        1080
+#define FRAME_COUNT   200         // frames per kernel
+
+// Runs a kernel over every row of a frame and reports the throughput in megapixels per second.
+template <typename Kernel>
+void run(const char* name, std::vector<std::uint32_t>& frame, Kernel kernel)
+{
+  auto start = clock_ticks();
+  for (int i = 0; i < FRAME_COUNT; i++) {
+    for (int y = 0; y < HEIGHT; y++) {
+      kernel(frame.data() + y * WIDTH, static_cast<std::size_t>(y), static_cast<std::uint32_t>(i));
+    }
+  }
+  auto end = clock_ticks();
+  report(name, static_cast<double>(FRAME_COUNT) * WIDTH * HEIGHT * 1e3 / elapsed_ns(start, end), "MP/s");
+}
+
+int main()
+{
+  std::printf("raster kernels: %s\n", raster_isa());
+  std::mt19937 random(1);
+  std::vector<std::uint32_t> frame(WIDTH * HEIGHT);
+  std::vector<std::uint32_t> sprite(WIDTH * HEIGHT);
+  for (auto& p : sprite) {
+    p = raster_premultiply(random());
+  }
+
+  // Each kernel set the CPU supports, the scalar references first.
+  for (const auto& k : raster_detail::kernels()) {
+    char name[64] = {};
+    std::snprintf(name, sizeof(name), "fill, %s", k.name);
+    run(name, frame, [&k](std::uint32_t* row, std::size_t, std::uint32_t i) {
+      k.fill(row, WIDTH, 0xFF000000 | i);
+    });
+    std::snprintf(name, sizeof(name), "color blend, %s", k.name);
+    run(name, frame, [&k](std::uint32_t* row, std::size_t, std::uint32_t i) {
+      k.blend_color(row, WIDTH, 0x80402010 | (i & 0xF));
+    });
+    std::snprintf(name, sizeof(name), "sprite blend, %s", k.name);
+    run(name, frame, [&k, &sprite](std::uint32_t* row, std::size_t y, std::uint32_t) {
+      k.blend_pixels(row, sprite.data() + y * WIDTH, WIDTH);
+    });
+  }
+
+  // Translucent full-frame fills through the canvas, serially and in bands on the pool.
+  thread_pool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+  for (auto p : { static_cast<thread_pool*>(nullptr), &pool }) {
+    canvas c(p);
+    c.resize(WIDTH, HEIGHT);
+    auto start = clock_ticks();
+    for (int i = 0; i < FRAME_COUNT; i++) {
+      c.fill({ 0, 0, WIDTH, HEIGHT }, 0x80402010 | (i & 0xF));
+    }
+    auto end = clock_ticks();
+    char name[64] = {};
+    if (p) {
+      std::snprintf(name, sizeof(name), "canvas blend, %zu bands", p->size() + 1);
+    } else {
+      std::snprintf(name, sizeof(name), "canvas blend, serial");
+    }
+    report(name, static_cast<double>(FRAME_COUNT) * WIDTH * HEIGHT * 1e3 / elapsed_ns(start, end), "MP/s");
+  }
+}
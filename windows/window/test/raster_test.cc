@@ -0,0 +1,184 @@
+#include "raster.h"
+#include "canvas.h"
+#include "check.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Blends one channel with exact integer rounding, independent of the kernels.
+std::uint32_t blend_channel(std::uint32_t dst, std::uint32_t src, std::uint32_t alpha)
+{
+  auto value = src + (dst * (255 - alpha) * 2 + 255) / 510;
+  return value > 255 ? 255 : value;
+}
+
+std::uint32_t blend_reference(std::uint32_t dst, std::uint32_t src)
+{
+  std::uint32_t result = 0;
+  for (auto shift = 0; shift < 32; shift += 8) {
+    result |= blend_channel((dst >> shift) & 0xFF, (src >> shift) & 0xFF, src >> 24) << shift;
+  }
+  return result;
+}
+
+void test_premultiply()
+{
+  CHECK(raster_premultiply(0xFF123456) == 0xFF123456);
+  CHECK(raster_premultiply(0x00FFFFFF) == 0x00000000);
+  CHECK(raster_premultiply(0x80FF8040) == 0x80804020);
+  for (std::uint32_t alpha = 0; alpha < 256; alpha++) {
+    for (std::uint32_t value = 0; value < 256; value++) {
+      auto color = raster_premultiply((alpha << 24) | value);
+      CHECK((color & 0xFF) == (value * alpha * 2 + 255) / 510);
+    }
+  }
+}
+
+void test_scalar()
+{
+  // The scalar references round every channel like exact division.
+  std::mt19937 random(1);
+  for (int i = 0; i < 100000; i++) {
+    std::uint32_t dst = random();
+    std::uint32_t src = random();
+    auto value = dst;
+    raster_blend_scalar(&value, 1, src);
+    CHECK(value == blend_reference(dst, src));
+  }
+}
+
+// Compares the selected kernels with the scalar references for every length and alignment of short spans.
+// Compares a kernel set with the scalar references at every alignment and at counts around the vector widths.
+void test_kernels(const raster_detail::kernel& k)
+{
+  std::mt19937 random(2);
+  std::vector<std::uint32_t> src(80);
+  std::vector<std::uint32_t> a(80);
+  std::vector<std::uint32_t> b(80);
+  for (int round = 0; round < 200; round++) {
+    for (std::size_t offset = 0; offset < 8; offset++) {
+      for (std::size_t count = 0; count + offset <= 72; count++) {
+        for (std::size_t i = 0; i < a.size(); i++) {
+          src[i] = round % 2 ? raster_premultiply(random()) : random();
+          a[i] = b[i] = random();
+        }
+        std::uint32_t color = round % 2 ? raster_premultiply(random()) : random();
+
+        k.fill(a.data() + offset, count, color);
+        raster_fill_scalar(b.data() + offset, count, color);
+        CHECK(a == b);
+        k.blend_color(a.data() + offset, count, color ^ 0x5A5A5A5A);
+        raster_blend_scalar(b.data() + offset, count, color ^ 0x5A5A5A5A);
+        CHECK(a == b);
+        k.blend_pixels(a.data() + offset, src.data() + 8 - offset, count);
+        raster_blend_scalar(b.data() + offset, src.data() + 8 - offset, count);
+        CHECK(a == b);
+        raster_copy(a.data() + offset, src.data(), count);
+        CHECK(std::equal(src.begin(), src.begin() + count, a.begin() + offset));
+      }
+    }
+  }
+}
+
+void test_dispatch()
+{
+  auto kernels = raster_detail::kernels();
+  CHECK(!kernels.empty());
+  CHECK(std::string(kernels.front().name) == "scalar");
+  CHECK(std::string(kernels.back().name) == raster_isa());
+
+  std::vector<std::uint32_t> a(37, 0x10203040);
+  std::vector<std::uint32_t> b(a);
+  raster_blend(a.data(), a.size(), 0x80402010);
+  kernels.back().blend_color(b.data(), b.size(), 0x80402010);
+  CHECK(a == b);
+}
+
+void test_canvas()
+{
+  canvas c;
+  CHECK(c.resize(10, 10));
+  CHECK(!c.resize(8, 9));
+  CHECK(c.resize(40, 30));
+  CHECK(c.width() == 40 && c.height() == 30);
+
+  c.fill({ 0, 0, 40, 30 }, 0xFF000000);
+  c.clip({ 5, 5, 35, 25 });
+  c.fill({ -10, -10, 100, 100 }, 0xFFFFFFFF);
+  CHECK(c.row(4)[10] == 0xFF000000);
+  CHECK(c.row(5)[5] == 0xFFFFFFFF);
+  CHECK(c.row(24)[34] == 0xFFFFFFFF);
+  CHECK(c.row(24)[35] == 0xFF000000);
+
+  c.hline(30, 0, 10, 0xFF0000FF);
+  CHECK(c.row(10)[4] == 0xFF000000);
+  CHECK(c.row(10)[5] == 0xFF0000FF);
+  CHECK(c.row(10)[30] == 0xFF0000FF);
+  CHECK(c.row(10)[31] == 0xFFFFFFFF);
+  c.vline(20, 0, 100, 0x80FF0000);
+  CHECK(c.row(4)[20] == 0xFF000000);
+  CHECK(c.row(5)[20] == 0xFFFF7F7F);
+  CHECK(c.row(25)[20] == 0xFF000000);
+
+  // Images are clipped on every side.
+  std::vector<std::uint32_t> pixels(4 * 4, 0xFF00FF00);
+  canvas_image image;
+  image.pixels = pixels.data();
+  image.width = 4;
+  image.height = 4;
+  image.stride = 4;
+  c.draw(image, 3, 23);
+  CHECK(c.row(23)[4] == 0xFF000000);
+  CHECK(c.row(23)[5] == 0xFF00FF00);
+  CHECK(c.row(24)[6] == 0xFF00FF00);
+  CHECK(c.row(25)[6] == 0xFF000000);
+}
+
+// Renders the same scene serially and in bands on the pool.
+void test_bands()
+{
+  thread_pool pool(3);
+  canvas serial;
+  canvas banded(&pool);
+  std::mt19937 random(3);
+  std::vector<std::uint32_t> pixels(700 * 500);
+  for (auto& p : pixels) {
+    p = raster_premultiply(random());
+  }
+  canvas_image image;
+  image.pixels = pixels.data();
+  image.width = 700;
+  image.height = 500;
+  image.stride = 700;
+
+  for (auto c : { &serial, &banded }) {
+    c->resize(1024, 768);
+    c->fill({ 0, 0, 1024, 768 }, 0xFF204060);
+    c->fill({ 10, 10, 1000, 700 }, 0x80FFFFFF);
+    c->draw(image, 200, 100);
+    c->draw(image, -100, 400);
+  }
+  for (int y = 0; y < 768; y++) {
+    CHECK(std::equal(serial.row(y), serial.row(y) + 1024, banded.row(y)));
+  }
+}
+
+}  // namespace
+
+int main()
+{
+  std::printf("raster kernels: %s\n", raster_isa());
+  test_premultiply();
+  test_scalar();
+  for (const auto& k : raster_detail::kernels()) {
+    std::printf("testing %s kernels\n", k.name);
+    test_kernels(k);
+  }
+  test_dispatch();
+  test_canvas();
+  test_bands();
+}